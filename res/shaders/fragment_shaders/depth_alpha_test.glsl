@@ -0,0 +1,21 @@
+#version 430
+
+// Used by the shadow caster pass for materials that discard fragments based on alpha
+layout(location = 3) in vec2 inUV;
+
+struct Material {
+	sampler2D AlbedoMap;
+};
+uniform Material u_Material;
+
+// Non-texture settings live in a uniform block, so the material only needs to upload
+// them when they change, see Material::Apply
+layout (std140, binding = 3) uniform b_Material {
+	float DiscardThreshold;
+} u_MaterialParams;
+
+void main() {
+	if (texture(u_Material.AlbedoMap, inUV).a < u_MaterialParams.DiscardThreshold) {
+		discard;
+	}
+}
@@ -0,0 +1,5 @@
+#version 430
+
+// Used by the shadow caster pass, we only care about depth so there's nothing to do here
+void main() {
+}
@@ -9,6 +9,7 @@ layout(location = 7) in vec4 inTextureWeights;
 ////////////////////////////////////////////////////////////////
 
 #include "../fragments/frame_uniforms.glsl"
+#include "../fragments/gbuffer_normals.glsl"
 
 ////////////////////////////////////////////////////////////////
 /////////////// Instance Level Uniforms ////////////////////////
@@ -24,12 +25,17 @@ struct Material {
 	sampler2D EmissiveB;
 	sampler2D NormalMapA;
 	sampler2D NormalMapB;
-	float     Shininess;
-	float     DiscardThreshold;
 };
 // Create a uniform for the material
 uniform Material u_Material;
 
+// Non-texture settings live in a uniform block, so the material only needs to upload
+// them when they change, see Material::Apply
+layout (std140, binding = 3) uniform b_Material {
+	float Shininess;
+	float DiscardThreshold;
+} u_MaterialParams;
+
 ////////////////////////////////////////////////////////////////
 ///////////// Application Level Uniforms ///////////////////////
 ////////////////////////////////////////////////////////////////
@@ -49,12 +55,12 @@ void main() {
 	
 
 	// Discarding fragments who's alpha is below the material's threshold
-	if (albedoColor.a < u_Material.DiscardThreshold) {
+	if (albedoColor.a < u_MaterialParams.DiscardThreshold) {
 		discard;
 	}
 
 	// Extract albedo from material, and store shininess
-	albedo_specPower = vec4(albedoColor.rgb, u_Material.Shininess);
+	albedo_specPower = vec4(albedoColor.rgb, u_MaterialParams.Shininess);
 	
 	// Normalize our input normal
 	vec3 normal = normalize(
@@ -66,9 +72,8 @@ void main() {
     // Here we apply the TBN matrix to transform the normal from tangent space to view space
     normal = normalize(inTBN * normal);
 	
-	// Map [-1, 1] to [0, 1]
-	normal = clamp((normal + 1) / 2.0, 0, 1);
-	normal_metallic = vec4(normal, 0.0f);
+	// Pack the normal for the G-Buffer layout we're using
+	normal_metallic = EncodeGBufferNormal(normal, 0.0f);
 
 	// Extract emissive from the material
 	emissive = 
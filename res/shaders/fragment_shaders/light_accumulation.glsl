@@ -4,35 +4,13 @@ layout(location = 0) in vec2 inUV;
 layout(location = 0) out vec4 outDiffuse;
 layout(location = 1) out vec4 outSpecular;
 
-// The maximum number of lights the shader supports, increasing this will lower performance!
-#define MAX_LIGHTS 8
+// Our lights, binned into clusters on the CPU
+#include "../fragments/light_clusters.glsl"
 
-// Represents a single light source
-struct Light {
-	vec4  PositionIntensity;
-	// Stores color in RBG and attenuation in w
-	vec4  ColorAttenuation;
-};
-
-// Our uniform buffer that will store all our lighting data
-// so that it can be shared between shaders
-layout (std140, binding = 2) uniform b_LightBlock {
-    // Stores ambient light color in rgb, and number
-	// of lights in w, allowing for easier struct packing
-	// on the C++ side
-    vec4  AmbientColAndNumLights;
-
-    // Our array of all lights
-    Light Lights[MAX_LIGHTS];
-
-    // The rotation of the skybox/environment map
-	mat3  EnvironmentRotation;
-};
+#include "../fragments/frame_uniforms.glsl"
 
 #include "../fragments/deferred_post_common.glsl"
 
-#include "../fragments/frame_uniforms.glsl"
-
 // Calculates the contribution the given point light has 
 // for the current fragment
 // @param viewPos   The fragment's position in view space
@@ -76,8 +54,12 @@ void main() {
 
     vec3 diffuse = vec3(0);
     vec3 specular = vec3(0);
-    for (int ix = 0; ix < AmbientColAndNumLights.w && ix < MAX_LIGHTS; ix++) {
-        CalcPointLightContribution(viewPos, normal, Lights[ix], specularPow, diffuse, specular);
+
+    // Only shade with the lights that can reach this fragment's cluster
+    uvec2 cluster = GetCluster(inUV, viewPos.z);
+    for (uint ix = 0; ix < cluster.y; ix++) {
+        Light light = ClusterLights[ClusterLightIndices[cluster.x + ix]];
+        CalcPointLightContribution(viewPos, normal, light, specularPow, diffuse, specular);
     }
 
     outDiffuse = vec4(diffuse, 1);
@@ -8,11 +8,17 @@ uniform layout(binding = 0) sampler2D s_Image;
 uniform float u_Filter[9];
 uniform vec2 u_PixelSize;
 
+#include "../../fragments/post_fusion.glsl"
+
 void main() {
     vec3 accumulator = vec3(0);
     for(int ix = -1; ix <= 1; ix++) {
         for (int iy = -1; iy <= 1; iy++) {
             int index =  (iy + 1) * 3 + (ix + 1);
+            // The filter is uniform, so this branch is coherent and saves the fetch for sparse kernels
+            if (u_Filter[index] == 0.0) {
+                continue;
+            }
             vec2 uv = inUV + vec2(u_PixelSize.x * ix, u_PixelSize.y * iy);
 
             vec3 texSample = texture(s_Image, uv).rgb;
@@ -20,5 +26,5 @@ void main() {
         }
     }
    
-   outColor = accumulator + 0.5;
+   outColor = ApplyFusedEffects(accumulator + 0.5);
 }
@@ -8,14 +8,20 @@ uniform layout(binding = 0) sampler2D s_Image;
 uniform float u_Filter[25];
 uniform vec2 u_PixelSize;
 
+#include "../../fragments/post_fusion.glsl"
+
 void main() {
     vec3 accumulator = vec3(0);
     for(int ix = -2; ix <= 2; ix++) {
         for (int iy = -2; iy <= 2; iy++) {
             int index =  (iy + 2) * 5 + (ix + 2);
+            // The filter is uniform, so this branch is coherent and saves the fetch for sparse kernels
+            if (u_Filter[index] == 0.0) {
+                continue;
+            }
             vec2 uv = inUV + vec2(u_PixelSize.x * ix, u_PixelSize.y * iy);
             accumulator += texture(s_Image, uv).rgb * u_Filter[index];
         }
     }
-    outColor = accumulator;
+    outColor = ApplyFusedEffects(accumulator);
 }
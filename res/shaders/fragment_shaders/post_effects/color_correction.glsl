@@ -9,9 +9,11 @@ uniform layout(binding = 1) sampler3D s_Lut;
 
 uniform float u_Strength;
 
+#include "../../fragments/post_fusion.glsl"
+
 void main() {
     vec3 color = texture(s_Image, inUV).rgb;
-    outColor = mix(color, texture(s_Lut, color).rgb, clamp(u_Strength, 0, 1));
+    outColor = ApplyFusedEffects(mix(color, texture(s_Lut, color).rgb, clamp(u_Strength, 0, 1)));
 }
 
 
@@ -13,6 +13,7 @@ layout(binding = 0) uniform sampler2D a_Sampler;
 layout(binding = 1) uniform sampler2D a_Depth;
 
 #include "../../fragments/frame_uniforms.glsl"
+#include "../../fragments/post_fusion.glsl"
 
 const float GOLDEN_ANGLE = 2.39996323;
 const float MAX_BLUR_RADIUS = 20; // We impose a hard limit on blurring to avoid killing the GPU
@@ -94,5 +95,5 @@ void main() {
     // Perform our DOF blurring
     vec3 dof = depthOfField(inUV, u_FocalDepth, focalLength);
     // Return the result
-    outColor = vec4(dof, 1.0);
+    outColor = vec4(ApplyFusedEffects(dof), 1.0);
 }
\ No newline at end of file
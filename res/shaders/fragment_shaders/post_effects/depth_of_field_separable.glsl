@@ -0,0 +1,79 @@
+#version 440
+
+// A separable version of depth_of_field.glsl, instead of gathering in a spiral we gather
+// along a line, once horizontally and then once vertically over the result. Each pass
+// takes at most 2 * MAX_BLUR_RADIUS samples instead of roughly MAX_BLUR_RADIUS squared
+
+layout(location = 0) in vec2 inUV;
+
+layout(location = 0) out vec4 outColor;
+
+// Our color buffer to sample from
+layout(binding = 0) uniform sampler2D a_Sampler;
+// The depth buffer to use (non-linearized)
+layout(binding = 1) uniform sampler2D a_Depth;
+
+// The axis to gather along, (1, 0) for the first pass and (0, 1) for the second
+uniform vec2 u_Direction;
+
+#include "../../fragments/frame_uniforms.glsl"
+#include "../../fragments/post_fusion.glsl"
+
+const float MAX_BLUR_RADIUS = 20; // We impose a hard limit on blurring to avoid killing the GPU
+
+// Converts a screen space coord and a raw depth value into a world-space distance
+float DepthToDist(vec2 screen, float rawValue) {
+	vec4 screenPos = vec4(screen.x, screen.y, rawValue, 1.0) * 2.0 - 1.0;
+	vec4 viewPosition = u_InvProjection * screenPos;
+
+	return -(viewPosition.z / viewPosition.w);
+}
+
+// Calculates the Circle of Confusion for a given depth value, see depth_of_field.glsl
+float getBlurSize(float depth, float focalPlane, float focalLength) {
+	float coc = clamp(
+        (focalLength * (focalPlane - depth)) / 
+        (depth * (focalPlane - focalLength)), 
+        -1.0, 1.0);
+	return abs(coc) * u_Aperture;
+}
+
+void main() {
+    // Calculate our focal length
+    float focalLength = 1.0f / (1.0 / u_FocalDepth + 1.0 / u_LensDepth);
+
+    // Determines the size of single texel
+    vec2 texelSize = 1.0 / textureSize(a_Depth, 0);
+
+    // Get our depth into view space, and use that to calculate our circle of confusion
+    float centerDepth = DepthToDist(inUV, texelFetch(a_Depth, ivec2(inUV / texelSize), 0).r);
+    float centerCOC = getBlurSize(centerDepth, u_FocalDepth, focalLength);
+
+    vec3 color = texture(a_Sampler, inUV).rgb;
+    float tot = 1.0;
+
+    int radius = int(min(u_Aperture, MAX_BLUR_RADIUS));
+    for (int ix = -radius; ix <= radius; ix++) {
+        if (ix == 0) {
+            continue;
+        }
+
+        // Collect the color, depth, circle of confusion for the sample
+        vec2 tc = inUV + u_Direction * texelSize * ix;
+        vec3 sampleColor = texture(a_Sampler, tc).rgb;
+        float sampleDepth = DepthToDist(tc, texelFetch(a_Depth, ivec2(tc / texelSize), 0).r);
+        float sampleCOC = getBlurSize(sampleDepth, u_FocalDepth, focalLength);
+
+        // Samples behind us can't blur further than we do
+        if (sampleDepth > centerDepth)
+            sampleCOC = clamp(sampleCOC, 0.0, centerCOC);
+
+        // The sample only contributes if it's circle of confusion reaches this pixel
+        float distance = abs(float(ix));
+        float m = smoothstep(distance - 0.5, distance + 0.5, sampleCOC);
+        color += sampleColor * m;
+        tot += m;
+    }
+
+    outColor = vec4(ApplyFusedEffects(color / tot), 1.0);
+}
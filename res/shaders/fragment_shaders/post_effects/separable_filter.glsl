@@ -0,0 +1,49 @@
+#version 430
+
+// One half of a separable convolution, the filter is run once along X and then once
+// along Y to get the same result as the full 2D kernel. Any taps that the column and row
+// can't re-create are sampled from the effect's input and added at the end of the Y pass
+
+layout(location = 0) in vec2 inUV;
+layout(location = 0) out vec3 outColor;
+
+uniform layout(binding = 0) sampler2D s_Image;
+// The input to the first pass, see PostProcessingLayer::EFFECT_INPUT_SLOT
+uniform layout(binding = 6) sampler2D s_Input;
+
+// The weights for the taps in [-u_Radius, u_Radius]
+uniform float u_Weights[9];
+uniform int   u_Radius;
+// The UV offset between two taps, along a single axis
+uniform vec2  u_Step;
+// True if samples should be converted to grayscale before being weighted
+uniform bool  u_Grayscale;
+// A constant to add to the filtered result
+uniform float u_Bias;
+// The leftover taps, xy is the offset in pixels and z is the weight
+uniform vec3  u_Residual[8];
+uniform int   u_ResidualCount;
+uniform vec2  u_PixelSize;
+// True if the residual samples should be converted to grayscale
+uniform bool  u_ResidualGrayscale;
+
+#include "../../fragments/post_fusion.glsl"
+
+void main() {
+    vec3 accumulator = vec3(0);
+    for (int ix = -u_Radius; ix <= u_Radius; ix++) {
+        vec3 texSample = texture(s_Image, inUV + u_Step * ix).rgb;
+        if (u_Grayscale) {
+            texSample = vec3((texSample.r + texSample.g + texSample.b) / 3);
+        }
+        accumulator += texSample * u_Weights[ix + u_Radius];
+    }
+    for (int ix = 0; ix < u_ResidualCount; ix++) {
+        vec3 texSample = texture(s_Input, inUV + u_Residual[ix].xy * u_PixelSize).rgb;
+        if (u_ResidualGrayscale) {
+            texSample = vec3((texSample.r + texSample.g + texSample.b) / 3);
+        }
+        accumulator += texSample * u_Residual[ix].z;
+    }
+    outColor = ApplyFusedEffects(accumulator + u_Bias);
+}
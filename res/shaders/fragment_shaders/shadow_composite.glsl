@@ -50,8 +50,8 @@ struct Light {
 	vec4  ColorAttenuation;
 };
 
-#include "../fragments/deferred_post_common.glsl"
 #include "../fragments/frame_uniforms.glsl"
+#include "../fragments/deferred_post_common.glsl"
 
 // Showing off another way to extract view pos from depth
 vec4 GetViewPos(vec2 uv) {
@@ -59,8 +59,8 @@ vec4 GetViewPos(vec2 uv) {
 	float zOverW = GetDepth(uv) * 2 - 1;
 	// We convert the range [0,1] to [-1,1], create a point to inverse project    
 	vec4 currentPos = vec4(uv.xy * 2 - 1, zOverW, 1);
-	// Transform by the view-projection inverse    
-	vec4 D = inverse(u_Projection) * currentPos;
+	// Transform by the inverse projection    
+	vec4 D = u_InvProjection * currentPos;
 	// Divide by w for perspective divide    
 	vec4 viewPos = D / D.w;
 	return viewPos;
@@ -4,6 +4,9 @@ layout(location = 0) in vec3 inNormal;
 
 uniform layout (binding=15) samplerCube s_Environment;
 
+#include "../fragments/frame_uniforms.glsl"
+#include "../fragments/gbuffer_normals.glsl"
+
 // We output a single color to the color buffer
 layout(location = 0) out vec4 albedo_specPower;
 layout(location = 1) out vec4 normal_metallic;
@@ -14,7 +17,7 @@ void main() {
     vec3 norm = normalize(inNormal);
 
     albedo_specPower = vec4(texture(s_Environment, norm).rgb, 0.0);
-    normal_metallic = vec4(0.5, 0.5, 1, 0);
+    normal_metallic = EncodeGBufferNormal(vec3(0, 0, 1), 0);
     emissive = vec4(0);
     view_pos = vec3(0);
 }
\ No newline at end of file
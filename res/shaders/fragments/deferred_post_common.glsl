@@ -1,23 +1,33 @@
+// NOTE: frame_uniforms.glsl must be included before this file
+#include "gbuffer_normals.glsl"
 
 uniform layout(binding=0) sampler2D s_Depth;
 uniform layout(binding=1) sampler2D s_AlbedoSpec;
 uniform layout(binding=2) sampler2D s_NormalsMetallic;
 uniform layout(binding=3) sampler2D s_Emissive;
+// Only bound for the full G-Buffer layout, the compact layout reconstructs position from depth
 uniform layout(binding=4) sampler2D s_Position;
 
 
 vec3 GetNormal(vec2 uv) {
-    return ((texture(s_NormalsMetallic, uv).xyz) * 2) - 1;
+    return DecodeGBufferNormal(texture(s_NormalsMetallic, uv));
 }
 
 vec3 GetAlbedo(vec2 uv) {
     return texture(s_AlbedoSpec, uv).rgb;
 }
 
-vec3 GetViewPosition(vec2 uv) {
-    return texture(s_Position, uv).rgb;
-}
-
 float GetDepth(vec2 uv) {
     return texelFetch(s_Depth, ivec2(uv * textureSize(s_Depth, 0)), 0).r;
-}
\ No newline at end of file
+}
+
+vec3 GetViewPosition(vec2 uv) {
+    if (IsCompactGBuffer()) {
+        // Map depth and uv from [0,1] to [-1,1], and inverse project back into view space
+        vec4 clipPos = vec4(uv * 2 - 1, GetDepth(uv) * 2 - 1, 1);
+        vec4 viewPos = u_InvProjection * clipPos;
+        return viewPos.xyz / viewPos.w;
+    } else {
+        return texture(s_Position, uv).rgb;
+    }
+}
@@ -45,6 +45,8 @@ layout (std140, binding = 1) uniform b_InstanceLevelUniforms {
     uniform mat4 u_ModelView;
     // Normal Matrix for transforming normals
     uniform mat4 u_NormalMatrix;
+    // Non-zero when the matrices above should be ignored in favor of the instance attributes
+    uniform uint u_IsInstanced;
 };
 
 #define FLAG_DISABLE_AMBIENT (1 << 0)
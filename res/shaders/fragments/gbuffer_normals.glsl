@@ -0,0 +1,54 @@
+/*
+ * Partial file for reading and writing the normal/metallic target of the G-Buffer, the layout
+ * of which is selected by the render layer at load (see RenderLayer's GBufferLayout)
+ *
+ * Full:    RGBA8, normal mapped from [-1, 1] to [0, 1] in rgb, metallic in a
+ * Compact: RGB10_A2, octahedral encoded normal in rg, metallic in b, and a is set to 1
+ *          wherever geometry has been drawn
+ *
+ * NOTE: frame_uniforms.glsl must be included before this file
+*/
+
+#define FLAG_COMPACT_GBUFFER (1 << 4)
+
+bool IsCompactGBuffer() {
+    return IsFlagSet(FLAG_COMPACT_GBUFFER);
+}
+
+// Encodes a unit vector onto an octahedron, unfolded into the [-1, 1] square
+// https://knarkowicz.wordpress.com/2014/04/16/octahedron-normal-vector-encoding/
+vec2 OctahedralEncode(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 result = n.xy;
+    if (n.z < 0.0) {
+        result = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return result;
+}
+
+// Decodes a vector encoded by OctahedralEncode
+vec3 OctahedralDecode(vec2 f) {
+    vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+// Packs a view space normal and metallic value for writing to the G-Buffer
+vec4 EncodeGBufferNormal(vec3 normal, float metallic) {
+    if (IsCompactGBuffer()) {
+        return vec4(OctahedralEncode(normal) * 0.5 + 0.5, metallic, 1.0);
+    } else {
+        return vec4(clamp((normal + 1) / 2.0, 0, 1), metallic);
+    }
+}
+
+// Unpacks a normal written by EncodeGBufferNormal, returns a zero vector where nothing was drawn
+vec3 DecodeGBufferNormal(vec4 encoded) {
+    if (IsCompactGBuffer()) {
+        return encoded.a < 0.5 ? vec3(0) : OctahedralDecode(encoded.rg * 2 - 1);
+    } else {
+        return (encoded.xyz * 2) - 1;
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * Partial file for reading the clustered light lists built by LightClusters on the
+ * C++ side. The view frustum is split into a grid of tiles in screen space, and
+ * logarithmically spaced slices in depth. Each cluster stores a range within
+ * ClusterLightIndices, listing only the lights that can reach it
+ *
+ * Usage:
+ * uvec2 cluster = GetCluster(inUV, viewPos.z);
+ * for (uint ix = 0; ix < cluster.y; ix++) {
+ *     Light light = ClusterLights[ClusterLightIndices[cluster.x + ix]];
+ * }
+*/
+
+// Represents a single light source
+struct Light {
+	// View space position in xyz, intensity in w
+	vec4  PositionIntensity;
+	// Stores color in RBG and attenuation in w
+	vec4  ColorAttenuation;
+};
+
+// All the lights in the scene
+layout (std430, binding = 3) readonly buffer b_ClusterLights {
+	Light ClusterLights[];
+};
+
+// The (offset, count) within ClusterLightIndices for each cluster
+layout (std430, binding = 4) readonly buffer b_Clusters {
+	uvec2 Clusters[];
+};
+
+// The light indices for all clusters, packed together
+layout (std430, binding = 5) readonly buffer b_ClusterLightIndices {
+	uint ClusterLightIndices[];
+};
+
+// Number of tiles along x and y, and number of depth slices
+uniform uvec3 u_ClusterDims;
+// Converts log(view depth) into a slice index
+uniform float u_ClusterDepthScale;
+uniform float u_ClusterDepthBias;
+
+// Gets the (offset, count) pair for the cluster containing the given point
+// @param uv         The screen UV of the fragment, in the [0, 1] range
+// @param viewDepthZ The Z coordinate of the fragment in view space (negative in front of the camera)
+uvec2 GetCluster(vec2 uv, float viewDepthZ) {
+	uvec2 tile = min(uvec2(uv * vec2(u_ClusterDims.xy)), u_ClusterDims.xy - 1);
+	float slice = floor(log(max(-viewDepthZ, 1e-5)) * u_ClusterDepthScale + u_ClusterDepthBias);
+	uint  sliceIx = uint(clamp(slice, 0.0, float(u_ClusterDims.z - 1)));
+	return Clusters[tile.x + tile.y * u_ClusterDims.x + sliceIx * u_ClusterDims.x * u_ClusterDims.y];
+}
@@ -0,0 +1,17 @@
+// Parameters for per-pixel effects that have been folded into the end of this pass
+// by the post processing layer, see PostProcessingLayer::FusionUniforms
+layout (std140, binding = 4) uniform b_PostFusion {
+    // Strength of the color correction LUT, 0 if color correction was not fused
+    float u_FusedLutStrength;
+};
+
+// The color correction LUT, only bound if color correction was fused
+uniform layout(binding = 7) sampler3D s_FusedLut;
+
+// Applies any fused effects to the final output of a post processing pass
+vec3 ApplyFusedEffects(vec3 color) {
+    if (u_FusedLutStrength > 0) {
+        color = mix(color, texture(s_FusedLut, color).rgb, clamp(u_FusedLutStrength, 0, 1));
+    }
+    return color;
+}
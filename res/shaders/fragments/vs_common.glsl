@@ -8,6 +8,11 @@ layout(location = 3) in vec2 inUV;
 layout(location = 4) in vec3 inTangent;
 layout(location = 5) in vec3 inBiTangent;
 
+// Per-instance attributes, only valid when u_IsInstanced is set (see InstanceBuffer)
+// Each matrix consumes 4 slots, one per column
+layout(location = 8)  in mat4 inInstanceModel;
+layout(location = 12) in mat4 inInstanceNormal;
+
 // Standard vertex shader outputs
 layout(location = 0) out vec3 outViewPos;
 layout(location = 1) out vec3 outColor;
@@ -17,3 +22,21 @@ layout(location = 4) out mat3 outTBN;
 
 // Include the matrices and frame level parameters
 #include "frame_uniforms.glsl"
+
+// Helpers for getting the object's matrices, these will pull from the instance
+// attributes when we are part of an instanced batch
+mat4 GetModel() {
+    return u_IsInstanced != 0 ? inInstanceModel : u_Model;
+}
+
+mat4 GetModelView() {
+    return u_IsInstanced != 0 ? u_View * inInstanceModel : u_ModelView;
+}
+
+mat4 GetModelViewProjection() {
+    return u_IsInstanced != 0 ? u_ViewProjection * inInstanceModel : u_ModelViewProjection;
+}
+
+mat3 GetNormalMatrix() {
+    return u_IsInstanced != 0 ? mat3(inInstanceNormal) : mat3(u_NormalMatrix);
+}
@@ -0,0 +1,11 @@
+#version 440
+
+// Include our common vertex shader attributes and uniforms
+#include "../fragments/vs_common.glsl"
+
+// Used by the shadow caster pass, we only need the clip space position, and the UVs
+// for alpha tested materials
+void main() {
+	gl_Position = GetModelViewProjection() * vec4(inPosition, 1.0);
+	outUV = inUV;
+}
@@ -8,10 +8,14 @@
 #include "Gameplay/InputEngine.h"
 #include "Application/Timing.h"
 #include <filesystem>
+#include <cstdlib>
 #include "Layers/GLAppLayer.h"
 #include "Utils/FileHelpers.h"
 #include "Utils/ResourceManager/ResourceManager.h"
 #include "Utils/ImGuiHelper.h"
+#include "Utils/JobSystem.h"
+#include "Utils/Profiler.h"
+#include "Utils/ObjLoaderBenchmark.h"
 
 // Graphics
 #include "Graphics/Buffers/IndexBuffer.h"
@@ -23,10 +27,13 @@
 #include "Graphics/Textures/Texture2DArray.h"
 #include "Graphics/Textures/Texture3D.h"
 #include "Graphics/Textures/TextureCube.h"
+#include "Graphics/Textures/TextureLoader.h"
 #include "Graphics/VertexTypes.h"
 #include "Graphics/Font.h"
 #include "Graphics/GuiBatcher.h"
 #include "Graphics/Framebuffer.h"
+#include "Graphics/GlStateCache.h"
+#include "Graphics/GpuProfiler.h"
 
 // Gameplay
 #include "Gameplay/Material.h"
@@ -83,7 +90,11 @@ Application::Application() :
 	_isEditor(true),
 	_windowTitle("INFR - 2350U"),
 	_currentScene(nullptr),
-	_targetScene(nullptr)
+	_targetScene(nullptr),
+	_profileFrames(0),
+	_profilePath("profile.json"),
+	_profileStartup(false),
+	_objBenchmarkIterations(0)
 { }
 
 Application::~Application() = default; 
@@ -96,6 +107,7 @@ Application& Application::Get() {
 void Application::Start(int argCount, char** arguments) {
 	LOG_ASSERT(_singleton == nullptr, "Application has already been started!");
 	_singleton = new Application();
+	_singleton->_ParseArguments(argCount, arguments);
 	_singleton->_Run();
 }
 
@@ -153,8 +165,33 @@ void Application::SaveSettings()
 	FileHelpers::WriteContentsToFile(settingsPath.string(), _appSettings.dump(1, '\t'));
 }
 
+void Application::_ParseArguments(int argCount, char** arguments)
+{
+	// First argument is always the executable
+	for (int ix = 1; ix < argCount; ix++) {
+		std::string arg = arguments[ix];
+		bool hasValue = ix + 1 < argCount;
+
+		if (arg == "--no-editor") {
+			_isEditor = false;
+		} else if (arg == "--profile-frames" && hasValue) {
+			_profileFrames = static_cast<uint32_t>(std::max(0, std::atoi(arguments[++ix])));
+		} else if (arg == "--profile-output" && hasValue) {
+			_profilePath = arguments[++ix];
+		} else if (arg == "--profile-startup") {
+			_profileStartup = true;
+		} else if (arg == "--benchmark-obj" && hasValue) {
+			_objBenchmarkIterations = static_cast<uint32_t>(std::max(0, std::atoi(arguments[++ix])));
+		} else {
+			LOG_WARN("Unknown or incomplete command line argument \"{}\"", arg);
+		}
+	}
+}
+
 void Application::_Run()
 {
+	Profiler::SetThreadName("Main Thread");
+
 	// TODO: Register layers
 	_layers.push_back(std::make_shared<GLAppLayer>());
 	_layers.push_back(std::make_shared<LogicUpdateLayer>());
@@ -183,18 +220,41 @@ void Application::_Run()
 	// Register all component and resource types
 	_RegisterClasses();
 
+	// Spin up our worker threads before the layers load, so they can use them
+	JobSystem::Init();
+
+
+	// With --profile-startup the capture begins before loading, so that resource and scene loads end up in the trace
+	if (_profileFrames > 0 && _profileStartup) {
+		Profiler::CaptureFrames(_profileFrames, _profilePath);
+	}
 
 	// Load all layers
 	_Load();
 
+	// The benchmark needs our GL context and workers, so it runs once everything else is up
+	if (_objBenchmarkIterations > 0) {
+		ObjLoaderBenchmark::Run(".", _objBenchmarkIterations);
+	}
+
+	// Otherwise start profiling now that loading is done, the application will quit once it's captured
+	if (_profileFrames > 0 && !_profileStartup) {
+		// Captures should measure steady state frames, not the first few frames of texture uploads
+		TextureLoader::WaitAll();
+		Profiler::CaptureFrames(_profileFrames, _profilePath);
+	}
+
 	// Grab current time as the previous frame
 	double lastFrame =  glfwGetTime();
 
-	// Done loading, app is now running!
-	_isRunning = true;
+	// Done loading, app is now running! Unless we were only started to run a benchmark
+	_isRunning = _objBenchmarkIterations == 0;
 
 	// Infinite loop as long as the application is running
 	while (_isRunning) {
+		// Frames span the whole loop, so we time them by hand rather than with a scoped zone
+		int64_t frameStart = Profiler::Now();
+
 		// Handle scene switching
 		if (_targetScene != nullptr) {
 			_HandleSceneChange();
@@ -270,6 +330,12 @@ void Application::_Run()
 
 		ImGuiHelper::StartFrame();
 
+		// Results for this frame are read back a few frames from now, so this never waits on the GPU
+		GpuProfiler::BeginFrame();
+
+		// Upload any textures that finished decoding since last frame, before anything gets rendered
+		TextureLoader::Update();
+
 		// Core update loop
 		if (_currentScene != nullptr) {
 			_Update();
@@ -283,10 +349,28 @@ void Application::_Run()
 		lastFrame = thisFrame;
 
 		InputEngine::EndFrame();
-		ImGuiHelper::EndFrame();
+		{
+			PROFILE_SCOPE("ImGui");
+			ImGuiHelper::EndFrame();
+		}
 
-		glfwSwapBuffers(_window);
+		GpuProfiler::EndFrame();
 
+		// ImGui restores most of the state it touches, but not necessarily the way we had it cached
+		GlStateCache::EndFrame();
+
+		{
+			PROFILE_SCOPE("SwapBuffers");
+			glfwSwapBuffers(_window);
+		}
+
+		if (Profiler::IsCapturing()) {
+			Profiler::RecordZone("Frame", frameStart, Profiler::Now());
+		}
+		// Command line captures are for headless runs, so we're done once they've been written
+		if (Profiler::EndFrame() && _profileFrames > 0) {
+			_isRunning = false;
+		}
 	}
 
 	// Unload all our layers
@@ -338,8 +422,11 @@ void Application::_RegisterClasses()
 }
 
 void Application::_Load() {
+	PROFILE_SCOPE("Application::_Load");
+
 	for (const auto& layer : _layers) {
 		if (layer->Enabled && *(layer->Overrides & AppLayerFunctions::OnAppLoad)) {
+			PROFILE_SCOPE_DYNAMIC(layer->Name.c_str());
 			layer->OnAppLoad(_appSettings);
 		}
 	}
@@ -354,16 +441,22 @@ void Application::_Load() {
 }
 
 void Application::_Update() {
+	PROFILE_SCOPE("Application::_Update");
+
 	for (const auto& layer : _layers) {
 		if (layer->Enabled && *(layer->Overrides & AppLayerFunctions::OnUpdate)) {
+			PROFILE_SCOPE_DYNAMIC(layer->Name.c_str());
 			layer->OnUpdate();
 		}
 	}
 }
 
 void Application::_LateUpdate() {
+	PROFILE_SCOPE("Application::_LateUpdate");
+
 	for (const auto& layer : _layers) {
 		if (layer->Enabled && *(layer->Overrides & AppLayerFunctions::OnLateUpdate)) {
+			PROFILE_SCOPE_DYNAMIC(layer->Name.c_str());
 			layer->OnLateUpdate();
 		}
 	}
@@ -371,9 +464,11 @@ void Application::_LateUpdate() {
 
 void Application::_PreRender()
 {
+	PROFILE_SCOPE("Application::_PreRender");
+
 	glm::ivec2 size ={ 0, 0 };
 	glfwGetWindowSize(_window, &size.x, &size.y);
-	glViewport(0, 0, size.x, size.y);
+	GlStateCache::SetViewport(0, 0, size.x, size.y);
 	glScissor(0, 0, size.x, size.y);
 
 	// Clear the screen
@@ -381,51 +476,76 @@ void Application::_PreRender()
 
 	for (const auto& layer : _layers) {
 		if (layer->Enabled && *(layer->Overrides & AppLayerFunctions::OnPreRender)) {
+			PROFILE_SCOPE_DYNAMIC(layer->Name.c_str());
 			layer->OnPreRender();
 		}
 	}
 }
 
 void Application::_RenderScene() {
+	PROFILE_SCOPE("Application::_RenderScene");
+	GPU_PROFILE_SCOPE("Render");
 
 	Framebuffer::Sptr result = nullptr;
 	for (const auto& layer : _layers) {
 		if (layer->Enabled && *(layer->Overrides & AppLayerFunctions::OnRender)) {
+			GPU_PROFILE_SCOPE(layer->Name);
+			PROFILE_SCOPE_DYNAMIC(layer->Name.c_str());
 			layer->OnRender(result);
 		}
 	}
 }
 
 void Application::_PostRender() {
+	PROFILE_SCOPE("Application::_PostRender");
+	GPU_PROFILE_SCOPE("Post Render");
+
 	// Note that we use a reverse iterator for post render
 	for (auto it = _layers.begin(); it != _layers.end(); it++) {
 		const auto& layer = *it;
 		if (layer->Enabled && *(layer->Overrides & AppLayerFunctions::OnPostRender)) {
+			GPU_PROFILE_SCOPE(layer->Name);
+			PROFILE_SCOPE_DYNAMIC(layer->Name.c_str());
 			layer->OnPostRender();
 		}
 	}
 }
 
 void Application::_Unload() {
+	PROFILE_SCOPE("Application::_Unload");
+
 	// Note that we use a reverse iterator for unloading
 	for (auto it = _layers.crbegin(); it != _layers.crend(); it++) {
 		const auto& layer = *it;
 		if (layer->Enabled && *(layer->Overrides & AppLayerFunctions::OnAppUnload)) {
+			PROFILE_SCOPE_DYNAMIC(layer->Name.c_str());
 			layer->OnAppUnload();
 		}
 	}
 
+	// Release our profiler queries while we still have a context
+	GpuProfiler::Cleanup();
+
+	// Same for the texture staging buffer and placeholders
+	TextureLoader::Cleanup();
+
 	// Clean up ImGui
 	ImGuiHelper::Cleanup();
+
+	// Join all our worker threads
+	JobSystem::Shutdown();
 }
 
 void Application::_HandleSceneChange() {
+	PROFILE_SCOPE("Application::_HandleSceneChange");
+
 	// If we currently have a current scene, let the layers know it's being unloaded
 	if (_currentScene != nullptr) {
 		// Note that we use a reverse iterator, so that layers are unloaded in the opposite order that they were loaded
 		for (auto it = _layers.crbegin(); it != _layers.crend(); it++) {
 			const auto& layer = *it;
 			if (layer->Enabled && *(layer->Overrides & AppLayerFunctions::OnSceneUnload)) {
+				PROFILE_SCOPE_DYNAMIC(layer->Name.c_str());
 				layer->OnSceneUnload();
 			}
 		}
@@ -436,6 +556,7 @@ void Application::_HandleSceneChange() {
 	// Let the layers know that we've loaded in a new scene
 	for (const auto& layer : _layers) {
 		if (layer->Enabled && *(layer->Overrides & AppLayerFunctions::OnSceneLoad)) {
+			PROFILE_SCOPE_DYNAMIC(layer->Name.c_str());
 			layer->OnSceneLoad();
 		}
 	}
@@ -452,8 +573,11 @@ void Application::_HandleSceneChange() {
 }
 
 void Application::_HandleWindowSizeChanged(const glm::ivec2& newSize) {
+	PROFILE_SCOPE("Application::_HandleWindowSizeChanged");
+
 	for (const auto& layer : _layers) {
 		if (layer->Enabled && *(layer->Overrides & AppLayerFunctions::OnWindowResize)) {
+			PROFILE_SCOPE_DYNAMIC(layer->Name.c_str());
 			layer->OnWindowResize(_windowSize, newSize);
 		}
 	}
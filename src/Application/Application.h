@@ -31,6 +31,12 @@ public:
 	/**
 	 * Called by the entry point to begin the application, creating the singleton 
 	 * intance and performing any library initialization
+	 * 
+	 * Supported arguments:
+	 *   --no-editor             Runs without the editor windows
+	 *   --profile-frames <N>    Captures a CPU profile of the first N frames, then quits
+	 *   --profile-output <path> Where to write the capture, default "profile.json"
+	 *   --benchmark-obj <N>     Times each OBJ loader on the meshes in the working directory N times, then quits
 	 */
 	static void Start(int argCount, char** arguments);
 
@@ -131,6 +137,15 @@ protected:
 	// The primary viewport that the game will render into, in client window bounds
 	glm::uvec4  _primaryViewport;
 
+	// The number of frames to profile from startup, 0 if we're not profiling from the command line
+	uint32_t    _profileFrames;
+	// The file to write the startup profile to
+	std::string _profilePath;
+	// True if the command line capture should also cover loading (--profile-startup), false to only capture steady state frames
+	bool        _profileStartup;
+	// The number of times to run the OBJ loader benchmark, 0 if we're running normally
+	uint32_t    _objBenchmarkIterations;
+
 	// Stores the current application settings
 	nlohmann::json _appSettings;
 
@@ -142,6 +157,7 @@ protected:
 	// Stores all the layers of the application, in the order they should be invoked
 	std::vector<ApplicationLayer::Sptr> _layers;
 
+	void _ParseArguments(int argCount, char** arguments);
 	void _Run();
 	void _RegisterClasses();
 	void _Load();
@@ -112,6 +112,7 @@ void DefaultSceneLayer::_CreateScene()
 			{ ShaderPartType::Fragment, "shaders/fragment_shaders/deferred_forward.glsl" }
 		});
 		deferredForward->SetDebugName("Deferred - GBuffer Generation");  
+		deferredForward->SetDepthCompatible(true);
 
 		// Our foliage shader which manipulates the vertices of the mesh
 		ShaderProgram::Sptr foliageShader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
@@ -119,6 +120,8 @@ void DefaultSceneLayer::_CreateScene()
 			{ ShaderPartType::Fragment, "shaders/fragment_shaders/deferred_forward.glsl" }
 		});  
 		foliageShader->SetDebugName("Foliage");   
+		// Wind can push vertices up to u_WindStrength units, this covers strengths up to 1
+		foliageShader->SetDisplacementMargin(1.0f);
 
 		// This shader handles our multitexturing example
 		ShaderProgram::Sptr multiTextureShader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
@@ -126,6 +129,7 @@ void DefaultSceneLayer::_CreateScene()
 			{ ShaderPartType::Fragment, "shaders/fragment_shaders/frag_multitextured.glsl" }
 		});
 		multiTextureShader->SetDebugName("Multitexturing"); 
+		multiTextureShader->SetDepthCompatible(true);
 
 		// This shader handles our displacement mapping example
 		ShaderProgram::Sptr displacementShader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
@@ -133,6 +137,8 @@ void DefaultSceneLayer::_CreateScene()
 			{ ShaderPartType::Fragment, "shaders/fragment_shaders/deferred_forward.glsl" }
 		});
 		displacementShader->SetDebugName("Displacement Mapping");
+		// Vertices are pushed out along their normals by up to u_Scale, which our materials keep at 0.1 or less
+		displacementShader->SetDisplacementMargin(0.1f);
 
 		// This shader handles our cel shading example
 		ShaderProgram::Sptr celShader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
@@ -140,6 +146,7 @@ void DefaultSceneLayer::_CreateScene()
 			{ ShaderPartType::Fragment, "shaders/fragment_shaders/cel_shader.glsl" }
 		});
 		celShader->SetDebugName("Cel Shader");
+		celShader->SetDisplacementMargin(0.1f);
 
 
 		// Load in the meshes
@@ -17,6 +17,7 @@
 #include "../Windows/PostProcessingSettingsWindow.h"
 
 #include "Graphics/DebugDraw.h"
+#include "Graphics/GlStateCache.h"
 
 ImGuiDebugLayer::ImGuiDebugLayer() :
 	ApplicationLayer(),
@@ -251,10 +252,10 @@ void ImGuiDebugLayer::OnPostRender()
 	// HACK HACK HACK - Getting debug gizmos to show up
 	Application& app = Application::Get();
 	const glm::uvec4& viewport = app.GetPrimaryViewport();
-	glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+	GlStateCache::SetViewport(viewport.x, viewport.y, viewport.z, viewport.w);
  
-	glEnable(GL_DEPTH_TEST);
-	glDepthMask(true);
+	GlStateCache::Enable(GL_DEPTH_TEST);
+	GlStateCache::SetDepthMask(true);
 
 	glClear(GL_DEPTH_BUFFER_BIT);
 
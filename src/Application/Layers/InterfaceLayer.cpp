@@ -1,5 +1,7 @@
 #include "InterfaceLayer.h"
 #include "Graphics/GuiBatcher.h"
+#include "Graphics/GlStateCache.h"
+#include "Graphics/RasterizerState.h"
 #include <GLM/glm.hpp>
 #include <GLM/gtc/matrix_transform.hpp>
 #include "../Application.h"
@@ -20,18 +22,16 @@ void InterfaceLayer::OnPostRender() {
 
 	// We can use the application's viewport to set our OpenGL viewport, as well as clip rendering to that area
 	const glm::uvec4& viewport = app.GetPrimaryViewport();
-	glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+	GlStateCache::SetViewport(viewport.x, viewport.y, viewport.z, viewport.w);
 
 	// Disable culling
-	glDisable(GL_CULL_FACE);
-	// Disable depth testing, we're going to use order-dependant layering
-	glDisable(GL_DEPTH_TEST);
-	// Disable depth writing
-	glDepthMask(GL_FALSE);
+	GlStateCache::SetCullMode(CullMode::None);
+	// Disable depth testing and writing, we're going to use order-dependant layering
+	DisabledDepthState.Apply();
 
 	// Enable alpha blending
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GlStateCache::Enable(GL_BLEND);
+	GlStateCache::SetBlendFunc(BlendFunc::SrcAlpha, BlendFunc::OneMinusSrcAlpha);
 
 	// Our projection matrix will be our entire window for now
 	glm::mat4 proj = glm::ortho(0.0f, (float)app.GetWindowSize().x, (float)app.GetWindowSize().y, 0.0f, -1.0f, 1.0f);
@@ -44,11 +44,11 @@ void InterfaceLayer::OnPostRender() {
 	GuiBatcher::Flush();
 
 	// Disable alpha blending
-	glDisable(GL_BLEND);
+	GlStateCache::Disable(GL_BLEND);
 	// Disable scissor testing
-	glDisable(GL_SCISSOR_TEST);
+	GlStateCache::Disable(GL_SCISSOR_TEST);
 	// Re-enable depth writing
-	glDepthMask(GL_TRUE);
+	GlStateCache::SetDepthMask(true);
 }
 
 void InterfaceLayer::OnWindowResize(const glm::ivec2& oldSize, const glm::ivec2& newSize) {
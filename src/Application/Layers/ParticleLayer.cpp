@@ -2,6 +2,7 @@
 #include "Gameplay/Components/ParticleSystem.h"
 #include "Application/Application.h"
 #include "RenderLayer.h"
+#include "Graphics/GlStateCache.h"
 
 ParticleLayer::ParticleLayer() :
 	ApplicationLayer()
@@ -17,12 +18,12 @@ void ParticleLayer::OnUpdate()
 {
 	Application& app = Application::Get();
 
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	GlStateCache::BindFramebuffer(FramebufferBinding::Draw, 0);
 
 	// Only update the particle systems when the game is playing, so we can edit them in
 	// the inspector
 	if (app.CurrentScene()->IsPlaying) {
-		app.CurrentScene()->Components().Each<ParticleSystem>([](const ParticleSystem::Sptr& system) {
+		app.CurrentScene()->Components().Each<ParticleSystem>([](ParticleSystem* system) {
 			if (system->IsEnabled) {
 				system->Update();
 			}
@@ -39,9 +40,9 @@ void ParticleLayer::OnPostRender()
 	RenderLayer::Sptr renderer = app.GetLayer<RenderLayer>();
 	const Framebuffer::Sptr renderOutput = renderer->GetRenderOutput();
 	renderOutput->Bind();
-	glViewport(0, 0, renderOutput->GetWidth(), renderOutput->GetHeight());
+	GlStateCache::SetViewport(0, 0, renderOutput->GetWidth(), renderOutput->GetHeight());
 
-	Application::Get().CurrentScene()->Components().Each<ParticleSystem>([](const ParticleSystem::Sptr& system) {
+	Application::Get().CurrentScene()->Components().Each<ParticleSystem>([](ParticleSystem* system) {
 		if (system->IsEnabled) {
 			system->Render(); 
 		}
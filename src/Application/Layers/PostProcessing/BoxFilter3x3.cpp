@@ -7,10 +7,15 @@
 #include <GLM/glm.hpp>
 
 BoxFilter3x3::BoxFilter3x3() :
-	PostProcessingLayer::Effect()
+	PostProcessingLayer::Effect(),
+	_separable(std::make_shared<SeparableFilter>(1)),
+	_isSeparable(false)
 {
 	Name = "Box Filter";
 	_format = RenderTargetType::ColorRgb8;
+	// Keep the in-between pass at a higher precision so splitting the filter doesn't band
+	_intermediateFormat = RenderTargetType::ColorRgb16F;
+	_isFusionHost = true;
 
 	// Zero the memory, then set center pixel to 1.0
 	memset(Filter, 0, sizeof(float) * 9);
@@ -35,6 +40,21 @@ void BoxFilter3x3::Apply(const Framebuffer::Sptr& gBuffer)
 	_shader->SetUniform("u_PixelSize", glm::vec2(1.0f) / (glm::vec2)gBuffer->GetSize()); 
 }
 
+uint32_t BoxFilter3x3::GetPassCount()
+{
+	_isSeparable = _separable->Factor(Filter);
+	return _isSeparable ? 2 : 1;
+}
+
+void BoxFilter3x3::ApplyPass(uint32_t pass, const Framebuffer::Sptr& gBuffer)
+{
+	if (_isSeparable) {
+		_separable->ApplyPass(pass, glm::vec2(1.0f) / (glm::vec2)gBuffer->GetSize(), true, 0.5f);
+	} else {
+		Apply(gBuffer);
+	}
+}
+
 void BoxFilter3x3::RenderImGui()
 {
 	ImGui::PushID(this);
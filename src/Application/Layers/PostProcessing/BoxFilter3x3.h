@@ -3,6 +3,7 @@
 #include "Graphics/ShaderProgram.h"
 #include "Graphics/Textures/Texture3D.h"
 #include "Graphics/Framebuffer.h"
+#include "SeparableFilter.h"
 
 class BoxFilter3x3 : public PostProcessingLayer::Effect {
 public:
@@ -13,6 +14,8 @@ public:
 	virtual ~BoxFilter3x3();
 
 	virtual void Apply(const Framebuffer::Sptr& gBuffer) override;
+	virtual uint32_t GetPassCount() override;
+	virtual void ApplyPass(uint32_t pass, const Framebuffer::Sptr& gBuffer) override;
 	virtual void RenderImGui() override;
 
 	// Inherited from IResource
@@ -22,5 +25,8 @@ public:
 
 protected:
 	ShaderProgram::Sptr _shader;
+	// Used instead of _shader when the filter can be split into two 1D passes
+	SeparableFilter::Sptr _separable;
+	bool _isSeparable;
 };
 
@@ -9,38 +9,27 @@
 #include <GLM/glm.hpp>
 
 BoxFilter5x5::BoxFilter5x5() :
-	PostProcessingLayer::Effect()
+	PostProcessingLayer::Effect(),
+	_separable(std::make_shared<SeparableFilter>(2)),
+	_isSeparable(false)
 {
 	Name = "Box Filter";
 	_format = RenderTargetType::ColorRgb8;
-
-	memset(Filter, 0, sizeof(float) * 25);
-	{
-		Filter[0] = 1.0f / 273.0f;
-		Filter[1] = 4.0f / 273.0f;
-		Filter[2] = 7.0f / 273.0f;
-		Filter[3] = 4.0f / 273.0f;
-		Filter[4] = 1.0f / 273.0f;
-		Filter[5] = 4.0f / 273.0f;
-		Filter[6] = 16.0f / 273.0f;
-		Filter[7] = 26.0f / 273.0f;
-		Filter[8] = 16.0f / 273.0f;
-		Filter[9] = 4.0f / 273.0f;
-		Filter[10] = 7.0f / 273.0f;
-		Filter[11] = 26.0f / 273.0f;
-		Filter[12] = 41.0f / 273.0f;
-		Filter[24] = 1.0f / 273.0f;
-		Filter[23] = 4.0f / 273.0f;
-		Filter[22] = 7.0f / 273.0f;
-		Filter[21] = 4.0f / 273.0f;
-		Filter[20] = 1.0f / 273.0f;
-		Filter[19] = 4.0f / 273.0f;
-		Filter[18] = 16.0f / 273.0f;
-		Filter[17] = 26.0f / 273.0f;
-		Filter[16] = 16.0f / 273.0f;
-		Filter[15] = 4.0f / 273.0f;
-		Filter[14] = 7.0f / 273.0f;
-		Filter[13] = 26.0f / 273.0f;
+	// Keep the in-between pass at a higher precision so splitting the filter doesn't band
+	_intermediateFormat = RenderTargetType::ColorRgb16F;
+	_isFusionHost = true;
+
+	// Default to the classic 5x5 gaussian approximation. It doesn't quite separate, so it's drawn as two
+	// 1D passes plus a few residual taps, use SetBinomialFilter for a blur that splits exactly
+	const float weights[25] = {
+		1.0f,  4.0f,  7.0f,  4.0f, 1.0f,
+		4.0f, 16.0f, 26.0f, 16.0f, 4.0f,
+		7.0f, 26.0f, 41.0f, 26.0f, 7.0f,
+		4.0f, 16.0f, 26.0f, 16.0f, 4.0f,
+		1.0f,  4.0f,  7.0f,  4.0f, 1.0f
+	};
+	for (int ix = 0; ix < 25; ix++) {
+		Filter[ix] = weights[ix] / 273.0f;
 	}
 
 	_shader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
@@ -53,6 +42,17 @@ BoxFilter5x5::BoxFilter5x5() :
 
 BoxFilter5x5::~BoxFilter5x5() = default;
 
+void BoxFilter5x5::SetBinomialFilter()
+{
+	// A 5x5 gaussian built from the binomial weights, the outer product of two 1D kernels so it separates exactly
+	const float weights[5] = { 1.0f, 4.0f, 6.0f, 4.0f, 1.0f };
+	for (int iy = 0; iy < 5; iy++) {
+		for (int ix = 0; ix < 5; ix++) {
+			Filter[iy * 5 + ix] = weights[iy] * weights[ix] / 256.0f;
+		}
+	}
+}
+
 void BoxFilter5x5::Apply(const Framebuffer::Sptr& gBuffer)
 {
 	_shader->Bind();
@@ -60,10 +60,30 @@ void BoxFilter5x5::Apply(const Framebuffer::Sptr& gBuffer)
 	_shader->SetUniform("u_PixelSize", glm::vec2(1.0f) / (glm::vec2)gBuffer->GetSize());
 }
 
+uint32_t BoxFilter5x5::GetPassCount()
+{
+	_isSeparable = _separable->Factor(Filter);
+	return _isSeparable ? 2 : 1;
+}
+
+void BoxFilter5x5::ApplyPass(uint32_t pass, const Framebuffer::Sptr& gBuffer)
+{
+	if (_isSeparable) {
+		_separable->ApplyPass(pass, glm::vec2(1.0f) / (glm::vec2)gBuffer->GetSize(), false, 0.0f);
+	} else {
+		Apply(gBuffer);
+	}
+}
+
 void BoxFilter5x5::RenderImGui()
 {
 	ImGui::PushID(this);
 
+	// Blurs lose very little detail when rendered at a lower resolution
+	if (LABEL_LEFT(ImGui::SliderFloat, "Resolution", &_outputScale.x, 0.25f, 1.0f)) {
+		_outputScale.y = _outputScale.x;
+	}
+
 	ImGui::Columns(5); 
 	for (int iy = 0; iy < 5; iy++) { 
 		for (int ix = 0; ix < 5; ix++) {
@@ -77,6 +97,10 @@ void BoxFilter5x5::RenderImGui()
 	}
 	ImGui::Columns(1);
 
+	if (ImGui::Button("Binomial")) {
+		SetBinomialFilter();
+	}
+	ImGui::SameLine();
 	if (ImGui::Button("Normalize")) {
 		float sum = 0.0f;
 		for (int ix = 0; ix < 25; ix++) {
@@ -108,6 +132,7 @@ BoxFilter5x5::Sptr BoxFilter5x5::FromJson(const nlohmann::json& data)
 {
 	BoxFilter5x5::Sptr result = std::make_shared<BoxFilter5x5>();
 	result->Enabled = JsonGet(data, "enabled", true);
+	result->_outputScale = glm::vec2(JsonGet(data, "resolution_scale", 1.0f));
 	std::vector<float> filter = JsonGet(data, "filter", std::vector<float>(25, 0.0f));
 	for (int ix = 0; ix < 25; ix++) {
 		result->Filter[ix] = filter[ix];
@@ -123,6 +148,7 @@ nlohmann::json BoxFilter5x5::ToJson() const
 	}
 	return {
 		{ "enabled", Enabled },
+		{ "resolution_scale", _outputScale.x },
 		{ "filter", filter }
 	};
 }
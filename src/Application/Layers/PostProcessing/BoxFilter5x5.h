@@ -3,6 +3,7 @@
 #include "Graphics/ShaderProgram.h"
 #include "Graphics/Textures/Texture3D.h"
 #include "Graphics/Framebuffer.h"
+#include "SeparableFilter.h"
 
 class BoxFilter5x5 : public PostProcessingLayer::Effect {
 public:
@@ -12,7 +13,12 @@ public:
 	BoxFilter5x5();
 	virtual ~BoxFilter5x5();
 
+	// Replaces the filter with a binomial gaussian, which is drawn as two cheaper 1D passes
+	void SetBinomialFilter();
+
 	virtual void Apply(const Framebuffer::Sptr& gBuffer) override;
+	virtual uint32_t GetPassCount() override;
+	virtual void ApplyPass(uint32_t pass, const Framebuffer::Sptr& gBuffer) override;
 	virtual void RenderImGui() override;
 
 	// Inherited from IResource
@@ -22,4 +28,7 @@ public:
 
 protected:
 	ShaderProgram::Sptr _shader;
+	// Used instead of _shader when the filter can be split into two 1D passes
+	SeparableFilter::Sptr _separable;
+	bool _isSeparable;
 };
\ No newline at end of file
@@ -14,6 +14,7 @@ ColorCorrectionEffect::ColorCorrectionEffect(bool defaultLut) :
 {
 	Name = "Color Correction";
 	_format = RenderTargetType::ColorRgb8;
+	_isFusionHost = true;
 
 	_shader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
 		{ ShaderPartType::Vertex, "shaders/vertex_shaders/fullscreen_quad.glsl" },
@@ -34,6 +35,22 @@ void ColorCorrectionEffect::Apply(const Framebuffer::Sptr& gBuffer)
 	_shader->SetUniform("u_Strength", _strength);
 }
 
+bool ColorCorrectionEffect::ApplyFused(PostProcessingLayer::FusionUniforms& fusion)
+{
+	// A zero strength lookup doesn't change anything, so there's nothing to apply
+	if (_strength <= 0.0f) {
+		return true;
+	}
+	// The host only has room for a single LUT
+	if (fusion.LutStrength > 0.0f || Lut == nullptr) {
+		return false;
+	}
+
+	Lut->Bind(PostProcessingLayer::FUSED_LUT_SLOT);
+	fusion.LutStrength = glm::min(_strength, 1.0f);
+	return true;
+}
+
 void ColorCorrectionEffect::RenderImGui()
 {
 	LABEL_LEFT(ImGui::LabelText, "LUT", Lut ? Lut->GetDebugName().c_str() : "none");
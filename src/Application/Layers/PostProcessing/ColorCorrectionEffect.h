@@ -13,6 +13,7 @@ public:
 	virtual ~ColorCorrectionEffect();
 
 	virtual void Apply(const Framebuffer::Sptr& gBuffer) override;
+	virtual bool ApplyFused(PostProcessingLayer::FusionUniforms& fusion) override;
 	virtual void RenderImGui() override;
 
 	// Inherited from IResource
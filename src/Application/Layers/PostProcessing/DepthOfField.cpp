@@ -7,15 +7,23 @@
 
 DepthOfField::DepthOfField() :
 	PostProcessingLayer::Effect(),
-	_shader(nullptr)
+	_shader(nullptr),
+	_separableShader(nullptr),
+	_isSeparable(false)
 {
 	Name = "Depth of Field";
 	_format = RenderTargetType::ColorRgb8;
+	_intermediateFormat = RenderTargetType::ColorRgb16F;
+	_isFusionHost = true;
 
 	_shader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
 		{ ShaderPartType::Vertex, "shaders/vertex_shaders/fullscreen_quad.glsl" },
 		{ ShaderPartType::Fragment, "shaders/fragment_shaders/post_effects/depth_of_field.glsl" }
 	});
+	_separableShader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
+		{ ShaderPartType::Vertex, "shaders/vertex_shaders/fullscreen_quad.glsl" },
+		{ ShaderPartType::Fragment, "shaders/fragment_shaders/post_effects/depth_of_field_separable.glsl" }
+	});
 }
 
 DepthOfField::~DepthOfField() = default;
@@ -26,10 +34,31 @@ void DepthOfField::Apply(const Framebuffer::Sptr& gBuffer)
 	gBuffer->BindAttachment(RenderTargetAttachment::Depth, 1);
 }
 
+uint32_t DepthOfField::GetPassCount()
+{
+	return _isSeparable ? 2 : 1;
+}
+
+void DepthOfField::ApplyPass(uint32_t pass, const Framebuffer::Sptr& gBuffer)
+{
+	if (_isSeparable) {
+		_separableShader->Bind();
+		_separableShader->SetUniform("u_Direction", pass == 0 ? glm::vec2(1.0f, 0.0f) : glm::vec2(0.0f, 1.0f));
+		gBuffer->BindAttachment(RenderTargetAttachment::Depth, 1);
+	} else {
+		Apply(gBuffer);
+	}
+}
+
 void DepthOfField::RenderImGui()
 {
 	const auto& cam = Application::Get().CurrentScene()->MainCamera;
 
+	ImGui::Checkbox("Separable  ", &_isSeparable);
+	if (ImGui::SliderFloat("Resolution ", &_outputScale.x, 0.25f, 1.0f)) {
+		_outputScale.y = _outputScale.x;
+	}
+
 	if (cam != nullptr) {
 		ImGui::DragFloat("Focal Depth", &cam->FocalDepth, 0.1f, 0.1f, 100.0f);
 		ImGui::DragFloat("Lens Dist. ", &cam->LensDepth,  0.01f, 0.001f, 50.0f);
@@ -41,12 +70,16 @@ DepthOfField::Sptr DepthOfField::FromJson(const nlohmann::json& data)
 {
 	DepthOfField::Sptr result = std::make_shared<DepthOfField>();
 	result->Enabled = JsonGet(data, "enabled", true);
+	result->_isSeparable = JsonGet(data, "separable", result->_isSeparable);
+	result->_outputScale = glm::vec2(JsonGet(data, "resolution_scale", 1.0f));
 	return result;
 }
 
 nlohmann::json DepthOfField::ToJson() const
 {
 	return {
-		{ "enabled", Enabled }
+		{ "enabled", Enabled },
+		{ "separable", _isSeparable },
+		{ "resolution_scale", _outputScale.x }
 	};
 }
@@ -13,6 +13,8 @@ public:
 	virtual ~DepthOfField();
 
 	virtual void Apply(const Framebuffer::Sptr& gBuffer) override;
+	virtual uint32_t GetPassCount() override;
+	virtual void ApplyPass(uint32_t pass, const Framebuffer::Sptr& gBuffer) override;
 	virtual void RenderImGui() override;
 
 	// Inherited from IResource
@@ -22,4 +24,8 @@ public:
 
 protected:
 	ShaderProgram::Sptr _shader;
+	// Gathers along a line instead of a spiral, rendered once horizontally and once vertically
+	ShaderProgram::Sptr _separableShader;
+	// True to use the two pass separable blur, off by default since it looks different to the single pass bokeh blur
+	bool                _isSeparable;
 };
\ No newline at end of file
@@ -15,6 +15,7 @@ OutlineEffect::OutlineEffect() :
 {
 	Name = "Outline Effect";
 	_format = RenderTargetType::ColorRgb8;
+	_isFusionHost = true;
 
 	_shader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
 		{ ShaderPartType::Vertex, "shaders/vertex_shaders/fullscreen_quad.glsl" },
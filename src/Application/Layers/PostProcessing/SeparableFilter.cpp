@@ -0,0 +1,111 @@
+#include "SeparableFilter.h"
+#include "Utils/ResourceManager/ResourceManager.h"
+
+SeparableFilter::SeparableFilter(int radius) :
+	_radius(glm::clamp(radius, 0, MAX_RADIUS)),
+	_row(),
+	_column(),
+	_residual(),
+	_shader(nullptr)
+{
+	LOG_ASSERT(radius <= MAX_RADIUS, "Separable filter radius exceeds the maximum");
+
+	int size = _radius * 2 + 1;
+	_row.resize(size, 0.0f);
+	_column.resize(size, 0.0f);
+
+	_shader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
+		{ ShaderPartType::Vertex, "shaders/vertex_shaders/fullscreen_quad.glsl" },
+		{ ShaderPartType::Fragment, "shaders/fragment_shaders/post_effects/separable_filter.glsl" }
+	});
+}
+
+bool SeparableFilter::Factor(const float* kernel) {
+	int size = _radius * 2 + 1;
+
+	// The 2D pass skips zero weights, so that's the number of samples we have to beat
+	int nonZero = 0;
+	float largest = 0.0f;
+	for (int ix = 0; ix < size * size; ix++) {
+		nonZero += kernel[ix] != 0.0f ? 1 : 0;
+		largest = glm::max(largest, glm::abs(kernel[ix]));
+	}
+	if (nonZero <= size * 2) {
+		return false;
+	}
+
+	// Tolerance is relative to the kernel, anything under it will be lost in an 8 bit target anyways
+	const float tolerance = largest * 1e-4f;
+
+	// Every non-zero element can be a pivot, the column through the pivot and the row through the pivot
+	// (scaled by the pivot) re-create every element of a separable kernel. For other kernels we keep
+	// the pivot that leaves the fewest elements behind, preferring larger pivots for stability
+	int bestCount = MAX_RESIDUAL_TAPS + 1;
+	float bestPivot = 0.0f;
+	int pivotRow = 0, pivotCol = 0;
+	for (int py = 0; py < size; py++) {
+		for (int px = 0; px < size; px++) {
+			float pivot = kernel[py * size + px];
+			if (glm::abs(pivot) <= tolerance) {
+				continue;
+			}
+
+			int count = 0;
+			for (int iy = 0; iy < size && count < bestCount; iy++) {
+				for (int ix = 0; ix < size; ix++) {
+					float approx = kernel[iy * size + px] * kernel[py * size + ix] / pivot;
+					count += glm::abs(kernel[iy * size + ix] - approx) > tolerance ? 1 : 0;
+				}
+			}
+			if (count < bestCount || (count == bestCount && glm::abs(pivot) > bestPivot)) {
+				bestCount = count;
+				bestPivot = glm::abs(pivot);
+				pivotRow = py;
+				pivotCol = px;
+			}
+		}
+	}
+
+	// Each residual tap costs an extra sample in the vertical pass
+	if (bestCount > MAX_RESIDUAL_TAPS || size * 2 + bestCount >= nonZero) {
+		return false;
+	}
+
+	float pivot = kernel[pivotRow * size + pivotCol];
+	for (int ix = 0; ix < size; ix++) {
+		_column[ix] = kernel[ix * size + pivotCol];
+		_row[ix] = kernel[pivotRow * size + ix] / pivot;
+	}
+
+	_residual.clear();
+	for (int iy = 0; iy < size; iy++) {
+		for (int ix = 0; ix < size; ix++) {
+			float remainder = kernel[iy * size + ix] - _column[iy] * _row[ix];
+			if (glm::abs(remainder) > tolerance) {
+				_residual.push_back(glm::vec3(ix - _radius, iy - _radius, remainder));
+			}
+		}
+	}
+	return true;
+}
+
+void SeparableFilter::ApplyPass(uint32_t pass, const glm::vec2& pixelSize, bool grayscale, float bias) {
+	bool horizontal = pass == 0;
+
+	_shader->Bind();
+	_shader->SetUniform("u_Weights", horizontal ? _row.data() : _column.data(), (int)_row.size());
+	_shader->SetUniform("u_Radius", _radius);
+	_shader->SetUniform("u_Step", horizontal ? glm::vec2(pixelSize.x, 0.0f) : glm::vec2(0.0f, pixelSize.y));
+	// Grayscale is linear, so it only needs to happen on the way in, and the bias on the way out
+	_shader->SetUniform("u_Grayscale", horizontal && grayscale);
+	_shader->SetUniform("u_Bias", horizontal ? 0.0f : bias);
+
+	// The leftover taps are added in on the way out, sampled from the effect's original input
+	int residualCount = horizontal ? 0 : (int)_residual.size();
+	_shader->SetUniform("u_ResidualCount", residualCount);
+	if (residualCount > 0) {
+		_shader->SetUniform("u_Residual", _residual.data(), residualCount);
+		_shader->SetUniform("u_PixelSize", pixelSize);
+		_shader->SetUniform("u_ResidualGrayscale", grayscale);
+	}
+}
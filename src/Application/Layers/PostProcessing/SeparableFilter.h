@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+#include "Utils/Macros.h"
+#include "Graphics/ShaderProgram.h"
+
+/**
+ * Helper for effects with a square convolution kernel. When the kernel is the outer
+ * product of a column and a row (ex: a gaussian or box blur), we can render it as two
+ * 1D passes, which takes 2N samples per pixel instead of N*N. Kernels that are only
+ * off by a few elements (ex: the classic 1 4 7 4 1 gaussian) are split into a column
+ * and row plus a handful of residual taps, which the second pass reads straight from
+ * the effect's input, so the result still matches the full 2D kernel
+ */
+class SeparableFilter {
+public:
+	MAKE_PTRS(SeparableFilter);
+	NO_COPY(SeparableFilter);
+	NO_MOVE(SeparableFilter);
+
+	/**
+	 * The largest radius we can handle, must match u_Weights in separable_filter.glsl
+	 */
+	static const int MAX_RADIUS = 4;
+	/**
+	 * The most taps that can be left over after splitting a kernel, must match u_Residual in separable_filter.glsl
+	 */
+	static const int MAX_RESIDUAL_TAPS = 8;
+
+	/**
+	 * Creates a new separable filter for kernels of (radius * 2 + 1) squared elements
+	 */
+	SeparableFilter(int radius);
+	~SeparableFilter() = default;
+
+	/**
+	 * Attempts to split the kernel into a column, a row and some residual taps, the kernel is
+	 * stored row by row
+	 * @returns True if the kernel can be rendered as two 1D passes without changing the result, and
+	 *          doing so takes fewer samples than a single 2D pass that skips the kernel's zero weights
+	 */
+	bool Factor(const float* kernel);
+
+	/**
+	 * Sets up one of the two passes, the horizontal pass is 0 and vertical pass is 1. Factor
+	 * must have returned true for the current kernel. The vertical pass reads the residual taps
+	 * from PostProcessingLayer::EFFECT_INPUT_SLOT
+	 * @param pass The index of the pass to set up
+	 * @param pixelSize The size of a single pixel in UV space
+	 * @param grayscale True if samples should be converted to grayscale before filtering
+	 * @param bias A value to add to the filtered result after the vertical pass
+	 */
+	void ApplyPass(uint32_t pass, const glm::vec2& pixelSize, bool grayscale = false, float bias = 0.0f);
+
+protected:
+	int _radius;
+	std::vector<float> _row;
+	std::vector<float> _column;
+	// The taps that the column and row don't cover, as the offset in pixels and the weight
+	std::vector<glm::vec3> _residual;
+	ShaderProgram::Sptr _shader;
+};
@@ -1,7 +1,12 @@
 #include "Application/Layers/PostProcessingLayer.h"
 
+#include <cstring>
+
 #include "Application/Application.h"
 #include "RenderLayer.h"
+#include "Graphics/GlStateCache.h"
+#include "Graphics/GpuProfiler.h"
+#include "Graphics/RasterizerState.h"
 
 #include "PostProcessing/ColorCorrectionEffect.h"
 #include "PostProcessing/BoxFilter3x3.h"
@@ -38,18 +43,13 @@ void PostProcessingLayer::OnAppLoad(const nlohmann::json& config)
 
 	//GetEffect<OutlineEffect>()->Enabled = false;
 
-	Application& app = Application::Get();
-	const glm::uvec4& viewport = app.GetPrimaryViewport();
-
-	// Initialize all the effect's output FBOs (inefficient) 
-	for (const auto& effect : _effects) {
-		FramebufferDescriptor fboDesc = FramebufferDescriptor();
-		fboDesc.Width  = viewport.z * effect->_outputScale.x;
-		fboDesc.Height = viewport.w * effect->_outputScale.y;
-		fboDesc.RenderTargets[RenderTargetAttachment::Color0] = RenderTargetDescriptor(effect->_format);
+	// Effect outputs are handed out from the pool each frame, so that effects that don't
+	// overlap can share the same memory
+	_targetPool = std::make_shared<RenderTargetPool>();
 
-		effect->_output = std::make_shared<Framebuffer>(fboDesc);
-	}
+	// Fused effect parameters for host passes, the empty block keeps fusion off everywhere else
+	_fusionUbo   = std::make_shared<UniformBuffer<FusionUniforms>>(FusionUniforms(), BufferUsage::DynamicDraw);
+	_noFusionUbo = std::make_shared<UniformBuffer<FusionUniforms>>(FusionUniforms(), BufferUsage::StaticDraw);
 
 	// We need a mesh for drawing fullscreen quads
 	glm::vec2 positions[6] = {
@@ -80,9 +80,8 @@ void PostProcessingLayer::OnPostRender()
 	Framebuffer::Sptr current = output;
 
 	// Disable depth testing and depth writing, as well as blending
-	glDisable(GL_DEPTH_TEST);
-	glDepthMask(false);
-	glDisable(GL_BLEND);
+	DisabledDepthState.Apply();
+	GlStateCache::Disable(GL_BLEND);
 
 	// Bind the quad VAO so our effects can use it
 	_quadVAO->Bind();
@@ -96,34 +95,82 @@ void PostProcessingLayer::OnPostRender()
 
 	else GetEffect<BoxFilter3x3>()->Enabled = false;
 
-	// Iterate over all the effects in the queue
-	for (const auto& effect : _effects) {
+	_passCount = 0;
+	_fusedCount = 0;
+
+	// The effects form a simple chain, each pass reads the previous pass's output and
+	// writes a new one. The input of a pass is released back to the pool as soon as the
+	// pass has been issued, so it can be re-used by the pass after it, meaning we only
+	// need two targets per size and format, no matter how many effects are enabled
+	for (size_t ix = 0; ix < _effects.size(); ix++) {
+		const Effect::Sptr& effect = _effects[ix];
 		// Only render if it's enabled
-		if (effect->Enabled) {
+		if (!effect->Enabled) {
+			continue;
+		}
+
+		// Fold any per-pixel effects that directly follow this one into it's last pass, so
+		// they don't cost a full read and write of the frame each
+		FusionUniforms fusion = FusionUniforms();
+		if (effect->_isFusionHost) {
+			for (; ix + 1 < _effects.size(); ix++) {
+				const Effect::Sptr& next = _effects[ix + 1];
+				if (next->Enabled && !next->ApplyFused(fusion)) {
+					break;
+				}
+				_fusedCount += next->Enabled ? 1 : 0;
+			}
+		}
+		if (memcmp(&fusion, &_fusionUbo->GetData(), sizeof(FusionUniforms)) != 0) {
+			_fusionUbo->SetData(fusion);
+		}
+
+		// Fused effects are timed as part of their host
+		GPU_PROFILE_SCOPE(effect->Name);
+
+		glm::ivec2 size = glm::ivec2(glm::vec2(output->GetSize()) * effect->_outputScale);
+		uint32_t passCount = effect->GetPassCount();
+		Framebuffer::Sptr input = current;
+		for (uint32_t pass = 0; pass < passCount; pass++) {
+			bool isLast = pass == passCount - 1;
+			Framebuffer::Sptr target = _targetPool->Acquire(size, isLast ? effect->_format : effect->_intermediateFormat);
+
 			// Bind the FBO and make sure we're rendering to the whole thing
-			effect->_output->Bind();
-			glViewport(0, 0, effect->_output->GetWidth(), effect->_output->GetHeight());
+			target->Bind();
+			GlStateCache::SetViewport(0, 0, target->GetWidth(), target->GetHeight());
 
 			// Bind color 0 from previous pass to texture slot 0 so our effects can access
 			current->BindAttachment(RenderTargetAttachment::Color0, 0);
+			if (passCount > 1) {
+				input->BindAttachment(RenderTargetAttachment::Color0, EFFECT_INPUT_SLOT);
+			}
+			(isLast ? _fusionUbo : _noFusionUbo)->Bind(FUSION_UBO_BINDING);
 
 			// Apply the effect and render the fullscreen quad
-			effect->Apply(gBuffer);
+			effect->ApplyPass(pass, gBuffer);
 			_quadVAO->Draw();
-
-			// Unbind output and set it as input for next pass
-			effect->_output->Unbind();
-			current = effect->_output;
+			_passCount++;
+
+			// Unbind output, the input is no longer needed so it can go back into the pool. Multi-pass
+			// effects hold on to their own input until their last pass is done
+			target->Unbind();
+			if (current != output && (current != input || passCount == 1)) {
+				_targetPool->Release(current);
+			}
+			current = target;
+		}
+		if (passCount > 1 && input != output) {
+			_targetPool->Release(input);
 		}
 	}
 	_quadVAO->Unbind();
 
 	// Restore viewport to game viewport
-	glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+	GlStateCache::SetViewport(viewport.x, viewport.y, viewport.z, viewport.w);
 
 	// Bind the output of our post processing as the source for the blit
 	current->Bind(FramebufferBinding::Read);
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	GlStateCache::BindFramebuffer(FramebufferBinding::Draw, 0);
 
 	// Blit the color buffer to our game window
 	current->Blit(
@@ -142,6 +189,12 @@ void PostProcessingLayer::OnPostRender()
 	);
 
 	gBuffer->Unbind();
+
+	// All our reads from the last target have been issued, so we can hand it back
+	if (current != output) {
+		_targetPool->Release(current);
+	}
+	_targetPool->EndFrame();
 }
 
 void PostProcessingLayer::OnSceneLoad()
@@ -162,8 +215,11 @@ void PostProcessingLayer::OnWindowResize(const glm::ivec2& oldSize, const glm::i
 {
 	for (const auto& effect : _effects) {
 		effect->OnWindowResize(oldSize, newSize);
-		effect->_output->Resize(newSize.x, newSize.y);
 	}
+
+	// None of the pooled targets will match the new size, so free them now rather
+	// than waiting for them to go idle
+	_targetPool->Clear();
 }
 
 const std::vector<PostProcessingLayer::Effect::Sptr>& PostProcessingLayer::GetEffects() const
@@ -3,6 +3,8 @@
 #include "Application/ApplicationLayer.h"
 #include "Utils/Macros.h"
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/RenderTargetPool.h"
+#include "Graphics/Buffers/UniformBuffer.h"
 
 /**
  * The post processing layer will handle rendering effects after the primary
@@ -12,6 +14,30 @@ class PostProcessingLayer final : public ApplicationLayer {
 public:
 	MAKE_PTRS(PostProcessingLayer);
 
+	/**
+	 * The UBO binding for the fused per-pixel effect parameters (see fragments/post_fusion.glsl)
+	 */
+	static const int FUSION_UBO_BINDING = 4;
+	/**
+	 * The texture slot that a fused color correction LUT is bound to
+	 */
+	static const int FUSED_LUT_SLOT = 7;
+	/**
+	 * The texture slot that the input to a multi-pass effect stays bound to for all of it's
+	 * passes, while slot 0 holds the output of the pass before
+	 */
+	static const int EFFECT_INPUT_SLOT = 6;
+
+	/**
+	 * The parameters for per-pixel effects that have been folded into the last pass of the
+	 * effect before them, must match b_PostFusion in fragments/post_fusion.glsl
+	 */
+	struct FusionUniforms {
+		// The strength of the color correction LUT in FUSED_LUT_SLOT, 0 to disable
+		float LutStrength = 0.0f;
+		float Padding[3] = { 0.0f, 0.0f, 0.0f };
+	};
+
 	/**
 	 * Base class for post processing effects, we extend this to create new effects
 	 */
@@ -33,6 +59,28 @@ public:
 		 * @param gBuffer The G-Buffer from the deferred rendering pipeline
 		 */
 		virtual void Apply(const Framebuffer::Sptr& gBuffer) = 0;
+		/**
+		 * Gets the number of fullscreen passes this effect needs to render (ex: 2 for a
+		 * separable blur). Every pass but the last renders into a target with the
+		 * intermediate format, which is bound to slot 0 for the pass after it. Invoked once
+		 * per frame before the effect's passes, so effects may choose their passes here
+		 */
+		virtual uint32_t GetPassCount() { return 1; }
+		/**
+		 * Overload this in multi-pass effects to set up a single pass, by default this
+		 * forwards to Apply
+		 * @param pass The index of the pass to set up, in the range [0, GetPassCount())
+		 * @param gBuffer The G-Buffer from the deferred rendering pipeline
+		 */
+		virtual void ApplyPass(uint32_t pass, const Framebuffer::Sptr& gBuffer) { Apply(gBuffer); }
+		/**
+		 * Per-pixel effects (ones that only read the input pixel under them) can overload
+		 * this to be folded into the last pass of the enabled effect before them, instead
+		 * of running a fullscreen pass of their own
+		 * @param fusion The fused parameters for the host pass, to be filled in by this effect
+		 * @returns True if the effect was folded in, false if it needs it's own pass
+		 */
+		virtual bool ApplyFused(FusionUniforms& fusion) { return false; }
 		/**
 		 * Allows this effect to perform logic when a new scene is loaded
 		 */
@@ -43,7 +91,8 @@ public:
 		virtual void OnSceneUnload() {}
 		/**
 		 * Allows this effect to perform additional logic when the window is resized
-		 * Note that the output framebuffer will already be resized by the post processing layer
+		 * Note that effects do not own their output, it is allocated from the layer's
+		 * render target pool every frame, so there is nothing to resize here
 		 */
 		virtual void OnWindowResize(const glm::ivec2& oldSize, const glm::ivec2& newSize) {}
 		/**
@@ -61,12 +110,16 @@ public:
 	protected:
 		friend class PostProcessingLayer;
 
-		// The output that this effect will render into
-		Framebuffer::Sptr _output = nullptr;
 		// The scaling between this effect's output and the screen size, default 1
 		glm::vec2 _outputScale = glm::vec2(1);
-		// The render target format for the effect's buffer
+		// The render target format for the effect's output, together with the scale this
+		// is the key used to get a transient target from the layer's pool
 		RenderTargetType _format = RenderTargetType::ColorRgba8;
+		// The format for the outputs of all but the last pass in multi-pass effects
+		RenderTargetType _intermediateFormat = RenderTargetType::ColorRgba16F;
+		// True if the shader for this effect's last pass includes fragments/post_fusion.glsl,
+		// so that per-pixel effects after it can be folded in
+		bool _isFusionHost = false;
 		
 		Effect() = default;
 	};
@@ -99,6 +152,19 @@ public:
 	 */
 	void AddEffect(const Effect::Sptr& effect);
 
+	/**
+	 * Gets the pool that the effects' output targets are allocated from
+	 */
+	const RenderTargetPool::Sptr& GetTargetPool() const { return _targetPool; }
+	/**
+	 * Gets the number of fullscreen passes that were rendered in the last frame
+	 */
+	uint32_t GetPassCount() const { return _passCount; }
+	/**
+	 * Gets the number of effects that were folded into another effect's pass in the last frame
+	 */
+	uint32_t GetFusedCount() const { return _fusedCount; }
+
 	// Inherited from ApplicationLayer
 
 	virtual void OnAppLoad(const nlohmann::json& config) override;
@@ -112,4 +178,14 @@ protected:
 
 	std::vector<Effect::Sptr> _effects;
 	VertexArrayObject::Sptr _quadVAO;
+	// Transient targets for the effects, only the ones needed by passes that are
+	// in flight at the same time are ever resident
+	RenderTargetPool::Sptr _targetPool;
+	// Parameters for the effects fused into the last pass of a host effect, and an
+	// all-zero block for every other pass
+	UniformBuffer<FusionUniforms>::Sptr _fusionUbo;
+	UniformBuffer<FusionUniforms>::Sptr _noFusionUbo;
+
+	uint32_t _passCount = 0;
+	uint32_t _fusedCount = 0;
 };
\ No newline at end of file
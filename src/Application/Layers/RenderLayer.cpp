@@ -8,6 +8,12 @@
 #include "Gameplay/Components/ComponentManager.h"
 #include "Gameplay/Components/RenderComponent.h"
 #include "Gameplay/Components/Light.h"
+#include "Utils/JsonGlmHelpers.h"
+#include "Graphics/GlStateCache.h"
+#include "Graphics/GpuProfiler.h"
+#include "Graphics/RasterizerState.h"
+
+#include <cmath>
 
 // GLM math library
 #include <GLM/glm.hpp>
@@ -22,9 +28,10 @@ RenderLayer::RenderLayer() :
 	ApplicationLayer(),
 	_primaryFBO(nullptr),
 	_blitFbo(true),
-	_frameUniforms(nullptr),
-	_instanceUniforms(nullptr),
+	_frameUniforms(),
+	_uniformRing(nullptr),
 	_renderFlags(RenderFlags::None),
+	_gbufferLayout(GBufferLayout::Full),
 	_clearColor({ 0.1f, 0.1f, 0.1f, 1.0f })
 {
 	Name = "Rendering";
@@ -50,6 +57,17 @@ void RenderLayer::OnPreRender()
 		glm::vec4(0.0f)
 	};
 
+	// Move on to the next segment of our uniform ring, this will only wait if the GPU is
+	// more than a few frames behind us
+	_uniformRing->BeginFrame();
+
+	// Keep the totals from the last frame around for the debug window, and start counting again
+	_lastFrameStats = _frameStats;
+	_frameStats = RenderQueue::Stats();
+	_lastViewStats.swap(_viewStats);
+	_viewStats.clear();
+	_instanceBuffer->Reset();
+
 	_primaryFBO->Bind();
 	// Clear the framebuffer. Note that this also binds and sets the viewport
 	_ClearFramebuffer(_primaryFBO, colors, 4);
@@ -79,9 +97,8 @@ void RenderLayer::OnPreRender()
 		colorLUT->Bind(14);
 	}
 
-	// Here we'll bind all the UBOs to their corresponding slots
-	_frameUniforms->Bind(FRAME_UBO_BINDING);
-	_instanceUniforms->Bind(INSTANCE_UBO_BINDING);
+	// Here we'll bind all the UBOs to their corresponding slots, the frame and instance
+	// uniforms are bound from the ring as they are written
 	_lightingUbo->Bind(LIGHTING_UBO_BINDING);
 
 	// Draw physics debug
@@ -97,21 +114,26 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 	Application& app = Application::Get();
 	
 	// Make sure depth testing and culling are re-enabled
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE); 
-	glDepthMask(true); 
+	DefaultDepthState.Apply();
+	GlStateCache::SetCullMode(CullMode::Back);
 
 	// Disable blending, we want to override any existing colors
-	glDisable(GL_BLEND);
+	GlStateCache::Disable(GL_BLEND);
 
 	// Grab shorthands to the camera and shader from the scene
 	Camera::Sptr camera = app.CurrentScene()->MainCamera;
 
 	// We can now render all our scene elements via the helper function
-	_RenderScene(camera->GetView(), camera->GetProjection(), _primaryFBO->GetSize());
+	{
+		GPU_PROFILE_SCOPE("G-Buffer");
+		_RenderScene(camera->GetView(), camera->GetProjection(), _primaryFBO->GetSize(), camera->GetFrustum(), camera->GetGameObject()->GetName());
+	}
 
 	// Use our cubemap to draw our skybox
-	app.CurrentScene()->DrawSkybox();
+	{
+		GPU_PROFILE_SCOPE("Skybox");
+		app.CurrentScene()->DrawSkybox();
+	}
 
 	VertexArrayObject::Unbind(); 
 }
@@ -129,7 +151,7 @@ void RenderLayer::OnPostRender() {
 	const glm::uvec4& viewport = app.GetPrimaryViewport();
 
 	// Restore viewport to game viewport
-	glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+	GlStateCache::SetViewport(viewport.x, viewport.y, viewport.z, viewport.w);
 
 	// Blit our depth to the primary framebuffer so that other rendering can use it
 	glBlitNamedFramebuffer(
@@ -153,6 +175,18 @@ void RenderLayer::OnPostRender() {
 	_outputBuffer->Unbind();
 }
 
+void RenderLayer::_BindGBuffer()
+{
+	_primaryFBO->BindAttachment(RenderTargetAttachment::Depth, 0);  // depth
+	_primaryFBO->BindAttachment(RenderTargetAttachment::Color0, 1); // albedo + spec
+	_primaryFBO->BindAttachment(RenderTargetAttachment::Color1, 2); // normals + metallic
+	_primaryFBO->BindAttachment(RenderTargetAttachment::Color2, 3); // emissive
+	// The compact layout has no position target, shaders reconstruct it from depth instead
+	if (_gbufferLayout == GBufferLayout::Full) {
+		_primaryFBO->BindAttachment(RenderTargetAttachment::Color3, 4); // view pos
+	}
+}
+
 void RenderLayer::_AccumulateLighting()
 {
 	using namespace Gameplay;
@@ -184,91 +218,84 @@ void RenderLayer::_AccumulateLighting()
 	_lightingFBO->Bind();
 	_ClearFramebuffer(_lightingFBO, colors, 2);
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE); 
+	GlStateCache::Enable(GL_BLEND);
+	GlStateCache::SetBlendFunc(BlendFunc::SrcAlpha, BlendFunc::One);
 
 	// Bind our shader for processing lighting 
 	_lightAccumulationShader->Bind(); 
 
 	// Bind our G-Buffer textures so that they're readable
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Depth)->Bind(0);  // depth
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color0)->Bind(1); // albedo + spec
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color1)->Bind(2); // normals + metallic
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color2)->Bind(3); // emissive
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color3)->Bind(4); // view pos
+	_BindGBuffer();
 
 
 	// Send in how many active lights we have and the global lighting settings
 	data.AmbientCol = glm::vec3(0.1f);
+
+	// Bin all the lights into view space clusters, the forward shaders only support the first
+	// MAX_LIGHTS lights, so we copy those into the UBO as we go
+	_lightClusters->Clear();
 	int ix = 0;
-	app.CurrentScene()->Components().Each<Light>([&](const Light::Sptr& light) {
+	app.CurrentScene()->Components().Each<Light>([&](Light* light) {
 		// Get the light's position in view space, since we're doing view space lighting
 		glm::vec4 pos = glm::vec4(light->GetGameObject()->GetWorldPosition(), 1.0f);
 		pos = view * pos;
 
-		// Copy to the ubo data
-		data.Lights[ix].Position = (glm::vec3)(pos) / pos.w;
-		data.Lights[ix].Intensity = light->GetIntensity();
-		data.Lights[ix].Color = light->GetColor();
-		data.Lights[ix].Attenuation = 1.0f / (1.0f + light->GetRadius());  
-
-		ix++;
-
-		// If we've reached the max # of lights the shader supports, draw to the screen and start the next batch
-		if (ix == MAX_LIGHTS) {
-			data.NumLights = MAX_LIGHTS;
+		glm::vec3 viewPos = (glm::vec3)(pos) / pos.w;
+		float attenuation = 1.0f / (1.0f + light->GetRadius());
+		_lightClusters->AddLight(viewPos, light->GetColor(), light->GetIntensity(), attenuation);
 
-			// Send updated data to OpenGL
-			_lightingUbo->Update();
-
-			// Draw the fullscreen quad to accumulate the lights
-			_fullscreenQuad->Draw();
-
-			ix = 0;
+		if (ix < MAX_LIGHTS) {
+			data.Lights[ix].Position = viewPos;
+			data.Lights[ix].Intensity = light->GetIntensity();
+			data.Lights[ix].Color = light->GetColor();
+			data.Lights[ix].Attenuation = attenuation;
+			ix++;
 		}
 	});
+	data.NumLights = ix;
 
-	// If we have lights left over that haven't been drawn, draw them now
-	if (ix > 0) {
-		data.NumLights = ix;
+	// Send updated data to OpenGL
+	_lightingUbo->Update();
 
-		// Send updated data to OpenGL
-		_lightingUbo->Update();
+	_lightClusters->Build(camera->GetProjection(), camera->GetNearPlane(), camera->GetFarPlane());
 
-		// Draw the fullscreen quad to accumulate the lights
+	// Every light is handled in a single pass, each pixel only loops over the lights in it's cluster
+	if (_lightClusters->GetLightCount() > 0) {
+		GPU_PROFILE_SCOPE("Lights");
+		_lightClusters->Bind(_lightAccumulationShader);
 		_fullscreenQuad->Draw();
 	}
 
-	// Re-render the scene for shadows
-	app.CurrentScene()->Components().Each<ShadowCamera>([&](const ShadowCamera::Sptr& shadowCam) {
-		// Bind the shadow camera's depth buffer and clear it
-		shadowCam->GetDepthBuffer()->Bind();
-		glClear(GL_DEPTH_BUFFER_BIT);
-		glViewport(0, 0, shadowCam->GetBufferResolution().x, shadowCam->GetBufferResolution().y);
-
-		_RenderScene(shadowCam->GetGameObject()->GetInverseTransform(), shadowCam->GetProjection(), shadowCam->GetDepthBuffer()->GetSize());
-
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-	});
+	// Render the shadow casters for each light, lights whose casters haven't changed will keep
+	// their shadow maps from the previous frame
+	std::unordered_map<Guid, ShadowCacheEntry> shadowCache;
+	{
+		GPU_PROFILE_SCOPE("Shadow Maps");
+		app.CurrentScene()->Components().Each<ShadowCamera>([&](ShadowCamera* shadowCam) {
+			GPU_PROFILE_SCOPE(shadowCam->GetGameObject()->GetName());
+			ShadowCacheEntry entry = _shadowCache[shadowCam->GetGUID()];
+			_RenderShadowCasters(shadowCam, entry);
+			shadowCache[shadowCam->GetGUID()] = entry;
+		});
+	}
+	// Dropping lights that weren't rendered this frame, so we don't hang on to deleted ones
+	_shadowCache.swap(shadowCache);
 
 	// Restore frame level uniforms
 	_InitFrameUniforms();
 
 	_lightingFBO->Bind();
-	glViewport(0, 0, _lightingFBO->GetWidth(), _lightingFBO->GetHeight());
+	GlStateCache::SetViewport(0, 0, _lightingFBO->GetWidth(), _lightingFBO->GetHeight());
 
 	// Bind our G-Buffer textures so that they're readable
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Depth)->Bind(0);  // depth
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color0)->Bind(1); // albedo + spec
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color1)->Bind(2); // normals + metallic
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color2)->Bind(3); // emissive
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color3)->Bind(4); // view pos
+	_BindGBuffer();
 
 	// Bind shadow composite shader
+	GPU_PROFILE_SCOPE("Shadow Lights");
 	_shadowShader->Bind();
 
 	// Add each shadow casting light to the lighting buffers
-	app.CurrentScene()->Components().Each<ShadowCamera>([&](const ShadowCamera::Sptr& shadowCam) {
+	app.CurrentScene()->Components().Each<ShadowCamera>([&](ShadowCamera* shadowCam) {
 
 		// This gets us the light -> view space matrix, which we'll inverse to go from view space to light space
 		glm::mat4 lightSpaceMatrix = camera->GetView() * shadowCam->GetGameObject()->GetTransform();
@@ -287,20 +314,20 @@ void RenderLayer::_AccumulateLighting()
 		}
 
 		//_shadowShader->SetUniformMatrix("u_ClipToShadow", clipToShadow); 
-		_shadowShader->SetUniformMatrix("u_ViewToShadow", viewToShadow); 
+		_shadowShader->SetUniform(_shadowUniforms.ViewToShadow, viewToShadow);
 
 		// Get color and normalize it (strip the alpha)
 		glm::vec4 color = shadowCam->GetColor();
 		color *= color.w;
 
-		_shadowShader->SetUniform("u_LightDirViewspace", lightDirViewSpace);
-		_shadowShader->SetUniform("u_ShadowBias", shadowCam->Bias);
-		_shadowShader->SetUniform("u_NormalBias", shadowCam->NormalBias);
-		_shadowShader->SetUniform("u_Attenuation", 1/shadowCam->Range);
-		_shadowShader->SetUniform("u_Intensity", shadowCam->Intensity);
-		_shadowShader->SetUniform("u_LightColor", (glm::vec3)color);
-		_shadowShader->SetUniform("u_LightPosViewspace", lightPosViewSpace);
-		_shadowShader->SetUniform("u_ShadowFlags", *shadowCam->Flags);
+		_shadowShader->SetUniform(_shadowUniforms.LightDirViewspace, lightDirViewSpace);
+		_shadowShader->SetUniform(_shadowUniforms.ShadowBias, shadowCam->Bias);
+		_shadowShader->SetUniform(_shadowUniforms.NormalBias, shadowCam->NormalBias);
+		_shadowShader->SetUniform(_shadowUniforms.Attenuation, 1/shadowCam->Range);
+		_shadowShader->SetUniform(_shadowUniforms.Intensity, shadowCam->Intensity);
+		_shadowShader->SetUniform(_shadowUniforms.LightColor, (glm::vec3)color);
+		_shadowShader->SetUniform(_shadowUniforms.LightPosViewspace, lightPosViewSpace);
+		_shadowShader->SetUniform(_shadowUniforms.ShadowFlags, *shadowCam->Flags);
 
 		// Draw the fullscreen quad to accumulate the lights
 		_fullscreenQuad->Draw();
@@ -317,19 +344,23 @@ void RenderLayer::_Composite()
 
 	Scene::Sptr& scene = app.CurrentScene();
 
-	_AccumulateLighting();
+	{
+		GPU_PROFILE_SCOPE("Lighting");
+		_AccumulateLighting();
+	}
 
 	// We want to switch to our compositing shader
+	GPU_PROFILE_SCOPE("Composite");
 	_compositingShader->Bind();
 
 	// Switch rendering to output
 	_outputBuffer->Bind();
-	glViewport(0, 0, _outputBuffer->GetWidth(), _outputBuffer->GetHeight());
+	GlStateCache::SetViewport(0, 0, _outputBuffer->GetWidth(), _outputBuffer->GetHeight());
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	// Disable blending, we want to override any existing colors
-	glDisable(GL_BLEND);
+	GlStateCache::Disable(GL_BLEND);
 
 	// Bind our albedo and lighting buffers so we can composite a final scene
 	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color0)->Bind(0);
@@ -340,7 +371,7 @@ void RenderLayer::_Composite()
 	_fullscreenQuad->Draw(); 
 
 	// Re-enable depth testing
-	glEnable(GL_DEPTH_TEST);
+	GlStateCache::Enable(GL_DEPTH_TEST);
 
 	// Blit our depth from primary FBO to our output depth buffer
 	glBlitNamedFramebuffer(
@@ -358,27 +389,25 @@ void RenderLayer::_Composite()
 }
 
 void RenderLayer::_ClearFramebuffer(Framebuffer::Sptr& buffer, const glm::vec4* colors, int layers) {
+	// We write depth, but ignore the existing values
+	static const DepthState clearDepthState = { true, true, DepthFunc::Always };
+
 	// Make the entire buffer visible
-	glViewport(0, 0, buffer->GetWidth(), buffer->GetHeight());
-	// Disable depth testing
-	glEnable(GL_DEPTH_TEST); 
-	// Enable depth writing
-	glDepthMask(true);
+	GlStateCache::SetViewport(0, 0, buffer->GetWidth(), buffer->GetHeight());
+	clearDepthState.Apply();
 	// Disable blending, we want to override the colors
-	glDisable(GL_BLEND);
-	// Ignore existing depth
-	glDepthFunc(GL_ALWAYS);
+	GlStateCache::Disable(GL_BLEND);
 
 	// Bind the buffer so we're writing to it
 	buffer->Bind();
 
 	// Bind our clear shader, and draw a fullscreen quad with all the clear colors
 	_clearShader->Bind();
-	_clearShader->SetUniform<glm::vec4>("ClearColors", colors, layers);
+	_clearShader->SetUniform(_clearColorsUniform, colors, layers);
 	_fullscreenQuad->Draw();
 
 	// Reset depth test function to default
-	glDepthFunc(GL_LESS);
+	GlStateCache::SetDepthFunc(DepthFunc::Less);
 }
 
 void RenderLayer::OnWindowResize(const glm::ivec2& oldSize, const glm::ivec2& newSize)
@@ -400,9 +429,14 @@ void RenderLayer::OnAppLoad(const nlohmann::json& config)
 	Application& app = Application::Get();
 
 	// GL states, we'll enable depth testing and backface fulling
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	GlStateCache::Enable(GL_DEPTH_TEST);
+	GlStateCache::SetCullMode(CullMode::Back);
+
+	// The G-Buffer layout can only be picked at load, since all the attachments depend on it
+	if (config.contains(Name)) {
+		_gbufferLayout = JsonParseEnum(GBufferLayout, config[Name], "gbuffer_layout", GBufferLayout::Full);
+	}
+	LOG_INFO("Using {} G-Buffer layout", ~_gbufferLayout);
 
 	// Create a new descriptor for our FBO
 	FramebufferDescriptor fboDescriptor;
@@ -413,12 +447,15 @@ void RenderLayer::OnAppLoad(const nlohmann::json& config)
 	fboDescriptor.RenderTargets[RenderTargetAttachment::Depth] = RenderTargetDescriptor(RenderTargetType::Depth32);
 	// Color layer 0 (albedo, specular)
 	fboDescriptor.RenderTargets[RenderTargetAttachment::Color0] = RenderTargetDescriptor(RenderTargetType::ColorRgba8);
-	// Color layer 1 (normals, metallic)
-	fboDescriptor.RenderTargets[RenderTargetAttachment::Color1] = RenderTargetDescriptor(RenderTargetType::ColorRgba8);
+	// Color layer 1 (normals, metallic), the compact layout stores octahedral normals with 10 bits per component
+	fboDescriptor.RenderTargets[RenderTargetAttachment::Color1] = RenderTargetDescriptor(
+		_gbufferLayout == GBufferLayout::Compact ? RenderTargetType::ColorRgb10A2 : RenderTargetType::ColorRgba8);
 	// Color layer 2 (emissive)  
 	fboDescriptor.RenderTargets[RenderTargetAttachment::Color2] = RenderTargetDescriptor(RenderTargetType::ColorRgba8);
-	// Color layer 3 (view space position)  
-	fboDescriptor.RenderTargets[RenderTargetAttachment::Color3] = RenderTargetDescriptor(RenderTargetType::ColorRgba16F);
+	// Color layer 3 (view space position), the compact layout reconstructs this from depth
+	if (_gbufferLayout == GBufferLayout::Full) {
+		fboDescriptor.RenderTargets[RenderTargetAttachment::Color3] = RenderTargetDescriptor(RenderTargetType::ColorRgba16F);
+	}
 	 
 	// Create the primary FBO
 	_primaryFBO = std::make_shared<Framebuffer>(fboDescriptor);
@@ -451,11 +488,34 @@ void RenderLayer::OnAppLoad(const nlohmann::json& config)
 	_clearShader->LoadShaderPartFromFile("shaders/vertex_shaders/fullscreen_quad.glsl", ShaderPartType::Vertex);
 	_clearShader->LoadShaderPartFromFile("shaders/fragment_shaders/clear.glsl", ShaderPartType::Fragment);
 	_clearShader->Link();
+	_clearColorsUniform = _clearShader->GetUniformHandle<glm::vec4>("ClearColors");
 
 	_shadowShader = ShaderProgram::Create();
 	_shadowShader->LoadShaderPartFromFile("shaders/vertex_shaders/fullscreen_quad.glsl", ShaderPartType::Vertex);
 	_shadowShader->LoadShaderPartFromFile("shaders/fragment_shaders/shadow_composite.glsl", ShaderPartType::Fragment);
 	_shadowShader->Link();
+	_shadowUniforms.ViewToShadow      = _shadowShader->GetUniformHandle<glm::mat4>("u_ViewToShadow");
+	_shadowUniforms.LightDirViewspace = _shadowShader->GetUniformHandle<glm::vec3>("u_LightDirViewspace");
+	_shadowUniforms.LightPosViewspace = _shadowShader->GetUniformHandle<glm::vec3>("u_LightPosViewspace");
+	_shadowUniforms.LightColor        = _shadowShader->GetUniformHandle<glm::vec3>("u_LightColor");
+	_shadowUniforms.ShadowBias        = _shadowShader->GetUniformHandle<float>("u_ShadowBias");
+	_shadowUniforms.NormalBias        = _shadowShader->GetUniformHandle<float>("u_NormalBias");
+	_shadowUniforms.Attenuation       = _shadowShader->GetUniformHandle<float>("u_Attenuation");
+	_shadowUniforms.Intensity         = _shadowShader->GetUniformHandle<float>("u_Intensity");
+	_shadowUniforms.ShadowFlags       = _shadowShader->GetUniformHandle<uint32_t>("u_ShadowFlags");
+
+	// Shared shaders for the shadow caster pass
+	_depthOnlyShader = ShaderProgram::Create();
+	_depthOnlyShader->LoadShaderPartFromFile("shaders/vertex_shaders/depth_only.glsl", ShaderPartType::Vertex);
+	_depthOnlyShader->LoadShaderPartFromFile("shaders/fragment_shaders/depth_only.glsl", ShaderPartType::Fragment);
+	_depthOnlyShader->Link();
+	_depthOnlyMaterial = std::make_shared<Gameplay::Material>(_depthOnlyShader);
+	_depthOnlyMaterial->Name = "Depth Only";
+
+	_depthAlphaTestShader = ShaderProgram::Create();
+	_depthAlphaTestShader->LoadShaderPartFromFile("shaders/vertex_shaders/depth_only.glsl", ShaderPartType::Vertex);
+	_depthAlphaTestShader->LoadShaderPartFromFile("shaders/fragment_shaders/depth_alpha_test.glsl", ShaderPartType::Fragment);
+	_depthAlphaTestShader->Link();
 
 	// We need a mesh for drawing fullscreen quads
 
@@ -473,9 +533,10 @@ void RenderLayer::OnAppLoad(const nlohmann::json& config)
 	});
 
 	// Create our common uniform buffers
-	_frameUniforms = std::make_shared<UniformBuffer<FrameLevelUniforms>>(BufferUsage::DynamicDraw);
-	_instanceUniforms = std::make_shared<UniformBuffer<InstanceLevelUniforms>>(BufferUsage::DynamicDraw);
+	_uniformRing = std::make_shared<UniformRingBuffer>();
+	_instanceBuffer = std::make_shared<InstanceBuffer>();
 	_lightingUbo = std::make_shared<UniformBuffer<LightingUboStruct>>(BufferUsage::DynamicDraw);
+	_lightClusters = std::make_shared<LightClusters>();
 }
 
 const Framebuffer::Sptr& RenderLayer::GetPrimaryFBO() const {
@@ -528,6 +589,16 @@ const Framebuffer::Sptr& RenderLayer::GetGBuffer() const
 	return _primaryFBO;
 }
 
+GBufferLayout RenderLayer::GetGBufferLayout() const {
+	return _gbufferLayout;
+}
+
+nlohmann::json RenderLayer::GetDefaultConfig() {
+	nlohmann::json result;
+	result["gbuffer_layout"] = ~GBufferLayout::Full;
+	return result;
+}
+
 void RenderLayer::_InitFrameUniforms()
 {
 	using namespace Gameplay;
@@ -542,7 +613,7 @@ void RenderLayer::_InitFrameUniforms()
 	glm::mat4 view = camera->GetView();
 
 	// Upload frame level uniforms
-	auto& frameData = _frameUniforms->GetData();
+	FrameLevelUniforms& frameData = _frameUniforms;
 	frameData.u_Projection = camera->GetProjection();
 	frameData.u_InvProjection = glm::inverse(camera->GetProjection());
 	frameData.u_View = camera->GetView();
@@ -551,6 +622,9 @@ void RenderLayer::_InitFrameUniforms()
 	frameData.u_Time = static_cast<float>(Timing::Current().TimeSinceSceneLoad());
 	frameData.u_DeltaTime = Timing::Current().DeltaTime();
 	frameData.u_RenderFlags = _renderFlags;
+	if (_gbufferLayout == GBufferLayout::Compact) {
+		frameData.u_RenderFlags = frameData.u_RenderFlags | RenderFlags::CompactGBuffer;
+	}
 	frameData.u_ZNear = camera->GetNearPlane();
 	frameData.u_ZFar = camera->GetFarPlane();
 	frameData.u_Viewport = { 0.0f, 0.0f, _primaryFBO->GetWidth(), _primaryFBO->GetHeight() };
@@ -558,33 +632,58 @@ void RenderLayer::_InitFrameUniforms()
 	frameData.u_Aperture   = camera->Aperture;
 	frameData.u_LensDepth  = camera->LensDepth;
 	frameData.u_FocalDepth = camera->FocalDepth;
-	_frameUniforms->Update();
+	_uniformRing->BindRange(FRAME_UBO_BINDING, _uniformRing->Write(frameData));
+}
+
+// Used to normalize view depth for the sort keys. This recovers the far plane from a perspective
+// projection, for orthographic projections it's only approximate, but it only affects ordering
+static float RecoverFarPlane(const glm::mat4& projection) {
+	float farPlane = glm::abs(projection[3][2] / (projection[2][2] + 1.0f));
+	if (!std::isfinite(farPlane) || farPlane <= 0.0f) {
+		farPlane = 1000.0f;
+	}
+	return farPlane;
+}
+
+// Folds some bytes into an FNV-1a hash
+static void HashBytes(uint64_t& hash, const void* data, size_t size) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t ix = 0; ix < size; ix++) {
+		hash ^= bytes[ix];
+		hash *= 0x100000001B3ull;
+	}
 }
 
-void RenderLayer::_RenderScene(const glm::mat4& view, const glm::mat4& projection, const glm::ivec2& screenSize)
+void RenderLayer::_WriteViewUniforms(const glm::mat4& view, const glm::mat4& projection, const glm::ivec2& screenSize)
+{
+	// Override the camera parameters for this view, the main camera's will be restored by _InitFrameUniforms
+	FrameLevelUniforms frameData = _frameUniforms;
+	frameData.u_Projection = projection;
+	frameData.u_View = view;
+	frameData.u_ViewProjection = projection * view;
+	frameData.u_CameraPos = view * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	frameData.u_Viewport = { 0.0f, 0.0f, screenSize.x, screenSize.y };
+	_uniformRing->BindRange(FRAME_UBO_BINDING, _uniformRing->Write(frameData));
+}
+
+void RenderLayer::_RenderScene(const glm::mat4& view, const glm::mat4& projection, const glm::ivec2& screenSize, const Frustum& frustum, const std::string& viewName)
 {
 	using namespace Gameplay;
 
 	Application& app = Application::Get();
 
-	glm::mat4 viewProj = projection * view;
-
-	// The current material that is bound for rendering
-	Material::Sptr currentMat = nullptr;
-	ShaderProgram::Sptr shader = nullptr;
-
 	Material::Sptr defaultMat = app.CurrentScene()->DefaultMaterial;
 
-	auto& frameData = _frameUniforms->GetData();
-	frameData.u_Projection = projection;
-	frameData.u_View = view;
-	frameData.u_ViewProjection = viewProj;
-	frameData.u_CameraPos = view * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
-	frameData.u_Viewport = { 0.0f, 0.0f, screenSize.x, screenSize.y };
-	_frameUniforms->Update();
+	_WriteViewUniforms(view, projection, screenSize);
+	float farPlane = RecoverFarPlane(projection);
+
+	// Objects outside of the view's frustum are rejected before they ever make it into the queue
+	ViewStats viewStats;
+	viewStats.Name = viewName;
 
-	// Render all our objects
-	app.CurrentScene()->Components().Each<RenderComponent>([&](const RenderComponent::Sptr& renderable) {
+	// Gather all our objects into the render queue
+	_renderQueue.Clear();
+	app.CurrentScene()->Components().Each<RenderComponent>([&](RenderComponent* renderable) {
 		// Early bail if mesh not set
 		if (renderable->GetMesh() == nullptr) {
 			return;
@@ -601,35 +700,255 @@ void RenderLayer::_RenderScene(const glm::mat4& view, const glm::mat4& projectio
 			}
 		}
 
-		// If the material has changed, we need to bind the new shader and set up our material and frame data
-		// Note: This is a good reason why we should be sorting the render components in ComponentManager
-		if (renderable->GetMaterial() != currentMat) {
-			currentMat = renderable->GetMaterial();
-			shader = currentMat->GetShader();
-
-			shader->Bind();
-			currentMat->Apply();
+		// Materials without shaders can't be drawn
+		if (renderable->GetMaterial()->GetShader() == nullptr) {
+			return;
 		}
 
-		// Grab the game object so we can do some stuff with it
+		// Grab the game object so we can determine how far it is from the camera
 		GameObject* object = renderable->GetGameObject();
+		const glm::mat4& transform = object->GetTransform();
+
+		if (!_IsInFrustum(renderable, transform, frustum, viewStats)) {
+			return;
+		}
+
+		float viewDepth = -(view * transform[3]).z;
+
+		// Make sure the mesh can read from the instance buffer in case it ends up in a batch
+		VertexArrayObject* mesh = renderable->GetMesh().get();
+		_instanceBuffer->AttachTo(mesh);
 
-		// Use our uniform buffer for our instance level uniforms
-		auto& instanceData = _instanceUniforms->GetData();
-		instanceData.u_Model = object->GetTransform();
-		instanceData.u_ModelViewProjection = viewProj * object->GetTransform();
-		instanceData.u_ModelView = view * object->GetTransform();
-		instanceData.u_NormalMatrix = glm::mat3(glm::transpose(glm::inverse(object->GetTransform())));
-		_instanceUniforms->Update();
+		_renderQueue.Push(RenderPass::Opaque, renderable->GetMaterial().get(), mesh, transform, viewDepth / farPlane);
+	});
+
+	_SubmitRenderQueue(_renderQueue, view, projection * view);
+	_viewStats.push_back(viewStats);
+}
+
+bool RenderLayer::_IsInFrustum(RenderComponent* renderable, const glm::mat4& transform, const Frustum& frustum, ViewStats& stats)
+{
+	// Test the mesh's bounding sphere against the frustum. The bounds are from the mesh's rest pose, so
+	// we grow them by however far the shader says it can move vertices around (ex: wind, displacement)
+	const BoundingVolume& bounds = renderable->GetMeshResource()->Bounds;
+	float margin = renderable->GetMaterial()->GetShader()->GetDisplacementMargin();
+	if (bounds.IsValid && margin >= 0.0f) {
+		glm::vec3 center;
+		float radius;
+		bounds.TransformSphere(transform, center, radius, margin);
+
+		stats.ObjectsTested++;
+		if (!frustum.IntersectsSphere(center, radius)) {
+			stats.ObjectsCulled++;
+			return false;
+		}
+	} else {
+		stats.ObjectsUnbounded++;
+	}
+	return true;
+}
+
+void RenderLayer::_SubmitRenderQueue(RenderQueue& queue, const glm::mat4& view, const glm::mat4& viewProj)
+{
+	// Sort so that draws sharing a shader, material and mesh end up next to each other
+	queue.Sort();
+
+	// Instanced batches all share a single block, since they only need the flag
+	UniformRingBuffer::Allocation instancedBlock;
+	queue.Submit(
+		[&](const RenderQueue::DrawPacket& packet) {
+			// Write our instance level uniforms straight into the ring. The mapped memory is write-combined,
+			// so we fill in every field in order and never read it back
+			UniformRingBuffer::Allocation block = _uniformRing->Allocate(sizeof(InstanceLevelUniforms));
+			InstanceLevelUniforms* instanceData = static_cast<InstanceLevelUniforms*>(block.Data);
+			instanceData->u_ModelViewProjection = viewProj * packet.Transform;
+			instanceData->u_Model = packet.Transform;
+			instanceData->u_ModelView = view * packet.Transform;
+			instanceData->u_NormalMatrix = glm::mat3(glm::transpose(glm::inverse(packet.Transform)));
+			instanceData->u_IsInstanced = 0;
+			_uniformRing->BindRange(INSTANCE_UBO_BINDING, block);
+		},
+		[&](const std::vector<const RenderQueue::DrawPacket*>& batch) {
+			// Stream the transforms into the instance buffer, only the ones that differ from
+			// what is already on the GPU will actually be uploaded
+			uint32_t baseInstance = _instanceBuffer->Allocate(static_cast<uint32_t>(batch.size()));
+			for (uint32_t ix = 0; ix < batch.size(); ix++) {
+				_instanceBuffer->Write(baseInstance + ix, batch[ix]->Transform);
+			}
+			_instanceBuffer->Flush();
+
+			// Let the shader know to pull its matrices from the instance attributes
+			if (instancedBlock.Data == nullptr) {
+				InstanceLevelUniforms flags = InstanceLevelUniforms();
+				flags.u_IsInstanced = 1;
+				instancedBlock = _uniformRing->Write(flags);
+			}
+			_uniformRing->BindRange(INSTANCE_UBO_BINDING, instancedBlock);
+			return baseInstance;
+		}
+	);
+
+	_frameStats += queue.GetStats();
+}
+
+void RenderLayer::_RenderShadowCasters(ShadowCamera* shadowCam, ShadowCacheEntry& cache)
+{
+	using namespace Gameplay;
+
+	Application& app = Application::Get();
+
+	const glm::mat4& view = shadowCam->GetGameObject()->GetInverseTransform();
+	const glm::mat4& projection = shadowCam->GetProjection();
+	const Framebuffer::Sptr& depthBuffer = shadowCam->GetDepthBuffer();
+	Frustum frustum = shadowCam->GetFrustum();
+	float farPlane = RecoverFarPlane(projection);
+
+	ViewStats viewStats;
+	viewStats.Name = shadowCam->GetGameObject()->GetName();
+
+	// Anything that could change the contents of the shadow map goes into the signature
+	uint64_t signature = 0xCBF29CE484222325ull;
+	glm::mat4 viewProj = projection * view;
+	glm::ivec2 size = depthBuffer->GetSize();
+	const Framebuffer* depthBufferPtr = depthBuffer.get();
+	HashBytes(signature, &viewProj, sizeof(glm::mat4));
+	HashBytes(signature, &size, sizeof(glm::ivec2));
+	HashBytes(signature, &depthBufferPtr, sizeof(const Framebuffer*));
+
+	// Gather the casters within the light's frustum. Dynamic casters are kept out of the signature,
+	// they are drawn every frame on top of the static ones
+	_renderQueue.Clear();
+	_dynamicCasterQueue.Clear();
+	app.CurrentScene()->Components().Each<RenderComponent>([&](RenderComponent* renderable) {
+		if (renderable->GetMesh() == nullptr || renderable->GetMaterial() == nullptr || renderable->GetMaterial()->GetShader() == nullptr) {
+			return;
+		}
+
+		const glm::mat4& transform = renderable->GetGameObject()->GetTransform();
+		if (!_IsInFrustum(renderable, transform, frustum, viewStats)) {
+			return;
+		}
+
+		Material* source = renderable->GetMaterial().get();
+		VertexArrayObject* mesh = renderable->GetMesh().get();
+		bool casterIsDynamic = false;
+		Material* material = _GetShadowMaterial(source, casterIsDynamic);
+
+		_instanceBuffer->AttachTo(mesh);
+		float viewDepth = -(view * transform[3]).z;
+		if (casterIsDynamic) {
+			_dynamicCasterQueue.Push(RenderPass::Opaque, material, mesh, transform, viewDepth / farPlane);
+			return;
+		}
 
-		// Draw the object
-		renderable->GetMesh()->Draw();
+		HashBytes(signature, &source, sizeof(Material*));
+		HashBytes(signature, &mesh, sizeof(VertexArrayObject*));
+		HashBytes(signature, &transform, sizeof(glm::mat4));
+
+		// Alpha tested casters also depend on the cutout settings copied from the source material. We hash
+		// the albedo's GL handle rather than the texture, since it changes when a streamed texture replaces
+		// it's placeholder, and a shadow drawn with the opaque placeholder would never discard anything
+		if (material != source && material != _depthOnlyMaterial.get()) {
+			float threshold = material->Get<float>("u_Material.DiscardThreshold", 0.0f);
+			uint32_t albedoHandle = material->GetTexture("u_Material.AlbedoMap")->GetHandle();
+			HashBytes(signature, &threshold, sizeof(float));
+			HashBytes(signature, &albedoHandle, sizeof(uint32_t));
+		}
 
+		_renderQueue.Push(RenderPass::Opaque, material, mesh, transform, viewDepth / farPlane);
 	});
 
+	const glm::ivec2& resolution = shadowCam->GetBufferResolution();
+	if (_dynamicCasterQueue.Size() == 0) {
+		// If no static casters have changed since we last drew this light, the shadow map is still valid. If
+		// we had a static copy, the shadow map also has last frame's dynamic casters in it and must be re-drawn
+		viewStats.IsCached = cache.IsValid && cache.StaticDepth == nullptr && cache.Signature == signature;
+		cache.StaticDepth = nullptr;
+		if (!viewStats.IsCached) {
+			// Bind the shadow camera's depth buffer and clear it
+			depthBuffer->Bind();
+			GlStateCache::SetViewport(0, 0, resolution.x, resolution.y);
+			glClear(GL_DEPTH_BUFFER_BIT);
+
+			_WriteViewUniforms(view, projection, size);
+			_SubmitRenderQueue(_renderQueue, view, viewProj);
+
+			cache.IsValid = true;
+			cache.Signature = signature;
+		}
+	} else {
+		// The static casters are cached in their own buffer, so only the dynamic ones are re-drawn every frame
+		viewStats.IsCached = cache.IsValid && cache.StaticDepth != nullptr && cache.Signature == signature;
+		_WriteViewUniforms(view, projection, size);
+		if (!viewStats.IsCached) {
+			if (cache.StaticDepth == nullptr) {
+				cache.StaticDepth = depthBuffer->Clone();
+				cache.StaticDepth->SetDebugName(viewStats.Name + " (static casters)");
+			}
+			cache.StaticDepth->Resize(size);
+
+			cache.StaticDepth->Bind();
+			GlStateCache::SetViewport(0, 0, resolution.x, resolution.y);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			_SubmitRenderQueue(_renderQueue, view, viewProj);
+
+			cache.IsValid = true;
+			cache.Signature = signature;
+		}
+
+		// Restore the static casters, then draw the dynamic ones over them
+		Framebuffer::Blit(cache.StaticDepth, depthBuffer, BufferFlags::Depth, MagFilter::Nearest);
+		depthBuffer->Bind();
+		GlStateCache::SetViewport(0, 0, resolution.x, resolution.y);
+		_SubmitRenderQueue(_dynamicCasterQueue, view, viewProj);
+	}
+
+	GlStateCache::BindFramebuffer(FramebufferBinding::Draw, 0);
+	_viewStats.push_back(viewStats);
+}
+
+Gameplay::Material* RenderLayer::_GetShadowMaterial(Gameplay::Material* material, bool& isDynamic)
+{
+	using namespace Gameplay;
+
+	// Shaders that move vertices around (ex: wind, displacement) need to use their own shader to get
+	// matching shadows, and may animate over time so we can't cache them
+	if (!material->GetShader()->GetIsDepthCompatible()) {
+		isDynamic = true;
+		return material;
+	}
+
+	// Materials that discard fragments need to do so in the shadow pass as well
+	float threshold = material->Get<float>("u_Material.DiscardThreshold", 0.0f);
+	ITexture::Sptr albedo = material->GetTexture("u_Material.AlbedoMap");
+	if (threshold > 0.0f && albedo != nullptr) {
+		Material::Sptr& result = _alphaTestMaterials[material->GetGUID()];
+		if (result == nullptr) {
+			result = std::make_shared<Material>(_depthAlphaTestShader);
+			result->Name = material->Name + " (shadow)";
+		}
+		// These are cheap to set, and keep us in sync if the source material is edited
+		result->Set("u_Material.AlbedoMap", albedo);
+		result->Set("u_Material.DiscardThreshold", threshold);
+		return result.get();
+	}
+
+	return _depthOnlyMaterial.get();
+}
+
+const RenderQueue::Stats& RenderLayer::GetRenderStats() const {
+	return _lastFrameStats;
+}
+
+const std::vector<RenderLayer::ViewStats>& RenderLayer::GetViewStats() const {
+	return _lastViewStats;
+}
+
+const LightClusters::Sptr& RenderLayer::GetLightClusters() const {
+	return _lightClusters;
 }
 
-const UniformBuffer<RenderLayer::FrameLevelUniforms>::Sptr& RenderLayer::GetFrameUniforms() const
+const RenderLayer::FrameLevelUniforms& RenderLayer::GetFrameUniforms() const
 {
 	return _frameUniforms;
 }
@@ -2,9 +2,21 @@
 #include "../ApplicationLayer.h"
 #include "Graphics/Framebuffer.h"
 #include "Graphics/Buffers/UniformBuffer.h"
+#include "Graphics/Buffers/UniformRingBuffer.h"
 #include "Graphics/ShaderProgram.h"
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/RenderQueue.h"
+#include "Graphics/InstanceBuffer.h"
+#include "Graphics/Frustum.h"
+#include "Graphics/LightClusters.h"
+#include "Gameplay/Material.h"
 
+#include <unordered_map>
+
+class RenderComponent;
+class ShadowCamera;
+
+// The number of lights available to forward rendered shaders, deferred lighting uses LightClusters instead
 #define MAX_LIGHTS 8
 
 ENUM_FLAGS(RenderFlags, uint32_t,
@@ -12,13 +24,42 @@ ENUM_FLAGS(RenderFlags, uint32_t,
 	DisableAmbient = 1 << 0,
 	DisableSpecular = 1 << 1,
 	DisableDiffuse = 1 << 2,
-	EnableColorCorrection = 1 << 3
+	EnableColorCorrection = 1 << 3,
+	// Set automatically when using the compact G-Buffer layout, see gbuffer_normals.glsl
+	CompactGBuffer = 1 << 4
+);
+
+/// <summary>
+/// The layouts available for the G-Buffer, selected with the "gbuffer_layout" setting
+///
+/// Full:    RGBA8 albedo/spec, RGBA8 normals/metallic, RGBA8 emissive, RGBA16F view position, 32 bit depth
+/// Compact: RGBA8 albedo/spec, RGB10A2 octahedral normals/metallic, RGBA8 emissive, 32 bit depth,
+///          with view position reconstructed from depth and the inverse projection
+/// </summary>
+ENUM(GBufferLayout, uint32_t,
+	Full    = 0,
+	Compact = 1
 );
 
 class RenderLayer final : public ApplicationLayer {
 public:
 	MAKE_PTRS(RenderLayer); 
 
+	/// <summary>
+	/// Culling results for a single view (camera or shadow camera) rendered during a frame
+	/// </summary>
+	struct ViewStats {
+		std::string Name;
+		// The number of renderables that were tested against the view's frustum
+		uint32_t    ObjectsTested = 0;
+		// The number of renderables that were rejected by the frustum test
+		uint32_t    ObjectsCulled = 0;
+		// Renderables with no bounds are always drawn
+		uint32_t    ObjectsUnbounded = 0;
+		// True if the view's contents were unchanged, and it's previous results were re-used
+		bool        IsCached = false;
+	};
+
 	// Structure for our frame-level uniforms, matches layout from
 	// fragments/frame_uniforms.glsl
 	// For use with a UBO.
@@ -68,6 +109,11 @@ public:
 		glm::mat4 u_ModelView;
 		// Normal Matrix for transforming normals
 		glm::mat4 u_NormalMatrix;
+		// Non-zero when drawing an instanced batch, in which case the matrices above are
+		// ignored and the shader reads them from the instance attributes instead
+		uint32_t  u_IsInstanced;
+		// Pads the block out to a multiple of vec4, as per std140
+		uint32_t  _padding[3];
 	};
 
 	/// <summary>
@@ -120,12 +166,34 @@ public:
 	const Framebuffer::Sptr& GetLightingBuffer() const;
 	const Framebuffer::Sptr& GetRenderOutput() const;
 	const Framebuffer::Sptr& GetGBuffer() const;
+	/// <summary>
+	/// Gets the layout of the G-Buffer, this is fixed once the layer is loaded
+	/// </summary>
+	GBufferLayout GetGBufferLayout() const;
 
-	const UniformBuffer<FrameLevelUniforms>::Sptr& GetFrameUniforms() const;
+	/// <summary>
+	/// Gets the frame level uniforms for the main camera for the current frame
+	/// </summary>
+	const FrameLevelUniforms& GetFrameUniforms() const;
+
+	/// <summary>
+	/// Gets the draw and state change counters for the last rendered frame, summed
+	/// over all views (main camera and shadow cameras)
+	/// </summary>
+	const RenderQueue::Stats& GetRenderStats() const;
+	/// <summary>
+	/// Gets the culling results for each view rendered in the last frame
+	/// </summary>
+	const std::vector<ViewStats>& GetViewStats() const;
+	/// <summary>
+	/// Gets the clustered light grid used for the last frame's lighting pass
+	/// </summary>
+	const LightClusters::Sptr& GetLightClusters() const;
 
 	// Inherited from ApplicationLayer
 
 	virtual void OnAppLoad(const nlohmann::json& config) override;
+	virtual nlohmann::json GetDefaultConfig() override;
 	virtual void OnPreRender() override;
 	virtual void OnRender(const Framebuffer::Sptr& prevLayer) override;
 	virtual void OnPostRender() override;
@@ -141,24 +209,91 @@ protected:
 	ShaderProgram::Sptr _compositingShader;
 	ShaderProgram::Sptr _shadowShader;
 
+	// Uniforms that are set every frame, resolved once at load so we aren't looking them up by name
+	ShaderProgram::UniformHandle<glm::vec4> _clearColorsUniform;
+	struct ShadowCompositeUniforms {
+		ShaderProgram::UniformHandle<glm::mat4> ViewToShadow;
+		ShaderProgram::UniformHandle<glm::vec3> LightDirViewspace;
+		ShaderProgram::UniformHandle<glm::vec3> LightPosViewspace;
+		ShaderProgram::UniformHandle<glm::vec3> LightColor;
+		ShaderProgram::UniformHandle<float>     ShadowBias;
+		ShaderProgram::UniformHandle<float>     NormalBias;
+		ShaderProgram::UniformHandle<float>     Attenuation;
+		ShaderProgram::UniformHandle<float>     Intensity;
+		ShaderProgram::UniformHandle<uint32_t>  ShadowFlags;
+	} _shadowUniforms;
+
+	// Shared shaders for rendering shadow casters
+	ShaderProgram::Sptr _depthOnlyShader;
+	ShaderProgram::Sptr _depthAlphaTestShader;
+	Gameplay::Material::Sptr _depthOnlyMaterial;
+	// Alpha tested shadow materials, keyed by the GUID of the material they were made from
+	std::unordered_map<Guid, Gameplay::Material::Sptr> _alphaTestMaterials;
+	// Casters that have to be re-drawn every frame, drawn over the cached static casters
+	RenderQueue _dynamicCasterQueue;
+
+	// Tracks what was last rendered for a shadow camera
+	struct ShadowCacheEntry {
+		bool     IsValid = false;
+		// Signature of the static casters, see _RenderShadowCasters
+		uint64_t Signature = 0;
+		// Only used by lights with dynamic casters, holds just the static casters so we can restore
+		// them before drawing the dynamic ones. When this is set, the signature describes this
+		// buffer rather than the light's depth buffer
+		Framebuffer::Sptr StaticDepth = nullptr;
+	};
+	// Keyed by the shadow camera's GUID, since component memory gets re-used by new lights
+	std::unordered_map<Guid, ShadowCacheEntry> _shadowCache;
+
 	VertexArrayObject::Sptr _fullscreenQuad;
 
 	bool              _blitFbo;
 	glm::vec4         _clearColor;
 	RenderFlags       _renderFlags;
+	GBufferLayout     _gbufferLayout;
 
 	const int FRAME_UBO_BINDING = 0;
-	UniformBuffer<FrameLevelUniforms>::Sptr _frameUniforms;
+	FrameLevelUniforms _frameUniforms;
 
 	const int INSTANCE_UBO_BINDING = 1;
-	UniformBuffer<InstanceLevelUniforms>::Sptr _instanceUniforms;
+	// Frame and instance uniforms are written into this ring, and bound by range
+	UniformRingBuffer::Sptr _uniformRing;
 
 	const int LIGHTING_UBO_BINDING = 2;
 	UniformBuffer<LightingUboStruct>::Sptr _lightingUbo;
+	// Lights binned into view space clusters for the deferred lighting pass
+	LightClusters::Sptr _lightClusters;
+
+	// Re-used between views so we don't re-allocate every time we render the scene
+	RenderQueue        _renderQueue;
+	RenderQueue::Stats _frameStats;
+	RenderQueue::Stats _lastFrameStats;
+	std::vector<ViewStats> _viewStats;
+	std::vector<ViewStats> _lastViewStats;
+
+	// Per-instance transforms for automatically instanced draws
+	InstanceBuffer::Sptr _instanceBuffer;
 
 	void _InitFrameUniforms();
-	void _RenderScene(const glm::mat4& view, const glm::mat4&Projection, const glm::ivec2& screenSize);
+	void _RenderScene(const glm::mat4& view, const glm::mat4&Projection, const glm::ivec2& screenSize, const Frustum& frustum, const std::string& viewName);
+	void _WriteViewUniforms(const glm::mat4& view, const glm::mat4& projection, const glm::ivec2& screenSize);
+	bool _IsInFrustum(RenderComponent* renderable, const glm::mat4& transform, const Frustum& frustum, ViewStats& stats);
+	void _SubmitRenderQueue(RenderQueue& queue, const glm::mat4& view, const glm::mat4& viewProj);
+
+	/// <summary>
+	/// Renders a shadow camera's depth buffer using the shared depth only shaders, skipping
+	/// it entirely if nothing within the light's frustum has changed since it was last rendered.
+	/// Casters that can't use the depth only shaders are re-drawn every frame on top of a cached
+	/// copy of the other casters
+	/// </summary>
+	void _RenderShadowCasters(ShadowCamera* shadowCam, ShadowCacheEntry& cache);
+	/// <summary>
+	/// Gets the material to use when rendering a caster with the given material into a shadow map
+	/// </summary>
+	/// <param name="isDynamic">Set to true if the material may change between frames, and can not be cached</param>
+	Gameplay::Material* _GetShadowMaterial(Gameplay::Material* material, bool& isDynamic);
 
+	void _BindGBuffer();
 	void _AccumulateLighting();
 	void _Composite();
 	void _ClearFramebuffer(Framebuffer::Sptr& buffer, const glm::vec4* colors, int layers);
@@ -2,6 +2,10 @@
 #include "Application/Application.h"
 #include "Application/ApplicationLayer.h"
 #include "Application/Layers/RenderLayer.h"
+#include "Application/Layers/PostProcessingLayer.h"
+#include "Graphics/GlStateCache.h"
+#include "Graphics/GpuProfiler.h"
+#include "Utils/Profiler.h"
 
 DebugWindow::DebugWindow() :
 	IEditorWindow()
@@ -24,6 +28,86 @@ void DebugWindow::RenderMenuBar()
 		app.CurrentScene()->SetPhysicsDebugDrawMode(physicsDrawMode);
 	}
 
+	if (renderLayer != nullptr) {
+		ImGui::Separator();
+
+		// Show how much state changing the render queue is saving us
+		const RenderQueue::Stats& stats = renderLayer->GetRenderStats();
+		ImGui::Text("Draw calls:       %u (%u instanced, %u instances)", stats.DrawCalls, stats.InstancedDraws, stats.InstancesDrawn);
+		ImGui::Text("Shader binds:     %u (%u skipped)", stats.ShaderBinds, stats.ShaderBindsSkipped);
+		ImGui::Text("Material applies: %u (%u skipped)", stats.MaterialApplies, stats.MaterialAppliesSkipped);
+		ImGui::Text("VAO binds:        %u (%u skipped)", stats.VaoBinds, stats.VaoBindsSkipped);
+
+		// Show how many GL calls the state cache is eliding, these are for the whole previous frame
+		const GlStateCache::Stats& glStats = GlStateCache::GetStats();
+		ImGui::Text("GL state changes: %u (%u elided)", glStats.States.Issued, glStats.States.Elided);
+		ImGui::Text("GL programs:      %u (%u elided)", glStats.Programs.Issued, glStats.Programs.Elided);
+		ImGui::Text("GL textures:      %u (%u elided)", glStats.Textures.Issued, glStats.Textures.Elided);
+		ImGui::Text("GL framebuffers:  %u (%u elided)", glStats.Framebuffers.Issued, glStats.Framebuffers.Elided);
+		ImGui::Text("GL viewports:     %u (%u elided)", glStats.Viewports.Issued, glStats.Viewports.Elided);
+
+		// Show how many objects each view is culling
+		for (const RenderLayer::ViewStats& view : renderLayer->GetViewStats()) {
+			ImGui::Text("%s: %u/%u culled (%u unbounded)%s", view.Name.c_str(), view.ObjectsCulled, view.ObjectsTested, view.ObjectsUnbounded, view.IsCached ? " [cached]" : "");
+		}
+
+		// Show how the lights were binned for the lighting pass
+		const LightClusters::Sptr& clusters = renderLayer->GetLightClusters();
+		if (clusters != nullptr) {
+			const glm::uvec3& dims = clusters->GetDimensions();
+			ImGui::Text("Light clusters:   %ux%ux%u", dims.x, dims.y, dims.z);
+			ImGui::Text("Lights:           %u (%u indices, max %u per cluster)", clusters->GetLightCount(), clusters->GetIndexCount(), clusters->GetMaxLightsPerCluster());
+		}
+	}
+
+	// Show how many transient targets the post processing chain is keeping around
+	PostProcessingLayer::Sptr postLayer = app.GetLayer<PostProcessingLayer>();
+	if (postLayer != nullptr && postLayer->GetTargetPool() != nullptr) {
+		const RenderTargetPool::Sptr& pool = postLayer->GetTargetPool();
+		ImGui::Text("Post targets:     %u resident (%u peak in use)", pool->GetResidentCount(), pool->GetPeakInUse());
+		ImGui::Text("Post passes:      %u (%u effects fused)", postLayer->GetPassCount(), postLayer->GetFusedCount());
+	}
+
+	// CPU captures are written in the Chrome trace format, open them in chrome://tracing
+	ImGui::Separator();
+	if (Profiler::IsCapturing()) {
+		ImGui::TextUnformatted("Capturing CPU profile...");
+	} else if (ImGui::Button("Capture CPU Profile (60 frames)")) {
+		Profiler::CaptureFrames(60, "profile.json");
+	}
+
+	// Rolling GPU timings for every scope in the frame, these are a few frames behind
+	ImGui::Separator();
+	bool profilerEnabled = GpuProfiler::IsEnabled();
+	if (ImGui::Checkbox("GPU Profiler", &profilerEnabled)) {
+		GpuProfiler::SetEnabled(profilerEnabled);
+	}
+	if (profilerEnabled) {
+		ImGui::SameLine();
+		if (ImGui::Button("Dump to File")) {
+			GpuProfiler::Dump("gpu-profile.json");
+		}
+		ImGui::SameLine();
+		ImGui::Text("(%u frames dropped)", GpuProfiler::GetDroppedFrames());
+
+		const std::vector<GpuProfiler::Scope>& scopes = GpuProfiler::GetScopes();
+		for (uint32_t index : GpuProfiler::GetLastFrame()) {
+			const GpuProfiler::Scope& scope = scopes[index];
+			ImGui::PushID(scope.Path.c_str());
+
+			char overlay[64];
+			snprintf(overlay, sizeof(overlay), "%.3f ms (avg %.3f, max %.3f)", scope.LastMs, scope.AverageMs, scope.MaxMs);
+
+			ImGui::Indent(scope.Depth * 10.0f + 1.0f);
+			ImGui::TextUnformatted(scope.Name.c_str());
+			int offset = scope.HistoryCount < GpuProfiler::HISTORY_LENGTH ? 0 : scope.HistoryOffset;
+			ImGui::PlotLines("", scope.History, scope.HistoryCount, offset, overlay, 0.0f, glm::max(scope.MaxMs, 0.01f), ImVec2(300.0f, 30.0f));
+			ImGui::Unindent(scope.Depth * 10.0f + 1.0f);
+
+			ImGui::PopID();
+		}
+	}
+
 	/*ImGui::Separator();
 
 	RenderFlags flags = renderLayer->GetRenderFlags();
@@ -27,7 +27,9 @@ void GBufferPreviews::Render()
 	Texture2D::Sptr& color = framebuffer->GetTextureAttachment(RenderTargetAttachment::Color0);
 	Texture2D::Sptr& normals = framebuffer->GetTextureAttachment(RenderTargetAttachment::Color1);
 	Texture2D::Sptr& emissive = framebuffer->GetTextureAttachment(RenderTargetAttachment::Color2);
-	Texture2D::Sptr& viewspace = framebuffer->GetTextureAttachment(RenderTargetAttachment::Color3);
+	// Will be null for the compact layout, which has no position target
+	Texture2D::Sptr viewspace = framebuffer->GetTextureAttachment(RenderTargetAttachment::Color3);
+	bool isCompact = renderLayer->GetGBufferLayout() == GBufferLayout::Compact;
 
 	Texture2D::Sptr& diffuse = lightBuffer->GetTextureAttachment(RenderTargetAttachment::Color0);
 	Texture2D::Sptr& specular = lightBuffer->GetTextureAttachment(RenderTargetAttachment::Color1);
@@ -37,6 +39,9 @@ void GBufferPreviews::Render()
 	int height = width / aspect;
 	ImVec2 size = ImVec2(width, height);
 
+	// Bytes written per pixel by the geometry pass (and read back by the lighting passes)
+	ImGui::Text("Layout: %s (%d bytes per pixel)", (~renderLayer->GetGBufferLayout()).c_str(), isCompact ? 16 : 24);
+
 	ImGui::Columns(2);
 	ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(0, 0));
 	ImGui::BeginChildFrame(ImGui::GetID(depth.get()), ImVec2(size.x, size.y + ImGui::GetTextLineHeight() + 10));
@@ -49,14 +54,16 @@ void GBufferPreviews::Render()
 	_RenderTexture2D(color, size, "color");
 	ImGui::NextColumn();
 
-	_RenderTexture2D(normals, size, "normals");
+	_RenderTexture2D(normals, size, isCompact ? "normals (octahedral)" : "normals");
 	ImGui::NextColumn();
 
 	_RenderTexture2D(emissive, size, "emissive"); 
 	ImGui::NextColumn();  
 
-	_RenderTexture2D(viewspace, size, "position (viewspace)");
-	ImGui::NextColumn();
+	if (viewspace != nullptr) {
+		_RenderTexture2D(viewspace, size, "position (viewspace)");
+		ImGui::NextColumn();
+	}
 
 	_RenderTexture2D(diffuse, size, "Diffuse Lighting");
 	ImGui::NextColumn();
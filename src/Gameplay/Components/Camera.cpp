@@ -110,6 +110,10 @@ namespace Gameplay {
 		return _viewProjection;
 	}
 
+	Frustum Camera::GetFrustum() const {
+		return Frustum(GetViewProjection());
+	}
+
 	const glm::vec4& Camera::GetClearColor() const
 	{
 		return _clearColor;
@@ -3,6 +3,7 @@
 #include <memory>
 #include <GLM/glm.hpp>
 #include "Gameplay/Components/IComponent.h"
+#include "Graphics/Frustum.h"
 
 namespace Gameplay {
 	/// <summary>
@@ -14,7 +15,7 @@ namespace Gameplay {
 		typedef std::shared_ptr<Camera> Sptr;
 
 		inline static Sptr Create() {
-			return std::make_shared<Camera>();
+			return AllocateComponent<Camera>();
 		}
 
 	// IComponent implementation
@@ -84,6 +85,10 @@ namespace Gameplay {
 		/// Gets the combined view-projection matrix for this camera, calculating if needed
 		/// </summary>
 		const glm::mat4& GetViewProjection() const;
+		/// <summary>
+		/// Gets the world space frustum planes for this camera, for use in culling
+		/// </summary>
+		Frustum GetFrustum() const;
 
 		const glm::vec4& GetClearColor() const;
 		void SetClearColor(const glm::vec4& color);
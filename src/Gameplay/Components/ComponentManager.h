@@ -1,15 +1,22 @@
 #pragma once
 #include <functional>
 #include "IComponent.h"
+#include "ComponentPool.h"
 #include <typeindex>
 #include <optional>
 #include <Logging.h>
 
 namespace Gameplay {
+	template <typename ComponentType>
+	class ComponentView;
+
 	/// <summary>
 	/// Helper class for component types, this class is what lets us load component types
 	/// from scene files, as well as providing a way to iterate over all active components
 	/// of a given type (and sort them in the future!)
+	/// 
+	/// Components of each type are tracked in a ComponentPool, which keeps a packed array
+	/// of raw pointers so that Each is a linear walk with no refcounting or casting
 	/// </summary>
 	class ComponentManager {
 	public:
@@ -18,6 +25,18 @@ namespace Gameplay {
 
 		inline void Clear() {
 			_Components.clear();
+			_ComponentsByGuid.clear();
+		}
+
+		/// <summary>
+		/// Gets a view that iterates over all components of the given type, ex:
+		/// View<RenderComponent>().Each([](RenderComponent* r) { ... })
+		/// </summary>
+		/// <typeparam name="ComponentType">The component type to iterate over</typeparam>
+		/// <param name="includeDisabled">True to include disabled components, false if otherwise</param>
+		template <typename ComponentType>
+		ComponentView<ComponentType> View(bool includeDisabled = false) {
+			return ComponentView<ComponentType>(*this, includeDisabled);
 		}
 
 		/// <summary>
@@ -46,7 +65,7 @@ namespace Gameplay {
 					result->_weakSelfPtr = result;
 
 					// Add the component to the global pools
-					_Components[result->_realType].push_back(result);
+					_AddToPool(result.get());
 					return result;
 				}
 			}
@@ -75,7 +94,7 @@ namespace Gameplay {
 					result->_realType = typeIndex.value();
 					result->_weakSelfPtr = result;
 					// Add the component to the global pools
-					_Components[result->_realType].push_back(result);
+					_AddToPool(result.get());
 					return result;
 				}
 			}
@@ -102,7 +121,7 @@ namespace Gameplay {
 				result->_realType = type;
 				result->_weakSelfPtr = result;
 				// Add the component to the global pools
-				_Components[result->_realType].push_back(result);
+				_AddToPool(result.get());
 				return result;
 			}
 			return nullptr;
@@ -135,16 +154,18 @@ namespace Gameplay {
 			std::type_index type = std::type_index(typeid(ComponentType));
 			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
 
-			// Create component, forwarding arguments
-			std::shared_ptr<ComponentType> component = std::make_shared<ComponentType>(std::forward<TArgs>(args)...);
+			// Create component, forwarding arguments. We allocate from the type's arena so that
+			// components of the same type end up packed together in memory
+			std::shared_ptr<ComponentType> component = AllocateComponent<ComponentType>(std::forward<TArgs>(args)...);
 
 			// Make sure the component knows it's concrete type
 			component->_realType = type;
+			component->_typeId = ComponentTypeId<ComponentType>();
 			// Give the component a weak pointer to itself that it can upcast to a shared pointer when needed
 			component->_weakSelfPtr = component;
 
-			// Add to global component list for that type
-			_Components[type].push_back(component);
+			// Add to global component pool for that type
+			_AddToPool(component.get());
 
 			// Return the result
 			return component;
@@ -165,50 +186,46 @@ namespace Gameplay {
 			std::type_index type = std::type_index(typeid(ComponentType));
 			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
 
-			// Clear any dead weak pointers
-			auto removeIt = std::remove_if(_Components[type].begin(), _Components[type].end(), [](const std::weak_ptr<IComponent>& ptr) {
-				return ptr.expired();
-			});
-			_Components[type].erase(removeIt, _Components[type].end());
-
-			// Search the component store for a component that matches that ID
-			auto& it = std::find_if(_Components[type].begin(), _Components[type].end(), [&](const std::weak_ptr<IComponent>& ptr) {
-				return (ptr.lock())->GetGUID() == id;
-			});
-
-			// If the component was found, return it. Otherwise return nullptr
-			if (it != _Components[type].end()) {
-				// We need to lock the weak pointer to convert it to a shared ptr
-				return std::dynamic_pointer_cast<ComponentType>((*it).lock());
-			} else {
-				return nullptr;
+			ComponentTypeID typeId = ComponentTypeId<ComponentType>();
+
+			// Try the GUID index first, we double check the GUID in case it was overridden after
+			// the component was created
+			auto it = _ComponentsByGuid.find(id);
+			if (it != _ComponentsByGuid.end() && it->second->GetGUID() == id) {
+				// We need to upgrade to a shared pointer, since the index only tracks raw pointers
+				return it->second->_typeId == typeId ? std::static_pointer_cast<ComponentType>(it->second->_weakSelfPtr.lock()) : nullptr;
+			}
+
+			// Fall back to searching the component pool, and re-index the component if we find it
+			ComponentPool* pool = _GetPool(typeId);
+			if (pool != nullptr) {
+				IComponent* const* data = pool->Data();
+				for (size_t ix = 0; ix < pool->Size(); ix++) {
+					if (data[ix] != nullptr && data[ix]->GetGUID() == id) {
+						_ComponentsByGuid[id] = data[ix];
+						return std::static_pointer_cast<ComponentType>(data[ix]->_weakSelfPtr.lock());
+					}
+				}
 			}
+			return nullptr;
 		}
 
 		/// <summary>
 		/// Iterates over all components of the given type and invokes a method with them
+		/// 
+		/// The callback is invoked with a raw pointer to the component, the component is guaranteed
+		/// to be alive for the duration of the callback. Components that are removed during iteration
+		/// will be skipped
 		/// </summary>
 		/// <typeparam name="ComponentType">The type of component to iterate on</typeparam>
-		/// <param name="callback">The callback to invoke with the components</param>
+		/// <param name="callback">The callback to invoke with the components, should accept a ComponentType*</param>
 		/// <param name="includeDisabled">True to include disabled components, false if otherwise</param>
 		template <
 			typename ComponentType,
+			typename Callback,
 			typename = typename std::enable_if<std::is_base_of<IComponent, ComponentType>::value>::type>
-		void Each(std::function<void(const std::shared_ptr<ComponentType>&)> callback, bool includeDisabled = false) {
-			// We can use typeid and type_index to get a unique ID for our types
-			std::type_index type = std::type_index(typeid(ComponentType));
-			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
-
-			// Iterate over all the components in the store
-			for (auto& wptr : _Components[type]) {
-				// Lock the weak pointer to get a shared pointer (maybe)
-				std::shared_ptr<IComponent> sptr = wptr.lock();
-				// If the pointer is alive and matches our enabled criteria, invoke the callback
-				if (sptr && sptr->IsEnabled | includeDisabled) {
-					// Upcast to component type and invoke the callback
-					callback(std::dynamic_pointer_cast<ComponentType>(sptr));
-				}
-			}
+		void Each(Callback&& callback, bool includeDisabled = false) {
+			View<ComponentType>(includeDisabled).Each(std::forward<Callback>(callback));
 		}
 
 		/// <summary>
@@ -231,6 +248,8 @@ namespace Gameplay {
 				_TypeLoadRegistry[type] = &ComponentManager::ParseTypeFromBlob<T>;
 				_TypeCreateRegistry[type] = &ComponentManager::_InternalCreate<T>;
 				_TypeNameMap[StringTools::SanitizeClassName(typeid(T).name())] = type;
+				// Make sure the type ID is assigned
+				ComponentTypeId<T>();
 			}
 		}
 
@@ -238,12 +257,20 @@ namespace Gameplay {
 		/// Removes all components of all types from the registry, whether they are referenced elsewhere or not
 		/// </summary>
 		inline void FlushAll() {
-			_Components = std::unordered_map<std::type_index, std::vector<std::weak_ptr<IComponent>>>();
+			for (auto& pool : _Components) {
+				if (pool != nullptr) {
+					pool->Clear();
+				}
+			}
+			_ComponentsByGuid.clear();
 		}
 
 	private:
 		// Give component friend access so it can call Remove
 		friend class IComponent;
+		// Views need access to the pools
+		template <typename ComponentType>
+		friend class ComponentView;
 
 		// This maps a readable type name to it's type_index. We use optional in case we try and access
 		// an element that does not have a type (and unordered_map requires a default constructor, which
@@ -254,14 +281,41 @@ namespace Gameplay {
 		// Stores functions to load components from JSON, indexed on the type that they load
 		inline static std::unordered_map<std::type_index, CreateComponentFunc> _TypeCreateRegistry;
 
-		// Weak pointers let us store a reference to an object stored by a shared pointer, without
-		// actually increasing the reference count. Thus components will be destroyed at the correct
-		// time (when the only reference is the one stored here).
-		std::unordered_map<std::type_index, std::vector<std::weak_ptr<IComponent>>> _Components;  
+		// The pools only store raw pointers, so they do not affect the lifetime of components. Components
+		// remove themselves from their pool in the IComponent destructor, so the pools never hold dead
+		// entries. Pools are indexed by ComponentTypeId, and are heap allocated so that growing the list
+		// does not move a pool that is currently being iterated over
+		std::vector<std::unique_ptr<ComponentPool>> _Components;
+		// Lets us resolve cross references between components in constant time
+		std::unordered_map<Guid, IComponent*> _ComponentsByGuid;
+
+		/// <summary>
+		/// Gets the pool for the given type ID, or nullptr if no components of that type have been created
+		/// </summary>
+		inline ComponentPool* _GetPool(ComponentTypeID typeId) {
+			return typeId < _Components.size() ? _Components[typeId].get() : nullptr;
+		}
+
+		/// <summary>
+		/// Adds a newly created component to the pool for it's concrete type
+		/// </summary>
+		inline void _AddToPool(IComponent* component) {
+			LOG_ASSERT(component->_typeId != ComponentTypeIds::Invalid, "Component was created without a type ID!");
+			if (component->_typeId >= _Components.size()) {
+				_Components.resize(component->_typeId + 1);
+			}
+			if (_Components[component->_typeId] == nullptr) {
+				_Components[component->_typeId] = std::make_unique<ComponentPool>();
+			}
+			component->_poolHandle = _Components[component->_typeId]->Add(component);
+			_ComponentsByGuid[component->GetGUID()] = component;
+		}
 
 		template <typename T>
 		static IComponent::Sptr ParseTypeFromBlob(const nlohmann::json& blob) {
-			return T::FromJson(blob);
+			IComponent::Sptr result = T::FromJson(blob);
+			result->_typeId = ComponentTypeId<T>();
+			return result;
 		}
 
 		template <typename ComponentType>
@@ -270,11 +324,12 @@ namespace Gameplay {
 			std::type_index type = std::type_index(typeid(ComponentType));
 			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
 
-			// Create component, forwarding arguments
-			std::shared_ptr<ComponentType> component = std::make_shared<ComponentType>();
+			// Create component from the type's arena
+			std::shared_ptr<ComponentType> component = AllocateComponent<ComponentType>();
 
 			// Make sure the component knows it's concrete type
 			component->_realType = type;
+			component->_typeId = ComponentTypeId<ComponentType>();
 			// Give the component a weak pointer to itself that it can upcast to a shared pointer when needed
 			component->_weakSelfPtr = component;
 
@@ -291,20 +346,62 @@ namespace Gameplay {
 		inline void Remove(const IComponent* component) {
 			if (_Components.size() == 0) return;
 
-			// Make sure the component's type was one that was registered
-			LOG_ASSERT(_TypeLoadRegistry[component->_realType] != nullptr, "You must register component types before creating them!");
+			// Swap the component out of it's pool, the handle lets us do this without searching
+			ComponentPool* pool = _GetPool(component->_typeId);
+			if (pool != nullptr) {
+				pool->Remove(component->_poolHandle);
+			}
 
-			
-			// Get a reference to the vector of components for easy access
-			std::vector<std::weak_ptr<IComponent>>& componentStore = _Components[component->_realType];
+			// Only drop the index entry if it actually refers to this component
+			auto it = _ComponentsByGuid.find(component->GetGUID());
+			if (it != _ComponentsByGuid.end() && it->second == component) {
+				_ComponentsByGuid.erase(it);
+			}
+		}
+	};
 
-			// Clear any dead weak pointers
-			auto it = std::remove_if(componentStore.begin(), componentStore.end(), [](const std::weak_ptr<IComponent>& ptr) {
-				return ptr.expired();
-				});
-			if (it != componentStore.end()) {
-				componentStore.erase(it);
+	/// <summary>
+	/// A view over all components of a given type. The callback passed to Each is a template
+	/// parameter, so it can be fully inlined into the loop
+	/// </summary>
+	/// <typeparam name="ComponentType">The component type whose pool is walked</typeparam>
+	template <typename ComponentType>
+	class ComponentView {
+		static_assert(std::is_base_of<IComponent, ComponentType>::value, "Views can only be created over component types!");
+
+	public:
+		ComponentView(ComponentManager& manager, bool includeDisabled) :
+			_manager(manager),
+			_includeDisabled(includeDisabled)
+		{ }
+
+		/// <summary>
+		/// Invokes the callback for each component in the view, the callback should accept a ComponentType*
+		/// </summary>
+		/// <param name="callback">The callback to invoke</param>
+		template <typename Callback>
+		void Each(Callback&& callback) {
+			ComponentPool* pool = _manager._GetPool(ComponentTypeId<ComponentType>());
+			if (pool == nullptr) return;
+
+			// Iterate over all the components in the pool. Note that we re-check the size each
+			// iteration, since the callback may create new components of this type
+			pool->BeginIteration();
+			for (size_t ix = 0; ix < pool->Size(); ix++) {
+				IComponent* component = pool->Data()[ix];
+				// If the component is alive and matches our enabled criteria, invoke the callback
+				if (component == nullptr || !(component->IsEnabled | _includeDisabled)) {
+					continue;
+				}
+
+				// Everything in this pool is exactly ComponentType, so a static cast is safe
+				callback(static_cast<ComponentType*>(component));
 			}
+			pool->EndIteration();
 		}
+
+	private:
+		ComponentManager& _manager;
+		bool              _includeDisabled;
 	};
 }
\ No newline at end of file
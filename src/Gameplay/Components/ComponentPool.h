@@ -0,0 +1,350 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <new>
+#include <atomic>
+#include <type_traits>
+
+namespace Gameplay {
+	class IComponent;
+
+	typedef uint32_t ComponentTypeID;
+
+	/// <summary>
+	/// Hands out small sequential IDs for component types, these are used to index directly
+	/// into the component pools instead of hashing a std::type_index
+	/// </summary>
+	class ComponentTypeIds {
+	public:
+		static constexpr ComponentTypeID Invalid = 0xFFFFFFFF;
+
+		/// <summary>
+		/// Gets the ID for the given component type, the ID is assigned the first time
+		/// the type is queried, and is stable for the rest of the application's lifetime
+		/// </summary>
+		template <typename T>
+		static ComponentTypeID Get() {
+			static const ComponentTypeID id = _next++;
+			return id;
+		}
+
+	private:
+		inline static std::atomic<ComponentTypeID> _next { 0 };
+	};
+
+	/// <summary>
+	/// Shorthand for ComponentTypeIds::Get
+	/// </summary>
+	template <typename T>
+	inline ComponentTypeID ComponentTypeId() {
+		return ComponentTypeIds::Get<typename std::remove_cv<T>::type>();
+	}
+
+	/// <summary>
+	/// A generational handle into a component pool. The slot index stays stable for
+	/// the lifetime of the component, and the generation lets us detect handles that
+	/// refer to a component that has since been removed (and it's slot re-used)
+	/// </summary>
+	struct ComponentHandle {
+		static constexpr uint32_t InvalidIndex = 0xFFFFFFFF;
+
+		uint32_t Index      = InvalidIndex;
+		uint32_t Generation = 0;
+
+		bool IsValid() const { return Index != InvalidIndex; }
+	};
+
+	/// <summary>
+	/// Stores all the components of a single concrete type. Components are kept in a
+	/// packed (dense) array so that iterating over them is a linear walk with no gaps,
+	/// no weak pointer locking and no casting. A sparse slot array maps the stable
+	/// handles to the current dense index, so removal is an O(1) swap and pop.
+	///
+	/// Note that the pool does NOT own the components, they are still owned by the
+	/// GameObject they are attached to, and remove themselves on destruction
+	/// </summary>
+	class ComponentPool {
+	public:
+		ComponentPool() :
+			_dense(),
+			_denseToSlot(),
+			_slots(),
+			_freeSlots(),
+			_iterationDepth(0),
+			_needsCompact(false)
+		{ }
+
+		/// <summary>
+		/// Adds a component to the pool, returning the handle that it can later be removed with
+		/// </summary>
+		/// <param name="component">The component to add, should not be null</param>
+		ComponentHandle Add(IComponent* component) {
+			uint32_t slotIx;
+			if (!_freeSlots.empty()) {
+				slotIx = _freeSlots.back();
+				_freeSlots.pop_back();
+			} else {
+				slotIx = static_cast<uint32_t>(_slots.size());
+				_slots.push_back(Slot());
+			}
+
+			Slot& slot = _slots[slotIx];
+			slot.DenseIndex = static_cast<uint32_t>(_dense.size());
+			_dense.push_back(component);
+			_denseToSlot.push_back(slotIx);
+
+			ComponentHandle result;
+			result.Index = slotIx;
+			result.Generation = slot.Generation;
+			return result;
+		}
+
+		/// <summary>
+		/// Removes the component referenced by the given handle from the pool. If we are currently
+		/// iterating over the pool, the entry is nulled out and compacted once iteration finishes
+		/// </summary>
+		/// <param name="handle">The handle that was returned from Add</param>
+		/// <returns>True if the handle was live and has been removed</returns>
+		bool Remove(const ComponentHandle& handle) {
+			if (!_IsLive(handle)) return false;
+
+			Slot& slot = _slots[handle.Index];
+			uint32_t denseIx = slot.DenseIndex;
+
+			// Bump the generation so any outstanding handles are invalidated
+			slot.Generation++;
+			slot.DenseIndex = ComponentHandle::InvalidIndex;
+			_freeSlots.push_back(handle.Index);
+
+			// We can't shuffle things around while someone is walking the dense array, so
+			// we leave a hole that the iterators will skip and clean it up later
+			if (_iterationDepth > 0) {
+				_dense[denseIx] = nullptr;
+				_denseToSlot[denseIx] = ComponentHandle::InvalidIndex;
+				_needsCompact = true;
+			} else {
+				_SwapRemove(denseIx);
+			}
+			return true;
+		}
+
+		/// <summary>
+		/// Resolves a handle into the component it references, or nullptr if the handle is stale
+		/// </summary>
+		IComponent* Resolve(const ComponentHandle& handle) const {
+			return _IsLive(handle) ? _dense[_slots[handle.Index].DenseIndex] : nullptr;
+		}
+
+		/// <summary>
+		/// Gets the number of entries in the dense array (may include holes during iteration)
+		/// </summary>
+		size_t Size() const { return _dense.size(); }
+		/// <summary>
+		/// Gets the raw packed array of components, entries may be nullptr during iteration
+		/// </summary>
+		IComponent* const* Data() const { return _dense.data(); }
+
+		/// <summary>
+		/// Marks the start of an iteration over the pool, removals will be deferred until
+		/// the matching EndIteration
+		/// </summary>
+		void BeginIteration() { _iterationDepth++; }
+		/// <summary>
+		/// Marks the end of an iteration over the pool, compacting any holes left behind
+		/// by removals if this is the outermost iteration
+		/// </summary>
+		void EndIteration() {
+			_iterationDepth--;
+			if (_iterationDepth == 0 && _needsCompact) {
+				_Compact();
+			}
+		}
+
+		/// <summary>
+		/// Drops all entries from the pool, invalidating all outstanding handles
+		/// </summary>
+		void Clear() {
+			for (Slot& slot : _slots) {
+				slot.Generation++;
+				slot.DenseIndex = ComponentHandle::InvalidIndex;
+			}
+			_freeSlots.clear();
+			for (uint32_t ix = static_cast<uint32_t>(_slots.size()); ix > 0; ix--) {
+				_freeSlots.push_back(ix - 1);
+			}
+			_dense.clear();
+			_denseToSlot.clear();
+			_needsCompact = false;
+		}
+
+	private:
+		struct Slot {
+			uint32_t DenseIndex = ComponentHandle::InvalidIndex;
+			uint32_t Generation = 0;
+		};
+
+		// The packed list of components, this is what we walk when iterating
+		std::vector<IComponent*> _dense;
+		// Maps dense indices back to their slots, so we can patch slots when swapping
+		std::vector<uint32_t>    _denseToSlot;
+		// Sparse array indexed by handle
+		std::vector<Slot>        _slots;
+		// Slots that can be re-used by new components
+		std::vector<uint32_t>    _freeSlots;
+
+		int  _iterationDepth;
+		bool _needsCompact;
+
+		bool _IsLive(const ComponentHandle& handle) const {
+			return handle.Index < _slots.size() &&
+				_slots[handle.Index].Generation == handle.Generation &&
+				_slots[handle.Index].DenseIndex != ComponentHandle::InvalidIndex;
+		}
+
+		void _SwapRemove(uint32_t denseIx) {
+			uint32_t lastIx = static_cast<uint32_t>(_dense.size() - 1);
+			if (denseIx != lastIx) {
+				_dense[denseIx] = _dense[lastIx];
+				_denseToSlot[denseIx] = _denseToSlot[lastIx];
+				_slots[_denseToSlot[denseIx]].DenseIndex = denseIx;
+			}
+			_dense.pop_back();
+			_denseToSlot.pop_back();
+		}
+
+		void _Compact() {
+			// Stable compaction, so that we do not re-order the remaining components
+			uint32_t write = 0;
+			for (uint32_t read = 0; read < _dense.size(); read++) {
+				if (_dense[read] != nullptr) {
+					_dense[write] = _dense[read];
+					_denseToSlot[write] = _denseToSlot[read];
+					_slots[_denseToSlot[write]].DenseIndex = write;
+					write++;
+				}
+			}
+			_dense.resize(write);
+			_denseToSlot.resize(write);
+			_needsCompact = false;
+		}
+	};
+
+	/// <summary>
+	/// A very simple fixed-size block arena, used to keep components of the same type
+	/// next to each other in memory. Blocks are handed out from chunks of BlocksPerChunk
+	/// elements, and freed blocks are recycled via an intrusive free list. Chunks are
+	/// never returned to the OS until the application exits
+	/// 
+	/// Arenas are keyed on the type rather than it's size, so that two component types that
+	/// happen to be the same size never end up interleaved in the same chunks
+	/// </summary>
+	/// <typeparam name="T">The type of object stored in the arena's blocks</typeparam>
+	template <typename T>
+	class BlockArena {
+	public:
+		static constexpr size_t BlocksPerChunk = 64;
+
+		static BlockArena& Get() {
+			static BlockArena instance;
+			return instance;
+		}
+
+		void* Allocate() {
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_freeList == nullptr) {
+				_AllocateChunk();
+			}
+			FreeBlock* result = _freeList;
+			_freeList = result->Next;
+			return result;
+		}
+
+		void Free(void* block) {
+			std::lock_guard<std::mutex> lock(_mutex);
+			FreeBlock* freed = static_cast<FreeBlock*>(block);
+			freed->Next = _freeList;
+			_freeList = freed;
+		}
+
+	private:
+		struct FreeBlock {
+			FreeBlock* Next;
+		};
+
+		static constexpr size_t BlockSize  = sizeof(T) < sizeof(FreeBlock) ? sizeof(FreeBlock) : sizeof(T);
+		static constexpr size_t BlockAlign = alignof(T) < alignof(FreeBlock) ? alignof(FreeBlock) : alignof(T);
+		// Round the block size up to the alignment so every block in a chunk is aligned
+		static constexpr size_t Stride = (BlockSize + BlockAlign - 1) / BlockAlign * BlockAlign;
+
+		struct ChunkDeleter {
+			void operator()(uint8_t* ptr) const {
+				::operator delete(ptr, std::align_val_t(BlockAlign));
+			}
+		};
+
+		std::vector<std::unique_ptr<uint8_t, ChunkDeleter>> _chunks;
+		FreeBlock* _freeList = nullptr;
+		std::mutex _mutex;
+
+		void _AllocateChunk() {
+			uint8_t* chunk = static_cast<uint8_t*>(::operator new(Stride * BlocksPerChunk, std::align_val_t(BlockAlign)));
+			_chunks.emplace_back(chunk);
+
+			// Thread the blocks into the free list in address order, so sequential allocations
+			// end up sequential in memory
+			for (size_t ix = BlocksPerChunk; ix > 0; ix--) {
+				FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + (ix - 1) * Stride);
+				block->Next = _freeList;
+				_freeList = block;
+			}
+		}
+	};
+
+	/// <summary>
+	/// Allocator for use with std::allocate_shared, so that components (and their shared_ptr
+	/// control blocks) are allocated from a per-type BlockArena. Note that allocate_shared rebinds
+	/// this to it's control block type, which embeds the component, so each component type still
+	/// gets an arena of it's own
+	/// </summary>
+	template <typename T>
+	struct ComponentAllocator {
+		typedef T value_type;
+
+		ComponentAllocator() noexcept = default;
+		template <typename U>
+		ComponentAllocator(const ComponentAllocator<U>&) noexcept { }
+
+		T* allocate(size_t count) {
+			if (count != 1) {
+				return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+			}
+			return static_cast<T*>(BlockArena<T>::Get().Allocate());
+		}
+
+		void deallocate(T* ptr, size_t count) noexcept {
+			if (count != 1) {
+				::operator delete(ptr, std::align_val_t(alignof(T)));
+				return;
+			}
+			BlockArena<T>::Get().Free(ptr);
+		}
+
+		template <typename U>
+		bool operator==(const ComponentAllocator<U>&) const noexcept { return true; }
+		template <typename U>
+		bool operator!=(const ComponentAllocator<U>&) const noexcept { return false; }
+	};
+
+	/// <summary>
+	/// Creates a component in it's type's BlockArena, this should be used instead of std::make_shared
+	/// anywhere a component is constructed (ex: in FromJson), so that every component lives in it's pool
+	/// </summary>
+	/// <typeparam name="T">The type of component to create</typeparam>
+	/// <param name="...args">The arguments to forward to the constructor</param>
+	template <typename T, typename ... TArgs>
+	inline std::shared_ptr<T> AllocateComponent(TArgs&& ... args) {
+		return std::allocate_shared<T>(ComponentAllocator<T>(), std::forward<TArgs>(args)...);
+	}
+}
\ No newline at end of file
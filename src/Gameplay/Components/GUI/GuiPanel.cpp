@@ -77,7 +77,7 @@ nlohmann::json GuiPanel::ToJson() const {
 }
 
 GuiPanel::Sptr GuiPanel::FromJson(const nlohmann::json& blob) {
-	GuiPanel::Sptr result = std::make_shared<GuiPanel>();
+	GuiPanel::Sptr result = Gameplay::AllocateComponent<GuiPanel>();
 
 	result->_color        = JsonGet(blob, "color", result->_color);
 	result->_borderRadius = JsonGet(blob, "border", 0);
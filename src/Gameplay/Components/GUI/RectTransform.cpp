@@ -111,7 +111,7 @@ void RectTransform::FinishGUI()
 
 RectTransform::Sptr RectTransform::FromJson(const nlohmann::json& blob)
 {
-	RectTransform::Sptr result = std::make_shared<RectTransform>();
+	RectTransform::Sptr result = Gameplay::AllocateComponent<RectTransform>();
 	result->_position = JsonGet(blob, "position", result->_position);
 	result->_halfSize = JsonGet(blob, "half_scale", result->_halfSize);
 	result->_rotation = JsonGet(blob, "rotation", 0.0f);
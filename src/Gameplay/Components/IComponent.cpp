@@ -28,10 +28,14 @@ namespace Gameplay {
 		IResource(),
 		IsEnabled(true),
 		_realType(typeid(IComponent)),
-		_context(nullptr)
+		_context(nullptr),
+		_poolHandle(ComponentHandle()),
+		_typeId(ComponentTypeIds::Invalid)
 	{ }
 
 	IComponent::~IComponent() {
-		_context->GetScene()->Components().Remove(this);
+		if (_context != nullptr) {
+			_context->GetScene()->Components().Remove(this);
+		}
 	}
 }
@@ -8,6 +8,7 @@
 #include "Utils/ResourceManager/ResourceManager.h"
 #include "Utils/ResourceManager/IResource.h"
 #include "Utils/TypeHelpers.h"
+#include "Gameplay/Components/ComponentPool.h"
 
 namespace Gameplay {
 	// We pre-declare GameObject to avoid circular dependencies in the headers
@@ -100,6 +101,16 @@ namespace Gameplay {
 		/// <param name="deltaTime">The time since the last frame, in seconds</param>
 		virtual void Update(float deltaTime) {};
 
+		/// <summary>
+		/// Components that only modify their own state and the transform of the game object they
+		/// are attached to can return true here, allowing the scene to update them on worker threads.
+		/// Parallel-safe components must not create or delete objects or components directly, use
+		/// Scene::Defer instead. Update order is preserved relative to components that are not
+		/// parallel-safe, see Scene::Update. Transforms read on worker threads are as they were at the start of
+		/// the parallel update, changes made by the component are applied once it is finished
+		/// </summary>
+		virtual bool IsParallelSafe() const { return false; }
+
 		/// <summary>
 		/// All components should override this to allow us to render component
 		/// info in ImGui for easy editing
@@ -163,6 +174,11 @@ namespace Gameplay {
 		std::type_index _realType;
 		GameObject* _context;
 
+		// Our handle into the ComponentManager's pool for our type
+		ComponentHandle _poolHandle;
+		// The small integer ID for our concrete type, see ComponentTypeId
+		ComponentTypeID _typeId;
+
 		// By storing a weak pointer to ourselves, we can pass a pointer to this
 		// for things like bullet user pointers
 		std::weak_ptr<IComponent> _weakSelfPtr;
@@ -17,6 +17,7 @@ public:
 
 	virtual void Awake() override;
 	virtual void Update(float deltaTime) override;
+	virtual bool IsParallelSafe() const override { return true; }
 
 public:
 	virtual void RenderImGui() override;
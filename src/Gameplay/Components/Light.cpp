@@ -68,7 +68,7 @@ void Light::SetType(LightType value) {
 /// Loads a light from a JSON blob
 /// </summary>
 Light::Sptr Light::FromJson(const nlohmann::json& data) {
-	Light::Sptr result = std::make_shared<Light>();
+	Light::Sptr result = Gameplay::AllocateComponent<Light>();
 	result->_color = JsonGet(data, "color", result->_color);
 	result->_radius = JsonGet(data, "range", result->_radius);
 	result->_direction = JsonGet(data, "direction", result->_direction);
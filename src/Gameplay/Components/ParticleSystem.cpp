@@ -4,6 +4,8 @@
 #include "Application/Application.h"
 #include "Utils/ImGuiHelper.h"
 #include "Graphics/DebugDraw.h"
+#include "Graphics/GlStateCache.h"
+#include "Graphics/GpuProfiler.h"
 #include "imgui_internal.h"
 
 ParticleSystem::ParticleSystem() :
@@ -13,7 +15,9 @@ ParticleSystem::ParticleSystem() :
 	_numParticles(0),
 	_particleBuffers(),
 	_feedbackBuffers(),
-	_query(0),
+	_queries(),
+	_queryPending(),
+	_queryIndex(0),
 	_currentVertexBuffer(0),
 	_currentFeedbackBuffer(1),
 	_updateShader(nullptr),
@@ -29,7 +33,7 @@ ParticleSystem::~ParticleSystem()
 	if (_hasInit) {
 		glDeleteBuffers(2, _particleBuffers);
 		glDeleteTransformFeedbacks(2, _feedbackBuffers);
-		glDeleteQueries(1, &_query);
+		glDeleteQueries(QUERY_RING_SIZE, _queries);
 		_updateShader = nullptr;
 		_renderShader = nullptr;
 	}
@@ -37,6 +41,8 @@ ParticleSystem::~ParticleSystem()
 
 void ParticleSystem::Update()
 {
+	GPU_PROFILE_SCOPE("Particle Update");
+
 	// If we haven't previously initialized our data, initialize it now
 	if (!_hasInit) {
 		_updateShader->Bind();
@@ -102,8 +108,9 @@ void ParticleSystem::Update()
 		glBindVertexArray(0);
 
 
-		// We create a query object to track the number of particles we're simulating
-		glGenQueries(1, &_query);
+		// We create a ring of query objects to track the number of particles we're simulating,
+		// so that we can read them back a few frames later instead of waiting on the GPU
+		glCreateQueries(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, QUERY_RING_SIZE, _queries);
 	}
 
 	if (_needsResize) {
@@ -137,7 +144,7 @@ void ParticleSystem::Update()
 	}
 
 	// Disable rasterization, this is update only
-	glEnable(GL_RASTERIZER_DISCARD);
+	GlStateCache::Enable(GL_RASTERIZER_DISCARD);
 
 	// Bind the update shader and send our relevant uniforms
 	_updateShader->Bind();
@@ -149,8 +156,26 @@ void ParticleSystem::Update()
 	// Bind the buffer and transform feedback
 	glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, _feedbackBuffers[_currentFeedbackBuffer]);
 
+	// Grab the particle count from the oldest query in the ring if the GPU is done with it. If
+	// it's still in flight we skip counting this frame rather than stall, the count is only
+	// for display, and the draws themselves get their counts from the transform feedback
+	uint32_t querySlot = _queryIndex % QUERY_RING_SIZE;
+	if (_queryPending[querySlot]) {
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(_queries[querySlot], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available) {
+			GLuint written = 0;
+			glGetQueryObjectuiv(_queries[querySlot], GL_QUERY_RESULT, &written);
+			_numParticles = written >= _emitters.size() ? written - static_cast<GLuint>(_emitters.size()) : 0;
+			_queryPending[querySlot] = false;
+		}
+	}
+	bool recordQuery = !_queryPending[querySlot];
+
 	// Our particles are points that we're simulating
-	glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, _query); 
+	if (recordQuery) {
+		glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, _queries[querySlot]);
+	}
 	glBeginTransformFeedback(GL_POINTS);
 
 	// If this is our first pass, or we have fresh emitter data, we use drawArrays 
@@ -164,15 +189,10 @@ void ParticleSystem::Update()
 
 	// End of transform feedback
 	glEndTransformFeedback();
-	glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN); 
-
-	// Use our query to get the number of particles
-	glGetQueryObjectuiv(_query, GL_QUERY_RESULT, &_numParticles);
-	if (_numParticles >= _emitters.size()) {
-		_numParticles -= _emitters.size();
-	}
-	else {
-		_numParticles = 0;
+	if (recordQuery) {
+		glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+		_queryPending[querySlot] = true;
+		_queryIndex++;
 	}
 
 	// Clean up our state
@@ -181,7 +201,7 @@ void ParticleSystem::Update()
 	glBindVertexArray(0);
 
 	// Re-enable rasterization for later OpenGL calls
-	glDisable(GL_RASTERIZER_DISCARD);
+	GlStateCache::Disable(GL_RASTERIZER_DISCARD);
 
 	_hasInit = true;
 	_needsUpload = false;
@@ -193,6 +213,8 @@ void ParticleSystem::Update()
 
 void ParticleSystem::Render()
 {
+	GPU_PROFILE_SCOPE("Particle Render");
+
 	// Make sure that we've actually initialized our stuff
 	if (_hasInit) {
 
@@ -208,11 +230,11 @@ void ParticleSystem::Render()
 
 		//glDisable(GL_DEPTH_TEST);
 		
-		glDisable(GL_BLEND);
-		glEnablei(GL_BLEND, 0);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		glDepthMask(false);
-		glEnable(GL_DEPTH_TEST);
+		// The render output only has a single color attachment, so we can just enable blending globally
+		GlStateCache::Enable(GL_BLEND);
+		GlStateCache::SetBlendFunc(BlendFunc::SrcAlpha, BlendFunc::OneMinusSrcAlpha);
+		GlStateCache::SetDepthMask(false);
+		GlStateCache::Enable(GL_DEPTH_TEST);
 
 		// Bind the current feedback buffer as our drawing buffer
 		glBindBuffer(GL_ARRAY_BUFFER, _particleBuffers[_currentVertexBuffer]); 
@@ -222,7 +244,7 @@ void ParticleSystem::Render()
 
 		glBindVertexArray(0);
 
-		glEnable(GL_DEPTH_TEST);
+		GlStateCache::Enable(GL_DEPTH_TEST);
 	}
 }
 
@@ -543,7 +565,7 @@ nlohmann::json ParticleSystem::ToJson() const {
 }
 
 ParticleSystem::Sptr ParticleSystem::FromJson(const nlohmann::json& blob) {
-	ParticleSystem::Sptr result = std::make_shared<ParticleSystem>();
+	ParticleSystem::Sptr result = Gameplay::AllocateComponent<ParticleSystem>();
 
 	result->_gravity = JsonGet(blob, "gravity", result->_gravity);
 	result->_maxParticles = JsonGet(blob, "max_particled", result->_maxParticles);
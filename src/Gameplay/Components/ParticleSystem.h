@@ -15,6 +15,9 @@ class ParticleSystem : public Gameplay::IComponent{
 public:
 	MAKE_PTRS(ParticleSystem);
 
+	// The number of particle count queries we keep in flight, counts are read this many frames late
+	static const uint32_t QUERY_RING_SIZE = 4;
+
 	glm::vec3 _gravity;
 
 	struct ParticleData {
@@ -105,7 +108,9 @@ protected:
 	uint32_t _feedbackBuffers[2];
 	uint32_t _updateVaos[2];
 	uint32_t _renderVaos[2];
-	uint32_t _query;
+	uint32_t _queries[QUERY_RING_SIZE];
+	bool     _queryPending[QUERY_RING_SIZE];
+	uint32_t _queryIndex;
 
 	uint32_t _currentVertexBuffer;
 	uint32_t _currentFeedbackBuffer;
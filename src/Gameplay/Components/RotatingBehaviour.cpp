@@ -20,7 +20,7 @@ nlohmann::json RotatingBehaviour::ToJson() const {
 }
 
 RotatingBehaviour::Sptr RotatingBehaviour::FromJson(const nlohmann::json& data) {
-	RotatingBehaviour::Sptr result = std::make_shared<RotatingBehaviour>();
+	RotatingBehaviour::Sptr result = Gameplay::AllocateComponent<RotatingBehaviour>();
 	result->RotationSpeed = JsonGet(data, "speed", result->RotationSpeed);
 	return result;
 }
@@ -12,6 +12,7 @@ public:
 	glm::vec3 RotationSpeed;
 
 	virtual void Update(float deltaTime) override;
+	virtual bool IsParallelSafe() const override { return true; }
 
 	virtual void RenderImGui() override;
 
@@ -54,6 +54,11 @@ glm::mat4 ShadowCamera::GetViewProjection() const
 	return _projectionMatrix * GetGameObject()->GetInverseTransform();
 }
 
+Frustum ShadowCamera::GetFrustum() const
+{
+	return Frustum(GetViewProjection());
+}
+
 void ShadowCamera::SetProjectionMask(const Texture2D::Sptr& image) {
 	_projectionMask = image;
 
@@ -94,7 +99,7 @@ nlohmann::json ShadowCamera::ToJson() const
 
 ShadowCamera::Sptr ShadowCamera::FromJson(const nlohmann::json& data)
 {
-	ShadowCamera::Sptr result = std::make_shared<ShadowCamera>();
+	ShadowCamera::Sptr result = Gameplay::AllocateComponent<ShadowCamera>();
 
 	result->Flags = (ShadowFlags)JsonGet<uint32_t>(data, "flags", *result->Flags);
 	result->Bias = JsonGet(data, "bias", result->Bias);
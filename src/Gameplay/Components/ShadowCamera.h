@@ -3,6 +3,7 @@
 #include "Graphics/Textures/Texture2D.h"
 #include "Gameplay/Components/IComponent.h"
 #include "Graphics/ShaderProgram.h"
+#include "Graphics/Frustum.h"
 
 ENUM_FLAGS(ShadowFlags, uint32_t,
 	None = 0,
@@ -68,6 +69,10 @@ public:
 	/// Returns this light's view projection
 	/// </summary>
 	glm::mat4 GetViewProjection() const;
+	/// <summary>
+	/// Gets the world space frustum planes for this light, for use in culling shadow casters
+	/// </summary>
+	Frustum GetFrustum() const;
 
 	/// <summary>
 	/// Sets the image to use for projection, and enables image projection
@@ -37,7 +37,7 @@ nlohmann::json ShipMoveBehaviour::ToJson() const {
 }
 
 ShipMoveBehaviour::Sptr ShipMoveBehaviour::FromJson(const nlohmann::json & blob) {
-	ShipMoveBehaviour::Sptr result = std::make_shared<ShipMoveBehaviour>();
+	ShipMoveBehaviour::Sptr result = Gameplay::AllocateComponent<ShipMoveBehaviour>();
 	result->Center = blob["center"];
 	result->Angle = blob["angle"];
 	result->Tilt = blob["tilt"];
@@ -135,7 +135,7 @@ nlohmann::json SimpleCameraControl::ToJson() const {
 }
 
 SimpleCameraControl::Sptr SimpleCameraControl::FromJson(const nlohmann::json & blob) {
-	SimpleCameraControl::Sptr result = std::make_shared<SimpleCameraControl>();
+	SimpleCameraControl::Sptr result = Gameplay::AllocateComponent<SimpleCameraControl>();
 	result->_mouseSensitivity = JsonGet(blob, "mouse_sensitivity", result->_mouseSensitivity);
 	result->_moveSpeeds = JsonGet(blob, "move_speed", result->_moveSpeeds);
 	result->_shiftMultipler = JsonGet(blob, "shift_mult", 2.0f);
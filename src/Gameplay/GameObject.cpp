@@ -14,64 +14,22 @@
 #include "Gameplay/Scene.h"
 
 namespace Gameplay {
-	GameObject::GameObject() :
+	GameObject::GameObject(Scene* scene) :
 		IResource(),
-		Name("Unknown"),
+		_name("Unknown"),
 		HideInHierarchy(false),
 		_components(std::vector<IComponent::Sptr>()),
-		_scene(nullptr),
-		_position(ZERO),
-		_rotation(glm::quat(glm::vec3(0.0f))),
-		_scale(ONE),
-		_localTransform(MAT4_IDENTITY),
-		_inverseLocalTransform(MAT4_IDENTITY),
-		_isLocalTransformDirty(true),
-		_worldTransform(MAT4_IDENTITY),
-		_inverseWorldTransform(MAT4_IDENTITY),
-		_isWorldTransformDirty(true),
+		_scene(scene),
+		_transforms(scene->_transforms),
+		_transform(TransformHandle()),
 		_parent(WeakRef()),
 		_children(std::vector<WeakRef>())
-	{ }
-
-	void GameObject::_RecalcLocalTransform() const
 	{
-		if (_isLocalTransformDirty) {
-			_localTransform = glm::translate(MAT4_IDENTITY, _position) * glm::mat4_cast(_rotation) * glm::scale(MAT4_IDENTITY, _scale);
-			_inverseLocalTransform = glm::inverse(_localTransform);
-			_isLocalTransformDirty = false;
-			_isWorldTransformDirty = true;
-
-			// Dirty all the child objects world transforms
-			for (const auto& childPtr : _children) {
-				GameObject::Sptr childSptr = childPtr;
-				if (childSptr != nullptr) {
-					childSptr->_isWorldTransformDirty = true;
-				}
-			}
-		}
+		_transform = _transforms->Allocate();
 	}
 
-	void GameObject::_RecalcWorldTransform() const {
-		// Start by determining our local transform if required
-		_RecalcLocalTransform();
-
-		// If our world transform has been marked as dirty, we need to recalculate it!
-		if (_isWorldTransformDirty) {
-			GameObject::Sptr parent = _parent;
-
-			// If out parent exists, we apply our local transformation relative to the parent's world transformation
-			if (parent != nullptr) {
-				_worldTransform = parent->GetTransform() * _localTransform;
-				_inverseWorldTransform = glm::inverse(_worldTransform);
-			}
-
-			// If our parent is null, we can simply use the local transform as the world transform
-			else {
-				_worldTransform = _localTransform;
-				_inverseWorldTransform = _inverseLocalTransform;
-			}
-			_isWorldTransformDirty = false;
-		}
+	GameObject::~GameObject() {
+		_transforms->Release(_transform);
 	}
 
 	void GameObject::_PurgeDeletedChildren() {
@@ -81,8 +39,22 @@ namespace Gameplay {
 		_children.erase(it, _children.end());
 	}
 
+	const std::string& GameObject::GetName() const {
+		return _name;
+	}
+
+	void GameObject::SetName(const std::string& name) {
+		if (name == _name) return;
+
+		std::string oldName = _name;
+		_name = name;
+		if (_scene != nullptr) {
+			_scene->_OnObjectRenamed(this, oldName);
+		}
+	}
+
 	void GameObject::LookAt(const glm::vec3& point) {
-		glm::mat4 rot = glm::lookAt(_position, point, glm::vec3(0.0f, 0.0f, 1.0f));
+		glm::mat4 rot = glm::lookAt(GetPosition(), point, glm::vec3(0.0f, 0.0f, 1.0f));
 		// Take the conjugate of the quaternion, as lookAt returns the *inverse* rotation
 		SetRotation(glm::conjugate(glm::quat_cast(rot)));
 	}
@@ -112,12 +84,11 @@ namespace Gameplay {
 	}
 
 	void GameObject::SetPostion(const glm::vec3& position) {
-		_position = position;
-		_isLocalTransformDirty = true;
+		_transforms->SetPosition(_transform, position);
 	}
 
 	const glm::vec3& GameObject::GetPosition() const {
-		return _position;
+		return _transforms->GetPosition(_transform);
 	}
 
 	glm::vec3 GameObject::GetWorldPosition() const {
@@ -125,51 +96,44 @@ namespace Gameplay {
 	}
 
 	void GameObject::SetRotation(const glm::quat& value) {
-		_rotation = value;
-		_isLocalTransformDirty = true;
+		_transforms->SetRotation(_transform, value);
 	}
 
 	const glm::quat& GameObject::GetRotation() const {
-		return _rotation;
+		return _transforms->GetRotation(_transform);
 	}
 
 	void GameObject::SetRotation(const glm::vec3& eulerAngles) {
-		_rotation = glm::quat(glm::radians(eulerAngles));
-		_isLocalTransformDirty = true;
+		_transforms->SetRotation(_transform, glm::quat(glm::radians(eulerAngles)));
 	}
 
 	glm::vec3 GameObject::GetRotationEuler() const {
-		return glm::degrees(glm::eulerAngles(_rotation));
+		return glm::degrees(glm::eulerAngles(GetRotation()));
 	}
 
 	void GameObject::SetScale(const glm::vec3& value) {
-		_scale = value;
-		_isLocalTransformDirty = true;
+		_transforms->SetScale(_transform, value);
 	}
 
 	const glm::vec3& GameObject::GetScale() const {
-		return _scale;
+		return _transforms->GetScale(_transform);
 	}
 
 	const glm::mat4& GameObject::GetTransform() const {
-		_RecalcWorldTransform();
-		return _worldTransform;
+		return _transforms->GetWorldTransform(_transform);
 	}
 
 	const glm::mat4& GameObject::GetInverseTransform() const {
-		_RecalcWorldTransform();
-		return _inverseWorldTransform;
+		return _transforms->GetInverseWorldTransform(_transform);
 	}
 
 	const glm::mat4& GameObject::GetLocalTransform() const
 	{
-		_RecalcLocalTransform();
-		return _localTransform;
+		return _transforms->GetLocalTransform(_transform);
 	}
 
 	const glm::mat4& GameObject::GetInverseLocalTransform() const {
-		_RecalcLocalTransform();
-		return _inverseLocalTransform;
+		return _transforms->GetInverseLocalTransform(_transform);
 	}
 
 	void GameObject::RenderGUI() {
@@ -216,8 +180,19 @@ namespace Gameplay {
 			}
 		}
 
-		_RecalcLocalTransform();
-		_RecalcWorldTransform();
+		_FinishUpdate();
+	}
+
+	void GameObject::_UpdateComponents(float dt, uint32_t begin, uint32_t end) {
+		for (uint32_t ix = begin; ix < end && ix < _components.size(); ix++) {
+			IComponent* component = _components[ix].get();
+			if (component->IsEnabled && component->IsParallelSafe()) {
+				component->Update(dt);
+			}
+		}
+	}
+
+	void GameObject::_FinishUpdate() {
 		_PurgeDeletedChildren();
 	}
 
@@ -225,7 +200,7 @@ namespace Gameplay {
 		// Iterate over all the pointers in the components list
 		for (const auto& ptr : _components) {
 			// If the pointer type matches T, we return true
-			if (std::type_index(typeid(*ptr.get())) == type) {
+			if (ptr->_realType == type) {
 				return true;
 			}
 		}
@@ -237,7 +212,7 @@ namespace Gameplay {
 		// Iterate over all the pointers in the binding list
 		for (const auto& ptr : _components) {
 			// If the pointer type matches T, we return that behaviour, making sure to cast it back to the requested type
-			if (std::type_index(typeid(*ptr.get())) == type) {
+			if (ptr->_realType == type) {
 				return ptr;
 			}
 		}
@@ -265,6 +240,8 @@ namespace Gameplay {
 	}
 
 	void GameObject::AddChild(const GameObject::Sptr& child) {
+		LOG_ASSERT(!_scene->IsUpdatingInParallel(), "Cannot re-parent objects during a parallel update, use Scene::Defer");
+
 		// If the object already has a parent, remove it from the other object
 		if (child->_parent != nullptr) {
 			child->_parent->RemoveChild(child);
@@ -279,9 +256,9 @@ namespace Gameplay {
 			// applies to the child
 			_children.push_back(child);
 			child->_parent = _selfRef.lock();
-			child->_isWorldTransformDirty = true;
+			_transforms->SetParent(child->_transform, _transform);
 		} else {
-			LOG_WARN("Attempting to add same child twice, ignoring: {}", child->Name);
+			LOG_WARN("Attempting to add same child twice, ignoring: {}", child->_name);
 		}
 	}
 
@@ -292,6 +269,7 @@ namespace Gameplay {
 		if (it != _children.end()) { 
 			// Clear the object's parent and remove from our list of children
 			child->_parent.Reset();
+			_transforms->SetParent(child->_transform, TransformHandle());
 			_children.erase(it);
 			return true;
 		} else {
@@ -315,16 +293,16 @@ namespace Gameplay {
 		ImGui::PushID(this); // Push a new ImGui ID scope for this object
 		// Since we're allowing names to change, we need to use the ### to have a static ID for the header
 		static char buffer[256];
-		sprintf_s(buffer, 256, "%s###GO_HEADER", Name.c_str());
+		sprintf_s(buffer, 256, "%s###GO_HEADER", _name.c_str());
 		if (ImGui::CollapsingHeader(buffer)) {
 			ImGui::Indent();
 
 			// Draw a textbox for our name
 			static char nameBuff[256];
-			memcpy(nameBuff, Name.c_str(), Name.size());
-			nameBuff[Name.size()] = '\0';
+			memcpy(nameBuff, _name.c_str(), _name.size());
+			nameBuff[_name.size()] = '\0';
 			if (ImGui::InputText("", nameBuff, 256)) {
-				Name = nameBuff;
+				SetName(nameBuff);
 			}
 			ImGui::SameLine();
 			if (ImGuiHelper::WarningButton("Delete")) {
@@ -354,16 +332,19 @@ namespace Gameplay {
 			}
 
 			// Render position label
-			_isLocalTransformDirty |= LABEL_LEFT(ImGui::DragFloat3, "Position", &_position.x, 0.01f);
+			glm::vec3 position = GetPosition();
+			if (LABEL_LEFT(ImGui::DragFloat3, "Position", &position.x, 0.01f)) {
+				SetPostion(position);
+			}
 			
 			// Get the ImGui storage state so we can avoid gimbal locking issues by storing euler angles in the editor
 			glm::vec3 euler = GetRotationEuler();
 			ImGuiStorage* guiStore = ImGui::GetStateStorage();
 
-			// Extract the angles from the storage, note that we're only using the address of the position for unique IDs
-			euler.x = guiStore->GetFloat(ImGui::GetID(&_position.x), euler.x);
-			euler.y = guiStore->GetFloat(ImGui::GetID(&_position.y), euler.y);
-			euler.z = guiStore->GetFloat(ImGui::GetID(&_position.z), euler.z);
+			// Extract the angles from the storage, the IDs are unique since we're inside this object's ID scope
+			euler.x = guiStore->GetFloat(ImGui::GetID("##euler_x"), euler.x);
+			euler.y = guiStore->GetFloat(ImGui::GetID("##euler_y"), euler.y);
+			euler.z = guiStore->GetFloat(ImGui::GetID("##euler_z"), euler.z);
 
 			//Draw the slider for angles
 			if (LABEL_LEFT(ImGui::DragFloat3, "Rotation", &euler.x, 1.0f)) {
@@ -371,16 +352,19 @@ namespace Gameplay {
 				euler = Wrap(euler, -180.0f, 180.0f);
 
 				// Update the editor state with our new values
-				guiStore->SetFloat(ImGui::GetID(&_position.x), euler.x);
-				guiStore->SetFloat(ImGui::GetID(&_position.y), euler.y);
-				guiStore->SetFloat(ImGui::GetID(&_position.z), euler.z);
+				guiStore->SetFloat(ImGui::GetID("##euler_x"), euler.x);
+				guiStore->SetFloat(ImGui::GetID("##euler_y"), euler.y);
+				guiStore->SetFloat(ImGui::GetID("##euler_z"), euler.z);
 
 				//Send new rotation to the gameobject
 				SetRotation(euler);
 			}
 			
 			// Draw the scale
-			_isLocalTransformDirty |= LABEL_LEFT(ImGui::DragFloat3, "Scale   ", &_scale.x, 0.01f, 0.0f);
+			glm::vec3 scale = GetScale();
+			if (LABEL_LEFT(ImGui::DragFloat3, "Scale   ", &scale.x, 0.01f, 0.0f)) {
+				SetScale(scale);
+			}
 
 			ImGui::Separator();
 			ImGui::TextUnformatted("Components");
@@ -438,10 +422,6 @@ namespace Gameplay {
 			ImGui::Unindent();
 		}
 		ImGui::PopID(); // Pop the ImGui ID scope for the object
-
-		// For if we're not in play mode
-		_RecalcLocalTransform();
-		_RecalcWorldTransform();
 	}
 
 	std::shared_ptr<GameObject> GameObject::SelfRef() {
@@ -452,19 +432,16 @@ namespace Gameplay {
 	{
 		// We need to manually construct since the GameObject constructor is
 		// protected. We can call it here since Scene is a friend class of GameObjects
-		GameObject::Sptr result(new GameObject());
-		result->_scene = scene;
+		GameObject::Sptr result(new GameObject(scene));
 
 		// Load in basic info
-		result->Name = data["name"];
+		result->_name = data["name"];
 		result->_guid = Guid(data["guid"]);
 		result->_parent = WeakRef(Guid(data.contains("parent") ? data["parent"] : "null"), nullptr);
-		result->_position = (data["position"]);
-		result->_rotation = (data["rotation"]);
-		result->_scale    = (data["scale"]);
+		result->SetPostion(data["position"]);
+		result->SetRotation((glm::quat)(data["rotation"]));
+		result->SetScale(data["scale"]);
 		result->HideInHierarchy = JsonGet(data, "hide_in_inspector", false);
-		result->_isLocalTransformDirty = true;
-		result->_isWorldTransformDirty = true;
 
 		// Since our components are stored based on the type name, we iterate
 		// on the keys and values from the components object
@@ -487,11 +464,11 @@ namespace Gameplay {
 	nlohmann::json GameObject::ToJson() const {
 		GameObject::Sptr parent = _parent;
 		nlohmann::json result = {
-			{ "name", Name },
+			{ "name", _name },
 			{ "guid", _guid.str() },
-			{ "position", _position },
-			{ "rotation", _rotation },
-			{ "scale",    _scale },
+			{ "position", GetPosition() },
+			{ "rotation", GetRotation() },
+			{ "scale",    GetScale() },
 			{ "parent",   parent == nullptr ? "null" : parent->_guid.str() },
 			{ "hide_in_inspector", HideInHierarchy }
 		};
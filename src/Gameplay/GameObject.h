@@ -11,6 +11,7 @@
 // Others
 #include "Gameplay/Components/IComponent.h"
 #include "Gameplay/Components/ComponentManager.h"
+#include "Gameplay/TransformHierarchy.h"
 #include "Utils/ResourceManager/IResource.h"
 
 class InspectorWindow;
@@ -34,6 +35,8 @@ namespace Gameplay {
 		typedef std::shared_ptr<GameObject> Sptr;
 		typedef std::weak_ptr<GameObject> Wptr;
 
+		virtual ~GameObject();
+
 		/// <summary>
 		/// Structure to assist in wrapping weak references to GameObjects
 		/// Can track the object's GUID before and after creation
@@ -133,12 +136,19 @@ namespace Gameplay {
 			void Reset();
 		};
 
-		// Human readable name for the object
-		std::string             Name;
-
 		// Hack to hide instances from the hierarchy (like when adding lots of instances)
 		bool HideInHierarchy = false;
 
+		/// <summary>
+		/// Gets the human readable name for this object
+		/// </summary>
+		const std::string& GetName() const;
+		/// <summary>
+		/// Renames this object, updating the scene's name index
+		/// </summary>
+		/// <param name="name">The new name for the object</param>
+		void SetName(const std::string& name);
+
 		/// <summary>
 		/// Rotates this object to look at the given point in world coordinates
 		/// </summary>
@@ -253,14 +263,7 @@ namespace Gameplay {
 		/// <typeparam name="T">The type of component to search for</typeparam>
 		template <typename T, typename = typename std::enable_if<std::is_base_of<IComponent, T>::value>::type>
 		bool Has() {
-			// Iterate over all the pointers in the components list
-			for (const auto& ptr : _components) {
-				// If the pointer type matches T, we return true
-				if (std::type_index(typeid(*ptr.get())) == std::type_index(typeid(T))) {
-					return true;
-				}
-			}
-			return false;
+			return _FindComponent(ComponentTypeId<T>()) != nullptr;
 		}
 
 		bool Has(const std::type_index& type);
@@ -271,11 +274,13 @@ namespace Gameplay {
 		/// <typeparam name="T">The type of component to search for</typeparam>
 		template <typename T, typename = typename std::enable_if<std::is_base_of<IComponent, T>::value>::type>
 		std::shared_ptr<T> Get() {
+			ComponentTypeID typeId = ComponentTypeId<T>();
 			// Iterate over all the pointers in the binding list
 			for (const auto& ptr : _components) {
 				// If the pointer type matches T, we return that behaviour, making sure to cast it back to the requested type
-				if (std::type_index(typeid(*ptr.get())) == std::type_index(typeid(T))) {
-					return std::dynamic_pointer_cast<T>(ptr);
+				// Since the concrete type matches exactly, we can skip the dynamic cast
+				if (ptr->_typeId == typeId) {
+					return std::static_pointer_cast<T>(ptr);
 				}
 			}
 			return nullptr;
@@ -293,6 +298,7 @@ namespace Gameplay {
 		std::shared_ptr<T> Add(TArgs&&... args) {
 			static_assert(is_valid_component<T>(), "Type is not a valid component type!");
 			LOG_ASSERT(!Has<T>(), "Cannot add 2 instances of a component type to a game object");
+			LOG_ASSERT(!_scene->IsUpdatingInParallel(), "Cannot add components during a parallel update, use Scene::Defer");
 
 			// Make a new component, forwarding the arguments
 			std::shared_ptr<T> component = _scene->Components().Create<T>(std::forward<TArgs>(args)...);
@@ -339,21 +345,14 @@ namespace Gameplay {
 		friend class InspectorWindow;
 		friend class HierarchyWindow;
 
-		// Rotation of the object as a quaternion
-		glm::quat _rotation;
-		// Position of the object
-		glm::vec3 _position;
-		// The scale of the object
-		glm::vec3 _scale;
+		// Human readable name for the object, only changed through SetName so the scene's
+		// name lookup stays up to date
+		std::string _name;
 
-		// The object's world transform
-		mutable glm::mat4 _localTransform;
-		mutable glm::mat4 _inverseLocalTransform;
-		mutable bool _isLocalTransformDirty;
-
-		mutable glm::mat4 _worldTransform;
-		mutable glm::mat4 _inverseWorldTransform;
-		mutable bool _isWorldTransformDirty;
+		// Our position, rotation, scale and matrices live in the scene's transform hierarchy,
+		// we hold a reference to it so that the node stays valid if we outlive the scene
+		TransformHierarchy::Sptr _transforms;
+		TransformHandle          _transform;
 
 		// For the hierarchy
 		WeakRef _parent;
@@ -371,13 +370,36 @@ namespace Gameplay {
 		/// <summary>
 		/// Only scenes will be allowed to create gameobjects
 		/// </summary>
-		GameObject();
-
-		// Recalculates the transform matrix for the object when required
-		void _RecalcLocalTransform() const;
-		void _RecalcWorldTransform() const;
+		/// <param name="scene">The scene that the object will belong to</param>
+		GameObject(Scene* scene);
 
 		void _PurgeDeletedChildren();
+
+		/// <summary>
+		/// Invokes Update on the enabled parallel-safe components in the given range, used by the
+		/// scene to update runs of parallel-safe components on worker threads
+		/// </summary>
+		/// <param name="dt">The time since the last frame, in seconds</param>
+		/// <param name="begin">The index of the first component to update</param>
+		/// <param name="end">One past the index of the last component to update</param>
+		void _UpdateComponents(float dt, uint32_t begin, uint32_t end);
+		/// <summary>
+		/// Purges dead children after all components have updated, transforms are handled
+		/// separately by the scene's transform hierarchy
+		/// </summary>
+		void _FinishUpdate();
+
+		/// <summary>
+		/// Gets the raw pointer to the component with the given type ID, or nullptr if none is attached
+		/// </summary>
+		inline IComponent* _FindComponent(ComponentTypeID typeId) const {
+			for (const auto& ptr : _components) {
+				if (ptr->_typeId == typeId) {
+					return ptr.get();
+				}
+			}
+			return nullptr;
+		}
 	};
 
 }
\ No newline at end of file
@@ -7,12 +7,67 @@
 #include "Utils/ImGuiHelper.h"
 #include "Graphics/Textures/Texture1D.h"
 #include "Graphics/Textures/Texture3D.h"
+#include "Graphics/GlStateCache.h"
+#include "Graphics/Textures/TextureLoader.h"
+
+#include <algorithm>
+#include <cstring>
 
 namespace Gameplay {
+	/// <summary>
+	/// Returns true if we know how to lay out the given type in a std140 block
+	/// </summary>
+	static bool IsStd140Packable(ShaderDataType type) {
+		switch (GetShaderDataTypeCode(type)) {
+			case ShaderDataTypecode::Float:
+			case ShaderDataTypecode::Int:
+			case ShaderDataTypecode::Uint:
+			case ShaderDataTypecode::Bool:
+			case ShaderDataTypecode::Matrix:
+				return type != ShaderDataType::Uint64;
+			default:
+				return false;
+		}
+	}
+
+	/// <summary>
+	/// Copies a value (or array of values) into a std140 block. Array elements and matrix
+	/// columns are padded out to a vec4, and bools are widened to 4 bytes per component
+	/// </summary>
+	static void PackStd140(std::vector<uint8_t>& block, int offset, ShaderDataType type, const uint8_t* data, size_t arraySize) {
+		const ShaderDataTypecode typeCode = GetShaderDataTypeCode(type);
+		const uint32_t elementSize = ShaderDataTypeSize(type);
+		const uint32_t rows        = (uint32_t)type & ShaderDataType_Size1Mask;
+		const uint32_t columns     = typeCode == ShaderDataTypecode::Matrix ? ((uint32_t)type & ShaderDataType_Size2Mask) >> 3 : 1;
+		const uint32_t arrayStride = columns * 16;
+
+		const size_t extent = (size_t)offset + (arraySize - 1) * arrayStride + (columns - 1) * 16 + rows * 4;
+		if (offset < 0 || extent > block.size()) {
+			LOG_WARN("Material parameter at offset {} does not fit in the parameter block", offset);
+			return;
+		}
+
+		for (size_t ix = 0; ix < arraySize; ix++) {
+			const uint8_t* element = data + ix * elementSize;
+			uint8_t* target = block.data() + offset + ix * arrayStride;
+
+			if (typeCode == ShaderDataTypecode::Bool) {
+				for (uint32_t c = 0; c < rows; c++) {
+					uint32_t value = element[c] ? 1 : 0;
+					memcpy(target + c * 4, &value, 4);
+				}
+			} else {
+				for (uint32_t c = 0; c < columns; c++) {
+					memcpy(target + c * 16, element + c * rows * 4, rows * 4);
+				}
+			}
+		}
+	}
+
 	Material::Material(const ShaderProgram::Sptr& shader) :
 		IResource(),
 		_shader(shader),
-		_uniforms(std::unordered_map<std::string, UniformData>())
+		_parameters(std::make_shared<ParameterBlock>())
 	{
 		_PopulateUniforms();
 	}
@@ -20,40 +75,60 @@ namespace Gameplay {
 	Material::Material() :
 		IResource(),
 		_shader(nullptr),
-		_uniforms(std::unordered_map<std::string, UniformData>())
+		_parameters(std::make_shared<ParameterBlock>())
 	{ }
 
 	void Material::Set(const std::string& name, ShaderDataType type, const void* value, size_t arraySize)
 	{
 		// Try and find the matching uniform
-		UniformData& uniform = _GetUniform(name);
+		auto it = _parameters->Lookup.find(name);
+		if (it == _parameters->Lookup.end()) {
+			LOG_WARN("Failed to set parameter \"{}\" in material \"{}\", shader uniform not found", name, Name);
+			return;
+		}
+		const UniformData& current = _parameters->Parameters[it->second];
+		const bool isTexture = current.IsTextureResource() && type == ShaderDataType::None;
 
-		// We have a uniform, let's see if we can update it
-		if (uniform.Location != -2) {
-			// If it's a texture, we update TextureAsset so it adds to the ref count
-			if (GetShaderDataTypeCode(uniform.Type) == ShaderDataTypecode::Texture && type == ShaderDataType::None) {
-				uniform.TextureAsset = *reinterpret_cast<const ITexture::Sptr*>(value);
-			}
-			// Check for type mismatch
-			else if (uniform.Type != type && uniform.Type != ShaderDataType::None) {
-				LOG_ERROR("Type mismatch for \"{}\", uniform is {}, passed {} in material \"{}\"", name, ~uniform.Type, ~type, Name);
-			}
-			// Types match, we're good to go
-			else {
-				// if it's an array, copy all the elements
-				if (uniform.ArraySize > 1) {
-					memcpy(uniform.ArrayBlock, value, ShaderDataTypeSize(type) * arraySize);
-				} 
-				// if it's just a value, copy the value
-				else {
-					memcpy(uniform.Value, value, ShaderDataTypeSize(type));
-				}
+		// Check for type mismatch
+		if (!isTexture && current.Type != type) {
+			LOG_ERROR("Type mismatch for \"{}\", uniform is {}, passed {} in material \"{}\"", name, ~current.Type, ~type, Name);
+			return;
+		}
+
+		// Skip values that haven't actually changed, so that we don't needlessly split from our clones
+		size_t size = isTexture ? 0 : ShaderDataTypeSize(type) * std::min(arraySize, current.ArraySize);
+		if (isTexture) {
+			if (current.TextureAsset == *reinterpret_cast<const ITexture::Sptr*>(value)) {
+				return;
 			}
+		} else if (memcmp(current.ArraySize > 1 ? current.ArrayBlock : current.Value, value, size) == 0) {
+			return;
 		}
-		// We couldn't find that uniform, log a warning
+
+		_MakeUnique();
+		UniformData& uniform = _parameters->Parameters[it->second];
+
+		// If it's a texture, we update TextureAsset so it adds to the ref count
+		if (isTexture) {
+			uniform.TextureAsset = *reinterpret_cast<const ITexture::Sptr*>(value);
+		}
+		// if it's an array, copy all the elements
+		else if (uniform.ArraySize > 1) {
+			memcpy(uniform.ArrayBlock, value, size);
+		}
+		// if it's just a value, copy the value
 		else {
-			LOG_WARN("Failed to set parameter \"{}\" in material \"{}\", shader uniform not found", name, Name);
+			memcpy(uniform.Value, value, size);
 		}
+		_parameters->IsDirty = true;
+	}
+
+	ITexture::Sptr Material::GetTexture(const std::string& name) const {
+		const UniformData* uniform = _FindUniform(name);
+		if (uniform == nullptr || !uniform->IsTextureResource()) {
+			return nullptr;
+		}
+		return uniform->TextureAsset;
 	}
 
 	const ShaderProgram::Sptr& Material::GetShader() const {
@@ -62,38 +137,32 @@ namespace Gameplay {
 
 	void Material::Apply() {
 		if (_shader != nullptr) {
-			// Skip the reserved # of texture slots
-			int textureSlot = 0;
-			
-			// Iterate over the uniforms map
-			for (auto&[name, data] : _uniforms) {
-				// The typecode is basically the underlying type of the uniform
-				// ex: float, matrix, texture, etc...
-				ShaderDataTypecode typeCode = GetShaderDataTypeCode(data.Type);
-
-				// If the uniform is a texture, we try and bind it, then move to the next slot
-				if (typeCode == ShaderDataTypecode::Texture) {
-					if (textureSlot >= MAX_TEXTURE_SLOTS) {
-						LOG_WARN("Ignoring material binding, exceeds allowed number of textures");
-					}
-					else {
-						ITexture::Sptr texture = data.TextureAsset;
-						if (texture != nullptr) {
-							texture->Bind(textureSlot);
-						}
-						else {
-							ITexture::Unbind(textureSlot);
-						}
-						// Send the slot to the shader
-						_shader->SetUniform(data.Location, data.Type, &textureSlot);
-						textureSlot++;
-					}
-				}
-				// The uniform is a plain ol' value type, send it in
-				else {
-					_shader->SetUniform(data.Location, data.Type, data.ArraySize > 1 ? data.ArrayBlock : data.Value, data.ArraySize);
+			ParameterBlock& params = *_parameters;
+			if (params.IsDirty) {
+				_FlushParameters();
+			} else if (params.TextureGeneration != TextureLoader::GetLoadGeneration()) {
+				_FetchTextureHandles();
+			}
+
+			// Textures all go down in one call. Every material using this shader has the same layout,
+			// so after the first material the sampler uniforms get caught by the shader's uniform cache
+			if (params.TextureCount > 0) {
+				GlStateCache::BindTextures(0, params.TextureCount, params.TextureHandles.data());
+				for (uint32_t ix = 0; ix < params.TextureCount; ix++) {
+					UniformData& data = params.Parameters[ix];
+					_shader->SetUniform(data.Location, data.Type, &data.BindingSlot);
 				}
 			}
+
+			// Uniforms that live outside of the parameter block still have to go through the shader
+			for (uint32_t ix = params.TextureCount; ix < params.BlockStart; ix++) {
+				UniformData& data = params.Parameters[ix];
+				_shader->SetUniform(data.Location, data.Type, data.ArraySize > 1 ? data.ArrayBlock : data.Value, data.ArraySize);
+			}
+
+			if (params.Buffer != nullptr) {
+				params.Buffer->Bind(params.BlockBinding);
+			}
 		}
 	}
 
@@ -106,10 +175,17 @@ namespace Gameplay {
 
 		if (open) {
 			ImGui::Text("Shader: %s", _shader != nullptr ? _shader->GetDebugName().c_str() : "null");
-			// Draw all of our valid uniforms
-			for (auto&[key, value] : _uniforms) {
-				if (value.Location != -2 && value.Location != -1) {
-					value.RenderImGui();
+			if (_parameters.use_count() > 1) {
+				ImGui::Text("Parameters shared with %d clone(s)", (int)_parameters.use_count() - 1);
+			}
+
+			// Draw all of our uniforms, we edit a copy so that we don't modify any clones we share parameters with
+			for (uint32_t ix = 0; ix < _parameters->Parameters.size(); ix++) {
+				UniformData value = _parameters->Parameters[ix];
+				if (value.RenderImGui()) {
+					_MakeUnique();
+					_parameters->Parameters[ix] = std::move(value);
+					_parameters->IsDirty = true;
 				}
 			}
 
@@ -122,8 +198,12 @@ namespace Gameplay {
 
 	Material::Sptr Material::Clone() const
 	{
-		// hehe, neat lil' hack
-		return FromJson(ToJson());
+		// The clone gets a new GUID, but shares our parameters until one of us changes them
+		Material::Sptr result = std::make_shared<Material>();
+		result->Name = Name;
+		result->_shader = _shader;
+		result->_parameters = _parameters;
+		return result;
 	}
 
 	Material::Sptr Material::FromJson(const nlohmann::json& data) {
@@ -136,12 +216,15 @@ namespace Gameplay {
 
 		// material specific parameters'
 		if (data.contains("parameters") && data["parameters"].is_object()) {
+			ParameterBlock& params = *result->_parameters;
+
 			// Iterate over all objects
 			for (auto& [key, value] : data["parameters"].items()) {
-				// Try loading a uniform from the blob, if successful, store it
-				Material::UniformData uniform = Material::UniformData::FromJson(value, key, result->_shader);
-				if (uniform.Location != -2) {
-					result->_uniforms[key] = uniform;
+				// Try loading the value into the matching parameter
+				auto it = params.Lookup.find(key);
+				if (it != params.Lookup.end()) {
+					UniformData& uniform = params.Parameters[it->second];
+					uniform = Material::UniformData::FromJson(value, uniform);
 				}
 			}
 		}
@@ -157,43 +240,130 @@ namespace Gameplay {
 		};
 
 		// Store all the uniforms
-		for (auto& [key, value] : _uniforms) {
-			if (value.Location != -1) {
-				result["parameters"][key] = value.ToJson();
-			}
+		for (const UniformData& value : _parameters->Parameters) {
+			result["parameters"][value.Name] = value.ToJson();
 		}
 
 		return result;
 	}
 
-	Material::UniformData& Material::_GetUniform(const std::string& name)
+	const Material::UniformData* Material::_FindUniform(const std::string& name) const
 	{
-		UniformData& data = _uniforms[name];
-		if (data.Location == -2) {
-			ShaderProgram::UniformInfo uniform;
-			if (_shader->FindUniform(name, &uniform)) {
-				// Ignoring our reserved textures
-				if (GetShaderDataTypeCode(uniform.Type) == ShaderDataTypecode::Texture && uniform.Binding >= MAX_TEXTURE_SLOTS) {
-					data.Location = -1;
-				}
-				else {
-					data = UniformData(name, _shader);
+		auto it = _parameters->Lookup.find(name);
+		return it != _parameters->Lookup.end() ? &_parameters->Parameters[it->second] : nullptr;
+	}
+
+	void Material::_PopulateUniforms()
+	{
+		_parameters = std::make_shared<ParameterBlock>();
+		if (_shader == nullptr) {
+			return;
+		}
+		ParameterBlock& params = *_parameters;
+
+		// Loose uniforms, ignoring our reserved textures
+		for (const auto& [key, value] : _shader->GetUniforms()) {
+			if (GetShaderDataTypeCode(value.Type) == ShaderDataTypecode::Texture && value.Binding >= MAX_TEXTURE_SLOTS) {
+				continue;
+			}
+			params.Parameters.emplace_back(key, value);
+		}
+
+		// Members of the parameter block, exposed under the material struct's name
+		const ShaderProgram::UniformBlockInfo* block = _shader->FindUniformBlock(PARAMETER_BLOCK_NAME);
+		if (block != nullptr) {
+			const std::string prefix = std::string(PARAMETER_BLOCK_NAME) + ".";
+			for (const auto& member : block->SubUniforms) {
+				if (!IsStd140Packable(member.Type)) {
+					LOG_WARN("Cannot pack \"{}\" ({}) into the parameter block for shader \"{}\"", member.Name, ~member.Type, _shader->GetDebugName());
+					continue;
 				}
-			} else {
-				data.Location = -1;
+				std::string name = member.Name.rfind(prefix, 0) == 0 ? member.Name.substr(prefix.size()) : member.Name;
+				UniformData data = UniformData("u_Material." + name, member);
+				data.IsBlockMember = true;
+				params.Parameters.push_back(std::move(data));
 			}
+			params.BlockData.resize(block->SizeInBytes, 0);
+			params.BlockBinding = block->DefaultBinding;
 		}
-		return data;
+
+		// Textures first, then loose uniforms, then the block, each sorted by location
+		auto group = [](const UniformData& data) { return data.IsTextureResource() ? 0 : (data.IsBlockMember ? 2 : 1); };
+		std::sort(params.Parameters.begin(), params.Parameters.end(), [&](const UniformData& a, const UniformData& b) {
+			int groupA = group(a), groupB = group(b);
+			return groupA != groupB ? groupA < groupB : a.Location < b.Location;
+		});
+
+		// Drop any textures that we don't have slots for
+		uint32_t textureCount = 0;
+		while (textureCount < params.Parameters.size() && params.Parameters[textureCount].IsTextureResource()) {
+			textureCount++;
+		}
+		if (textureCount > MAX_TEXTURE_SLOTS) {
+			LOG_WARN("Shader \"{}\" uses {} material textures, ignoring all but the first {}", _shader->GetDebugName(), textureCount, MAX_TEXTURE_SLOTS);
+			params.Parameters.erase(params.Parameters.begin() + MAX_TEXTURE_SLOTS, params.Parameters.begin() + textureCount);
+			textureCount = MAX_TEXTURE_SLOTS;
+		}
+
+		params.TextureCount = textureCount;
+		params.BlockStart = (uint32_t)params.Parameters.size();
+		for (uint32_t ix = 0; ix < params.Parameters.size(); ix++) {
+			UniformData& data = params.Parameters[ix];
+			if (ix < textureCount) {
+				data.BindingSlot = ix;
+			}
+			if (data.IsBlockMember && ix < params.BlockStart) {
+				params.BlockStart = ix;
+			}
+			params.Lookup[data.Name] = ix;
+		}
+		params.TextureHandles.resize(textureCount, 0);
+		params.IsDirty = true;
 	}
 
-	void Material::_PopulateUniforms()
+	void Material::_MakeUnique()
 	{
-		const auto& uniforms = _shader->GetUniforms();
-		for (const auto& [key, value] : uniforms) {
-			_uniforms[key] = _GetUniform(key);
+		if (_parameters.use_count() > 1) {
+			_parameters = std::make_shared<ParameterBlock>(*_parameters);
+			// We need our own buffer, the old one still belongs to our clones
+			_parameters->Buffer = nullptr;
+			_parameters->IsDirty = true;
 		}
 	}
 
+	void Material::_FlushParameters()
+	{
+		ParameterBlock& params = *_parameters;
+
+		_FetchTextureHandles();
+
+		if (!params.BlockData.empty()) {
+			for (uint32_t ix = params.BlockStart; ix < params.Parameters.size(); ix++) {
+				const UniformData& data = params.Parameters[ix];
+				const uint8_t* value = data.ArraySize > 1 ? (const uint8_t*)data.ArrayBlock : data.Value;
+				PackStd140(params.BlockData, data.Location, data.Type, value, data.ArraySize);
+			}
+
+			if (params.Buffer == nullptr) {
+				params.Buffer = std::make_shared<AbstractUniformBuffer>((uint32_t)params.BlockData.size(), BufferUsage::StaticDraw);
+			}
+			params.Buffer->LoadData(params.BlockData.data(), 1, (uint32_t)params.BlockData.size());
+		}
+
+		params.IsDirty = false;
+	}
+
+	void Material::_FetchTextureHandles()
+	{
+		ParameterBlock& params = *_parameters;
+
+		for (uint32_t ix = 0; ix < params.TextureCount; ix++) {
+			const ITexture::Sptr& texture = params.Parameters[ix].TextureAsset;
+			params.TextureHandles[ix] = texture != nullptr ? texture->GetHandle() : 0;
+		}
+		params.TextureGeneration = TextureLoader::GetLoadGeneration();
+	}
+
 	bool Material::UniformData::RenderImGui() {
 		ImGui::PushID(Name.c_str());
 
@@ -302,6 +472,7 @@ namespace Gameplay {
 						Texture2D::Sptr tex = std::dynamic_pointer_cast<Texture2D>(TextureAsset);
 						if (ImGuiHelper::DrawTextureDrop(tex, ImVec2(ImGui::GetTextLineHeight() * 2, ImGui::GetTextLineHeight() * 2))) {
 							TextureAsset = tex;
+							modified = true;
 						}
 					}
 						break;
@@ -395,22 +566,22 @@ namespace Gameplay {
 		return *this;
 	}
 
-	Material::UniformData::UniformData(const std::string& uniformName, const ShaderProgram::Sptr& shader) :
+	Material::UniformData::UniformData(const std::string& name, const ShaderProgram::UniformInfo& uniform) :
 		TextureAsset(nullptr)
 	{
-		// We extract the uniform info from the shader to populate our info
-		ShaderProgram::UniformInfo uniform;
-		if (shader != nullptr && shader->FindUniform(uniformName, &uniform)) {
-			Name = uniformName;
-			Location = uniform.Location;
-			Type = uniform.Type;
-			ArraySize = uniform.ArraySize;
-			BindingSlot = uniform.Binding;
-			
-			// Allocate memory for array if the uniform is an array
-			if (ArraySize > 1) {
-				ArrayBlock = malloc(ShaderDataTypeSize(Type) * ArraySize);
-			}
+		// Copy in the info that the shader extracted for the uniform
+		Name = name;
+		Location = uniform.Location;
+		Type = uniform.Type;
+		ArraySize = uniform.ArraySize;
+		BindingSlot = uniform.Binding;
+		IsBlockMember = false;
+
+		// Allocate memory for array if the uniform is an array, otherwise make sure we start zeroed
+		if (ArraySize > 1) {
+			ArrayBlock = calloc(ArraySize, ShaderDataTypeSize(Type));
+		} else if (GetShaderDataTypeCode(Type) != ShaderDataTypecode::Texture) {
+			memset(Value, 0, sizeof(Value));
 		}
 	}
 
@@ -421,6 +592,8 @@ namespace Gameplay {
 		Location = other.Location;
 		ArraySize = other.ArraySize;
 		Type = other.Type;
+		BindingSlot = other.BindingSlot;
+		IsBlockMember = other.IsBlockMember;
 
 		if (GetShaderDataTypeCode(Type) == ShaderDataTypecode::Texture) {
 			TextureAsset = other.TextureAsset;
@@ -429,7 +602,7 @@ namespace Gameplay {
 		if (ArraySize > 1) {
 			ArrayBlock = malloc(ShaderDataTypeSize(Type) * ArraySize);
 			memcpy(ArrayBlock, other.ArrayBlock, ShaderDataTypeSize(Type) * ArraySize);
-		} else {
+		} else if (GetShaderDataTypeCode(Type) != ShaderDataTypecode::Texture) {
 			memcpy(Value, other.Value, ShaderDataTypeSize(Type));
 		}
 	}
@@ -441,6 +614,8 @@ namespace Gameplay {
 		Location  = other.Location;
 		ArraySize = other.ArraySize;
 		Type      = other.Type;
+		BindingSlot   = other.BindingSlot;
+		IsBlockMember = other.IsBlockMember;
 
 		if (GetShaderDataTypeCode(Type) == ShaderDataTypecode::Texture) {
 			TextureAsset = other.TextureAsset;
@@ -450,7 +625,7 @@ namespace Gameplay {
 			ArrayBlock = other.ArrayBlock;
 			other.ArrayBlock = nullptr;
 			other.ArraySize  = 0;
-		} else {
+		} else if (GetShaderDataTypeCode(Type) != ShaderDataTypecode::Texture) {
 			memcpy(Value, other.Value, ShaderDataTypeSize(Type));
 		}
 	}
@@ -634,12 +809,13 @@ namespace Gameplay {
 		return result;
 	}
 
-	Material::UniformData Material::UniformData::FromJson(const nlohmann::json& blob, const std::string& name, const ShaderProgram::Sptr& shader) {
+	Material::UniformData Material::UniformData::FromJson(const nlohmann::json& blob, const UniformData& layout) {
 		ShaderDataType type = ParseShaderDataType(JsonGet<std::string>(blob, "type"), ShaderDataType::None);
-		if (type == ShaderDataType::None) {
-			return Material::UniformData();
+		if (type != layout.Type) {
+			LOG_WARN("Ignoring stored value for \"{}\", stored as {} but the shader expects {}", layout.Name, ~type, ~layout.Type);
+			return layout;
 		}
-		Material::UniformData result = Material::UniformData(name, shader);
+		Material::UniformData result = layout;
 		
 		switch (type)
 		{
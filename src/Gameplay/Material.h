@@ -1,7 +1,9 @@
 #pragma once
 #include <memory>
+#include <vector>
 #include "Graphics/ShaderProgram.h"
 #include "Graphics/Textures/ITexture.h"
+#include "Graphics/Buffers/UniformBuffer.h"
 
 namespace Gameplay {
 	/// <summary>
@@ -19,6 +21,15 @@ namespace Gameplay {
 		/// </summary>
 		static const int MAX_TEXTURE_SLOTS = 14;
 
+		/// <summary>
+		/// Shaders can declare a std140 uniform block with this name to hold their non-texture
+		/// material parameters. The material keeps the block in it's own uniform buffer, so it only
+		/// needs to be uploaded when a parameter changes. Members of the block are exposed as
+		/// "u_Material.<member>", so parameter names stay the same as when they lived in the
+		/// material struct
+		/// </summary>
+		static constexpr const char* PARAMETER_BLOCK_NAME = "b_Material";
+
 		/// <summary>
 		/// A human readable name for the material
 		/// </summary>
@@ -55,6 +66,28 @@ namespace Gameplay {
 		/// <param name="arraySize">The array size in the event that the value is an array</param>
 		void Set(const std::string& name, ShaderDataType type, const void* value, size_t arraySize = 1ul);
 
+		/// <summary>
+		/// Gets the value of a non-array material parameter
+		/// </summary>
+		/// <typeparam name="T">The type of parameter to get, must match the uniform's type</typeparam>
+		/// <param name="name">The name of the parameter, should match the uniform name</param>
+		/// <param name="fallback">The value to return if the parameter does not exist or the type does not match</param>
+		template <typename T>
+		T Get(const std::string& name, const T& fallback) const {
+			const UniformData* uniform = _FindUniform(name);
+			if (uniform == nullptr || uniform->ArraySize > 1 || uniform->Type != GetShaderDataType<T>()) {
+				return fallback;
+			}
+			return *reinterpret_cast<const T*>(uniform->Value);
+		}
+
+		/// <summary>
+		/// Gets the texture assigned to a texture parameter
+		/// </summary>
+		/// <param name="name">The name of the parameter, should match the uniform name</param>
+		/// <returns>The texture, or nullptr if the parameter does not exist or is not a texture</returns>
+		ITexture::Sptr GetTexture(const std::string& name) const;
+
 		/// <summary>
 		/// Gets the shader that this material is using
 		/// </summary>
@@ -62,7 +95,8 @@ namespace Gameplay {
 
 		/// <summary>
 		/// Handles applying this material's state to the OpenGL pipeline
-		/// Will bind the shader, update material uniforms, and bind textures
+		/// Will re-upload the parameter block if it has changed, bind it, and bind all
+		/// textures in a single call
 		/// </summary>
 		virtual void Apply();
 
@@ -73,7 +107,8 @@ namespace Gameplay {
 
 		/// <summary>
 		/// Creates a clone of this material, useful for cases where you have many similar 
-		/// materials with slight variations
+		/// materials with slight variations. The clone shares this material's parameters
+		/// until one of the two is modified
 		/// </summary>
 		Material::Sptr Clone() const;
 
@@ -93,7 +128,7 @@ namespace Gameplay {
 		struct UniformData {
 			// The name of the uniform in the shader
 			std::string    Name;
-			// Location of the uniform within the shader
+			// Location of the uniform within the shader, or the byte offset for members of the parameter block
 			int            Location = -2;
 			union {
 				// A space to store non-array values, can store up to a dmat4
@@ -107,7 +142,10 @@ namespace Gameplay {
 			};
 			// The size of the array, in elements
 			size_t         ArraySize;
+			// The texture unit that textures are bound to
 			int            BindingSlot;
+			// True if the uniform lives in the material's parameter block
+			bool           IsBlockMember;
 
 			// The type of uniform
 			ShaderDataType Type = ShaderDataType::None;
@@ -118,13 +156,14 @@ namespace Gameplay {
 				TextureAsset(nullptr),
 				ArraySize(0),
 				BindingSlot(-1),
+				IsBlockMember(false),
 				Type(ShaderDataType::None) 
 			{ }
 			UniformData(const UniformData& other);
 			UniformData(UniformData&& other);
 			UniformData& operator=(const UniformData& other);
 			UniformData& operator=(UniformData&& other) noexcept;
-			UniformData(const std::string& uniformName, const ShaderProgram::Sptr& shader);
+			UniformData(const std::string& name, const ShaderProgram::UniformInfo& uniform);
 			~UniformData();
 
 			/// <summary>
@@ -137,10 +176,11 @@ namespace Gameplay {
 			/// </summary>
 			nlohmann::json ToJson() const;
 			/// <summary>
-			/// Parses a uniform information structure from a JSON blob
+			/// Parses a uniform's value from a JSON blob
 			/// </summary>
 			/// <param name="blob">The JSON blob to parse</param>
-			static UniformData FromJson(const nlohmann::json& blob, const std::string& name, const ShaderProgram::Sptr& shader);
+			/// <param name="layout">The uniform from the material's layout that the value is for</param>
+			static UniformData FromJson(const nlohmann::json& blob, const UniformData& layout);
 
 			template <typename T>
 			T& Get() {
@@ -170,12 +210,45 @@ namespace Gameplay {
 		/// The shader that the material is using
 		/// </summary>
 		ShaderProgram::Sptr    _shader;
+
+		/// <summary>
+		/// A material's parameters, compiled into a flat layout that is sorted so that
+		/// textures come first in slot order, followed by loose uniforms by location, followed
+		/// by members of the parameter block by offset. Shared between clones of a material
+		/// until one of them is modified
+		/// </summary>
+		struct ParameterBlock {
+			std::vector<UniformData> Parameters;
+			// Maps parameter names to their index in Parameters
+			std::unordered_map<std::string, uint32_t> Lookup;
+			// Parameters[0, TextureCount) are textures, bound to slots 0..TextureCount-1
+			uint32_t TextureCount = 0;
+			// Parameters[BlockStart, end) are members of the parameter block
+			uint32_t BlockStart = 0;
+
+			// The texture handles to hand to glBindTextures, one per texture parameter
+			std::vector<GLuint> TextureHandles;
+			// The TextureLoader generation when we fetched the handles, textures that were still
+			// streaming in hand out a placeholder's handle so we fetch them again when it changes
+			uint32_t TextureGeneration = 0;
+			// A std140 copy of the parameter block, and the buffer it gets uploaded to
+			std::vector<uint8_t> BlockData;
+			AbstractUniformBuffer::Sptr Buffer = nullptr;
+			int BlockBinding = -1;
+
+			// Set whenever a parameter changes, so the handles and buffer get refreshed on the next Apply
+			bool IsDirty = true;
+		};
+
 		/// <summary>
-		/// The uniforms that the material will be modifying
+		/// The parameters that the material will be modifying
 		/// </summary>
-		std::unordered_map<std::string, UniformData> _uniforms;
+		std::shared_ptr<ParameterBlock> _parameters;
 
-		UniformData& _GetUniform(const std::string& name);
+		const UniformData* _FindUniform(const std::string& name) const;
 		void _PopulateUniforms();
+		void _MakeUnique();
+		void _FlushParameters();
+		void _FetchTextureHandles();
 	};
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "MeshResource.h"
 #include <filesystem>
 
-#include "Utils/ObjLoader.h"
+#include "Utils/OptimizedObjLoader.h"
 
 namespace Gameplay {
 	MeshResource::MeshResource() :
@@ -9,6 +9,7 @@ namespace Gameplay {
 		Filename(""),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
 		Mesh(nullptr),
+		Bounds(),
 		BulletTriMesh(nullptr)
 	{ }
 
@@ -17,9 +18,10 @@ namespace Gameplay {
 		Filename(filename),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
 		Mesh(nullptr),
+		Bounds(),
 		BulletTriMesh(nullptr)
 	{
-		Mesh = ObjLoader::LoadFromFile(filename);
+		_LoadFromFile();
 	}
 
 	MeshResource::~MeshResource() = default;
@@ -52,15 +54,11 @@ namespace Gameplay {
 			}
 			MeshFactory::CalculateTBN(mesh);
 			result->Mesh = mesh.Bake();
+			result->Bounds = BoundingVolume::FromPoints(mesh.GetVertexDataPtr(), mesh.GetVertexCount(), sizeof(VertexPosNormTexColTangents));
 		} else {
 			result->Filename = JsonGet<std::string>(blob, "filename", "null");
 			if (result->Filename != "null" && std::filesystem::exists(result->Filename)) {
-				#ifdef OPTIMIZED_OBJ_LOADER
-				result->Mesh = OptimizedObjLoader::LoadFromFile(result->Filename);
-				#else
-				result->Mesh = ObjLoader::LoadFromFile(result->Filename);
-				#endif
-
+				result->_LoadFromFile();
 			}
 		}
 		return result;
@@ -73,9 +71,22 @@ namespace Gameplay {
 		}
 		MeshFactory::CalculateTBN(mesh);
 		Mesh = mesh.Bake();
+		Bounds = BoundingVolume::FromPoints(mesh.GetVertexDataPtr(), mesh.GetVertexCount(), sizeof(VertexPosNormTexColTangents));
 	}
 
 	void MeshResource::AddParam(const MeshBuilderParam & param) {
 		MeshBuilderParams.push_back(param);
 	}
+
+	void MeshResource::_LoadFromFile() {
+		// The submesh table has the bounds already, so we never need the vertices back from the GPU
+		OptimizedObjLoader::MeshTables tables;
+		Mesh = OptimizedObjLoader::LoadFromFile(Filename, &tables);
+		Bounds = BoundingVolume();
+		for (const auto& submesh : tables.Submeshes) {
+			glm::vec3 min = Bounds.IsValid ? glm::min(Bounds.Min, submesh.BoundsMin) : submesh.BoundsMin;
+			glm::vec3 max = Bounds.IsValid ? glm::max(Bounds.Max, submesh.BoundsMax) : submesh.BoundsMax;
+			Bounds = BoundingVolume::FromMinMax(min, max);
+		}
+	}
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/BoundingVolume.h"
 #include "Utils/MeshFactory.h"
 
 // bullet triangle mesh pre-declaration
@@ -40,7 +41,10 @@ namespace Gameplay {
 		/// The VAO for rendering this mesh in OpenGL
 		/// </summary>
 		VertexArrayObject::Sptr         Mesh;
-
+		/// <summary>
+		/// The local space bounds of the mesh, calculated when the mesh is generated or loaded
+		/// </summary>
+		BoundingVolume                  Bounds;
 
 		/// <summary>
 		/// The optional mesh resource for generating colliders from this mesh
@@ -65,5 +69,11 @@ namespace Gameplay {
 
 		virtual nlohmann::json ToJson() const override;
 		static MeshResource::Sptr FromJson(const nlohmann::json& blob);
+
+	protected:
+		/// <summary>
+		/// Loads Mesh from Filename, taking Bounds from the file's submesh table
+		/// </summary>
+		void _LoadFromFile();
 	};
 }
\ No newline at end of file
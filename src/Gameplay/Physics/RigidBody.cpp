@@ -281,7 +281,7 @@ namespace Gameplay::Physics {
 	}
 
 	RigidBody::Sptr RigidBody::FromJson(const nlohmann::json& data) {
-		RigidBody::Sptr result = std::make_shared<RigidBody>();
+		RigidBody::Sptr result = AllocateComponent<RigidBody>();
 		// Read out the RigidBody config
 		result->_type = ParseRigidBodyType(data["type"], RigidBodyType::Unknown);
 		result->_mass = data["mass"];
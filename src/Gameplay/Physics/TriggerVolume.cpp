@@ -186,7 +186,7 @@ namespace Gameplay::Physics {
 	}
 
 	TriggerVolume::Sptr TriggerVolume::FromJson(const nlohmann::json& data) {
-		TriggerVolume::Sptr result = std::make_shared<TriggerVolume>();
+		TriggerVolume::Sptr result = AllocateComponent<TriggerVolume>();
 		result->FromJsonBase(data);
 		return result;
 	}
@@ -3,8 +3,11 @@
 #include <GLFW/glfw3.h>
 #include <locale>
 #include <codecvt>
+#include <unordered_set>
 
 #include "Utils/FileHelpers.h"
+#include "Utils/JobSystem.h"
+#include "Utils/Profiler.h"
 #include "Utils/GlmBulletConversions.h"
 
 #include "Gameplay/Physics/RigidBody.h"
@@ -15,6 +18,7 @@
 #include "Graphics/DebugDraw.h"
 #include "Graphics/Textures/TextureCube.h"
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/GlStateCache.h"
 #include "Application/Application.h"
 
 namespace Gameplay {
@@ -23,6 +27,8 @@ namespace Gameplay {
 		_deletionQueue(std::vector<std::weak_ptr<GameObject>>()),
 		IsPlaying(false),
 		IsDestroyed(false),
+		_isUpdatingInParallel(false),
+		_transforms(std::make_shared<TransformHierarchy>()),
 		MainCamera(nullptr),
 		DefaultMaterial(nullptr),
 		_isAwake(false),
@@ -47,6 +53,8 @@ namespace Gameplay {
 		_skyboxShader = nullptr;
 		_skyboxMesh = nullptr;
 		_skyboxTexture = nullptr;
+		_objectsByGuid.clear();
+		_objectsByName.clear();
 		_objects.clear();
 		_components.Clear();
 		_CleanupPhysics();
@@ -95,33 +103,43 @@ namespace Gameplay {
 
 	GameObject::Sptr Scene::CreateGameObject(const std::string& name)
 	{
-		GameObject::Sptr result(new GameObject());
-		result->Name = name;
+		LOG_ASSERT(!_isUpdatingInParallel, "Cannot create objects during a parallel update, use Scene::Defer");
+
+		GameObject::Sptr result(new GameObject(this));
+		result->_name = name;
 		result->_scene = this;
 		result->_selfRef = result;
 		_objects.push_back(result);
+		_IndexObject(result.get());
 		return result;
 	}
 
 	void Scene::RemoveGameObject(const GameObject::Sptr& object) {
+		std::lock_guard<std::mutex> lock(_deferredMutex);
+		_QueueDeletion(object);
+	}
+
+	void Scene::_QueueDeletion(const GameObject::Sptr& object) {
 		_deletionQueue.push_back(object);
 		for (const auto& child : object->_children) {
-			RemoveGameObject(child);
+			_QueueDeletion(child);
 		}
 	}
 
+	void Scene::Defer(std::function<void()> action) {
+		std::lock_guard<std::mutex> lock(_deferredMutex);
+		_deferredActions.push_back(std::move(action));
+	}
+
 	GameObject::Sptr Scene::FindObjectByName(const std::string name) const {
-		auto it = std::find_if(_objects.begin(), _objects.end(), [&](const GameObject::Sptr& obj) {
-			return obj->Name == name;
-		});
-		return it == _objects.end() ? nullptr : *it;
+		// Buckets are in the order the objects were added, so the first entry is our result
+		auto it = _objectsByName.find(name);
+		return it == _objectsByName.end() ? nullptr : it->second.front()->SelfRef();
 	}
 
 	GameObject::Sptr Scene::FindObjectByGUID(Guid id) const {
-		auto it = std::find_if(_objects.begin(), _objects.end(), [&](const GameObject::Sptr& obj) {
-			return obj->_guid == id;
-		});
-		return it == _objects.end() ? nullptr : *it;
+		auto it = _objectsByGuid.find(id);
+		return it == _objectsByGuid.end() ? nullptr : it->second->SelfRef();
 	}
 
 	void Scene::SetAmbientLight(const glm::vec3& value) {
@@ -157,10 +175,11 @@ namespace Gameplay {
 	}
 
 	void Scene::DoPhysics(float dt) {
-		_components.Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
+		PROFILE_SCOPE("Scene::DoPhysics");
+		_components.Each<Gameplay::Physics::RigidBody>([=](Gameplay::Physics::RigidBody* body) {
 			body->PhysicsPreStep(dt);
 		});
-		_components.Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
+		_components.Each<Gameplay::Physics::TriggerVolume>([=](Gameplay::Physics::TriggerVolume* body) {
 			body->PhysicsPreStep(dt);
 		});
 
@@ -168,10 +187,10 @@ namespace Gameplay {
 
 			_physicsWorld->stepSimulation(dt, 1);
 
-			_components.Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
+			_components.Each<Gameplay::Physics::RigidBody>([=](Gameplay::Physics::RigidBody* body) {
 				body->PhysicsPostStep(dt);
 			});
-			_components.Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
+			_components.Each<Gameplay::Physics::TriggerVolume>([=](Gameplay::Physics::TriggerVolume* body) {
 				body->PhysicsPostStep(dt);
 			});
 		}
@@ -185,13 +204,93 @@ namespace Gameplay {
 	}
 
 	void Scene::Update(float dt) {
+		PROFILE_SCOPE("Scene::Update");
 		_FlushDeleteQueue();
 		if (IsPlaying) {
+			// We walk the components in the same order as a serial update would. Parallel-safe components
+			// are gathered into a run, which is updated as soon as we reach a component that needs the
+			// main thread, so that it still sees everything that came before it as finished.
+			// Note that we use indices, since main thread components may add new objects and components
+			_parallelRun.clear();
+			for (size_t objIx = 0; objIx < _objects.size(); objIx++) {
+				GameObject* object = _objects[objIx].get();
+				for (uint32_t ix = 0; ix < object->_components.size(); ix++) {
+					IComponent* component = object->_components[ix].get();
+					if (!component->IsEnabled) {
+						continue;
+					}
+
+					if (component->IsParallelSafe()) {
+						if (!_parallelRun.empty() && _parallelRun.back().Object == object) {
+							_parallelRun.back().End = ix + 1;
+						} else {
+							_parallelRun.push_back({ object, ix, ix + 1 });
+						}
+					} else {
+						_UpdateParallelRun(dt);
+						component->Update(dt);
+					}
+				}
+			}
+			_UpdateParallelRun(dt);
+			_FlushDeferredActions();
+
 			for (int i = 0; i < _objects.size(); i++) {
-				_objects[i]->Update(dt);
+				_objects[i]->_FinishUpdate();
 			}
 		}
 		_FlushDeleteQueue();
+
+		// Bring all the dirty transforms up to date in one pass, we do this even when not playing
+		// so that edits from the inspector are picked up
+		_transforms->Update();
+	}
+
+	void Scene::_UpdateParallelRun(float dt) {
+		if (_parallelRun.empty()) {
+			return;
+		}
+
+		// Short runs are updated right here, since there is no one to share them with. Otherwise the
+		// transforms are brought up to date first, so reading them on worker threads never modifies the hierarchy
+		static constexpr uint32_t GRAIN_SIZE = 64;
+		uint32_t count = static_cast<uint32_t>(_parallelRun.size());
+		bool isWide = count > GRAIN_SIZE;
+		if (isWide) {
+			_transforms->SetReadOnly(true);
+		}
+
+		// Each range covers a single object, so all the components on an object are updated by the same thread
+		_isUpdatingInParallel = true;
+		JobSystem::ParallelFor(count, GRAIN_SIZE, [&](uint32_t start, uint32_t end) {
+			for (uint32_t ix = start; ix < end; ix++) {
+				_parallelRun[ix].Object->_UpdateComponents(dt, _parallelRun[ix].Begin, _parallelRun[ix].End);
+			}
+		});
+		_isUpdatingInParallel = false;
+
+		if (isWide) {
+			_transforms->SetReadOnly(false);
+		}
+		_parallelRun.clear();
+
+		// Sync point, apply any changes that were requested by the run
+		_FlushDeferredActions();
+	}
+
+	void Scene::_FlushDeferredActions() {
+		// Actions may defer more actions, so keep going until the queue is empty
+		while (true) {
+			std::vector<std::function<void()>> actions;
+			{
+				std::lock_guard<std::mutex> lock(_deferredMutex);
+				if (_deferredActions.empty()) break;
+				actions.swap(_deferredActions);
+			}
+			for (auto& action : actions) {
+				action();
+			}
+		}
 	}
 
 	void Scene::RenderGUI()
@@ -213,6 +312,8 @@ namespace Gameplay {
 
 		Scene::Sptr result = std::make_shared<Scene>();
 		result->MainCamera = nullptr;
+		result->_objectsByGuid.clear();
+		result->_objectsByName.clear();
 		result->_objects.clear();
 		result->DefaultMaterial = ResourceManager::Get<Material>(Guid(data["default_material"]));
 
@@ -236,6 +337,7 @@ namespace Gameplay {
 			obj->_parent.SceneContext = result.get();
 			obj->_selfRef = obj;
 			result->_objects.push_back(obj);
+			result->_IndexObject(obj.get());
 		}
 
 		// Re-build the parent hierarchy 
@@ -280,6 +382,7 @@ namespace Gameplay {
 	}
 
 	void Scene::Save(const std::string& path) {
+		PROFILE_SCOPE("Scene::Save");
 		_filePath = path;
 		// Save data to file
 		FileHelpers::WriteContentsToFile(path, ToJson().dump(1, '\t'));
@@ -288,6 +391,7 @@ namespace Gameplay {
 
 	Scene::Sptr Scene::Load(const std::string& path)
 	{
+		PROFILE_SCOPE("Scene::Load");
 		LOG_INFO("Loading scene from \"{}\"", path);
 		std::string content = FileHelpers::ReadFile(path);
 		nlohmann::json blob = nlohmann::json::parse(content);
@@ -335,14 +439,58 @@ namespace Gameplay {
 
 
 	void Scene::_FlushDeleteQueue() {
-		for (auto& weakPtr : _deletionQueue) {
-			if (weakPtr.expired()) continue;
-			auto& it = std::find(_objects.begin(), _objects.end(), weakPtr.lock());
-			if (it != _objects.end()) {
-				_objects.erase(it);
+		std::vector<std::weak_ptr<GameObject>> queue;
+		{
+			std::lock_guard<std::mutex> lock(_deferredMutex);
+			queue.swap(_deletionQueue);
+		}
+		if (queue.empty()) return;
+
+		// Gather everything that needs to go, then remove it all in a single pass over the
+		// object list rather than searching for every deleted object
+		std::unordered_set<GameObject*> toDelete;
+		for (auto& weakPtr : queue) {
+			GameObject::Sptr object = weakPtr.lock();
+			if (object != nullptr && toDelete.insert(object.get()).second) {
+				_UnindexObject(object.get());
+			}
+		}
+
+		auto it = std::remove_if(_objects.begin(), _objects.end(), [&](const GameObject::Sptr& obj) {
+			return toDelete.count(obj.get()) > 0;
+		});
+		_objects.erase(it, _objects.end());
+	}
+
+	void Scene::_IndexObject(GameObject* object) {
+		_objectsByGuid[object->_guid] = object;
+		_objectsByName[object->_name].push_back(object);
+	}
+
+	void Scene::_UnindexObject(GameObject* object) {
+		auto guidIt = _objectsByGuid.find(object->_guid);
+		if (guidIt != _objectsByGuid.end() && guidIt->second == object) {
+			_objectsByGuid.erase(guidIt);
+		}
+
+		_RemoveFromNameIndex(object, object->_name);
+	}
+
+	void Scene::_OnObjectRenamed(GameObject* object, const std::string& oldName) {
+		// Renamed objects go to the back of their new bucket
+		_RemoveFromNameIndex(object, oldName);
+		_objectsByName[object->_name].push_back(object);
+	}
+
+	void Scene::_RemoveFromNameIndex(GameObject* object, const std::string& name) {
+		auto nameIt = _objectsByName.find(name);
+		if (nameIt != _objectsByName.end()) {
+			auto& bucket = nameIt->second;
+			bucket.erase(std::remove(bucket.begin(), bucket.end(), object), bucket.end());
+			if (bucket.empty()) {
+				_objectsByName.erase(nameIt);
 			}
 		}
-		_deletionQueue.clear();
 	}
 
 	void Scene::DrawAllGameObjectGUIs()
@@ -368,9 +516,9 @@ namespace Gameplay {
 			_skyboxTexture != nullptr &&
 			MainCamera != nullptr) {
 			
-			glDepthMask(false);
-			glDisable(GL_CULL_FACE);
-			glDepthFunc(GL_LEQUAL); 
+			GlStateCache::SetDepthMask(false);
+			GlStateCache::SetCullMode(CullMode::None);
+			GlStateCache::SetDepthFunc(DepthFunc::LessEqual);
 
 			_skyboxShader->Bind();
 			_skyboxShader->SetUniformMatrix("u_ClippedView", MainCamera->GetProjection());
@@ -378,9 +526,9 @@ namespace Gameplay {
 			_skyboxTexture->Bind(0);
 			_skyboxMesh->Mesh->Draw();
 
-			glDepthFunc(GL_LESS);
-			glEnable(GL_CULL_FACE);
-			glDepthMask(true);
+			GlStateCache::SetDepthFunc(DepthFunc::Less);
+			GlStateCache::SetCullMode(CullMode::Back);
+			GlStateCache::SetDepthMask(true);
 
 		}
 	}
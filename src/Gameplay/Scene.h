@@ -10,6 +10,10 @@
 #include "Graphics/Buffers/UniformBuffer.h"
 #include "Graphics/Textures/Texture3D.h"
 
+#include <mutex>
+#include <atomic>
+#include <functional>
+
 struct GLFWwindow;
 
 class TextureCube;
@@ -83,6 +87,19 @@ namespace Gameplay {
 		/// <param name="object">The gameobject to delete</param>
 		void RemoveGameObject(const GameObject::Sptr& object);
 
+		/// <summary>
+		/// Queues an action to be run on the main thread at the next sync point in the update loop.
+		/// This is how parallel-safe components should make structural changes (creating objects,
+		/// adding or removing components, etc...). Safe to call from any thread
+		/// </summary>
+		/// <param name="action">The action to perform</param>
+		void Defer(std::function<void()> action);
+
+		/// <summary>
+		/// Returns true while parallel-safe components are being updated on worker threads
+		/// </summary>
+		bool IsUpdatingInParallel() const { return _isUpdatingInParallel; }
+
 		/// <summary>
 		/// Searches all objects in the scene and returns the first
 		/// one who's name matches the one given, or nullptr if no object
@@ -136,6 +153,12 @@ namespace Gameplay {
 		/// Performs updates on all enabled components and gameobjects in the
 		/// scene
 		/// 
+		/// Components are updated in object order, and in the order they were added within each
+		/// object. Consecutive runs of parallel-safe components are spread over the job system,
+		/// so within a run, components on different objects may update in any order, but a
+		/// component never updates before one that comes earlier in that order and is not
+		/// parallel-safe
+		/// 
 		/// Only invokes events if IsPlaying is true
 		/// </summary>
 		/// <param name="dt">The time in seconds since the last frame</param>
@@ -215,10 +238,33 @@ namespace Gameplay {
 		// Our physics scene's global gravity, default matches earth's gravity (m/s^2)
 		glm::vec3 _gravity;
 
+		// Position, rotation, scale and matrices for every object in the scene
+		TransformHierarchy::Sptr       _transforms;
+
 		// Stores all the objects in our scene
 		std::vector<GameObject::Sptr>  _objects;
 		std::vector<std::weak_ptr<GameObject>>  _deletionQueue;
 
+		// Structural changes requested from worker threads, applied at sync points in Update
+		std::vector<std::function<void()>> _deferredActions;
+		// Guards the deletion queue and deferred actions, since they can be written from worker threads
+		std::mutex                         _deferredMutex;
+		std::atomic<bool>                  _isUpdatingInParallel;
+
+		// A range of consecutive parallel-safe components on a single object
+		struct ComponentRange {
+			GameObject* Object;
+			uint32_t    Begin;
+			uint32_t    End;
+		};
+		// The parallel-safe components waiting to be updated, see Update
+		std::vector<ComponentRange>        _parallelRun;
+
+		// Lookup tables so that finding objects (and resolving WeakRefs) does not need to scan
+		// the entire scene. Objects with duplicate names are stored in creation order
+		std::unordered_map<Guid, GameObject*>                      _objectsByGuid;
+		std::unordered_map<std::string, std::vector<GameObject*>> _objectsByName;
+
 		// Info for rendering our skybox will be stored in the scene itself
 		std::shared_ptr<ShaderProgram>       _skyboxShader;
 		std::shared_ptr<MeshResource> _skyboxMesh;
@@ -242,5 +288,26 @@ namespace Gameplay {
 		void _CleanupPhysics();
 
 		void _FlushDeleteQueue();
+		void _FlushDeferredActions();
+		/// <summary>
+		/// Updates the pending run of parallel-safe components on the job system, then applies
+		/// any actions they deferred
+		/// </summary>
+		void _UpdateParallelRun(float dt);
+		void _QueueDeletion(const GameObject::Sptr& object);
+
+		/// <summary>
+		/// Adds an object to the GUID and name lookup tables
+		/// </summary>
+		void _IndexObject(GameObject* object);
+		/// <summary>
+		/// Removes an object from the GUID and name lookup tables
+		/// </summary>
+		void _UnindexObject(GameObject* object);
+		/// <summary>
+		/// Invoked by GameObject::SetName to move an object to it's new name bucket
+		/// </summary>
+		void _OnObjectRenamed(GameObject* object, const std::string& oldName);
+		void _RemoveFromNameIndex(GameObject* object, const std::string& name);
 	};
 }
\ No newline at end of file
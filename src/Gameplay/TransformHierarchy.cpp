@@ -0,0 +1,385 @@
+#include "Gameplay/TransformHierarchy.h"
+
+#include <algorithm>
+#include <type_traits>
+
+#include "Utils/JobSystem.h"
+#include "Logging.h"
+
+namespace Gameplay {
+	// Levels with fewer nodes than this are updated on the calling thread
+	static constexpr uint32_t PARALLEL_LEVEL_SIZE = 512;
+	static constexpr uint32_t PARALLEL_GRAIN_SIZE = 256;
+
+	/// <summary>
+	/// Multiplies two affine matrices, skipping the work for the bottom row since
+	/// we know it will always be (0, 0, 0, 1)
+	/// </summary>
+	inline static glm::mat4 AffineMul(const glm::mat4& a, const glm::mat4& b) {
+		glm::mat4 result;
+		result[0] = a[0] * b[0].x + a[1] * b[0].y + a[2] * b[0].z;
+		result[1] = a[0] * b[1].x + a[1] * b[1].y + a[2] * b[1].z;
+		result[2] = a[0] * b[2].x + a[1] * b[2].y + a[2] * b[2].z;
+		result[3] = a[0] * b[3].x + a[1] * b[3].y + a[2] * b[3].z + a[3];
+		return result;
+	}
+
+	/// <summary>
+	/// Builds translation * rotation * scale and it's inverse without going through glm::inverse,
+	/// the inverse is simply scale^-1 * rotation^T * translation^-1
+	/// </summary>
+	inline static void ComposeTRS(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale, glm::mat4& outLocal, glm::mat4& outInverse) {
+		glm::mat3 rot = glm::mat3_cast(rotation);
+
+		outLocal[0] = glm::vec4(rot[0] * scale.x, 0.0f);
+		outLocal[1] = glm::vec4(rot[1] * scale.y, 0.0f);
+		outLocal[2] = glm::vec4(rot[2] * scale.z, 0.0f);
+		outLocal[3] = glm::vec4(position, 1.0f);
+
+		// Zero scale has no inverse, we collapse that axis rather than produce infinities
+		glm::vec3 invScale(
+			scale.x != 0.0f ? 1.0f / scale.x : 0.0f,
+			scale.y != 0.0f ? 1.0f / scale.y : 0.0f,
+			scale.z != 0.0f ? 1.0f / scale.z : 0.0f
+		);
+		glm::mat3 invRotScale = glm::transpose(rot);
+		invRotScale[0] *= invScale;
+		invRotScale[1] *= invScale;
+		invRotScale[2] *= invScale;
+
+		outInverse[0] = glm::vec4(invRotScale[0], 0.0f);
+		outInverse[1] = glm::vec4(invRotScale[1], 0.0f);
+		outInverse[2] = glm::vec4(invRotScale[2], 0.0f);
+		outInverse[3] = glm::vec4(-(invRotScale * position), 1.0f);
+	}
+
+	TransformHierarchy::TransformHierarchy() :
+		_slots(),
+		_freeSlots(),
+		_levelStarts(),
+		_structureDirty(false),
+		_numDead(0),
+		_readOnly(false)
+	{ }
+
+	TransformHandle TransformHierarchy::Allocate() {
+		LOG_ASSERT(!_readOnly, "Cannot allocate transforms while the hierarchy is read only");
+		uint32_t slotIx;
+		if (!_freeSlots.empty()) {
+			slotIx = _freeSlots.back();
+			_freeSlots.pop_back();
+		} else {
+			slotIx = static_cast<uint32_t>(_slots.size());
+			_slots.push_back(Slot());
+		}
+
+		Slot& slot = _slots[slotIx];
+		slot.Parent = TransformHandle();
+		slot.DenseIndex = static_cast<uint32_t>(_denseToHandle.size());
+		_PushNode(slotIx);
+
+		// New nodes are appended at the end, which may not be in depth order
+		_structureDirty = true;
+
+		TransformHandle result;
+		result.Index = slotIx;
+		result.Generation = slot.Generation;
+		return result;
+	}
+
+	void TransformHierarchy::Release(const TransformHandle& handle) {
+		LOG_ASSERT(!_readOnly, "Cannot release transforms while the hierarchy is read only");
+		if (!IsValid(handle)) return;
+
+		Slot& slot = _slots[handle.Index];
+		// Leave the dense data where it is, it will be dropped the next time we re-sort
+		_denseToHandle[slot.DenseIndex] = TransformHandle::InvalidIndex;
+		slot.DenseIndex = TransformHandle::InvalidIndex;
+		slot.Parent = TransformHandle();
+		slot.Generation++;
+		_freeSlots.push_back(handle.Index);
+		_numDead++;
+		_structureDirty = true;
+	}
+
+	bool TransformHierarchy::IsValid(const TransformHandle& handle) const {
+		return handle.Index < _slots.size() &&
+			_slots[handle.Index].Generation == handle.Generation &&
+			_slots[handle.Index].DenseIndex != TransformHandle::InvalidIndex;
+	}
+
+	void TransformHierarchy::SetParent(const TransformHandle& handle, const TransformHandle& parent) {
+		LOG_ASSERT(IsValid(handle), "Invalid transform handle");
+		LOG_ASSERT(!_readOnly, "Cannot re-parent transforms while the hierarchy is read only");
+		Slot& slot = _slots[handle.Index];
+		if (slot.Parent.Index == parent.Index && slot.Parent.Generation == parent.Generation) {
+			return;
+		}
+		slot.Parent = IsValid(parent) ? parent : TransformHandle();
+		_worldDirty[slot.DenseIndex] = 1;
+		_structureDirty = true;
+	}
+
+	void TransformHierarchy::SetPosition(const TransformHandle& handle, const glm::vec3& value) {
+		uint32_t ix = _DenseIndex(handle);
+		_positions[ix] = value;
+		_localDirty[ix] = 1;
+	}
+
+	const glm::vec3& TransformHierarchy::GetPosition(const TransformHandle& handle) const {
+		return _positions[_DenseIndex(handle)];
+	}
+
+	void TransformHierarchy::SetRotation(const TransformHandle& handle, const glm::quat& value) {
+		uint32_t ix = _DenseIndex(handle);
+		_rotations[ix] = value;
+		_localDirty[ix] = 1;
+	}
+
+	const glm::quat& TransformHierarchy::GetRotation(const TransformHandle& handle) const {
+		return _rotations[_DenseIndex(handle)];
+	}
+
+	void TransformHierarchy::SetScale(const TransformHandle& handle, const glm::vec3& value) {
+		uint32_t ix = _DenseIndex(handle);
+		_scales[ix] = value;
+		_localDirty[ix] = 1;
+	}
+
+	const glm::vec3& TransformHierarchy::GetScale(const TransformHandle& handle) const {
+		return _scales[_DenseIndex(handle)];
+	}
+
+	const glm::mat4& TransformHierarchy::GetLocalTransform(const TransformHandle& handle) const {
+		uint32_t ix = _DenseIndex(handle);
+		if (!_readOnly) {
+			_ResolveLocal(ix);
+		}
+		return _local[ix];
+	}
+
+	const glm::mat4& TransformHierarchy::GetInverseLocalTransform(const TransformHandle& handle) const {
+		uint32_t ix = _DenseIndex(handle);
+		if (!_readOnly) {
+			_ResolveLocal(ix);
+		}
+		return _inverseLocal[ix];
+	}
+
+	const glm::mat4& TransformHierarchy::GetWorldTransform(const TransformHandle& handle) const {
+		// Everything was resolved when we went read only, and resolving now would race with other readers
+		if (_readOnly) {
+			return _world[_DenseIndex(handle)];
+		}
+		_EnsureSorted();
+		uint32_t ix = _DenseIndex(handle);
+		_Resolve(ix);
+		return _world[ix];
+	}
+
+	const glm::mat4& TransformHierarchy::GetInverseWorldTransform(const TransformHandle& handle) const {
+		if (_readOnly) {
+			return _inverseWorld[_DenseIndex(handle)];
+		}
+		_EnsureSorted();
+		uint32_t ix = _DenseIndex(handle);
+		_Resolve(ix);
+		return _inverseWorld[ix];
+	}
+
+	void TransformHierarchy::Update() {
+		LOG_ASSERT(!_readOnly, "Cannot update the hierarchy while it is read only");
+		_EnsureSorted();
+
+		// Since the nodes are sorted by depth, every parent is finished before we reach it's children.
+		// Nodes within a level are independent, so wide levels can be split over the job system
+		for (size_t level = 0; level + 1 < _levelStarts.size(); level++) {
+			uint32_t start = _levelStarts[level];
+			uint32_t end   = _levelStarts[level + 1];
+
+			if (end - start >= PARALLEL_LEVEL_SIZE) {
+				JobSystem::ParallelFor(end - start, PARALLEL_GRAIN_SIZE, [this, start](uint32_t begin, uint32_t finish) {
+					for (uint32_t ix = start + begin; ix < start + finish; ix++) {
+						_UpdateNode(ix);
+					}
+				});
+			} else {
+				for (uint32_t ix = start; ix < end; ix++) {
+					_UpdateNode(ix);
+				}
+			}
+		}
+	}
+
+	void TransformHierarchy::SetReadOnly(bool readOnly) {
+		if (readOnly && !_readOnly) {
+			Update();
+		}
+		_readOnly = readOnly;
+	}
+
+	uint32_t TransformHierarchy::_DenseIndex(const TransformHandle& handle) const {
+		LOG_ASSERT(IsValid(handle), "Invalid transform handle");
+		return _slots[handle.Index].DenseIndex;
+	}
+
+	void TransformHierarchy::_PushNode(uint32_t slotIx) {
+		_positions.push_back(glm::vec3(0.0f));
+		_rotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+		_scales.push_back(glm::vec3(1.0f));
+		_local.push_back(glm::mat4(1.0f));
+		_inverseLocal.push_back(glm::mat4(1.0f));
+		_world.push_back(glm::mat4(1.0f));
+		_inverseWorld.push_back(glm::mat4(1.0f));
+		_parents.push_back(TransformHandle::InvalidIndex);
+		_localDirty.push_back(1);
+		_worldDirty.push_back(1);
+		_worldVersion.push_back(0);
+		_parentVersion.push_back(0);
+		_denseToHandle.push_back(slotIx);
+	}
+
+	void TransformHierarchy::_EnsureSorted() const {
+		if (_structureDirty) {
+			// The sort does not change any observable state, only the layout of our arrays
+			const_cast<TransformHierarchy*>(this)->_Rebuild();
+		}
+	}
+
+	void TransformHierarchy::_Rebuild() {
+		static constexpr uint32_t Unvisited = 0xFFFFFFFF;
+		static constexpr uint32_t Visiting  = 0xFFFFFFFE;
+
+		// Determine the depth of every live node, dropping links to released parents
+		std::vector<uint32_t> depths(_slots.size(), Unvisited);
+		std::vector<uint32_t> stack;
+		uint32_t maxDepth = 0;
+		for (uint32_t slotIx = 0; slotIx < _slots.size(); slotIx++) {
+			if (_slots[slotIx].DenseIndex == TransformHandle::InvalidIndex || depths[slotIx] != Unvisited) {
+				continue;
+			}
+
+			// Walk up until we find a root or a node we already know the depth of
+			stack.clear();
+			uint32_t current = slotIx;
+			while (true) {
+				Slot& slot = _slots[current];
+				if (slot.Parent.IsValid() && !IsValid(slot.Parent)) {
+					slot.Parent = TransformHandle();
+					_worldDirty[slot.DenseIndex] = 1;
+				}
+				if (!slot.Parent.IsValid() || depths[slot.Parent.Index] < Visiting) {
+					break;
+				}
+				if (depths[slot.Parent.Index] == Visiting) {
+					LOG_WARN("Cycle detected in transform hierarchy, breaking link");
+					slot.Parent = TransformHandle();
+					_worldDirty[slot.DenseIndex] = 1;
+					break;
+				}
+				depths[current] = Visiting;
+				stack.push_back(current);
+				current = slot.Parent.Index;
+			}
+
+			// Then unwind back down, assigning depths as we go
+			depths[current] = _slots[current].Parent.IsValid() ? depths[_slots[current].Parent.Index] + 1 : 0;
+			maxDepth = std::max(maxDepth, depths[current]);
+			for (auto it = stack.rbegin(); it != stack.rend(); it++) {
+				depths[*it] = _slots[*it].Parent.IsValid() ? depths[_slots[*it].Parent.Index] + 1 : 0;
+				maxDepth = std::max(maxDepth, depths[*it]);
+			}
+		}
+
+		// Counting sort by depth, keeping the existing order within each level
+		_levelStarts.assign(maxDepth + 2, 0);
+		for (uint32_t handleIx : _denseToHandle) {
+			if (handleIx != TransformHandle::InvalidIndex) {
+				_levelStarts[depths[handleIx] + 1]++;
+			}
+		}
+		for (size_t level = 1; level < _levelStarts.size(); level++) {
+			_levelStarts[level] += _levelStarts[level - 1];
+		}
+
+		size_t count = _denseToHandle.size() - _numDead;
+		std::vector<uint32_t> order(count);
+		std::vector<uint32_t> cursor(_levelStarts.begin(), _levelStarts.end() - 1);
+		for (uint32_t denseIx = 0; denseIx < _denseToHandle.size(); denseIx++) {
+			uint32_t handleIx = _denseToHandle[denseIx];
+			if (handleIx != TransformHandle::InvalidIndex) {
+				order[cursor[depths[handleIx]]++] = denseIx;
+			}
+		}
+
+		// Gather all our streams into their new order
+		auto gather = [&order](auto& stream) {
+			typename std::remove_reference<decltype(stream)>::type sorted;
+			sorted.reserve(order.size());
+			for (uint32_t ix : order) {
+				sorted.push_back(stream[ix]);
+			}
+			stream.swap(sorted);
+		};
+		gather(_positions);
+		gather(_rotations);
+		gather(_scales);
+		gather(_local);
+		gather(_inverseLocal);
+		gather(_world);
+		gather(_inverseWorld);
+		gather(_localDirty);
+		gather(_worldDirty);
+		gather(_worldVersion);
+		gather(_parentVersion);
+		gather(_denseToHandle);
+
+		for (uint32_t denseIx = 0; denseIx < _denseToHandle.size(); denseIx++) {
+			_slots[_denseToHandle[denseIx]].DenseIndex = denseIx;
+		}
+		_parents.resize(count);
+		for (uint32_t denseIx = 0; denseIx < _denseToHandle.size(); denseIx++) {
+			const Slot& slot = _slots[_denseToHandle[denseIx]];
+			_parents[denseIx] = slot.Parent.IsValid() ? _slots[slot.Parent.Index].DenseIndex : TransformHandle::InvalidIndex;
+		}
+
+		_numDead = 0;
+		_structureDirty = false;
+	}
+
+	void TransformHierarchy::_ResolveLocal(uint32_t denseIx) const {
+		if (_localDirty[denseIx]) {
+			ComposeTRS(_positions[denseIx], _rotations[denseIx], _scales[denseIx], _local[denseIx], _inverseLocal[denseIx]);
+			_localDirty[denseIx] = 0;
+			_worldDirty[denseIx] = 1;
+		}
+	}
+
+	void TransformHierarchy::_UpdateNode(uint32_t denseIx) const {
+		_ResolveLocal(denseIx);
+
+		uint32_t parentIx = _parents[denseIx];
+		if (parentIx != TransformHandle::InvalidIndex) {
+			if (_worldDirty[denseIx] || _parentVersion[denseIx] != _worldVersion[parentIx]) {
+				_world[denseIx] = AffineMul(_world[parentIx], _local[denseIx]);
+				_inverseWorld[denseIx] = AffineMul(_inverseLocal[denseIx], _inverseWorld[parentIx]);
+				_parentVersion[denseIx] = _worldVersion[parentIx];
+				_worldVersion[denseIx]++;
+				_worldDirty[denseIx] = 0;
+			}
+		} else if (_worldDirty[denseIx]) {
+			_world[denseIx] = _local[denseIx];
+			_inverseWorld[denseIx] = _inverseLocal[denseIx];
+			_worldVersion[denseIx]++;
+			_worldDirty[denseIx] = 0;
+		}
+	}
+
+	void TransformHierarchy::_Resolve(uint32_t denseIx) const {
+		uint32_t parentIx = _parents[denseIx];
+		if (parentIx != TransformHandle::InvalidIndex) {
+			_Resolve(parentIx);
+		}
+		_UpdateNode(denseIx);
+	}
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+#include "GLM/glm.hpp"
+#include "GLM/gtc/quaternion.hpp"
+
+namespace Gameplay {
+	/// <summary>
+	/// A generational handle to a node in a TransformHierarchy. The index stays stable for the
+	/// lifetime of the node, and the generation lets us detect handles to released nodes
+	/// </summary>
+	struct TransformHandle {
+		static constexpr uint32_t InvalidIndex = 0xFFFFFFFF;
+
+		uint32_t Index      = InvalidIndex;
+		uint32_t Generation = 0;
+
+		bool IsValid() const { return Index != InvalidIndex; }
+	};
+
+	/// <summary>
+	/// Stores the transforms for all objects in a scene as a flattened structure of arrays.
+	/// Nodes are kept sorted by their depth in the hierarchy, so parents always come before
+	/// their children and each depth level is a contiguous run of nodes. This lets us update
+	/// every dirty transform in a single linear pass (split across the job system for wide
+	/// levels), rather than chasing parent pointers recursively for every object.
+	///
+	/// Local transforms are always translation * rotation * scale, so we can invert them
+	/// directly instead of using a general 4x4 inverse, and world inverses are built by
+	/// composing the local inverses down the hierarchy.
+	///
+	/// Changing a local transform only flags that node, children notice the change by
+	/// comparing the version of their parent's world transform against the version they
+	/// were last built from
+	/// </summary>
+	class TransformHierarchy {
+	public:
+		typedef std::shared_ptr<TransformHierarchy> Sptr;
+
+		TransformHierarchy();
+		~TransformHierarchy() = default;
+
+		/// <summary>
+		/// Allocates a new root node with an identity transform
+		/// </summary>
+		TransformHandle Allocate();
+		/// <summary>
+		/// Releases a node, any children of the node will become roots
+		/// </summary>
+		/// <param name="handle">The handle returned from Allocate</param>
+		void Release(const TransformHandle& handle);
+		/// <summary>
+		/// Returns true if the handle refers to a live node in this hierarchy
+		/// </summary>
+		bool IsValid(const TransformHandle& handle) const;
+
+		/// <summary>
+		/// Sets the parent of a node, or makes it a root node if parent is an invalid handle
+		/// </summary>
+		void SetParent(const TransformHandle& handle, const TransformHandle& parent);
+
+		void SetPosition(const TransformHandle& handle, const glm::vec3& value);
+		const glm::vec3& GetPosition(const TransformHandle& handle) const;
+		void SetRotation(const TransformHandle& handle, const glm::quat& value);
+		const glm::quat& GetRotation(const TransformHandle& handle) const;
+		void SetScale(const TransformHandle& handle, const glm::vec3& value);
+		const glm::vec3& GetScale(const TransformHandle& handle) const;
+
+		/// <summary>
+		/// Gets the local to parent transform for a node, recalculating it if required
+		/// </summary>
+		const glm::mat4& GetLocalTransform(const TransformHandle& handle) const;
+		const glm::mat4& GetInverseLocalTransform(const TransformHandle& handle) const;
+		/// <summary>
+		/// Gets the local to world transform for a node, recalculating it (and any dirty parents) if required
+		/// </summary>
+		const glm::mat4& GetWorldTransform(const TransformHandle& handle) const;
+		const glm::mat4& GetInverseWorldTransform(const TransformHandle& handle) const;
+
+		/// <summary>
+		/// Recalculates all dirty nodes in a single pass over the hierarchy, should be called once
+		/// per frame on the main thread
+		/// </summary>
+		void Update();
+
+		/// <summary>
+		/// While read only, the getters return the matrices as they were at the last Update without
+		/// recalculating anything, so any number of threads can read transforms at once. Setters
+		/// may still be used for nodes that only one thread touches, but the changes are not seen
+		/// by the matrix getters until read only mode ends and the hierarchy is updated again.
+		/// Structural changes (allocating, releasing or re-parenting nodes) are not allowed.
+		///
+		/// Entering read only mode performs a full Update, must be called on the main thread
+		/// </summary>
+		void SetReadOnly(bool readOnly);
+		bool IsReadOnly() const { return _readOnly; }
+
+		/// <summary>
+		/// Gets the number of live nodes in the hierarchy
+		/// </summary>
+		size_t Size() const { return _denseToHandle.size() - _numDead; }
+
+	private:
+		// Sparse per-handle data
+		struct Slot {
+			uint32_t        DenseIndex = TransformHandle::InvalidIndex;
+			uint32_t        Generation = 0;
+			TransformHandle Parent;
+		};
+		std::vector<Slot>     _slots;
+		std::vector<uint32_t> _freeSlots;
+
+		// Dense, depth sorted node data. These are mutable so that the const getters
+		// can lazily recalculate matrices
+		std::vector<glm::vec3>         _positions;
+		std::vector<glm::quat>         _rotations;
+		std::vector<glm::vec3>         _scales;
+		mutable std::vector<glm::mat4> _local;
+		mutable std::vector<glm::mat4> _inverseLocal;
+		mutable std::vector<glm::mat4> _world;
+		mutable std::vector<glm::mat4> _inverseWorld;
+		// Dense index of the parent, or InvalidIndex for roots
+		std::vector<uint32_t>          _parents;
+		// Stored as bytes rather than a vector<bool>, so that different threads can flag different nodes
+		mutable std::vector<uint8_t>   _localDirty;
+		mutable std::vector<uint8_t>   _worldDirty;
+		// Incremented every time a node's world transform changes
+		mutable std::vector<uint32_t>  _worldVersion;
+		// The parent's world version that our world transform was last built from
+		mutable std::vector<uint32_t>  _parentVersion;
+		std::vector<uint32_t>          _denseToHandle;
+
+		// Start of each depth level in the dense arrays, with a trailing entry for the end
+		std::vector<uint32_t> _levelStarts;
+		// Set when nodes are added, removed or re-parented and the dense arrays need re-sorting
+		bool                  _structureDirty;
+		size_t                _numDead;
+		// When set, the getters never modify the hierarchy, see SetReadOnly
+		bool                  _readOnly;
+
+		uint32_t _DenseIndex(const TransformHandle& handle) const;
+		void _PushNode(uint32_t slotIx);
+
+		/// <summary>
+		/// Re-sorts the dense arrays by hierarchy depth, dropping released nodes
+		/// </summary>
+		void _Rebuild();
+		/// <summary>
+		/// Invokes _Rebuild if the structure has changed, used by the lazy getters
+		/// </summary>
+		void _EnsureSorted() const;
+		/// <summary>
+		/// Brings a single node up to date, parents must already be up to date
+		/// </summary>
+		void _UpdateNode(uint32_t denseIx) const;
+		/// <summary>
+		/// Brings a single node and all of it's parents up to date
+		/// </summary>
+		void _Resolve(uint32_t denseIx) const;
+		void _ResolveLocal(uint32_t denseIx) const;
+	};
+}
@@ -0,0 +1,70 @@
+#include "Graphics/BoundingVolume.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+BoundingVolume::BoundingVolume() :
+	Min(0.0f),
+	Max(0.0f),
+	Center(0.0f),
+	Radius(0.0f),
+	IsValid(false)
+{ }
+
+void BoundingVolume::TransformSphere(const glm::mat4& transform, glm::vec3& outCenter, float& outRadius, float margin) const {
+	outCenter = glm::vec3(transform * glm::vec4(Center, 1.0f));
+
+	// Use the largest scale along any axis, so non-uniform scales never shrink the sphere
+	float maxScaleSqr = std::max({
+		glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+		glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])),
+		glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]))
+	});
+	outRadius = (Radius + margin) * glm::sqrt(maxScaleSqr);
+}
+
+BoundingVolume BoundingVolume::FromPoints(const void* data, size_t count, size_t stride) {
+	BoundingVolume result;
+	if (data == nullptr || count == 0) {
+		return result;
+	}
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+	glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+	for (size_t ix = 0; ix < count; ix++) {
+		glm::vec3 point;
+		memcpy(&point, bytes + ix * stride, sizeof(glm::vec3));
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
+
+	result.Min = min;
+	result.Max = max;
+	result.Center = (min + max) * 0.5f;
+
+	// Second pass to find the furthest point from the center
+	float radiusSqr = 0.0f;
+	for (size_t ix = 0; ix < count; ix++) {
+		glm::vec3 point;
+		memcpy(&point, bytes + ix * stride, sizeof(glm::vec3));
+		glm::vec3 delta = point - result.Center;
+		radiusSqr = std::max(radiusSqr, glm::dot(delta, delta));
+	}
+	result.Radius = glm::sqrt(radiusSqr);
+	result.IsValid = true;
+
+	return result;
+}
+
+BoundingVolume BoundingVolume::FromMinMax(const glm::vec3& min, const glm::vec3& max) {
+	BoundingVolume result;
+	result.Min = glm::min(min, max);
+	result.Max = glm::max(min, max);
+	result.Center = (result.Min + result.Max) * 0.5f;
+	result.Radius = glm::length(result.Max - result.Center);
+	result.IsValid = true;
+	return result;
+}
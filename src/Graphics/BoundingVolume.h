@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+#include "GLM/glm.hpp"
+
+/// <summary>
+/// Stores the local space bounds of a mesh, as both an axis aligned box and a bounding sphere
+/// around the box's center
+/// </summary>
+struct BoundingVolume {
+	/// <summary>
+	/// The minimum corner of the AABB
+	/// </summary>
+	glm::vec3 Min;
+	/// <summary>
+	/// The maximum corner of the AABB
+	/// </summary>
+	glm::vec3 Max;
+	/// <summary>
+	/// The center of the bounding sphere (this is the center of the AABB)
+	/// </summary>
+	glm::vec3 Center;
+	/// <summary>
+	/// The radius of the bounding sphere, this is the distance to the furthest point rather than
+	/// half the box's diagonal, so it's usually tighter
+	/// </summary>
+	float     Radius;
+	/// <summary>
+	/// False if the volume contains no points, in which case it should not be used for culling
+	/// </summary>
+	bool      IsValid;
+
+	BoundingVolume();
+
+	/// <summary>
+	/// Transforms the bounding sphere into another space, scaling the radius by the largest
+	/// axis scale in the transform so that the sphere remains conservative
+	/// </summary>
+	/// <param name="transform">The transform to apply, usually an object's world transform</param>
+	/// <param name="outCenter">Receives the transformed sphere's center</param>
+	/// <param name="outRadius">Receives the transformed sphere's radius</param>
+	/// <param name="margin">Extra local space distance to grow the sphere by, ex: for vertex displacement</param>
+	void TransformSphere(const glm::mat4& transform, glm::vec3& outCenter, float& outRadius, float margin = 0.0f) const;
+
+	/// <summary>
+	/// Calculates the bounds from a strided array of positions
+	/// </summary>
+	/// <param name="data">Pointer to the first position in the array</param>
+	/// <param name="count">The number of positions to read</param>
+	/// <param name="stride">The number of bytes between positions, ex: sizeof(VertexType)</param>
+	static BoundingVolume FromPoints(const void* data, size_t count, size_t stride = sizeof(glm::vec3));
+
+	/// <summary>
+	/// Creates bounds from an axis aligned box, ex: one stored with the mesh. The sphere encloses the
+	/// whole box, so it is looser than the one FromPoints would find
+	/// </summary>
+	/// <param name="min">The minimum corner of the box</param>
+	/// <param name="max">The maximum corner of the box</param>
+	static BoundingVolume FromMinMax(const glm::vec3& min, const glm::vec3& max);
+};
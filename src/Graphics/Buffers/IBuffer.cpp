@@ -32,6 +32,12 @@ void IBuffer::LoadData(const void* data, uint32_t elementSize, uint32_t elementC
 	_size = elementCount * elementSize;
 }
 
+void IBuffer::UpdateRange(uint32_t offset, const void* data, uint32_t size)
+{
+	LOG_ASSERT(offset + size <= _size, "Attempting to write beyond the end of the buffer!");
+	glNamedBufferSubData(_rendererId, (GLintptr)offset, (GLsizeiptr)size, data);
+}
+
 void IBuffer::UpdateData(const void* data, uint32_t elementSize, uint32_t elementCount, bool allowResize /*= true*/)
 {
 	if (elementSize * elementCount > _size) {
@@ -52,6 +52,14 @@ public:
 	/// <param name="allowResize">True if resizing the buffer is allowed, otherwise an assertion is thrown for oversized writes</param>
 	virtual void UpdateData(const void* data, uint32_t elementSize, uint32_t elementCount, bool allowResize = true);
 
+	/// <summary>
+	/// Overwrites a range of bytes within the buffer, without resizing it
+	/// </summary>
+	/// <param name="offset">The offset into the buffer to start writing at, in bytes</param>
+	/// <param name="data">The data to write</param>
+	/// <param name="size">The number of bytes to write, offset + size must not exceed the buffer size</param>
+	void UpdateRange(uint32_t offset, const void* data, uint32_t size);
+
 	/// <summary>
 	/// Loads an array of data into this buffer, using the bindless method glNamedBufferData
 	/// </summary>
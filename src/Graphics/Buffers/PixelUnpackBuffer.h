@@ -0,0 +1,29 @@
+#pragma once
+#include "IBuffer.h"
+#include <memory>
+
+/// <summary>
+/// A pixel unpack buffer (PBO), texture uploads read from this buffer instead of client memory
+/// while it is bound, which lets the driver copy the pixels to the GPU without stalling the
+/// calling thread
+/// </summary>
+class PixelUnpackBuffer : public IBuffer
+{
+public:
+	typedef std::shared_ptr<PixelUnpackBuffer> Sptr;
+
+	static inline Sptr Create(BufferUsage usage = BufferUsage::StreamDraw) {
+		return std::make_shared<PixelUnpackBuffer>(usage);
+	}
+
+	/// <summary>
+	/// Creates a new pixel unpack buffer, with the given usage. Data will still need to be uploaded before it can be used
+	/// </summary>
+	/// <param name="usage">The usage hint for the buffer, default is GL_STREAM_DRAW</param>
+	PixelUnpackBuffer(BufferUsage usage = BufferUsage::StreamDraw) : IBuffer(BufferType::PixelUnpack, usage) { }
+
+	/// <summary>
+	/// Unbinds the pixel unpack buffer, so that texture uploads read from client memory again
+	/// </summary>
+	static void UnBind() { IBuffer::UnBind(BufferType::PixelUnpack); }
+};
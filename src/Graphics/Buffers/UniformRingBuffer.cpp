@@ -0,0 +1,158 @@
+#include "UniformRingBuffer.h"
+#include "Logging.h"
+
+#include <algorithm>
+
+// How long to wait on a fence at a time before logging that we're stalled, in nanoseconds
+static constexpr GLuint64 FENCE_TIMEOUT = 1000000000;
+
+UniformRingBuffer::UniformRingBuffer(uint32_t bytesPerFrame, uint32_t frameCount) :
+	IBuffer(BufferType::Uniform, BufferUsage::DynamicDraw),
+	_bytesPerFrame(0),
+	_frameCount(frameCount > 0 ? frameCount : 1),
+	_alignment(256),
+	_mapped(nullptr),
+	_frameIndex(0),
+	_segmentStart(0),
+	_cursor(0),
+	_stallCount(0),
+	_isFrameOpen(false),
+	_fences(),
+	_retired()
+{
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment > 0) {
+		_alignment = static_cast<uint32_t>(alignment);
+	}
+
+	// Round the segment size up so every segment starts on an aligned offset
+	_bytesPerFrame = ((std::max(bytesPerFrame, _alignment) + _alignment - 1) / _alignment) * _alignment;
+	_fences.resize(_frameCount, nullptr);
+
+	_CreateStorage();
+}
+
+UniformRingBuffer::~UniformRingBuffer() {
+	for (GLsync& fence : _fences) {
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+	for (const RetiredBuffer& buffer : _retired) {
+		glDeleteBuffers(1, &buffer.Handle);
+	}
+	_retired.clear();
+
+	if (_mapped != nullptr) {
+		glUnmapNamedBuffer(_rendererId);
+		_mapped = nullptr;
+	}
+}
+
+void UniformRingBuffer::BeginFrame() {
+	// Fence everything that was submitted using the previous segment. We do this here rather than at the
+	// end of the frame so that any layers that render after us are covered by the fence as well
+	if (_isFrameOpen) {
+		_fences[_frameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		_frameIndex = (_frameIndex + 1) % _frameCount;
+	}
+	_isFrameOpen = true;
+
+	// Make sure the GPU is done with the segment we're about to overwrite. With enough frames
+	// in flight this should almost never actually wait
+	GLsync& fence = _fences[_frameIndex];
+	if (fence != nullptr) {
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) {
+			_stallCount++;
+			do {
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+				if (result == GL_TIMEOUT_EXPIRED) {
+					LOG_WARN("Waiting on the GPU to release uniform ring segment {}", _frameIndex);
+				}
+			} while (result == GL_TIMEOUT_EXPIRED);
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	// Release any buffers we've outgrown once the GPU can no longer be using them
+	for (size_t ix = 0; ix < _retired.size();) {
+		if (--_retired[ix].FramesLeft == 0) {
+			glDeleteBuffers(1, &_retired[ix].Handle);
+			_retired[ix] = _retired.back();
+			_retired.pop_back();
+		} else {
+			ix++;
+		}
+	}
+
+	_segmentStart = _frameIndex * _bytesPerFrame;
+	_cursor = _segmentStart;
+}
+
+UniformRingBuffer::Allocation UniformRingBuffer::Allocate(uint32_t size) {
+	uint32_t alignedSize = ((size + _alignment - 1) / _alignment) * _alignment;
+	if (_cursor + alignedSize > _segmentStart + _bytesPerFrame) {
+		_Grow(std::max(_bytesPerFrame * 2, (_cursor - _segmentStart) + alignedSize));
+	}
+
+	Allocation result;
+	result.Data   = _mapped + _cursor;
+	result.Offset = _cursor;
+	result.Size   = size;
+	result.Buffer = _rendererId;
+	_cursor += alignedSize;
+	return result;
+}
+
+void UniformRingBuffer::BindRange(uint32_t slot, const Allocation& block) const {
+	// Blocks from before a grow live in a retired buffer, which is kept alive until the GPU is done with it
+	glBindBufferRange(GL_UNIFORM_BUFFER, slot, block.Buffer, block.Offset, block.Size);
+}
+
+void UniformRingBuffer::LoadData(const void* data, uint32_t elementSize, uint32_t elementCount) {
+	LOG_ASSERT(false, "Uniform ring buffers can not be re-allocated, use Allocate or Write instead");
+}
+
+void UniformRingBuffer::UpdateData(const void* data, uint32_t elementSize, uint32_t elementCount, bool allowResize) {
+	LOG_ASSERT(false, "Uniform ring buffers can not be updated directly, use Allocate or Write instead");
+}
+
+void UniformRingBuffer::_CreateStorage() {
+	_size = _bytesPerFrame * _frameCount;
+	_elementSize = _bytesPerFrame;
+	_elementCount = _frameCount;
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glNamedBufferStorage(_rendererId, _size, nullptr, flags);
+	_mapped = static_cast<uint8_t*>(glMapNamedBufferRange(_rendererId, 0, _size, flags));
+	LOG_ASSERT(_mapped != nullptr, "Failed to persistently map uniform ring buffer");
+}
+
+void UniformRingBuffer::_Grow(uint32_t minBytesPerFrame) {
+	uint32_t newSize = ((minBytesPerFrame + _alignment - 1) / _alignment) * _alignment;
+	LOG_INFO("Growing uniform ring from {} to {} bytes per frame", _bytesPerFrame, newSize);
+
+	// Anything already allocated this frame may still be bound or referenced by queued draws, so
+	// we keep the old buffer alive until the GPU is guaranteed to be done with it
+	glUnmapNamedBuffer(_rendererId);
+	_retired.push_back({ _rendererId, _frameCount + 1 });
+
+	// The new buffer has never been used by the GPU, so the old fences no longer apply
+	for (GLsync& fence : _fences) {
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	glCreateBuffers(1, &_rendererId);
+	_bytesPerFrame = newSize;
+	_CreateStorage();
+
+	_segmentStart = _frameIndex * _bytesPerFrame;
+	_cursor = _segmentStart;
+}
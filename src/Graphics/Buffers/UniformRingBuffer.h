@@ -0,0 +1,111 @@
+#pragma once
+#include "IBuffer.h"
+#include <vector>
+#include <cstring>
+
+/// <summary>
+/// A persistently mapped uniform buffer that is split into one segment per frame in flight.
+/// Uniform blocks are sub-allocated linearly from the current frame's segment, written directly
+/// into the mapped memory, and bound with glBindBufferRange. This lets us write all the frame and
+/// per-draw uniforms for a frame without any glBufferSubData calls, which would otherwise force the
+/// driver to synchronize with the GPU on every draw
+///
+/// Each segment is protected by a fence, so we only ever wait on the GPU if it falls more than
+/// frameCount frames behind the CPU
+/// </summary>
+class UniformRingBuffer final : public IBuffer {
+public:
+	DEFINE_RESOURCE(UniformRingBuffer);
+
+	/// <summary>
+	/// A block of memory within the ring, valid until the segment is re-used frameCount frames later
+	/// </summary>
+	struct Allocation {
+		// The mapped memory to write to, note that this is write-combined memory and should never be read from
+		void*    Data   = nullptr;
+		// The offset of the block within the buffer, in bytes
+		uint32_t Offset = 0;
+		// The size of the block, in bytes
+		uint32_t Size   = 0;
+		// The buffer the block was allocated from, which will differ from the ring's current buffer
+		// if the ring grew after the block was allocated
+		uint32_t Buffer = 0;
+	};
+
+	/// <summary>
+	/// Creates a new ring buffer
+	/// </summary>
+	/// <param name="bytesPerFrame">The initial number of bytes available to each frame, the ring will grow if this is exceeded</param>
+	/// <param name="frameCount">The number of frames that may be in flight at once</param>
+	UniformRingBuffer(uint32_t bytesPerFrame = 1024 * 1024, uint32_t frameCount = 3);
+	virtual ~UniformRingBuffer();
+
+	/// <summary>
+	/// Fences the previous frame's segment and moves on to the next one, waiting for the GPU to
+	/// finish with it if needed. Should be invoked once at the start of the frame, before any allocations
+	/// </summary>
+	void BeginFrame();
+
+	/// <summary>
+	/// Allocates a block of memory from the current frame's segment, aligned for use with glBindBufferRange
+	/// </summary>
+	/// <param name="size">The size of the block in bytes</param>
+	Allocation Allocate(uint32_t size);
+
+	/// <summary>
+	/// Allocates a block and copies the given structure into it
+	/// </summary>
+	/// <typeparam name="T">The type of structure to write, should be laid out to match an std140 block</typeparam>
+	/// <param name="value">The value to write into the ring</param>
+	template <typename T>
+	Allocation Write(const T& value) {
+		Allocation result = Allocate(sizeof(T));
+		memcpy(result.Data, &value, sizeof(T));
+		return result;
+	}
+
+	/// <summary>
+	/// Binds a block from the ring to a uniform buffer binding point
+	/// </summary>
+	/// <param name="slot">The uniform block binding to bind to</param>
+	/// <param name="block">The block to bind, as returned by Allocate or Write this frame</param>
+	void BindRange(uint32_t slot, const Allocation& block) const;
+
+	/// <summary>
+	/// Gets the number of bytes allocated in the current frame
+	/// </summary>
+	uint32_t GetBytesUsed() const { return _cursor - _segmentStart; }
+	/// <summary>
+	/// Gets the number of times BeginFrame had to wait for the GPU to release a segment
+	/// </summary>
+	uint32_t GetStallCount() const { return _stallCount; }
+
+	// Ring buffers have immutable storage, so these will assert
+	virtual void LoadData(const void* data, uint32_t elementSize, uint32_t elementCount) override;
+	virtual void UpdateData(const void* data, uint32_t elementSize, uint32_t elementCount, bool allowResize = true) override;
+
+protected:
+	// A buffer that has been replaced by a larger one, but may still be in use by the GPU
+	struct RetiredBuffer {
+		uint32_t Handle;
+		uint32_t FramesLeft;
+	};
+
+	uint32_t _bytesPerFrame;
+	uint32_t _frameCount;
+	uint32_t _alignment;
+
+	uint8_t* _mapped;
+	uint32_t _frameIndex;
+	uint32_t _segmentStart;
+	uint32_t _cursor;
+	uint32_t _stallCount;
+	// True once the first BeginFrame has been called
+	bool     _isFrameOpen;
+
+	std::vector<GLsync>        _fences;
+	std::vector<RetiredBuffer> _retired;
+
+	void _CreateStorage();
+	void _Grow(uint32_t minBytesPerFrame);
+};
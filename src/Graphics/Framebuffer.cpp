@@ -2,6 +2,7 @@
 
 #include "Graphics/RenderBuffer.h"
 #include "Utils/JsonGlmHelpers.h"
+#include "Graphics/GlStateCache.h"
 
 
 Framebuffer::Framebuffer(const FramebufferDescriptor& description) :
@@ -25,6 +26,7 @@ Framebuffer::Framebuffer(const FramebufferDescriptor& description) :
 
 Framebuffer::~Framebuffer() {
 	LOG_INFO("Deleting frame buffer with ID: {}", _rendererId);
+	GlStateCache::OnFramebufferDeleted(_rendererId);
 	glDeleteFramebuffers(1, &_rendererId);
 }
 
@@ -183,22 +185,22 @@ void Framebuffer::Bind(FramebufferBinding bindMode /*= FramebufferBinding::Draw*
 	_currentBinding = bindMode;
 	// Make sure that we're drawing to all the color buffers
 	glNamedFramebufferDrawBuffers(_rendererId, _drawBuffers.size(), reinterpret_cast<const GLenum*>(_drawBuffers.data()));
-	glBindFramebuffer(*bindMode, _rendererId);
+	GlStateCache::BindFramebuffer(bindMode, _rendererId);
 }
 
 void Framebuffer::Unbind() {
 	// Only handle if we've been bound
 	if (_currentBinding != FramebufferBinding::None) {
 		// Unbind the framebuffer and clear our binding
-		glBindFramebuffer(*_currentBinding, 0);
+		GlStateCache::BindFramebuffer(_currentBinding, 0);
 		_currentBinding = FramebufferBinding::None;
 	}
 }
 
 void Framebuffer::Blit(const Sptr& source, const Sptr& dest, BufferFlags flags /*= BufferFlags::All*/, MagFilter filter /*= MagFilter::Linear*/) {
 	// Bind this buffer as the read, and the unsampled as the write
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, source ? source->GetHandle() : 0);
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dest ? dest->GetHandle() : 0);
+	GlStateCache::BindFramebuffer(FramebufferBinding::Read, source ? source->GetHandle() : 0);
+	GlStateCache::BindFramebuffer(FramebufferBinding::Draw, dest ? dest->GetHandle() : 0);
 
 	// Figure out bounds of the framebuffers
 	glm::ivec4 srcBounds; 
@@ -224,8 +226,7 @@ void Framebuffer::Blit(const Sptr& source, const Sptr& dest, BufferFlags flags /
 	Blit(srcBounds, dstBounds, flags, filter);
 
 	// Unbind both buffers
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	GlStateCache::BindFramebuffer(FramebufferBinding::Both, 0);
 }
 
 void Framebuffer::Blit(const glm::ivec4& srcBounds, const glm::ivec4& dstBounds, BufferFlags flags /*= BufferFlags::All*/, MagFilter filter /*= MagFilter::Linear*/) {
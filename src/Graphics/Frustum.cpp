@@ -0,0 +1,75 @@
+#include "Graphics/Frustum.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define FRUSTUM_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+Frustum::Frustum() :
+	_planes()
+{
+	// A default frustum accepts everything
+	for (int ix = 0; ix < 8; ix++) {
+		_planeX[ix] = _planeY[ix] = _planeZ[ix] = 0.0f;
+		_planeW[ix] = 1.0f;
+	}
+	for (int ix = 0; ix < PlaneCount; ix++) {
+		_planes[ix] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection) :
+	Frustum()
+{
+	// Gribb-Hartmann plane extraction, GLM is column major so we need to pull out the rows
+	glm::vec4 rows[4];
+	for (int ix = 0; ix < 4; ix++) {
+		rows[ix] = glm::vec4(viewProjection[0][ix], viewProjection[1][ix], viewProjection[2][ix], viewProjection[3][ix]);
+	}
+
+	_planes[Left]   = rows[3] + rows[0];
+	_planes[Right]  = rows[3] - rows[0];
+	_planes[Bottom] = rows[3] + rows[1];
+	_planes[Top]    = rows[3] - rows[1];
+	_planes[Near]   = rows[3] + rows[2];
+	_planes[Far]    = rows[3] - rows[2];
+
+	// Normalize so that plane distances are in world units, and can be compared with radii
+	for (int ix = 0; ix < PlaneCount; ix++) {
+		float length = glm::length(glm::vec3(_planes[ix]));
+		if (length > 0.0f) {
+			_planes[ix] /= length;
+		}
+
+		_planeX[ix] = _planes[ix].x;
+		_planeY[ix] = _planes[ix].y;
+		_planeZ[ix] = _planes[ix].z;
+		_planeW[ix] = _planes[ix].w;
+	}
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const {
+	#ifdef FRUSTUM_USE_SSE
+	const __m128 cx = _mm_set1_ps(center.x);
+	const __m128 cy = _mm_set1_ps(center.y);
+	const __m128 cz = _mm_set1_ps(center.z);
+	const __m128 negRadius = _mm_set1_ps(-radius);
+
+	int outside = 0;
+	for (int ix = 0; ix < 8; ix += 4) {
+		__m128 dist = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(_mm_load_ps(_planeX + ix), cx), _mm_mul_ps(_mm_load_ps(_planeY + ix), cy)),
+			_mm_add_ps(_mm_mul_ps(_mm_load_ps(_planeZ + ix), cz), _mm_load_ps(_planeW + ix))
+		);
+		outside |= _mm_movemask_ps(_mm_cmplt_ps(dist, negRadius));
+	}
+	return outside == 0;
+	#else
+	for (int ix = 0; ix < PlaneCount; ix++) {
+		if (glm::dot(glm::vec3(_planes[ix]), center) + _planes[ix].w < -radius) {
+			return false;
+		}
+	}
+	return true;
+	#endif
+}
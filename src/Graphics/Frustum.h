@@ -0,0 +1,53 @@
+#pragma once
+#include "GLM/glm.hpp"
+
+/// <summary>
+/// The six clipping planes of a view frustum, used for culling objects that can not be seen
+/// by a camera.
+///
+/// Planes are stored as (normal, distance) with normals pointing into the frustum, so a point
+/// is inside a plane when dot(normal, point) + distance >= 0
+/// </summary>
+class Frustum {
+public:
+	enum Plane {
+		Left   = 0,
+		Right  = 1,
+		Bottom = 2,
+		Top    = 3,
+		Near   = 4,
+		Far    = 5,
+		PlaneCount = 6
+	};
+
+	Frustum();
+	/// <summary>
+	/// Extracts the frustum planes from a view projection matrix
+	/// </summary>
+	/// <param name="viewProjection">The view projection matrix, with an OpenGL style -1 to 1 depth range</param>
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	/// <summary>
+	/// Gets one of the frustum's planes, as (normal, distance)
+	/// </summary>
+	const glm::vec4& GetPlane(Plane plane) const { return _planes[plane]; }
+
+	/// <summary>
+	/// Tests whether a sphere is at least partially within the frustum. This is conservative, a sphere
+	/// near the corners of the frustum may pass without actually being visible
+	/// </summary>
+	/// <param name="center">The center of the sphere, in the same space as the view projection's input</param>
+	/// <param name="radius">The radius of the sphere</param>
+	/// <returns>False if the sphere is definitely outside of the frustum</returns>
+	bool IntersectsSphere(const glm::vec3& center, float radius) const;
+
+protected:
+	glm::vec4 _planes[PlaneCount];
+
+	// The planes transposed into groups of 4, so we can test a sphere against 4 planes at a time
+	// The last two planes in the second group are padding that always pass
+	alignas(16) float _planeX[8];
+	alignas(16) float _planeY[8];
+	alignas(16) float _planeZ[8];
+	alignas(16) float _planeW[8];
+};
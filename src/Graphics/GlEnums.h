@@ -47,6 +47,7 @@ ENUM(InternalFormat, GLint,
 	RGB8         = GL_RGB8,
 	SRGB         = GL_SRGB8,
 	RGB10        = GL_RGB10,
+	RGB10A2      = GL_RGB10_A2,
 	RGB16        = GL_RGB16,
 	RGB32F       = GL_RGB32F,
 	RGBA8        = GL_RGBA8,
@@ -696,6 +697,20 @@ inline size_t GetIndexTypeSize(IndexType type) {
 	}
 }
 
+/**
+ * Enumerates all possible options for glDepthFunc
+ */
+ENUM(DepthFunc, uint32_t,
+	Never        = GL_NEVER,
+	Less         = GL_LESS,
+	Equal        = GL_EQUAL,
+	LessEqual    = GL_LEQUAL,
+	Greater      = GL_GREATER,
+	NotEqual     = GL_NOTEQUAL,
+	GreaterEqual = GL_GEQUAL,
+	Always       = GL_ALWAYS
+)
+
 /**
  * Enumerates all possible options for glPolygonMode
  */
@@ -751,7 +766,9 @@ ENUM(BlendEquation, uint32_t,
 ENUM(BufferType, GLenum,
 	Vertex  = GL_ARRAY_BUFFER,
 	Index   = GL_ELEMENT_ARRAY_BUFFER,
-	Uniform = GL_UNIFORM_BUFFER
+	Uniform = GL_UNIFORM_BUFFER,
+	ShaderStorage = GL_SHADER_STORAGE_BUFFER,
+	PixelUnpack   = GL_PIXEL_UNPACK_BUFFER
 )
 
 /// <summary>
@@ -815,6 +832,9 @@ ENUM(AttributeType, GLenum,
 	 UInt    = GL_UNSIGNED_INT,
 	 Float   = GL_FLOAT,
 	 Double  = GL_DOUBLE,
+	 Half    = GL_HALF_FLOAT,
+	 Int2_10_10_10_Rev  = GL_INT_2_10_10_10_REV,  // Packed signed x,y,z,w in 10,10,10,2 bits, size must be 4
+	 UInt2_10_10_10_Rev = GL_UNSIGNED_INT_2_10_10_10_REV,
 	 Unknown = GL_NONE
 )
 
@@ -864,6 +884,7 @@ ENUM(RenderTargetType, uint32_t,
 	 Unknown      = GL_NONE,
 	 ColorRgba8   = GL_RGBA8,
 	 ColorRgb10   = GL_RGB10,
+	 ColorRgb10A2 = GL_RGB10_A2,
 	 ColorRgb8    = GL_RGB8,
 	 ColorRG8     = GL_RG8,
 	 ColorRed8    = GL_R8,
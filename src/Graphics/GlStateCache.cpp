@@ -0,0 +1,210 @@
+#include "Graphics/GlStateCache.h"
+
+GlStateCache::Tracked       GlStateCache::__capabilities[CapCount] = { };
+GlStateCache::Tracked       GlStateCache::__depthMask = GlStateCache::Tracked::Unknown;
+DepthFunc                   GlStateCache::__depthFunc = DepthFunc::Less;
+CullMode                    GlStateCache::__cullFace = CullMode::Back;
+FillMode                    GlStateCache::__polygonMode[2] = { FillMode::Fill, FillMode::Fill };
+BlendFunc                   GlStateCache::__blendFunc[4] = { BlendFunc::One, BlendFunc::Zero, BlendFunc::One, BlendFunc::Zero };
+BlendEquation               GlStateCache::__blendEquation[2] = { BlendEquation::Add, BlendEquation::Add };
+glm::ivec4                  GlStateCache::__viewport = glm::ivec4(0);
+uint32_t                    GlStateCache::__knownState = 0;
+
+GLuint GlStateCache::__program = GlStateCache::UNKNOWN_HANDLE;
+GLuint GlStateCache::__textures[MAX_TRACKED_TEXTURE_UNITS];
+GLuint GlStateCache::__readFramebuffer = GlStateCache::UNKNOWN_HANDLE;
+GLuint GlStateCache::__drawFramebuffer = GlStateCache::UNKNOWN_HANDLE;
+
+GlStateCache::Stats GlStateCache::__frameStats;
+GlStateCache::Stats GlStateCache::__lastFrameStats;
+
+// Small helper for the common pattern of "skip if it matches, otherwise count and update"
+#define ELIDE_IF(condition, counter) if (condition) { __frameStats.counter.Elided++; return; } __frameStats.counter.Issued++;
+
+void GlStateCache::Invalidate() {
+	for (int ix = 0; ix < CapCount; ix++) {
+		__capabilities[ix] = Tracked::Unknown;
+	}
+	__depthMask = Tracked::Unknown;
+	__knownState = 0;
+
+	__program = UNKNOWN_HANDLE;
+	for (int ix = 0; ix < MAX_TRACKED_TEXTURE_UNITS; ix++) {
+		__textures[ix] = UNKNOWN_HANDLE;
+	}
+	__readFramebuffer = UNKNOWN_HANDLE;
+	__drawFramebuffer = UNKNOWN_HANDLE;
+}
+
+void GlStateCache::EndFrame() {
+	__lastFrameStats = __frameStats;
+	__frameStats = Stats();
+	Invalidate();
+}
+
+const GlStateCache::Stats& GlStateCache::GetStats() {
+	return __lastFrameStats;
+}
+
+void GlStateCache::SetEnabled(GLenum capability, bool enabled) {
+	int index = __GetCapabilityIndex(capability);
+	if (index < 0) {
+		__frameStats.States.Issued++;
+	} else {
+		Tracked value = enabled ? Tracked::On : Tracked::Off;
+		ELIDE_IF(__capabilities[index] == value, States);
+		__capabilities[index] = value;
+	}
+
+	if (enabled) {
+		glEnable(capability);
+	} else {
+		glDisable(capability);
+	}
+}
+
+void GlStateCache::SetDepthMask(bool enabled) {
+	Tracked value = enabled ? Tracked::On : Tracked::Off;
+	ELIDE_IF(__depthMask == value, States);
+	__depthMask = value;
+	glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void GlStateCache::SetDepthFunc(DepthFunc func) {
+	ELIDE_IF((__knownState & KnownDepthFunc) && __depthFunc == func, States);
+	__knownState |= KnownDepthFunc;
+	__depthFunc = func;
+	glDepthFunc(*func);
+}
+
+void GlStateCache::SetCullMode(CullMode mode) {
+	SetEnabled(GL_CULL_FACE, mode != CullMode::None);
+	if (mode != CullMode::None) {
+		ELIDE_IF((__knownState & KnownCullFace) && __cullFace == mode, States);
+		__knownState |= KnownCullFace;
+		__cullFace = mode;
+		glCullFace(*mode);
+	}
+}
+
+void GlStateCache::SetPolygonMode(FillMode front, FillMode back) {
+	ELIDE_IF((__knownState & KnownPolygonMode) && __polygonMode[0] == front && __polygonMode[1] == back, States);
+	__knownState |= KnownPolygonMode;
+	__polygonMode[0] = front;
+	__polygonMode[1] = back;
+	// Core profile only accepts GL_FRONT_AND_BACK
+	if (front == back) {
+		glPolygonMode(GL_FRONT_AND_BACK, *front);
+	} else {
+		glPolygonMode(GL_FRONT, *front);
+		glPolygonMode(GL_BACK, *back);
+	}
+}
+
+void GlStateCache::SetBlendFunc(BlendFunc srcRgb, BlendFunc dstRgb, BlendFunc srcAlpha, BlendFunc dstAlpha) {
+	ELIDE_IF((__knownState & KnownBlendFunc) &&
+			 __blendFunc[0] == srcRgb && __blendFunc[1] == dstRgb &&
+			 __blendFunc[2] == srcAlpha && __blendFunc[3] == dstAlpha, States);
+	__knownState |= KnownBlendFunc;
+	__blendFunc[0] = srcRgb;
+	__blendFunc[1] = dstRgb;
+	__blendFunc[2] = srcAlpha;
+	__blendFunc[3] = dstAlpha;
+	glBlendFuncSeparate(*srcRgb, *dstRgb, *srcAlpha, *dstAlpha);
+}
+
+void GlStateCache::SetBlendEquation(BlendEquation rgb, BlendEquation alpha) {
+	ELIDE_IF((__knownState & KnownBlendEquation) && __blendEquation[0] == rgb && __blendEquation[1] == alpha, States);
+	__knownState |= KnownBlendEquation;
+	__blendEquation[0] = rgb;
+	__blendEquation[1] = alpha;
+	glBlendEquationSeparate(*rgb, *alpha);
+}
+
+void GlStateCache::SetViewport(int x, int y, int width, int height) {
+	glm::ivec4 viewport = glm::ivec4(x, y, width, height);
+	ELIDE_IF((__knownState & KnownViewport) && __viewport == viewport, Viewports);
+	__knownState |= KnownViewport;
+	__viewport = viewport;
+	glViewport(x, y, width, height);
+}
+
+void GlStateCache::UseProgram(GLuint program) {
+	ELIDE_IF(__program == program, Programs);
+	__program = program;
+	glUseProgram(program);
+}
+
+void GlStateCache::BindTexture(int slot, GLuint texture) {
+	if (slot >= 0 && slot < MAX_TRACKED_TEXTURE_UNITS) {
+		ELIDE_IF(__textures[slot] == texture, Textures);
+		__textures[slot] = texture;
+	} else {
+		__frameStats.Textures.Issued++;
+	}
+	glBindTextureUnit(slot, texture);
+}
+
+void GlStateCache::BindTextures(int first, int count, const GLuint* textures) {
+	// Narrow the range down to the units that actually need to change
+	int begin = count;
+	int end = 0;
+	for (int ix = 0; ix < count; ix++) {
+		int unit = first + ix;
+		if (unit >= MAX_TRACKED_TEXTURE_UNITS || __textures[unit] != textures[ix]) {
+			begin = glm::min(begin, ix);
+			end = ix + 1;
+		}
+	}
+
+	ELIDE_IF(begin >= end, Textures);
+	for (int ix = begin; ix < end && first + ix < MAX_TRACKED_TEXTURE_UNITS; ix++) {
+		__textures[first + ix] = textures[ix];
+	}
+	glBindTextures(first + begin, end - begin, textures + begin);
+}
+
+void GlStateCache::BindFramebuffer(FramebufferBinding binding, GLuint framebuffer) {
+	bool read = binding == FramebufferBinding::Read || binding == FramebufferBinding::Both;
+	bool draw = binding == FramebufferBinding::Draw || binding == FramebufferBinding::Both;
+	ELIDE_IF((!read || __readFramebuffer == framebuffer) && (!draw || __drawFramebuffer == framebuffer), Framebuffers);
+	if (read) { __readFramebuffer = framebuffer; }
+	if (draw) { __drawFramebuffer = framebuffer; }
+	glBindFramebuffer(*binding, framebuffer);
+}
+
+void GlStateCache::OnProgramDeleted(GLuint program) {
+	if (__program == program) {
+		__program = UNKNOWN_HANDLE;
+	}
+}
+
+void GlStateCache::OnTextureDeleted(GLuint texture) {
+	for (int ix = 0; ix < MAX_TRACKED_TEXTURE_UNITS; ix++) {
+		if (__textures[ix] == texture) {
+			__textures[ix] = UNKNOWN_HANDLE;
+		}
+	}
+}
+
+void GlStateCache::OnFramebufferDeleted(GLuint framebuffer) {
+	if (__readFramebuffer == framebuffer) {
+		__readFramebuffer = UNKNOWN_HANDLE;
+	}
+	if (__drawFramebuffer == framebuffer) {
+		__drawFramebuffer = UNKNOWN_HANDLE;
+	}
+}
+
+int GlStateCache::__GetCapabilityIndex(GLenum capability) {
+	switch (capability) {
+		case GL_DEPTH_TEST:         return CapDepthTest;
+		case GL_CULL_FACE:          return CapCullFace;
+		case GL_BLEND:              return CapBlend;
+		case GL_SCISSOR_TEST:       return CapScissorTest;
+		case GL_RASTERIZER_DISCARD: return CapRasterizerDiscard;
+		default:                    return -1;
+	}
+}
+
+#undef ELIDE_IF
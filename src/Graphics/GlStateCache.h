@@ -0,0 +1,160 @@
+#pragma once
+#include <cstdint>
+#include <glad/glad.h>
+#include <GLM/glm.hpp>
+
+#include "Graphics/GlEnums.h"
+
+/// <summary>
+/// Shadows the OpenGL pipeline state that our renderers touch the most, so that binds and
+/// state changes that would not change anything never make it to the driver
+///
+/// All of our code should go through this class instead of calling glEnable, glUseProgram,
+/// glBindTextureUnit and friends directly. Anything that modifies GL state behind our back
+/// (ImGui's renderer for instance) must be followed by a call to Invalidate
+/// </summary>
+class GlStateCache {
+public:
+	/// <summary>
+	/// The number of texture units that we track, binds to higher units always go through
+	/// </summary>
+	static const int MAX_TRACKED_TEXTURE_UNITS = 32;
+
+	/// <summary>
+	/// Counts the calls that were sent to OpenGL versus the ones we skipped
+	/// </summary>
+	struct Counter {
+		uint32_t Issued = 0;
+		uint32_t Elided = 0;
+	};
+
+	/// <summary>
+	/// Per-frame counters, broken down by the type of state
+	/// </summary>
+	struct Stats {
+		// glEnable/glDisable, depth, blend, cull and polygon state
+		Counter States;
+		// glUseProgram
+		Counter Programs;
+		// glBindTextureUnit and glBindTextures
+		Counter Textures;
+		// glBindFramebuffer
+		Counter Framebuffers;
+		// glViewport
+		Counter Viewports;
+	};
+
+	/// <summary>
+	/// Forgets everything we know about the GL state, so that the next call to each setter
+	/// is always sent to OpenGL
+	/// </summary>
+	static void Invalidate();
+	/// <summary>
+	/// Stores this frame's counters for GetStats, resets them, and invalidates the cache since
+	/// ImGui and the window system may have touched the state after we finished rendering
+	/// </summary>
+	static void EndFrame();
+	/// <summary>
+	/// Gets the counters for the last completed frame
+	/// </summary>
+	static const Stats& GetStats();
+
+	/// <summary>
+	/// Enables or disables a pipeline capability, such as GL_DEPTH_TEST or GL_BLEND. Capabilities
+	/// that we don't track are passed straight to OpenGL
+	/// </summary>
+	static void SetEnabled(GLenum capability, bool enabled);
+	static void Enable(GLenum capability) { SetEnabled(capability, true); }
+	static void Disable(GLenum capability) { SetEnabled(capability, false); }
+
+	static void SetDepthMask(bool enabled);
+	static void SetDepthFunc(DepthFunc func);
+	/// <summary>
+	/// Sets the cull mode, CullMode::None will disable GL_CULL_FACE
+	/// </summary>
+	static void SetCullMode(CullMode mode);
+	static void SetPolygonMode(FillMode front, FillMode back);
+	static void SetBlendFunc(BlendFunc srcRgb, BlendFunc dstRgb, BlendFunc srcAlpha, BlendFunc dstAlpha);
+	static void SetBlendFunc(BlendFunc src, BlendFunc dst) { SetBlendFunc(src, dst, src, dst); }
+	static void SetBlendEquation(BlendEquation rgb, BlendEquation alpha);
+	static void SetViewport(int x, int y, int width, int height);
+	static void SetViewport(const glm::ivec4& viewport) { SetViewport(viewport.x, viewport.y, viewport.z, viewport.w); }
+
+	/// <summary>
+	/// Binds a shader program by it's handle, 0 to unbind
+	/// </summary>
+	static void UseProgram(GLuint program);
+	/// <summary>
+	/// Binds a texture to a texture unit, or unbinds the unit if texture is 0
+	/// </summary>
+	static void BindTexture(int slot, GLuint texture);
+	/// <summary>
+	/// Binds a range of texture units at once, only the part of the range that has actually
+	/// changed is sent to OpenGL, with a single glBindTextures call
+	/// </summary>
+	/// <param name="first">The first texture unit to bind</param>
+	/// <param name="count">The number of units to bind</param>
+	/// <param name="textures">The texture handles, 0 will unbind the unit</param>
+	static void BindTextures(int first, int count, const GLuint* textures);
+	/// <summary>
+	/// Binds a framebuffer to the given binding point, FramebufferBinding::Both will bind it for
+	/// reading and drawing
+	/// </summary>
+	static void BindFramebuffer(FramebufferBinding binding, GLuint framebuffer);
+
+	/// <summary>
+	/// Should be invoked when a GL object is deleted, since OpenGL will unbind it and may hand
+	/// the same name out again for a new object
+	/// </summary>
+	static void OnProgramDeleted(GLuint program);
+	static void OnTextureDeleted(GLuint texture);
+	static void OnFramebufferDeleted(GLuint framebuffer);
+
+private:
+	// Capabilities that we shadow, anything else is untracked
+	enum TrackedCapability {
+		CapDepthTest = 0,
+		CapCullFace,
+		CapBlend,
+		CapScissorTest,
+		CapRasterizerDiscard,
+		CapCount
+	};
+	// Tri-state values, so we can tell a known state apart from one we've never set
+	enum class Tracked : uint8_t {
+		Unknown,
+		Off,
+		On
+	};
+	// Bits in __knownState for the values that don't have an unknown state of their own
+	enum KnownStateBits : uint32_t {
+		KnownDepthFunc     = 1 << 0,
+		KnownCullFace      = 1 << 1,
+		KnownPolygonMode   = 1 << 2,
+		KnownBlendFunc     = 1 << 3,
+		KnownBlendEquation = 1 << 4,
+		KnownViewport      = 1 << 5
+	};
+	// Handle value that means we don't know what is bound
+	static const GLuint UNKNOWN_HANDLE = 0xFFFFFFFF;
+
+	static Tracked       __capabilities[CapCount];
+	static Tracked       __depthMask;
+	static DepthFunc     __depthFunc;
+	static CullMode      __cullFace;
+	static FillMode      __polygonMode[2];
+	static BlendFunc     __blendFunc[4];
+	static BlendEquation __blendEquation[2];
+	static glm::ivec4    __viewport;
+	static uint32_t      __knownState;
+
+	static GLuint __program;
+	static GLuint __textures[MAX_TRACKED_TEXTURE_UNITS];
+	static GLuint __readFramebuffer;
+	static GLuint __drawFramebuffer;
+
+	static Stats __frameStats;
+	static Stats __lastFrameStats;
+
+	static int __GetCapabilityIndex(GLenum capability);
+};
@@ -0,0 +1,252 @@
+#include "Graphics/GpuProfiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <json.hpp>
+#include <Logging.h>
+
+#include "Utils/FileHelpers.h"
+
+bool     GpuProfiler::__enabled = true;
+bool     GpuProfiler::__hasQueries = false;
+bool     GpuProfiler::__recording = false;
+uint64_t GpuProfiler::__frameIndex = 0;
+uint64_t GpuProfiler::__resolvedFrames = 0;
+uint32_t GpuProfiler::__droppedFrames = 0;
+GpuProfiler::Frame GpuProfiler::__frames[FRAME_LATENCY];
+int      GpuProfiler::__stack[MAX_DEPTH];
+int      GpuProfiler::__stackDepth = 0;
+
+std::vector<GpuProfiler::Scope> GpuProfiler::__scopes;
+std::vector<uint32_t>           GpuProfiler::__lastFrame;
+std::vector<std::string>        GpuProfiler::__paths;
+
+// Lets us find the history for a scope path without scanning all the scopes
+static std::unordered_map<std::string, uint32_t> __scopeLookup;
+
+void GpuProfiler::SetEnabled(bool enabled) {
+	__enabled = enabled;
+}
+
+bool GpuProfiler::IsEnabled() {
+	return __enabled;
+}
+
+void GpuProfiler::BeginFrame() {
+	if (!__enabled) {
+		// Anything still in flight is stale by the time we're re-enabled
+		for (Frame& frame : __frames) {
+			frame.Pending = false;
+		}
+		return;
+	}
+
+	// Queries are made on first use, since we need a context
+	if (!__hasQueries) {
+		for (Frame& frame : __frames) {
+			glCreateQueries(GL_TIMESTAMP, MAX_SCOPES * 2, frame.Queries);
+			frame.Pending = false;
+		}
+		__hasQueries = true;
+	}
+
+	// The slot we're about to record into holds the frame from FRAME_LATENCY frames ago
+	Frame& frame = __frames[__frameIndex % FRAME_LATENCY];
+	if (frame.Pending) {
+		__Resolve(frame);
+	}
+
+	frame.EntryCount = 0;
+	frame.QueryCount = 0;
+	frame.Pending = false;
+	__stackDepth = 0;
+	__recording = true;
+
+	BeginScope("Frame");
+}
+
+void GpuProfiler::EndFrame() {
+	if (!__recording) {
+		return;
+	}
+
+	// Close the frame scope, and anything someone forgot to close
+	if (__stackDepth > 1) {
+		LOG_WARN("GPU profiler scope was not closed before the end of the frame");
+	}
+	while (__stackDepth > 0) {
+		EndScope();
+	}
+
+	__frames[__frameIndex % FRAME_LATENCY].Pending = true;
+	__frameIndex++;
+	__recording = false;
+}
+
+void GpuProfiler::BeginScope(const char* name) {
+	if (!__recording) {
+		return;
+	}
+
+	Frame& frame = __frames[__frameIndex % FRAME_LATENCY];
+
+	// We still track the depth of scopes we can't record, so that EndScope stays balanced
+	if (__stackDepth >= MAX_DEPTH) {
+		__stackDepth++;
+		return;
+	}
+	if (frame.EntryCount >= MAX_SCOPES) {
+		__stack[__stackDepth++] = -1;
+		return;
+	}
+
+	Entry& entry = frame.Entries[frame.EntryCount];
+	strncpy(entry.Name, name, MAX_NAME_LENGTH - 1);
+	entry.Name[MAX_NAME_LENGTH - 1] = '\0';
+	entry.Parent = __stackDepth > 0 ? __stack[__stackDepth - 1] : -1;
+	entry.Depth = __stackDepth;
+	entry.BeginQuery = frame.QueryCount++;
+	entry.EndQuery = entry.BeginQuery;
+	glQueryCounter(frame.Queries[entry.BeginQuery], GL_TIMESTAMP);
+
+	__stack[__stackDepth++] = frame.EntryCount++;
+}
+
+void GpuProfiler::EndScope() {
+	if (!__recording || __stackDepth == 0) {
+		return;
+	}
+
+	__stackDepth--;
+	if (__stackDepth >= MAX_DEPTH || __stack[__stackDepth] < 0) {
+		return;
+	}
+
+	Frame& frame = __frames[__frameIndex % FRAME_LATENCY];
+	Entry& entry = frame.Entries[__stack[__stackDepth]];
+	entry.EndQuery = frame.QueryCount++;
+	glQueryCounter(frame.Queries[entry.EndQuery], GL_TIMESTAMP);
+}
+
+const std::vector<GpuProfiler::Scope>& GpuProfiler::GetScopes() {
+	return __scopes;
+}
+
+const std::vector<uint32_t>& GpuProfiler::GetLastFrame() {
+	return __lastFrame;
+}
+
+uint32_t GpuProfiler::GetDroppedFrames() {
+	return __droppedFrames;
+}
+
+void GpuProfiler::Dump(const std::string& path) {
+	nlohmann::json blob;
+	blob["dropped_frames"] = __droppedFrames;
+	blob["history_length"] = HISTORY_LENGTH;
+
+	nlohmann::json scopes = nlohmann::json::array();
+	for (const Scope& scope : __scopes) {
+		// History is stored as a ring, we want it oldest to newest
+		std::vector<float> history;
+		history.reserve(scope.HistoryCount);
+		int first = (scope.HistoryOffset - scope.HistoryCount + HISTORY_LENGTH) % HISTORY_LENGTH;
+		for (int ix = 0; ix < scope.HistoryCount; ix++) {
+			history.push_back(scope.History[(first + ix) % HISTORY_LENGTH]);
+		}
+
+		scopes.push_back({
+			{ "path", scope.Path },
+			{ "depth", scope.Depth },
+			{ "last_ms", scope.LastMs },
+			{ "average_ms", scope.AverageMs },
+			{ "max_ms", scope.MaxMs },
+			{ "history_ms", history }
+		});
+	}
+	blob["scopes"] = scopes;
+
+	FileHelpers::WriteContentsToFile(path, blob.dump(1, '\t'));
+	LOG_INFO("Wrote GPU profile for {} scopes to \"{}\"", __scopes.size(), path);
+}
+
+void GpuProfiler::Cleanup() {
+	if (__hasQueries) {
+		for (Frame& frame : __frames) {
+			glDeleteQueries(MAX_SCOPES * 2, frame.Queries);
+			frame.Pending = false;
+		}
+		__hasQueries = false;
+	}
+	__recording = false;
+}
+
+void GpuProfiler::__Resolve(Frame& frame) {
+	if (frame.QueryCount == 0) {
+		return;
+	}
+
+	// Timestamps complete in order, so if the last one is ready the whole frame is. If it
+	// isn't, we drop the frame rather than wait for it
+	GLint available = GL_FALSE;
+	glGetQueryObjectiv(frame.Queries[frame.QueryCount - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (available == GL_FALSE) {
+		__droppedFrames++;
+		return;
+	}
+
+	__lastFrame.clear();
+	__paths.resize(frame.EntryCount);
+	for (uint32_t ix = 0; ix < frame.EntryCount; ix++) {
+		const Entry& entry = frame.Entries[ix];
+
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(frame.Queries[entry.BeginQuery], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(frame.Queries[entry.EndQuery], GL_QUERY_RESULT, &end);
+		float ms = end > begin ? static_cast<float>(end - begin) / 1000000.0f : 0.0f;
+
+		// Parents are always recorded before their children, so their path is already built
+		__paths[ix] = entry.Parent >= 0 ? __paths[entry.Parent] + "/" + entry.Name : std::string(entry.Name);
+		uint32_t scopeIx = __FindScope(__paths[ix], entry.Name, entry.Depth);
+		Scope& scope = __scopes[scopeIx];
+
+		// If we've already seen this path this frame, we add on to the sample we already took
+		if (scope.LastResolved == __resolvedFrames) {
+			scope.LastMs += ms;
+			scope.History[(scope.HistoryOffset - 1 + HISTORY_LENGTH) % HISTORY_LENGTH] = scope.LastMs;
+		} else {
+			__lastFrame.push_back(scopeIx);
+			scope.LastResolved = __resolvedFrames;
+			scope.LastMs = ms;
+			scope.History[scope.HistoryOffset] = ms;
+			scope.HistoryOffset = (scope.HistoryOffset + 1) % HISTORY_LENGTH;
+			scope.HistoryCount = std::min(scope.HistoryCount + 1, (int)HISTORY_LENGTH);
+		}
+
+		float sum = 0.0f;
+		scope.MaxMs = 0.0f;
+		for (int iy = 0; iy < scope.HistoryCount; iy++) {
+			sum += scope.History[iy];
+			scope.MaxMs = std::max(scope.MaxMs, scope.History[iy]);
+		}
+		scope.AverageMs = sum / scope.HistoryCount;
+	}
+	__resolvedFrames++;
+}
+
+uint32_t GpuProfiler::__FindScope(const std::string& path, const char* name, int depth) {
+	auto it = __scopeLookup.find(path);
+	if (it != __scopeLookup.end()) {
+		return it->second;
+	}
+
+	// Scope holds a decent chunk of history, so we grow this rarely and only for new paths
+	uint32_t result = static_cast<uint32_t>(__scopes.size());
+	__scopes.emplace_back();
+	__scopes.back().Path = path;
+	__scopes.back().Name = name;
+	__scopes.back().Depth = depth;
+	__scopeLookup[path] = result;
+	return result;
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+/// <summary>
+/// Measures how long the GPU spends in named, nested scopes of the frame, using GL_TIMESTAMP
+/// queries. Queries are kept in a ring several frames deep and only read back once they're
+/// available, so the profiler never stalls the pipeline waiting for results
+///
+/// Scopes are identified by their path from the root of the frame (ex: "Frame/Rendering/G-Buffer"),
+/// so the same name can appear under different parents. Scopes with the same path in a single
+/// frame (ex: one per particle system) are added together
+/// </summary>
+class GpuProfiler {
+public:
+	/// <summary>
+	/// The number of frames worth of queries we keep in flight, results are read this many frames late
+	/// </summary>
+	static const int FRAME_LATENCY = 4;
+	/// <summary>
+	/// The maximum number of scopes we can record in a single frame, scopes past this are ignored
+	/// </summary>
+	static const int MAX_SCOPES = 128;
+	/// <summary>
+	/// The maximum depth that scopes can be nested
+	/// </summary>
+	static const int MAX_DEPTH = 16;
+	/// <summary>
+	/// The number of frames of history we keep for each scope
+	/// </summary>
+	static const int HISTORY_LENGTH = 120;
+	/// <summary>
+	/// The longest scope name we will store, longer names are truncated
+	/// </summary>
+	static const int MAX_NAME_LENGTH = 48;
+
+	/// <summary>
+	/// The timing results for a single scope
+	/// </summary>
+	struct Scope {
+		// The path to the scope, ex: "Frame/Post Processing/Depth of Field"
+		std::string Path;
+		// The name of the scope, without it's parents
+		std::string Name;
+		// How many scopes this one is nested in, the frame itself is 0
+		int         Depth = 0;
+		// The time spent in the scope in the most recent resolved frame, in milliseconds
+		float       LastMs = 0.0f;
+		// The average and peak over the history, in milliseconds
+		float       AverageMs = 0.0f;
+		float       MaxMs = 0.0f;
+		// The rolling history of times in milliseconds, HistoryOffset is the oldest sample
+		float       History[HISTORY_LENGTH] = { 0.0f };
+		int         HistoryOffset = 0;
+		int         HistoryCount = 0;
+		// The index of the last resolved frame that this scope appeared in
+		uint64_t    LastResolved = UINT64_MAX;
+	};
+
+	/// <summary>
+	/// Enables or disables the profiler, takes effect at the start of the next frame
+	/// </summary>
+	static void SetEnabled(bool enabled);
+	static bool IsEnabled();
+
+	/// <summary>
+	/// Starts recording a new frame, and resolves the frame that was recorded FRAME_LATENCY
+	/// frames ago if it's results are ready. Opens the root "Frame" scope
+	/// </summary>
+	static void BeginFrame();
+	/// <summary>
+	/// Closes the root scope, and any scopes that were left open
+	/// </summary>
+	static void EndFrame();
+
+	/// <summary>
+	/// Opens a new scope nested in the current scope, prefer GPU_PROFILE_SCOPE over calling
+	/// this directly. Name is copied, so it does not need to outlive the call
+	/// </summary>
+	static void BeginScope(const char* name);
+	/// <summary>
+	/// Closes the most recently opened scope
+	/// </summary>
+	static void EndScope();
+
+	/// <summary>
+	/// Gets all the scopes that the profiler has seen, in no particular order
+	/// </summary>
+	static const std::vector<Scope>& GetScopes();
+	/// <summary>
+	/// Gets the indices into GetScopes for the scopes in the last resolved frame, in the
+	/// order they were opened (so children always come right after their parent)
+	/// </summary>
+	static const std::vector<uint32_t>& GetLastFrame();
+	/// <summary>
+	/// Gets the number of frames that we skipped because their results were not ready in time
+	/// </summary>
+	static uint32_t GetDroppedFrames();
+
+	/// <summary>
+	/// Writes the history for all scopes to a JSON file
+	/// </summary>
+	/// <param name="path">The path of the file to write</param>
+	static void Dump(const std::string& path);
+
+	/// <summary>
+	/// Releases the GL queries, must be called while the context is still alive
+	/// </summary>
+	static void Cleanup();
+
+private:
+	// A single recorded scope, waiting for it's queries to resolve
+	struct Entry {
+		char     Name[MAX_NAME_LENGTH];
+		int      Parent;
+		int      Depth;
+		uint32_t BeginQuery;
+		uint32_t EndQuery;
+	};
+	// All the queries and scopes for a frame in the ring
+	struct Frame {
+		GLuint   Queries[MAX_SCOPES * 2];
+		Entry    Entries[MAX_SCOPES];
+		uint32_t EntryCount;
+		uint32_t QueryCount;
+		bool     Pending;
+	};
+
+	static bool     __enabled;
+	static bool     __hasQueries;
+	static bool     __recording;
+	static uint64_t __frameIndex;
+	static uint64_t __resolvedFrames;
+	static uint32_t __droppedFrames;
+	static Frame    __frames[FRAME_LATENCY];
+	static int      __stack[MAX_DEPTH];
+	static int      __stackDepth;
+
+	static std::vector<Scope>       __scopes;
+	static std::vector<uint32_t>    __lastFrame;
+	static std::vector<std::string> __paths;
+
+	static void __Resolve(Frame& frame);
+	static uint32_t __FindScope(const std::string& path, const char* name, int depth);
+};
+
+/// <summary>
+/// Opens a GPU profiler scope for the lifetime of this object
+/// </summary>
+class GpuProfileScope {
+public:
+	GpuProfileScope(const char* name) { GpuProfiler::BeginScope(name); }
+	GpuProfileScope(const std::string& name) { GpuProfiler::BeginScope(name.c_str()); }
+	~GpuProfileScope() { GpuProfiler::EndScope(); }
+
+	GpuProfileScope(const GpuProfileScope&) = delete;
+	GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+};
+
+#define __GPU_PROFILE_CONCAT_INNER(a, b) a##b
+#define __GPU_PROFILE_CONCAT(a, b) __GPU_PROFILE_CONCAT_INNER(a, b)
+/// <summary>
+/// Profiles the GPU work issued from this line to the end of the enclosing block
+/// </summary>
+#define GPU_PROFILE_SCOPE(name) GpuProfileScope __GPU_PROFILE_CONCAT(__gpuProfileScope, __LINE__)(name)
@@ -56,7 +56,8 @@ void GuiBatcher::PushRect(const glm::vec2& min, const glm::vec2& max, const glm:
 
 void GuiBatcher::PushRect(const glm::vec2& min, const glm::vec2& max, const glm::vec4& color, const Texture2D::Sptr& tex, int edgeRadius)
 {
-	if (edgeRadius <= 0) {
+	// Textures that are still streaming in don't have a size yet, so we can't work out their edge UVs
+	if (edgeRadius <= 0 || tex->GetWidth() <= 2 || tex->GetHeight() <= 2) {
 		PushRect(min, max, color, tex, { 0,0 }, { 1,1 });
 	} 
 	else {
@@ -0,0 +1,97 @@
+#include "Graphics/InstanceBuffer.h"
+
+#include <algorithm>
+#include <cstddef>
+
+// Our instance attributes start after the attributes used by vs_common.glsl and the
+// extra slots used by some of our vertex shaders
+static constexpr uint32_t INSTANCE_ATTRIB_START = 8;
+
+InstanceBuffer::InstanceBuffer(uint32_t initialCapacity) :
+	_buffer(nullptr),
+	_instances(),
+	_capacity(initialCapacity > 0 ? initialCapacity : 1),
+	_cursor(0),
+	_dirtyBegin(0),
+	_dirtyEnd(0),
+	_validCount(0),
+	_bytesUploaded(0)
+{
+	_buffer = VertexBuffer::Create(BufferUsage::DynamicDraw);
+	_buffer->LoadData<InstanceData>(nullptr, _capacity);
+	_instances.resize(_capacity);
+}
+
+void InstanceBuffer::Reset() {
+	_cursor = 0;
+	_bytesUploaded = 0;
+}
+
+uint32_t InstanceBuffer::Allocate(uint32_t count) {
+	uint32_t result = _cursor;
+	_cursor += count;
+
+	if (_cursor > _capacity) {
+		// Grow geometrically, re-allocating the buffer loses it's contents so everything
+		// we've already written this frame will need to be uploaded again
+		_capacity = std::max(_cursor, _capacity * 2);
+		_instances.resize(_capacity);
+		_buffer->LoadData<InstanceData>(nullptr, _capacity);
+		_validCount = 0;
+		_dirtyBegin = 0;
+		_dirtyEnd = std::max(_dirtyEnd, result);
+	}
+
+	return result;
+}
+
+void InstanceBuffer::Write(uint32_t index, const glm::mat4& model) {
+	InstanceData& instance = _instances[index];
+	if (index < _validCount && instance.Model == model) {
+		return;
+	}
+
+	instance.Model = model;
+	instance.NormalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
+
+	if (_dirtyBegin == _dirtyEnd) {
+		_dirtyBegin = index;
+		_dirtyEnd = index + 1;
+	} else {
+		_dirtyBegin = std::min(_dirtyBegin, index);
+		_dirtyEnd = std::max(_dirtyEnd, index + 1);
+	}
+}
+
+void InstanceBuffer::Flush() {
+	if (_dirtyBegin == _dirtyEnd) {
+		return;
+	}
+
+	uint32_t size = (_dirtyEnd - _dirtyBegin) * sizeof(InstanceData);
+	_buffer->UpdateRange(_dirtyBegin * sizeof(InstanceData), &_instances[_dirtyBegin], size);
+	_bytesUploaded += size;
+
+	if (_dirtyBegin <= _validCount) {
+		_validCount = std::max(_validCount, _dirtyEnd);
+	}
+	_dirtyBegin = _dirtyEnd = 0;
+}
+
+void InstanceBuffer::AttachTo(VertexArrayObject* vao) {
+	// We tag our attributes with User3 so we can find them again
+	VertexArrayObject::VertexBufferBinding* binding = vao->GetBufferBinding(AttribUsage::User3);
+	if (binding != nullptr && binding->GetBuffer() == _buffer) {
+		return;
+	}
+
+	// Each matrix takes up 4 attribute slots, one per column
+	std::vector<BufferAttribute> attributes;
+	for (uint32_t column = 0; column < 4; column++) {
+		attributes.push_back(BufferAttribute(INSTANCE_ATTRIB_START + column, 4, AttributeType::Float, sizeof(InstanceData), offsetof(InstanceData, Model) + column * sizeof(glm::vec4), AttribUsage::User3));
+	}
+	for (uint32_t column = 0; column < 4; column++) {
+		attributes.push_back(BufferAttribute(INSTANCE_ATTRIB_START + 4 + column, 4, AttributeType::Float, sizeof(InstanceData), offsetof(InstanceData, NormalMatrix) + column * sizeof(glm::vec4), AttribUsage::User3));
+	}
+	vao->AddVertexBuffer(_buffer, attributes, true);
+}
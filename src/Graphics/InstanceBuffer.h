@@ -0,0 +1,90 @@
+#pragma once
+#include <vector>
+
+#include "GLM/glm.hpp"
+#include "Utils/Macros.h"
+#include "Graphics/Buffers/VertexBuffer.h"
+#include "Graphics/VertexArrayObject.h"
+
+/// <summary>
+/// A vertex buffer of per-instance transforms that is shared between all meshes drawn with
+/// automatic instancing. Batches allocate a contiguous range of instances each frame and draw
+/// with a base instance into it.
+///
+/// We keep a CPU side copy of everything that was uploaded, so writing an instance that has not
+/// changed since last frame costs a compare rather than an upload. Only the range between the
+/// first and last changed instance is sent to the GPU on Flush
+///
+/// Instance attributes occupy slots 8-15, see fragments/vs_common.glsl
+/// </summary>
+class InstanceBuffer {
+public:
+	MAKE_PTRS(InstanceBuffer);
+	NO_COPY(InstanceBuffer);
+	NO_MOVE(InstanceBuffer);
+
+	/// <summary>
+	/// The layout of a single instance in the buffer
+	/// </summary>
+	struct InstanceData {
+		glm::mat4 Model;
+		glm::mat4 NormalMatrix;
+	};
+
+	/// <summary>
+	/// Creates a new instance buffer
+	/// </summary>
+	/// <param name="initialCapacity">The number of instances to reserve space for up front</param>
+	InstanceBuffer(uint32_t initialCapacity = 1024);
+	~InstanceBuffer() = default;
+
+	/// <summary>
+	/// Resets the allocation cursor, should be invoked once at the start of the frame
+	/// </summary>
+	void Reset();
+
+	/// <summary>
+	/// Reserves a contiguous range of instances, growing the buffer if needed
+	/// </summary>
+	/// <param name="count">The number of instances to reserve</param>
+	/// <returns>The index of the first instance in the range, for use as the base instance</returns>
+	uint32_t Allocate(uint32_t count);
+
+	/// <summary>
+	/// Writes an instance's transform, the normal matrix is only recalculated if the transform has changed
+	/// </summary>
+	/// <param name="index">The index of the instance, as returned by Allocate</param>
+	/// <param name="model">The instance's model matrix</param>
+	void Write(uint32_t index, const glm::mat4& model);
+
+	/// <summary>
+	/// Uploads any instances that have changed since the last flush
+	/// </summary>
+	void Flush();
+
+	/// <summary>
+	/// Adds our per-instance attributes to the given VAO if they have not already been added
+	/// </summary>
+	void AttachTo(VertexArrayObject* vao);
+
+	/// <summary>
+	/// Gets the number of bytes uploaded since the last reset
+	/// </summary>
+	uint32_t GetBytesUploaded() const { return _bytesUploaded; }
+
+protected:
+	VertexBuffer::Sptr        _buffer;
+	// Mirrors what is currently in GPU memory
+	std::vector<InstanceData> _instances;
+	uint32_t                  _capacity;
+	uint32_t                  _cursor;
+
+	// The range of instances that need to be uploaded on the next flush [begin, end)
+	uint32_t                  _dirtyBegin;
+	uint32_t                  _dirtyEnd;
+	// The number of leading instances that have been uploaded since the buffer was last (re)allocated,
+	// anything past this has undefined contents on the GPU and must be uploaded
+	uint32_t                  _validCount;
+
+	uint32_t                  _bytesUploaded;
+};
@@ -0,0 +1,260 @@
+#include "Graphics/LightClusters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Utils/JobSystem.h"
+
+// Our lighting buffers are 8 bits per channel, so any contribution below this is lost anyway. We use
+// it to find the distance at which a light stops mattering, and thus which clusters it can touch
+static constexpr float LIGHT_CUTOFF = 1.0f / 256.0f;
+
+// The grid uniforms, see fragments/light_clusters.glsl
+static constexpr ShaderProgram::UniformId U_CLUSTER_DIMS("u_ClusterDims");
+static constexpr ShaderProgram::UniformId U_CLUSTER_DEPTH_SCALE("u_ClusterDepthScale");
+static constexpr ShaderProgram::UniformId U_CLUSTER_DEPTH_BIAS("u_ClusterDepthBias");
+
+LightClusters::LightClusters(const glm::uvec3& dimensions) :
+	_dimensions(glm::max(dimensions, glm::uvec3(1))),
+	_lights(),
+	_ranges(),
+	_clusters(),
+	_indices(),
+	_maxLightsPerCluster(0),
+	_bounds(),
+	_boundsProjection(0.0f),
+	_boundsNear(0.0f),
+	_boundsFar(0.0f),
+	_slicePairs(),
+	_depthScale(0.0f),
+	_depthBias(0.0f),
+	_lightBuffer(nullptr),
+	_clusterBuffer(nullptr),
+	_indexBuffer(nullptr)
+{
+	_clusters.resize(_dimensions.x * _dimensions.y * _dimensions.z);
+	_slicePairs.resize(_dimensions.z);
+
+	_lightBuffer   = ShaderStorageBuffer::Create();
+	_clusterBuffer = ShaderStorageBuffer::Create();
+	_indexBuffer   = ShaderStorageBuffer::Create();
+}
+
+void LightClusters::Clear() {
+	_lights.clear();
+	_ranges.clear();
+}
+
+void LightClusters::AddLight(const glm::vec3& viewPosition, const glm::vec3& color, float intensity, float attenuation) {
+	// Solve intensity / (1 + attenuation * d^2) = cutoff for d, see CalcPointLightContribution
+	float brightness = intensity * std::max({ color.r, color.g, color.b });
+	float radiusSqr = (brightness / LIGHT_CUTOFF - 1.0f) / std::max(attenuation, 1e-6f);
+	if (brightness <= 0.0f || radiusSqr <= 0.0f) {
+		return;
+	}
+
+	GpuLight light;
+	light.PositionIntensity = glm::vec4(viewPosition, intensity);
+	light.ColorAttenuation  = glm::vec4(color, attenuation);
+	_lights.push_back(light);
+
+	LightRange range;
+	range.Center = viewPosition;
+	range.Radius = glm::sqrt(radiusSqr);
+	range.Min = glm::uvec3(0);
+	range.Max = glm::uvec3(0);
+	_ranges.push_back(range);
+}
+
+void LightClusters::Build(const glm::mat4& projection, float zNear, float zFar) {
+	// Our depth slices are logarithmic, so we can't let the near plane sit on (or behind) the camera
+	zNear = std::max(zNear, 0.001f);
+	zFar  = std::max(zFar, zNear * 2.0f);
+
+	if (projection != _boundsProjection || zNear != _boundsNear || zFar != _boundsFar || _bounds.empty()) {
+		_BuildBounds(projection, zNear, zFar);
+	}
+
+	const uint32_t tilesPerSlice = _dimensions.x * _dimensions.y;
+
+	// Find the range of clusters each light could touch, lights that are completely outside
+	// of the view are given an empty range (Min > Max)
+	for (LightRange& range : _ranges) {
+		float depth = -range.Center.z;
+		if (depth + range.Radius < zNear || depth - range.Radius > zFar) {
+			range.Min = glm::uvec3(1);
+			range.Max = glm::uvec3(0);
+			continue;
+		}
+		range.Min.z = _GetSlice(depth - range.Radius);
+		range.Max.z = _GetSlice(depth + range.Radius);
+
+		// If the light's bounds cross the near plane, we can't project them
+		if (depth - range.Radius <= zNear) {
+			range.Min.x = range.Min.y = 0;
+			range.Max.x = _dimensions.x - 1;
+			range.Max.y = _dimensions.y - 1;
+			continue;
+		}
+
+		// Project the corners of the light's bounding box to find it's extent on screen
+		glm::vec2 ndcMin = glm::vec2(std::numeric_limits<float>::max());
+		glm::vec2 ndcMax = glm::vec2(std::numeric_limits<float>::lowest());
+		for (int corner = 0; corner < 8; corner++) {
+			glm::vec3 offset = glm::vec3(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f) * range.Radius;
+			glm::vec4 clip = projection * glm::vec4(range.Center + offset, 1.0f);
+			glm::vec2 ndc = glm::vec2(clip) / clip.w;
+			ndcMin = glm::min(ndcMin, ndc);
+			ndcMax = glm::max(ndcMax, ndc);
+		}
+		if (ndcMax.x < -1.0f || ndcMax.y < -1.0f || ndcMin.x > 1.0f || ndcMin.y > 1.0f) {
+			range.Min = glm::uvec3(1);
+			range.Max = glm::uvec3(0);
+			continue;
+		}
+
+		glm::vec2 tileMin = glm::clamp((ndcMin * 0.5f + 0.5f) * glm::vec2(_dimensions), glm::vec2(0.0f), glm::vec2(_dimensions) - 1.0f);
+		glm::vec2 tileMax = glm::clamp((ndcMax * 0.5f + 0.5f) * glm::vec2(_dimensions), glm::vec2(0.0f), glm::vec2(_dimensions) - 1.0f);
+		range.Min.x = static_cast<uint32_t>(tileMin.x);
+		range.Min.y = static_cast<uint32_t>(tileMin.y);
+		range.Max.x = static_cast<uint32_t>(tileMax.x);
+		range.Max.y = static_cast<uint32_t>(tileMax.y);
+	}
+
+	// Test each light against the clusters in it's range, each slice writes to it's own list
+	// so we can split the work up by slice
+	JobSystem::ParallelFor(_dimensions.z, 1, [&](uint32_t start, uint32_t end) {
+		for (uint32_t slice = start; slice < end; slice++) {
+			std::vector<glm::uvec2>& pairs = _slicePairs[slice];
+			pairs.clear();
+
+			for (uint32_t lightIx = 0; lightIx < _ranges.size(); lightIx++) {
+				const LightRange& range = _ranges[lightIx];
+				if (slice < range.Min.z || slice > range.Max.z) {
+					continue;
+				}
+
+				for (uint32_t y = range.Min.y; y <= range.Max.y; y++) {
+					for (uint32_t x = range.Min.x; x <= range.Max.x; x++) {
+						uint32_t tile = x + y * _dimensions.x;
+						const ClusterBounds& bounds = _bounds[slice * tilesPerSlice + tile];
+
+						// Sphere vs AABB, using the closest point in the box to the light
+						glm::vec3 closest = glm::clamp(range.Center, bounds.Min, bounds.Max);
+						glm::vec3 delta = closest - range.Center;
+						if (glm::dot(delta, delta) <= range.Radius * range.Radius) {
+							pairs.push_back(glm::uvec2(tile, lightIx));
+						}
+					}
+				}
+			}
+		}
+	});
+
+	// Counting sort the pairs into a flat index list, grouped by cluster
+	std::fill(_clusters.begin(), _clusters.end(), glm::uvec2(0));
+	for (uint32_t slice = 0; slice < _dimensions.z; slice++) {
+		for (const glm::uvec2& pair : _slicePairs[slice]) {
+			_clusters[slice * tilesPerSlice + pair.x].y++;
+		}
+	}
+
+	uint32_t offset = 0;
+	_maxLightsPerCluster = 0;
+	for (glm::uvec2& cluster : _clusters) {
+		cluster.x = offset;
+		offset += cluster.y;
+		_maxLightsPerCluster = std::max(_maxLightsPerCluster, cluster.y);
+		// We re-count as we fill in the indices below
+		cluster.y = 0;
+	}
+
+	_indices.resize(offset);
+	for (uint32_t slice = 0; slice < _dimensions.z; slice++) {
+		for (const glm::uvec2& pair : _slicePairs[slice]) {
+			glm::uvec2& cluster = _clusters[slice * tilesPerSlice + pair.x];
+			_indices[cluster.x + cluster.y] = pair.y;
+			cluster.y++;
+		}
+	}
+
+	// Re-allocate rather than updating in place, so the driver can orphan the old storage instead
+	// of waiting for the previous frame to finish with it. GL doesn't like binding empty buffers,
+	// so we always upload at least one element
+	static const GpuLight emptyLight = GpuLight();
+	static const uint32_t emptyIndex = 0;
+	_lightBuffer->LoadData(_lights.empty() ? &emptyLight : _lights.data(), std::max<uint32_t>(1, GetLightCount()));
+	_clusterBuffer->LoadData(_clusters.data(), static_cast<uint32_t>(_clusters.size()));
+	_indexBuffer->LoadData(_indices.empty() ? &emptyIndex : _indices.data(), std::max<uint32_t>(1, GetIndexCount()));
+}
+
+void LightClusters::Bind(const ShaderProgram::Sptr& shader) const {
+	_lightBuffer->Bind(LIGHTS_BINDING);
+	_clusterBuffer->Bind(CLUSTER_BINDING);
+	_indexBuffer->Bind(INDEX_BINDING);
+
+	shader->SetUniform(U_CLUSTER_DIMS, _dimensions);
+	shader->SetUniform(U_CLUSTER_DEPTH_SCALE, _depthScale);
+	shader->SetUniform(U_CLUSTER_DEPTH_BIAS, _depthBias);
+}
+
+void LightClusters::_BuildBounds(const glm::mat4& projection, float zNear, float zFar) {
+	_boundsProjection = projection;
+	_boundsNear = zNear;
+	_boundsFar  = zFar;
+
+	// Slices are distributed logarithmically, so that clusters stay roughly cube shaped
+	float logRatio = std::log(zFar / zNear);
+	_depthScale = _dimensions.z / logRatio;
+	_depthBias  = -(_dimensions.z * std::log(zNear)) / logRatio;
+
+	// For each tile corner, we find the points where it crosses the near and far planes. Points
+	// at a given depth can then be found by interpolating, which works for any projection
+	glm::mat4 invProjection = glm::inverse(projection);
+	std::vector<glm::vec3> cornerNear((_dimensions.x + 1) * (_dimensions.y + 1));
+	std::vector<glm::vec3> cornerFar(cornerNear.size());
+	for (uint32_t y = 0; y <= _dimensions.y; y++) {
+		for (uint32_t x = 0; x <= _dimensions.x; x++) {
+			glm::vec2 ndc = glm::vec2(x, y) / glm::vec2(_dimensions) * 2.0f - 1.0f;
+			glm::vec4 pNear = invProjection * glm::vec4(ndc, -1.0f, 1.0f);
+			glm::vec4 pFar  = invProjection * glm::vec4(ndc,  1.0f, 1.0f);
+			cornerNear[x + y * (_dimensions.x + 1)] = glm::vec3(pNear) / pNear.w;
+			cornerFar[x + y * (_dimensions.x + 1)]  = glm::vec3(pFar) / pFar.w;
+		}
+	}
+
+	_bounds.resize(_clusters.size());
+	for (uint32_t slice = 0; slice < _dimensions.z; slice++) {
+		float sliceNear = zNear * std::pow(zFar / zNear, static_cast<float>(slice) / _dimensions.z);
+		float sliceFar  = zNear * std::pow(zFar / zNear, static_cast<float>(slice + 1) / _dimensions.z);
+
+		for (uint32_t y = 0; y < _dimensions.y; y++) {
+			for (uint32_t x = 0; x < _dimensions.x; x++) {
+				ClusterBounds& bounds = _bounds[x + y * _dimensions.x + slice * _dimensions.x * _dimensions.y];
+				bounds.Min = glm::vec3(std::numeric_limits<float>::max());
+				bounds.Max = glm::vec3(std::numeric_limits<float>::lowest());
+
+				for (uint32_t corner = 0; corner < 4; corner++) {
+					uint32_t cornerIx = (x + (corner & 1)) + (y + (corner >> 1)) * (_dimensions.x + 1);
+					const glm::vec3& pNear = cornerNear[cornerIx];
+					const glm::vec3& pFar  = cornerFar[cornerIx];
+					for (float depth : { sliceNear, sliceFar }) {
+						float t = (depth + pNear.z) / (pNear.z - pFar.z);
+						glm::vec3 point = glm::mix(pNear, pFar, t);
+						bounds.Min = glm::min(bounds.Min, point);
+						bounds.Max = glm::max(bounds.Max, point);
+					}
+				}
+			}
+		}
+	}
+}
+
+uint32_t LightClusters::_GetSlice(float viewDepth) const {
+	if (viewDepth <= _boundsNear) {
+		return 0;
+	}
+	float slice = std::floor(std::log(viewDepth) * _depthScale + _depthBias);
+	return static_cast<uint32_t>(glm::clamp(slice, 0.0f, static_cast<float>(_dimensions.z - 1)));
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "GLM/glm.hpp"
+#include "Utils/Macros.h"
+#include "Graphics/Buffers/ShaderStorageBuffer.h"
+#include "Graphics/ShaderProgram.h"
+
+/// <summary>
+/// Bins point lights into a grid of view space clusters (froxels), so that the lighting
+/// pass only needs to shade each pixel with the lights that can actually reach it.
+///
+/// The grid is split evenly into tiles in normalized device coordinates, and logarithmically
+/// into slices along the view depth, see fragments/light_clusters.glsl for the shader side
+///
+/// The results are stored in three shader storage buffers:
+///     - the lights themselves, in view space
+///     - a (offset, count) pair per cluster
+///     - a flat list of light indices, which the cluster entries index into
+/// </summary>
+class LightClusters {
+public:
+	MAKE_PTRS(LightClusters);
+	NO_COPY(LightClusters);
+	NO_MOVE(LightClusters);
+
+	/// <summary>
+	/// A light as stored on the GPU, the layout matches the Light structure in our shaders
+	/// </summary>
+	struct GpuLight {
+		// View space position in xyz, intensity in w
+		glm::vec4 PositionIntensity;
+		// Color in rgb, attenuation factor in w
+		glm::vec4 ColorAttenuation;
+	};
+
+	/// <summary>
+	/// The storage buffer binding slots that Bind uses
+	/// </summary>
+	static const int LIGHTS_BINDING  = 3;
+	static const int CLUSTER_BINDING = 4;
+	static const int INDEX_BINDING   = 5;
+
+	/// <summary>
+	/// Creates a new light cluster grid
+	/// </summary>
+	/// <param name="dimensions">The number of tiles along x and y, and the number of depth slices</param>
+	LightClusters(const glm::uvec3& dimensions = glm::uvec3(16, 9, 24));
+	~LightClusters() = default;
+
+	/// <summary>
+	/// Removes all lights from the grid, should be invoked before adding the frame's lights
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Adds a point light to the grid
+	/// </summary>
+	/// <param name="viewPosition">The light's position in view space</param>
+	/// <param name="color">The light's color</param>
+	/// <param name="intensity">The light's intensity multiplier</param>
+	/// <param name="attenuation">The light's quadratic attenuation factor, see light_accumulation.glsl</param>
+	void AddLight(const glm::vec3& viewPosition, const glm::vec3& color, float intensity, float attenuation);
+
+	/// <summary>
+	/// Bins all the lights into clusters and uploads the results to the GPU. The binning is split
+	/// across the job system by depth slice
+	/// </summary>
+	/// <param name="projection">The camera's projection matrix</param>
+	/// <param name="zNear">The distance to the camera's near plane</param>
+	/// <param name="zFar">The distance to the camera's far plane</param>
+	void Build(const glm::mat4& projection, float zNear, float zFar);
+
+	/// <summary>
+	/// Binds the storage buffers, and sets the grid uniforms on the given shader
+	/// </summary>
+	void Bind(const ShaderProgram::Sptr& shader) const;
+
+	/// <summary>
+	/// Gets the number of lights that were added since the last clear
+	/// </summary>
+	uint32_t GetLightCount() const { return static_cast<uint32_t>(_lights.size()); }
+	/// <summary>
+	/// Gets the total number of light/cluster pairs generated by the last build
+	/// </summary>
+	uint32_t GetIndexCount() const { return static_cast<uint32_t>(_indices.size()); }
+	/// <summary>
+	/// Gets the highest number of lights affecting a single cluster in the last build
+	/// </summary>
+	uint32_t GetMaxLightsPerCluster() const { return _maxLightsPerCluster; }
+	/// <summary>
+	/// Gets the grid dimensions
+	/// </summary>
+	const glm::uvec3& GetDimensions() const { return _dimensions; }
+
+protected:
+	// View space bounds of a single cluster
+	struct ClusterBounds {
+		glm::vec3 Min;
+		glm::vec3 Max;
+	};
+
+	// The range of clusters a light might touch, used to narrow down the per-cluster tests
+	struct LightRange {
+		glm::vec3  Center;
+		float      Radius;
+		glm::uvec3 Min;
+		glm::uvec3 Max;
+	};
+
+	glm::uvec3 _dimensions;
+
+	std::vector<GpuLight>      _lights;
+	std::vector<LightRange>    _ranges;
+	std::vector<glm::uvec2>    _clusters;
+	std::vector<uint32_t>      _indices;
+	uint32_t                   _maxLightsPerCluster;
+
+	// Cluster bounds only need to be rebuilt when the projection changes
+	std::vector<ClusterBounds> _bounds;
+	glm::mat4                  _boundsProjection;
+	float                      _boundsNear;
+	float                      _boundsFar;
+
+	// Per-slice (cluster, light) pairs, so slices can be binned in parallel
+	std::vector<std::vector<glm::uvec2>> _slicePairs;
+
+	float _depthScale;
+	float _depthBias;
+
+	ShaderStorageBuffer::Sptr _lightBuffer;
+	ShaderStorageBuffer::Sptr _clusterBuffer;
+	ShaderStorageBuffer::Sptr _indexBuffer;
+
+	void _BuildBounds(const glm::mat4& projection, float zNear, float zFar);
+	uint32_t _GetSlice(float viewDepth) const;
+};
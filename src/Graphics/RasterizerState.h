@@ -2,6 +2,7 @@
 #include <EnumToString.h>
 #include "glad/glad.h"
 #include "Graphics/GlEnums.h"
+#include "Graphics/GlStateCache.h"
 
 /**
  * Represents the state of the OpenGL blend function 
@@ -37,16 +38,14 @@ struct BlendState {
 	BlendFunc     DstAlpha       = BlendFunc::Zero;
 
 	/**
-	 * Applies this blending state to the OpenGL pipeline
+	 * Applies this blending state to the OpenGL pipeline, only the parts that differ
+	 * from the current state are sent to OpenGL
 	 */
-	inline void Apply() {
+	inline void Apply() const {
+		GlStateCache::SetEnabled(GL_BLEND, BlendEnabled);
 		if (BlendEnabled) {
-			glEnable(GL_BLEND);
-			glBlendFuncSeparate(*SrcRgb, *DstRgb, *SrcAlpha, *DstAlpha);
-			glBlendEquationSeparate(*RgbBlendFunc, *AlphaBlendFunc);
-		}
-		else  {
-			glDisable(GL_BLEND);
+			GlStateCache::SetBlendFunc(SrcRgb, DstRgb, SrcAlpha, DstAlpha);
+			GlStateCache::SetBlendEquation(RgbBlendFunc, AlphaBlendFunc);
 		}
 	}
 };
@@ -64,6 +63,43 @@ const BlendState AlphaBlendState = {
 	BlendFunc::One
 };
 
+/**
+ * Represents the state of the depth test and depth writes
+ */
+struct DepthState {
+	/**
+	 * True if depth testing is enabled
+	 */
+	bool      TestEnabled  = true;
+	/**
+	 * True if fragments should write to the depth buffer
+	 */
+	bool      WriteEnabled = true;
+	/**
+	 * The comparison to use for depth testing
+	 */
+	DepthFunc Func         = DepthFunc::Less;
+
+	/**
+	 * Applies this depth state to the OpenGL pipeline, only the parts that differ
+	 * from the current state are sent to OpenGL
+	 */
+	inline void Apply() const {
+		GlStateCache::SetEnabled(GL_DEPTH_TEST, TestEnabled);
+		GlStateCache::SetDepthMask(WriteEnabled);
+		GlStateCache::SetDepthFunc(Func);
+	}
+};
+
+/**
+ * Depth testing and writing with the default less than test
+ */
+const DepthState DefaultDepthState = { true, true, DepthFunc::Less };
+/**
+ * No depth testing or writing, for fullscreen passes
+ */
+const DepthState DisabledDepthState = { false, false, DepthFunc::Less };
+
 /*
 * Represents the core state of the graphics rasterizer, such as the culling, fill modes, blending, etc...
 */
@@ -86,16 +122,12 @@ struct RasterizerState {
 	BlendState Blending    = BlendState();
 
 	/**
-	 * Applies the entire rasterizer state to the OpenGL render pipeline
+	 * Applies the entire rasterizer state to the OpenGL render pipeline, only the parts 
+	 * that differ from the current state are sent to OpenGL
 	 */
-	inline void Apply() {
-		glPolygonMode(GL_FRONT, *FrontFaceFill);
-		glPolygonMode(GL_BACK, *BackFaceFill);
-		if (CullMode != CullMode::None) {
-			glEnable(GL_CULL_FACE);
-			glCullFace(*CullMode);
-		} else {
-			glDisable(GL_CULL_FACE);
-		}
+	inline void Apply() const {
+		GlStateCache::SetPolygonMode(FrontFaceFill, BackFaceFill);
+		GlStateCache::SetCullMode(CullMode);
+		Blending.Apply();
 	}
 };
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "Graphics/RenderQueue.h"
+
+#include <algorithm>
+
+// Bit widths of the fields in the sort key, these must add up to 64
+static constexpr uint32_t PASS_BITS     = 4;
+static constexpr uint32_t SHADER_BITS   = 12;
+static constexpr uint32_t MATERIAL_BITS = 16;
+static constexpr uint32_t MESH_BITS     = 16;
+static constexpr uint32_t DEPTH_BITS    = 16;
+
+static constexpr uint32_t DEPTH_SHIFT    = 0;
+static constexpr uint32_t MESH_SHIFT     = DEPTH_SHIFT + DEPTH_BITS;
+static constexpr uint32_t MATERIAL_SHIFT = MESH_SHIFT + MESH_BITS;
+static constexpr uint32_t SHADER_SHIFT   = MATERIAL_SHIFT + MATERIAL_BITS;
+static constexpr uint32_t PASS_SHIFT     = SHADER_SHIFT + SHADER_BITS;
+
+static_assert(PASS_SHIFT + PASS_BITS == 64, "Sort key fields must fill 64 bits");
+
+RenderQueue::Stats& RenderQueue::Stats::operator+=(const Stats& other) {
+	DrawCalls              += other.DrawCalls;
+	ShaderBinds            += other.ShaderBinds;
+	ShaderBindsSkipped     += other.ShaderBindsSkipped;
+	MaterialApplies        += other.MaterialApplies;
+	MaterialAppliesSkipped += other.MaterialAppliesSkipped;
+	VaoBinds               += other.VaoBinds;
+	VaoBindsSkipped        += other.VaoBindsSkipped;
+	InstancedDraws         += other.InstancedDraws;
+	InstancesDrawn         += other.InstancesDrawn;
+	return *this;
+}
+
+RenderQueue::RenderQueue() :
+	_packets(),
+	_order(),
+	_stats(),
+	_instancingThreshold(2),
+	_batchIndices(),
+	_batch(),
+	_shaderIds(),
+	_materialIds(),
+	_meshIds()
+{ }
+
+void RenderQueue::Clear() {
+	_packets.clear();
+	_order.clear();
+	_stats = Stats();
+	_shaderIds.clear();
+	_materialIds.clear();
+	_meshIds.clear();
+}
+
+void RenderQueue::Push(RenderPass pass, Gameplay::Material* material, VertexArrayObject* mesh, const glm::mat4& transform, float depth) {
+	ShaderProgram* shader = material->GetShader().get();
+
+	// Quantize the depth, transparent objects need to be drawn back to front so we flip them
+	uint64_t depthBits = static_cast<uint64_t>(glm::clamp(depth, 0.0f, 1.0f) * ((1 << DEPTH_BITS) - 1));
+	if (pass == RenderPass::Transparent) {
+		depthBits = ((1 << DEPTH_BITS) - 1) - depthBits;
+	}
+
+	uint64_t key =
+		(static_cast<uint64_t>(pass) << PASS_SHIFT) |
+		(static_cast<uint64_t>(_GetId(_shaderIds, shader, (1 << SHADER_BITS) - 1)) << SHADER_SHIFT) |
+		(static_cast<uint64_t>(_GetId(_materialIds, material, (1 << MATERIAL_BITS) - 1)) << MATERIAL_SHIFT) |
+		(static_cast<uint64_t>(_GetId(_meshIds, mesh, (1 << MESH_BITS) - 1)) << MESH_SHIFT) |
+		(depthBits << DEPTH_SHIFT);
+
+	DrawPacket packet;
+	packet.SortKey   = key;
+	packet.Shader    = shader;
+	packet.Material  = material;
+	packet.Mesh      = mesh;
+	packet.Transform = transform;
+
+	_order.push_back({ key, static_cast<uint32_t>(_packets.size()) });
+	_packets.push_back(packet);
+}
+
+void RenderQueue::Sort() {
+	std::sort(_order.begin(), _order.end(), [](const SortEntry& a, const SortEntry& b) {
+		return a.Key < b.Key;
+	});
+}
+
+uint32_t RenderQueue::_GetId(std::unordered_map<const void*, uint32_t>& ids, const void* ptr, uint32_t maxValue) {
+	auto it = ids.find(ptr);
+	if (it != ids.end()) {
+		return it->second;
+	}
+
+	// If we run out of IDs, everything else shares the last one. This only costs us
+	// some extra state changes, never correctness, since we still compare pointers on submit
+	uint32_t id = static_cast<uint32_t>(ids.size());
+	if (id > maxValue) {
+		id = maxValue;
+	}
+	ids[ptr] = id;
+	return id;
+}
@@ -0,0 +1,211 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+#include "GLM/glm.hpp"
+#include "Gameplay/Material.h"
+#include "Graphics/ShaderProgram.h"
+#include "Graphics/VertexArrayObject.h"
+
+/// <summary>
+/// The passes that draw packets can belong to, packets are submitted in this order
+/// </summary>
+enum class RenderPass : uint8_t {
+	Opaque      = 0,
+	Transparent = 1
+};
+
+/// <summary>
+/// Collects draw packets for a single view, sorts them by a packed 64 bit key and then
+/// submits them while skipping redundant shader binds, material applies and VAO binds.
+///
+/// The key is laid out from most to least significant as:
+///     pass (4 bits) | shader (12 bits) | material (16 bits) | mesh (16 bits) | depth (16 bits)
+/// so that draws are grouped by the most expensive state changes first, and opaque draws
+/// within a group are ordered front to back (transparent draws are ordered back to front)
+///
+/// Since sorting places draws that share a material and mesh next to each other, runs of
+/// these can be collapsed into a single instanced draw, see Submit
+/// </summary>
+class RenderQueue {
+public:
+	/// <summary>
+	/// Counters for how much state changing work was done (or skipped) during submission
+	/// </summary>
+	struct Stats {
+		uint32_t DrawCalls              = 0;
+		uint32_t ShaderBinds            = 0;
+		uint32_t ShaderBindsSkipped     = 0;
+		uint32_t MaterialApplies        = 0;
+		uint32_t MaterialAppliesSkipped = 0;
+		uint32_t VaoBinds               = 0;
+		uint32_t VaoBindsSkipped        = 0;
+		uint32_t InstancedDraws         = 0;
+		uint32_t InstancesDrawn         = 0;
+
+		Stats& operator +=(const Stats& other);
+	};
+
+	/// <summary>
+	/// A single draw that has been pushed into the queue
+	/// </summary>
+	struct DrawPacket {
+		uint64_t            SortKey;
+		ShaderProgram*      Shader;
+		Gameplay::Material* Material;
+		VertexArrayObject*  Mesh;
+		glm::mat4           Transform;
+	};
+
+	RenderQueue();
+	~RenderQueue() = default;
+
+	/// <summary>
+	/// Removes all packets from the queue and resets the stats
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Adds a draw to the queue
+	/// </summary>
+	/// <param name="pass">The pass that the draw belongs to</param>
+	/// <param name="material">The material to draw with, must have a valid shader</param>
+	/// <param name="mesh">The VAO to draw</param>
+	/// <param name="transform">The object's world transform</param>
+	/// <param name="depth">The object's distance from the camera, normalized to the 0-1 range</param>
+	void Push(RenderPass pass, Gameplay::Material* material, VertexArrayObject* mesh, const glm::mat4& transform, float depth);
+
+	/// <summary>
+	/// Sorts all the packets in the queue by their keys
+	/// </summary>
+	void Sort();
+
+	/// <summary>
+	/// Sets the minimum number of consecutive draws sharing a material and mesh that will be
+	/// submitted as a single instanced draw, or 0 to disable instancing
+	/// </summary>
+	void SetInstancingThreshold(uint32_t value) { _instancingThreshold = value; }
+	uint32_t GetInstancingThreshold() const { return _instancingThreshold; }
+
+	/// <summary>
+	/// Submits all packets in sorted order. Runs of packets that share a material and mesh
+	/// are handed to perBatch, which must upload the instance data and return the base instance
+	/// to draw with. All other packets are handed to perDraw before they are drawn, so that
+	/// per-object state (such as instance uniforms) can be uploaded
+	///
+	/// Packets within a batch are given in the order they were pushed, rather than by depth,
+	/// so that the instance data stays stable between frames and views
+	/// </summary>
+	/// <typeparam name="DrawCallback">A callable with the signature void(const DrawPacket&)</typeparam>
+	/// <typeparam name="BatchCallback">A callable with the signature uint32_t(const std::vector<const DrawPacket*>&)</typeparam>
+	template <typename DrawCallback, typename BatchCallback>
+	void Submit(DrawCallback&& perDraw, BatchCallback&& perBatch) {
+		ShaderProgram*      currentShader   = nullptr;
+		Gameplay::Material* currentMaterial = nullptr;
+		VertexArrayObject*  currentMesh     = nullptr;
+
+		size_t ix = 0;
+		while (ix < _order.size()) {
+			const DrawPacket& packet = _packets[_order[ix].Index];
+
+			// Find the run of packets that can share an instanced draw with this one
+			size_t runEnd = ix + 1;
+			while (runEnd < _order.size() &&
+				_packets[_order[runEnd].Index].Material == packet.Material &&
+				_packets[_order[runEnd].Index].Mesh == packet.Mesh) {
+				runEnd++;
+			}
+			uint32_t runLength = static_cast<uint32_t>(runEnd - ix);
+			bool instanced = _instancingThreshold > 0 && runLength >= _instancingThreshold;
+			// Without instancing we only draw the first packet of the run this iteration
+			if (!instanced) {
+				runEnd = ix + 1;
+			}
+
+			if (packet.Shader != currentShader) {
+				packet.Shader->Bind();
+				currentShader = packet.Shader;
+				_stats.ShaderBinds++;
+			} else {
+				_stats.ShaderBindsSkipped++;
+			}
+
+			if (packet.Material != currentMaterial) {
+				packet.Material->Apply();
+				currentMaterial = packet.Material;
+				_stats.MaterialApplies++;
+			} else {
+				_stats.MaterialAppliesSkipped++;
+			}
+
+			if (packet.Mesh != currentMesh) {
+				packet.Mesh->Bind();
+				currentMesh = packet.Mesh;
+				_stats.VaoBinds++;
+			} else {
+				_stats.VaoBindsSkipped++;
+			}
+
+			if (instanced) {
+				_batch.clear();
+				for (size_t batchIx = ix; batchIx < runEnd; batchIx++) {
+					_batchIndices.push_back(_order[batchIx].Index);
+				}
+				std::sort(_batchIndices.begin(), _batchIndices.end());
+				for (uint32_t packetIx : _batchIndices) {
+					_batch.push_back(&_packets[packetIx]);
+				}
+				_batchIndices.clear();
+
+				uint32_t baseInstance = perBatch(_batch);
+				packet.Mesh->DrawInstancedBound(runLength, DrawMode::TriangleList, baseInstance);
+				_stats.InstancedDraws++;
+				_stats.InstancesDrawn += runLength;
+			} else {
+				perDraw(packet);
+				packet.Mesh->DrawBound();
+			}
+			_stats.DrawCalls++;
+
+			ix = runEnd;
+		}
+
+		VertexArrayObject::Unbind();
+	}
+
+	/// <summary>
+	/// Gets the number of packets in the queue
+	/// </summary>
+	size_t Size() const { return _packets.size(); }
+
+	/// <summary>
+	/// Gets the stats for the last submission since the queue was cleared
+	/// </summary>
+	const Stats& GetStats() const { return _stats; }
+
+protected:
+	struct SortEntry {
+		uint64_t Key;
+		uint32_t Index;
+	};
+
+	std::vector<DrawPacket> _packets;
+	// We sort a list of small key/index pairs rather than moving the packets around
+	std::vector<SortEntry>  _order;
+	Stats                   _stats;
+	uint32_t                _instancingThreshold;
+
+	// Scratch space for building instanced batches
+	std::vector<uint32_t>          _batchIndices;
+	std::vector<const DrawPacket*> _batch;
+
+	// Maps state objects to small IDs so they can be packed into the sort keys, these
+	// are re-assigned every time the queue is cleared
+	std::unordered_map<const void*, uint32_t> _shaderIds;
+	std::unordered_map<const void*, uint32_t> _materialIds;
+	std::unordered_map<const void*, uint32_t> _meshIds;
+
+	static uint32_t _GetId(std::unordered_map<const void*, uint32_t>& ids, const void* ptr, uint32_t maxValue);
+};
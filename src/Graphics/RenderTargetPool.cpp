@@ -0,0 +1,78 @@
+#include "Graphics/RenderTargetPool.h"
+#include "Logging.h"
+
+RenderTargetPool::RenderTargetPool(uint32_t maxIdleFrames) :
+	_entries(),
+	_maxIdleFrames(maxIdleFrames),
+	_inUse(0),
+	_framePeak(0),
+	_lastFramePeak(0)
+{ }
+
+Framebuffer::Sptr RenderTargetPool::Acquire(const glm::ivec2& size, RenderTargetType format) {
+	glm::ivec2 clampedSize = glm::max(size, glm::ivec2(1));
+
+	Entry* result = nullptr;
+	for (Entry& entry : _entries) {
+		if (!entry.InUse && entry.Size == clampedSize && entry.Format == format) {
+			result = &entry;
+			break;
+		}
+	}
+
+	// Nothing free matches, we need a new target
+	if (result == nullptr) {
+		FramebufferDescriptor desc = FramebufferDescriptor();
+		desc.Width  = clampedSize.x;
+		desc.Height = clampedSize.y;
+		desc.RenderTargets[RenderTargetAttachment::Color0] = RenderTargetDescriptor(format);
+
+		LOG_TRACE("Allocating {}x{} {} transient render target", clampedSize.x, clampedSize.y, ~format);
+		_entries.push_back({ std::make_shared<Framebuffer>(desc), clampedSize, format, false, 0 });
+		result = &_entries.back();
+	}
+
+	result->InUse = true;
+	result->IdleFrames = 0;
+	_inUse++;
+	_framePeak = glm::max(_framePeak, _inUse);
+	return result->Target;
+}
+
+void RenderTargetPool::Release(const Framebuffer::Sptr& target) {
+	for (Entry& entry : _entries) {
+		if (entry.Target == target) {
+			LOG_ASSERT(entry.InUse, "Render target released twice");
+			entry.InUse = false;
+			_inUse--;
+			return;
+		}
+	}
+	LOG_WARN("Attempted to release a render target that does not belong to this pool");
+}
+
+void RenderTargetPool::EndFrame() {
+	for (size_t ix = 0; ix < _entries.size();) {
+		Entry& entry = _entries[ix];
+		if (!entry.InUse && ++entry.IdleFrames > _maxIdleFrames) {
+			_entries[ix] = std::move(_entries.back());
+			_entries.pop_back();
+		} else {
+			ix++;
+		}
+	}
+
+	_lastFramePeak = _framePeak;
+	_framePeak = _inUse;
+}
+
+void RenderTargetPool::Clear() {
+	for (size_t ix = 0; ix < _entries.size();) {
+		if (!_entries[ix].InUse) {
+			_entries[ix] = std::move(_entries.back());
+			_entries.pop_back();
+		} else {
+			ix++;
+		}
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "GLM/glm.hpp"
+#include "Utils/Macros.h"
+#include "Graphics/Framebuffer.h"
+
+/// <summary>
+/// A pool of single color target framebuffers for transient, per-frame passes such as
+/// post processing. Targets are keyed by size and format, a target that has been released
+/// can be handed out again to any later pass with the same key in the same frame, so passes
+/// that don't overlap end up sharing memory
+///
+/// Targets that go unused for a few frames (ex: the effect that needed them was disabled)
+/// are freed in EndFrame
+/// </summary>
+class RenderTargetPool {
+public:
+	MAKE_PTRS(RenderTargetPool);
+	NO_COPY(RenderTargetPool);
+	NO_MOVE(RenderTargetPool);
+
+	/// <summary>
+	/// Creates a new render target pool
+	/// </summary>
+	/// <param name="maxIdleFrames">The number of frames a target can go unused before we free it</param>
+	RenderTargetPool(uint32_t maxIdleFrames = 3);
+	~RenderTargetPool() = default;
+
+	/// <summary>
+	/// Gets a target with the given size and format, re-using a released one if we have one
+	/// </summary>
+	/// <param name="size">The size of the target in pixels</param>
+	/// <param name="format">The format of the target's single color attachment</param>
+	Framebuffer::Sptr Acquire(const glm::ivec2& size, RenderTargetType format);
+	/// <summary>
+	/// Returns a target to the pool, once all reads from it have been issued
+	/// </summary>
+	void Release(const Framebuffer::Sptr& target);
+
+	/// <summary>
+	/// Frees any targets that have been idle for too long, should be invoked once per frame
+	/// after all passes have released their targets
+	/// </summary>
+	void EndFrame();
+	/// <summary>
+	/// Frees all targets that are not currently in use, ex: after a resize where none of them
+	/// will ever match again
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Gets the number of targets that currently have memory allocated
+	/// </summary>
+	uint32_t GetResidentCount() const { return static_cast<uint32_t>(_entries.size()); }
+	/// <summary>
+	/// Gets the highest number of targets that were in use at once during the last frame
+	/// </summary>
+	uint32_t GetPeakInUse() const { return _lastFramePeak; }
+
+protected:
+	struct Entry {
+		Framebuffer::Sptr Target;
+		glm::ivec2        Size;
+		RenderTargetType  Format;
+		bool              InUse;
+		uint32_t          IdleFrames;
+	};
+
+	std::vector<Entry> _entries;
+	uint32_t _maxIdleFrames;
+	uint32_t _inUse;
+	uint32_t _framePeak;
+	uint32_t _lastFramePeak;
+};
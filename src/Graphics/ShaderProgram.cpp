@@ -3,20 +3,27 @@
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <algorithm>
+#include <cstring>
 
 #include "Utils/FileHelpers.h"
+#include "Graphics/GlStateCache.h"
 #include "Utils/JsonGlmHelpers.h"
 
 ShaderProgram::ShaderProgram() : 
 	IGraphicsResource(),
-	IResource()
+	IResource(),
+	_displacementMargin(0.0f),
+	_isDepthCompatible(false)
 {
 	_rendererId = glCreateProgram();
 }
 
 ShaderProgram::ShaderProgram(const std::unordered_map<ShaderPartType, std::string>& filePaths) :
 	IGraphicsResource(),
-	IResource()
+	IResource(),
+	_displacementMargin(0.0f),
+	_isDepthCompatible(false)
 {
 	_rendererId = glCreateProgram();
 	for (auto& [type, path] : filePaths) {
@@ -27,6 +34,7 @@ ShaderProgram::ShaderProgram(const std::unordered_map<ShaderPartType, std::strin
 
 ShaderProgram::~ShaderProgram() {
 	if (_rendererId != 0) {
+		GlStateCache::OnProgramDeleted(_rendererId);
 		glDeleteProgram(_rendererId);
 		_rendererId = 0;
 	}
@@ -162,79 +170,103 @@ bool ShaderProgram::Link() {
 }
 
 void ShaderProgram::Bind() {
-	// Simply calls glUseProgram with our shader handle
-	glUseProgram(_rendererId);
+	// Goes through the state cache, so re-binding the current program is free
+	GlStateCache::UseProgram(_rendererId);
 }
 
 void ShaderProgram::Unbind() {
 	// We unbind a shader program by using the default program (0)
-	glUseProgram(0);
+	GlStateCache::UseProgram(0);
 }
 
 void ShaderProgram::SetUniformMatrix(int location, const glm::mat3* value, int count, bool transposed) {
+	if (transposed) _InvalidateUniformCache(location, count);
+	else if (_IsUniformCached(location, value, sizeof(glm::mat3) * count)) return;
 	glProgramUniformMatrix3fv(_rendererId, location, count, transposed, glm::value_ptr(*value));
 }
 void ShaderProgram::SetUniformMatrix(int location, const glm::mat4* value, int count, bool transposed) {
+	if (transposed) _InvalidateUniformCache(location, count);
+	else if (_IsUniformCached(location, value, sizeof(glm::mat4) * count)) return;
 	glProgramUniformMatrix4fv(_rendererId, location, count, transposed, glm::value_ptr(*value));
 }
 
 void ShaderProgram::SetUniform(int location, const float* value, int count) {
+	if (_IsUniformCached(location, value, sizeof(float) * count)) return;
 	glProgramUniform1fv(_rendererId, location, count, value);
 }
 void ShaderProgram::SetUniform(int location, const glm::vec2* value, int count) {
+	if (_IsUniformCached(location, value, sizeof(glm::vec2) * count)) return;
 	glProgramUniform2fv(_rendererId, location, count, glm::value_ptr(*value));
 }
 void ShaderProgram::SetUniform(int location, const glm::vec3* value, int count) {
+	if (_IsUniformCached(location, value, sizeof(glm::vec3) * count)) return;
 	glProgramUniform3fv(_rendererId, location, count, glm::value_ptr(*value));
 }
 void ShaderProgram::SetUniform(int location, const glm::vec4* value, int count) {
+	if (_IsUniformCached(location, value, sizeof(glm::vec4) * count)) return;
 	glProgramUniform4fv(_rendererId, location, count, glm::value_ptr(*value));
 }
 
 void ShaderProgram::SetUniform(int location, const int* value, int count) {
+	if (_IsUniformCached(location, value, sizeof(int) * count)) return;
 	glProgramUniform1iv(_rendererId, location, count, value);
 }
 void ShaderProgram::SetUniform(int location, const glm::ivec2* value, int count) {
+	if (_IsUniformCached(location, value, sizeof(glm::ivec2) * count)) return;
 	glProgramUniform2iv(_rendererId, location, count, glm::value_ptr(*value));
 }
 void ShaderProgram::SetUniform(int location, const glm::ivec3* value, int count) {
+	if (_IsUniformCached(location, value, sizeof(glm::ivec3) * count)) return;
 	glProgramUniform3iv(_rendererId, location, count, glm::value_ptr(*value));
 }
 void ShaderProgram::SetUniform(int location, const glm::ivec4* value, int count) {
+	if (_IsUniformCached(location, value, sizeof(glm::ivec4) * count)) return;
 	glProgramUniform4iv(_rendererId, location, count, glm::value_ptr(*value));
 }
 
 void ShaderProgram::SetUniform(int location, const uint32_t* value, int count) {
+	if (_IsUniformCached(location, value, sizeof(uint32_t) * count)) return;
 	glProgramUniform1uiv(_rendererId, location, count, value);
 }
 void ShaderProgram::SetUniform(int location, const glm::uvec2* value, int count) {
+	if (_IsUniformCached(location, value, sizeof(glm::uvec2) * count)) return;
 	glProgramUniform2uiv(_rendererId, location, count, glm::value_ptr(*value));
 }
 void ShaderProgram::SetUniform(int location, const glm::uvec3* value, int count) {
+	if (_IsUniformCached(location, value, sizeof(glm::uvec3) * count)) return;
 	glProgramUniform3uiv(_rendererId, location, count, glm::value_ptr(*value));
 }
 void ShaderProgram::SetUniform(int location, const glm::uvec4* value, int count) {
+	if (_IsUniformCached(location, value, sizeof(glm::uvec4) * count)) return;
 	glProgramUniform4uiv(_rendererId, location, count, glm::value_ptr(*value));
 }
 
 void ShaderProgram::SetUniform(int location, const bool* value, int count) {
+	if (_IsUniformCached(location, value, sizeof(bool) * count)) return;
 	LOG_ASSERT(count == 1, "SetUniform for bools only supports setting single values at a time!");
-	glProgramUniform1i(location, *value, 1);
+	glProgramUniform1i(_rendererId, location, *value);
 }
 void ShaderProgram::SetUniform(int location, const glm::bvec2* value, int count) {
+	if (_IsUniformCached(location, value, sizeof(glm::bvec2) * count)) return;
 	LOG_ASSERT(count == 1, "SetUniform for bools only supports setting single values at a time!");
-	glProgramUniform2i(location, value->x, value->y, 1);
+	glProgramUniform2i(_rendererId, location, value->x, value->y);
 }
 void ShaderProgram::SetUniform(int location, const glm::bvec3* value, int count) {
+	if (_IsUniformCached(location, value, sizeof(glm::bvec3) * count)) return;
 	LOG_ASSERT(count == 1, "SetUniform for bools only supports setting single values at a time!");
-	glProgramUniform3i(location, value->x, value->y, value->z, 1);
+	glProgramUniform3i(_rendererId, location, value->x, value->y, value->z);
 }
 void ShaderProgram::SetUniform(int location, const glm::bvec4* value, int count) {
+	if (_IsUniformCached(location, value, sizeof(glm::bvec4) * count)) return;
 	LOG_ASSERT(count == 1, "SetUniform for bools only supports setting single values at a time!");
-	glProgramUniform4i(location, value->x, value->y, value->z, value->w, 1);
+	glProgramUniform4i(_rendererId, location, value->x, value->y, value->z, value->w);
 }
 
 void ShaderProgram::SetUniform(int location, ShaderDataType type, void* data, int count /*= 1*/, bool transposed  /* =false*/) {
+	// The cache doesn't track transposition, so transposed matrices always go through
+	if (transposed) _InvalidateUniformCache(location, count);
+	else if (_IsUniformCached(location, data, ShaderDataTypeSize(type) * count)) return;
+
 	switch (type)
 	{
 		case ShaderDataType::Bool:    glProgramUniform1i(_rendererId, location, *static_cast<const bool*>(data)); break;
@@ -331,9 +363,51 @@ int ShaderProgram::__GetUniformLocation(const std::string& name) {
 	return _uniforms[name].Location;
 }
 
+int ShaderProgram::__GetUniformLocation(const UniformId& id) const {
+	auto it = _uniformIds.find(id.Hash);
+	return it != _uniformIds.end() ? it->second : -1;
+}
+
+void ShaderProgram::_InvalidateUniformCache(int location, int count) {
+	for (int ix = std::max(location, 0); ix < location + count && ix < (int)_uniformCache.size(); ix++) {
+		_uniformCache[ix].IsValid = false;
+	}
+}
+
+bool ShaderProgram::_IsUniformCached(int location, const void* data, uint32_t size) {
+	if (location < 0 || location >= (int)_uniformCache.size()) {
+		return false;
+	}
+	UniformCacheSlot& slot = _uniformCache[location];
+	// Not a location we know about, or more data than the uniform can hold, let GL deal with it
+	if (slot.ElementSize == 0 || size > slot.ElementSize * slot.ElementsLeft) {
+		return false;
+	}
+
+	// Array elements have consecutive locations, so all the elements we're setting need to have been set before
+	uint32_t elements = (size + slot.ElementSize - 1) / slot.ElementSize;
+	bool isValid = true;
+	for (uint32_t ix = 0; ix < elements; ix++) {
+		isValid &= _uniformCache[location + ix].IsValid;
+	}
+
+	uint8_t* cached = _uniformCacheData.data() + slot.Offset;
+	if (isValid && memcmp(cached, data, size) == 0) {
+		return true;
+	}
+
+	memcpy(cached, data, size);
+	for (uint32_t ix = 0; ix < elements; ix++) {
+		_uniformCache[location + ix].IsValid = true;
+	}
+	return false;
+}
+
 nlohmann::json ShaderProgram::ToJson() const {
 	nlohmann::json result;
 	result["name"] = _debugName;
+	result["displacement_margin"] = _displacementMargin;
+	result["depth_compatible"] = _isDepthCompatible;
 	for (auto& [key, value] : _fileSourceMap) {
 		result[~key][value.IsFilePath ? "path" : "source"] = value.Source;
 	}
@@ -344,6 +418,8 @@ nlohmann::json ShaderProgram::ToJson() const {
 ShaderProgram::Sptr ShaderProgram::FromJson(const nlohmann::json& data) {
 	ShaderProgram::Sptr result = std::make_shared<ShaderProgram>();
 	result->SetDebugName(JsonGet(data, "name", result->_debugName));
+	result->_displacementMargin = JsonGet(data, "displacement_margin", 0.0f);
+	result->_isDepthCompatible = JsonGet(data, "depth_compatible", false);
 	for (auto& [key, blob] : data.items()) {
 		// Get the shader part type from the key
 		ShaderPartType type = ParseShaderPartType(key, ShaderPartType::Unknown);
@@ -370,6 +446,11 @@ void ShaderProgram::_Introspect() {
 }
 
 void ShaderProgram::_IntrospectUniforms() {
+	// Any cached values are meaningless after a re-link
+	_uniformIds.clear();
+	_uniformCache.clear();
+	_uniformCacheData.clear();
+
 	// Query the program for how many active uniforms we have
 	int numInputs = 0;
 	glGetProgramInterfaceiv(_rendererId, GL_UNIFORM, GL_ACTIVE_RESOURCES, &numInputs);
@@ -420,6 +501,39 @@ void ShaderProgram::_IntrospectUniforms() {
 
 		// Store the uniform info
 		_uniforms[e.Name] = e;
+
+		// Allow the uniform to be looked up by it's hashed name as well. If two names collide, neither can
+		// be set by ID, so the ID is mapped to -1 rather than silently writing to the wrong uniform
+		uint32_t hash = UniformId::HashName(e.Name.c_str());
+		auto it = _uniformIds.find(hash);
+		if (it != _uniformIds.end() && it->second != e.Location) {
+			for (const auto& [name, other] : _uniforms) {
+				if (name != e.Name && UniformId::HashName(name.c_str()) == hash) {
+					LOG_WARN("Uniforms \"{}\" and \"{}\" have the same hash, neither can be set by ID", name, e.Name);
+				}
+			}
+			it->second = -1;
+		} else {
+			_uniformIds[hash] = e.Location;
+		}
+
+		// Reserve space to cache the uniform's value, each array element has it's own location
+		uint32_t elementSize = ShaderDataTypeSize(e.Type);
+		if (elementSize > 0) {
+			int arraySize = std::max(e.ArraySize, 1);
+			if ((int)_uniformCache.size() < e.Location + arraySize) {
+				_uniformCache.resize(e.Location + arraySize);
+			}
+			uint32_t offset = static_cast<uint32_t>(_uniformCacheData.size());
+			_uniformCacheData.resize(offset + elementSize * arraySize);
+			for (int ix = 0; ix < arraySize; ix++) {
+				UniformCacheSlot& slot = _uniformCache[e.Location + ix];
+				slot.Offset = offset + elementSize * ix;
+				slot.ElementSize = elementSize;
+				slot.ElementsLeft = arraySize - ix;
+				slot.IsValid = false;
+			}
+		}
 	}
 }
 
@@ -531,6 +645,11 @@ bool ShaderProgram::FindUniform(const std::string& name, UniformInfo* out) {
 	return false;
 }
 
+const ShaderProgram::UniformBlockInfo* ShaderProgram::FindUniformBlock(const std::string& name) const {
+	auto it = _uniformBlocks.find(name);
+	return it != _uniformBlocks.end() ? &it->second : nullptr;
+}
+
 GlResourceType ShaderProgram::GetResourceClass() const {
 	return GlResourceType::ShaderProgram;
 }
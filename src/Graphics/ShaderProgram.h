@@ -3,6 +3,7 @@
 #include <memory>
 #include <string>               // for std::string
 #include <unordered_map>        // for std::unordered_map
+#include <vector>
 #include <GLM/glm.hpp>          // for our GLM types
 #include <GLM/gtc/type_ptr.hpp> // for glm::value_ptr
 #include <Logging.h>            // for the logging functions
@@ -57,6 +58,39 @@ public:
 
 		std::vector<UniformInfo> SubUniforms;
 	};
+
+	/// <summary>
+	/// A uniform name hashed at compile time, lets us look up uniforms without constructing
+	/// or hashing strings at runtime. Should be declared constexpr so the hash is done by the compiler, ex:
+	/// static constexpr ShaderProgram::UniformId U_TIME("u_Time");
+	/// </summary>
+	struct UniformId {
+		uint32_t Hash;
+
+		constexpr explicit UniformId(const char* name) : Hash(HashName(name)) {}
+
+		/// <summary>
+		/// FNV-1a hash of a null terminated uniform name
+		/// </summary>
+		static constexpr uint32_t HashName(const char* name) {
+			uint32_t hash = 2166136261u;
+			for (; *name != '\0'; name++) {
+				hash = (hash ^ static_cast<uint8_t>(*name)) * 16777619u;
+			}
+			return hash;
+		}
+	};
+
+	/// <summary>
+	/// A uniform location that has been resolved ahead of time, typed so that the value
+	/// set through it always matches the type it was resolved for
+	/// </summary>
+	template <typename T>
+	struct UniformHandle {
+		int Location = -1;
+
+		bool IsValid() const { return Location != -1; }
+	};
 	
 public:
 	/// <summary>
@@ -108,6 +142,26 @@ public:
 	static void Unbind();
 
 	const std::unordered_map<std::string, UniformInfo>& GetUniforms() const { return _uniforms; }
+	const std::unordered_map<std::string, UniformBlockInfo>& GetUniformBlocks() const { return _uniformBlocks; }
+
+
+	/// <summary>
+	/// Sets how far the vertex stage may move vertices away from their position in the mesh, in
+	/// object space. Bounding volumes are grown by this much when culling meshes drawn with this
+	/// shader. A negative margin means the movement can't be bounded, and the mesh is never culled
+	/// </summary>
+	/// <param name="margin">The furthest distance a vertex can be moved, default is 0</param>
+	void SetDisplacementMargin(float margin) { _displacementMargin = margin; }
+	float GetDisplacementMargin() const { return _displacementMargin; }
+
+	/// <summary>
+	/// Marks whether the vertex stage only transforms positions by the instance matrices, in which
+	/// case meshes drawn with this shader can have their shadows drawn with the shared depth only
+	/// shaders and cached between frames. Shaders that move vertices around should leave this off
+	/// </summary>
+	/// <param name="value">True if the vertex stage is depth compatible, default is false</param>
+	void SetDepthCompatible(bool value) { _isDepthCompatible = value; }
+	bool GetIsDepthCompatible() const { return _isDepthCompatible; }
 
 	// Inherited from IGraphicsResource
 
@@ -120,6 +174,10 @@ public:
 
 public:
 	bool FindUniform(const std::string& name, UniformInfo* out);
+	/// <summary>
+	/// Looks up a uniform block by name, returns nullptr if the shader has no active block with that name
+	/// </summary>
+	const UniformBlockInfo* FindUniformBlock(const std::string& name) const;
 
 	void SetUniformMatrix(int location, const glm::mat3* value, int count = 1, bool transposed = false);
 	void SetUniformMatrix(int location, const glm::mat4* value, int count = 1, bool transposed = false);
@@ -139,6 +197,9 @@ public:
 	void SetUniform(int location, const glm::bvec2* value, int count = 1); 
 	void SetUniform(int location, const glm::bvec3* value, int count = 1);
 	void SetUniform(int location, const glm::bvec4* value, int count = 1);
+	// Matrix overloads so that matrices can be set through handles and IDs
+	void SetUniform(int location, const glm::mat3* value, int count = 1) { SetUniformMatrix(location, value, count); }
+	void SetUniform(int location, const glm::mat4* value, int count = 1) { SetUniformMatrix(location, value, count); }
 
 	/// <summary>
 	/// Sets a uniform based on a shader data type, can be used by our materials class
@@ -150,6 +211,50 @@ public:
 	/// <param name="transposed"True if matrices should be transposed</param>
 	void SetUniform(int location, ShaderDataType type, void* data, int count = 1, bool transposed = false);
 
+	/// <summary>
+	/// Resolves a uniform into a handle, which can be used to set the uniform without any lookups.
+	/// Handles remain valid until the shader is re-linked
+	/// </summary>
+	/// <typeparam name="T">The type of value that will be set through the handle</typeparam>
+	/// <param name="name">The name of the uniform to resolve</param>
+	template <typename T>
+	UniformHandle<T> GetUniformHandle(const std::string& name) {
+		UniformHandle<T> result;
+		result.Location = __GetUniformLocation(name);
+		if (result.Location == -1) {
+			LOG_WARN("Uniform \"{}\" not found, handle will be ignored", name);
+		}
+		return result;
+	}
+
+	template <typename T>
+	void SetUniform(const UniformHandle<T>& handle, const T& value) {
+		if (handle.Location != -1) {
+			SetUniform(handle.Location, &value, 1);
+		}
+	}
+	template <typename T>
+	void SetUniform(const UniformHandle<T>& handle, const T* values, int count) {
+		if (handle.Location != -1) {
+			SetUniform(handle.Location, values, count);
+		}
+	}
+
+	template <typename T>
+	void SetUniform(const UniformId& id, const T& value) {
+		int location = __GetUniformLocation(id);
+		if (location != -1) {
+			SetUniform(location, &value, 1);
+		}
+	}
+	template <typename T>
+	void SetUniform(const UniformId& id, const T* values, int count) {
+		int location = __GetUniformLocation(id);
+		if (location != -1) {
+			SetUniform(location, values, count);
+		}
+	}
+
 	template <typename T>
 	void SetUniform(const std::string& name, const T& value) {
 		int location = __GetUniformLocation(name);
@@ -188,6 +293,21 @@ protected:
 	// Map access to look up uniform locations and blocks
 	std::unordered_map<std::string, UniformInfo> _uniforms;
 	std::unordered_map<std::string, UniformBlockInfo> _uniformBlocks;
+	// Maps hashed uniform names to locations, see UniformId
+	std::unordered_map<uint32_t, int> _uniformIds;
+
+	// The last value set for each uniform location, so we can skip redundant glProgramUniform calls
+	struct UniformCacheSlot {
+		// Offset of the value within _uniformCacheData
+		uint32_t Offset = 0;
+		// Size of a single element of the uniform, in bytes
+		uint32_t ElementSize = 0;
+		// Number of array elements from this location to the end of the uniform
+		uint32_t ElementsLeft = 0;
+		bool     IsValid = false;
+	};
+	std::vector<UniformCacheSlot> _uniformCache;
+	std::vector<uint8_t>          _uniformCacheData;
 
 	// Stores information about the source of our shader parts
 	// EX: if a VS shader is loaded from a file, will contain
@@ -198,6 +318,11 @@ protected:
 	};
 	std::unordered_map<ShaderPartType, ShaderSource> _fileSourceMap;
 
+	// See SetDisplacementMargin
+	float _displacementMargin;
+	// See SetDepthCompatible
+	bool  _isDepthCompatible;
+
 	/// <summary>
 	/// Performs program introspection, where we examine the uniforms that
 	/// the program contains
@@ -213,5 +338,13 @@ protected:
 	/// </summary>
 	void _IntrospectUnifromBlocks();
 
+	/// <summary>
+	/// Compares a value against the cached value for a uniform, and updates the cache
+	/// </summary>
+	/// <returns>True if the value is unchanged and does not need to be sent to OpenGL</returns>
+	bool _IsUniformCached(int location, const void* data, uint32_t size);
+	void _InvalidateUniformCache(int location, int count);
+
 	int __GetUniformLocation(const std::string& name);
+	int __GetUniformLocation(const UniformId& id) const;
 };
\ No newline at end of file
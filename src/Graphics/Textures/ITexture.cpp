@@ -1,11 +1,31 @@
 #include "ITexture.h"
+#include <cstring>
+#include <stb_image.h>
+#include <Logging.h>
+#include "Graphics/GlStateCache.h"
+#include "Graphics/Textures/TextureLoader.h"
+#include "Utils/ResourceManager/DerivedDataCache.h"
+
+namespace {
+	// Bump this whenever the way we decode images changes, so that old cache entries are ignored
+	const uint32_t IMAGE_IMPORTER_VERSION = 1;
+
+	// Stored after the pixels in a cache entry, so that the pixels can be used without moving them
+	struct CachedImageTrailer {
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t Channels;
+		uint32_t Reserved;
+	};
+}
 
 ITexture::Limits ITexture::__limits = ITexture::Limits();
 bool ITexture::__isStaticInit = false;
 
 ITexture::ITexture(TextureType type) :
 	IGraphicsResource(),
-	_type(type)
+	_type(type),
+	_usePlaceholder(false)
 {
 	__StaticInit();
 	_Recreate();
@@ -19,8 +39,66 @@ void ITexture::_Recreate()
 	glCreateTextures((GLenum)_type, 1, &_rendererId);
 }
 
+bool ITexture::_LoadImage(const std::string& filename, int targetChannels, ImageData& result) {
+	result = ImageData();
+
+	// Decoding is the slowest part of loading most textures, so we keep decoded pixels in the derived data cache
+	DerivedDataCache::Key key;
+	DerivedDataCache::MakeKey(filename, "image", IMAGE_IMPORTER_VERSION, "channels=" + std::to_string(targetChannels), key);
+	if (key.IsValid() && DerivedDataCache::Load(key, result.Pixels)) {
+		CachedImageTrailer trailer = CachedImageTrailer();
+		if (result.Pixels.size() >= sizeof(CachedImageTrailer)) {
+			memcpy(&trailer, result.Pixels.data() + result.Pixels.size() - sizeof(CachedImageTrailer), sizeof(CachedImageTrailer));
+		}
+		size_t pixelBytes = static_cast<size_t>(trailer.Width) * trailer.Height * trailer.Channels;
+		if (pixelBytes > 0 && result.Pixels.size() == pixelBytes + sizeof(CachedImageTrailer)) {
+			result.Width    = trailer.Width;
+			result.Height   = trailer.Height;
+			result.Channels = trailer.Channels;
+			result.Pixels.resize(pixelBytes);
+			return true;
+		}
+		LOG_WARN("Cached image data for \"{}\" was invalid, decoding it again", filename);
+	}
+
+	// Use STBI to load the image, the vertical flip is set up in __StaticInit
+	int width, height, numChannels;
+	uint8_t* data = stbi_load(filename.c_str(), &width, &height, &numChannels, targetChannels);
+	if (data == nullptr) {
+		result = ImageData();
+		return false;
+	}
+
+	// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
+	if (targetChannels != 0) {
+		numChannels = targetChannels;
+	}
+
+	size_t pixelBytes = static_cast<size_t>(width) * height * numChannels;
+	result.Width    = width;
+	result.Height   = height;
+	result.Channels = numChannels;
+	result.Pixels.resize(pixelBytes + sizeof(CachedImageTrailer));
+	memcpy(result.Pixels.data(), data, pixelBytes);
+	stbi_image_free(data);
+
+	// Tack the trailer on and store the entry, then trim it back off
+	if (key.IsValid()) {
+		CachedImageTrailer trailer = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), static_cast<uint32_t>(numChannels), 0 };
+		memcpy(result.Pixels.data() + pixelBytes, &trailer, sizeof(CachedImageTrailer));
+		DerivedDataCache::Store(key, result.Pixels.data(), result.Pixels.size());
+	}
+	result.Pixels.resize(pixelBytes);
+
+	return true;
+}
+
 ITexture::~ITexture() {
+	if (_usePlaceholder) {
+		TextureLoader::Cancel(this);
+	}
 	if (glIsTexture(_rendererId)) {
+		GlStateCache::OnTextureDeleted(_rendererId);
 		glDeleteTextures(1, &_rendererId);
 		_rendererId = 0;
 	}
@@ -29,12 +107,12 @@ ITexture::~ITexture() {
 void ITexture::Bind(int slot) {
 	if (_rendererId != 0) {
 		// Instead of glActiveTexture + glBindTexture, we can one line it now :D
-		glBindTextureUnit(slot, _rendererId); 
+		GlStateCache::BindTexture(slot, GetHandle());
 	}
 }
 
 void ITexture::Unbind(int slot) {
-	glBindTextureUnit(slot, 0);
+	GlStateCache::BindTexture(slot, 0);
 }
 
 void ITexture::Clear(const glm::vec4& color) {
@@ -47,6 +125,17 @@ GlResourceType ITexture::GetResourceClass() const {
 	return GlResourceType::Texture;
 }
 
+uint32_t ITexture::GetHandle() const {
+	// Anything that grabs our handle while we're streaming in gets the placeholder instead
+	if (_usePlaceholder) {
+		GLuint placeholder = TextureLoader::GetPlaceholder(_type);
+		if (placeholder != 0) {
+			return placeholder;
+		}
+	}
+	return _rendererId;
+}
+
 void ITexture::__StaticInit()
 {
 	// If we've already run the static initializer, abort now
@@ -62,6 +151,9 @@ void ITexture::__StaticInit()
 	// Enable seamless cube maps (we'll need this later!)
 	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
+	// STBI's flip flag is a global, images are decoded on worker threads so we set it once up front
+	stbi_set_flip_vertically_on_load(true);
+
 	// Let's write all our info into the console so we know what's up
 	LOG_INFO("==== Texture Limits =====");
 	LOG_INFO("\tSize:       {}", __limits.MAX_TEXTURE_SIZE);
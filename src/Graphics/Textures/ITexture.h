@@ -2,6 +2,8 @@
 #include <memory>
 #include <glad/glad.h>
 #include <cstdint>
+#include <string>
+#include <vector>
 #include <GLM/glm.hpp>
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/IGraphicsResource.h"
@@ -48,9 +50,16 @@ public:
 	/// <param name="color">The color to clear to</param>
 	void Clear(const glm::vec4& color);
 
+	/// <summary>
+	/// Returns false while this texture's images are still being streamed in by the TextureLoader,
+	/// or if they failed to load. The texture's handle refers to a placeholder until this is true
+	/// </summary>
+	bool IsLoaded() const { return !_usePlaceholder; }
+
 	// Inherited from IGraphicsResource
 
 	virtual GlResourceType GetResourceClass() const override;
+	virtual uint32_t GetHandle() const override;
 
 protected:
 	ITexture(TextureType type);
@@ -60,7 +69,38 @@ protected:
 	/// </summary>
 	virtual void _Recreate();
 
+	/// <summary>
+	/// 8 bit pixels decoded from an image file, flipped vertically to match OpenGL
+	/// </summary>
+	struct ImageData {
+		int Width    = 0;
+		int Height   = 0;
+		int Channels = 0;
+		std::vector<uint8_t> Pixels;
+	};
+
+	/// <summary>
+	/// Decodes an image file with STBI, or loads the decoded pixels from the derived data cache if
+	/// the file has been decoded before
+	/// </summary>
+	/// <param name="filename">The path of the image to load</param>
+	/// <param name="targetChannels">The number of channels to convert the image to, or 0 to keep the channels from the file</param>
+	/// <param name="result">The structure to store the decoded image in</param>
+	/// <returns>True if the image was loaded, false if it could not be decoded</returns>
+	static bool _LoadImage(const std::string& filename, int targetChannels, ImageData& result);
+
+	/// <summary>
+	/// Called on the main thread by the TextureLoader once the images this texture queued have
+	/// been decoded, should allocate the texture's storage and upload the images
+	/// </summary>
+	/// <param name="images">The decoded images, in the order their files were queued</param>
+	/// <returns>True if the texture was loaded, false to keep using the placeholder</returns>
+	virtual bool _OnImagesDecoded(std::vector<ImageData>& images) { return false; }
+
 	TextureType _type; // The type for this texture, mainly used for debugging
+	bool _usePlaceholder; // True while our images are streaming in, or if they failed to load
+
+	friend class TextureLoader;
 
 // STATIC SECTION
 private:
@@ -1,7 +1,6 @@
 #include "Texture1D.h"
 #include "Utils/Base64.h"
 #include "Utils/JsonGlmHelpers.h"
-#include <stb_image.h>
 
 inline int CalcRequiredMipLevels(int size) {
 	return (1 + floor(log2(size)));
@@ -124,26 +123,18 @@ void Texture1D::_LoadDataFromFile()
 	LOG_ASSERT(_description.Size == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
 
 	if (!_description.Filename.empty()) {
-		// Variables that will store properties about our image
-		int width, height, numChannels;
 		const int targetChannels = GetTexelComponentCount(_description.FormatHint);
 
-		// Use STBI to load the image
-		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(_description.Filename.c_str(), &width, &height, &numChannels, targetChannels);
-
-		// If we could not load any data, warn and return null
-		if (data == nullptr) {
+		// Decode the image, or grab it from the derived data cache
+		ImageData image;
+		if (!_LoadImage(_description.Filename, targetChannels, image)) {
 			LOG_WARN("STBI Failed to load image from \"{}\"", _description.Filename);
 			return;
 		}
+		int width = image.Width, height = image.Height, numChannels = image.Channels;
 
 		// We should estimate a good format for our data
 
-		// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
-		if (targetChannels != 0)
-			numChannels = targetChannels;
-
 		// We'll determine a recommended format for the image based on number of channels
 		// We hinted that we wanted a certain number of channels, but we're not guaranteed
 		// that all those channels exist (ex: loading an RGB image but requesting RGBA)
@@ -163,10 +154,7 @@ void Texture1D::_LoadDataFromFile()
 		_SetTextureParams();
 
 		// Upload data to our texture
-		LoadData(width * height, image_format, PixelType::UByte, data);
-
-		// We now have data in the image, we can clear the STBI data
-		stbi_image_free(data);
+		LoadData(width * height, image_format, PixelType::UByte, image.Pixels.data());
 	}
 
 	SetDebugName(_description.Filename);
@@ -1,9 +1,11 @@
 #include "Texture2D.h"
-#include <stb_image.h>
+#include <cstring>
 #include <Logging.h>
 #include "GLM/glm.hpp"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/Base64.h"
+#include "Graphics/GlStateCache.h"
+#include "Graphics/Textures/TextureLoader.h"
 
 /// <summary>
 /// Get the number of mipmap levels required for a texture of the given size
@@ -150,58 +152,51 @@ void Texture2D::_LoadDataFromFile() {
 	LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
 
 	if (!_description.Filename.empty()) {
-		// Variables that will store properties about our image
-		int width, height, numChannels;
+		// Decoding happens on the job system, we'll get the image back in _OnImagesDecoded
 		const int targetChannels = GetTexelComponentCount(_description.FormatHint);
+		TextureLoader::Queue(this, { _description.Filename }, targetChannels);
+	}
+	
+	SetDebugName(_description.Filename);
+}
 
-		// Use STBI to load the image
-		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(_description.Filename.c_str(), &width, &height, &numChannels, targetChannels);
-
-		// If we could not load any data, warn and return null
-		if (data == nullptr) {
-			LOG_WARN("STBI Failed to load image from \"{}\"", _description.Filename);
-			return ;
-		}
-
-		// We should estimate a good format for our data
+bool Texture2D::_OnImagesDecoded(std::vector<ImageData>& images) {
+	const ImageData& image = images[0];
+	int width = image.Width, height = image.Height, numChannels = image.Channels;
 
-		// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
-		if (targetChannels != 0)
-			numChannels = targetChannels;
+	// We should estimate a good format for our data
 
-		// We'll determine a recommended format for the image based on number of channels
-		// We hinted that we wanted a certain number of channels, but we're not guaranteed
-		// that all those channels exist (ex: loading an RGB image but requesting RGBA)
-		InternalFormat internal_format = GetInternalFormatForChannels8(numChannels);
-		PixelFormat    image_format = GetPixelFormatForChannels(numChannels);
+	// We'll determine a recommended format for the image based on number of channels
+	// We hinted that we wanted a certain number of channels, but we're not guaranteed
+	// that all those channels exist (ex: loading an RGB image but requesting RGBA)
+	InternalFormat internal_format = GetInternalFormatForChannels8(numChannels);
+	PixelFormat    image_format = GetPixelFormatForChannels(numChannels);
 
-		// This is one of those poorly documented things in OpenGL
-		if ((numChannels * width) % 4 != 0) {
-			LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
-		}
+	// This is one of those poorly documented things in OpenGL
+	if ((numChannels * width) % 4 != 0) {
+		LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
+	}
 
-		// Update our description to match what we loaded
-		_description.Format = internal_format;
-		_description.Width = width;
-		_description.Height = height;
+	// Update our description to match what we loaded
+	_description.Format = internal_format;
+	_description.Width = width;
+	_description.Height = height;
 
-		// Allocates our memory
-		_SetTextureParams();
+	// Allocates our memory
+	_SetTextureParams();
 
-		// Upload data to our texture
-		LoadData(width, height, image_format, PixelType::UByte, data);
+	// Upload data to our texture through the loader's staging buffer
+	memcpy(TextureLoader::BeginUpload(image.Pixels.size()), image.Pixels.data(), image.Pixels.size());
+	LoadData(width, height, image_format, PixelType::UByte, TextureLoader::SubmitUpload());
+	TextureLoader::EndUpload();
 
-		// We now have data in the image, we can clear the STBI data
-		stbi_image_free(data);
-	}
-	
-	SetDebugName(_description.Filename);
+	return true;
 }
 
 void Texture2D::_SetTextureParams() {
 	// If we have a multisampled texture, and the current type is 2D, change it to 2D multisampled
 	if (_description.MultisampleCount > 1 && _type == TextureType::_2D) {
+		GlStateCache::OnTextureDeleted(_rendererId);
 		glDeleteTextures(1, &_rendererId);
 		_type = TextureType::_2DMultisample;
 		glCreateTextures(*_type, 1, &_rendererId);
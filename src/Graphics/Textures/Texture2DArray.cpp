@@ -1,9 +1,10 @@
 #include "Texture2DArray.h"
-#include <stb_image.h>
+#include <cstring>
 #include <Logging.h>
 #include "GLM/glm.hpp"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/Base64.h"
+#include "Graphics/Textures/TextureLoader.h"
 
 /// <summary>
 /// Get the number of mipmap levels required for a texture of the given size
@@ -153,101 +154,100 @@ void Texture2DArray::_LoadDataFromFile() {
 	LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
 
 	if (!_description.Filename.empty()) {
-		// Variables that will store properties about our image
-		int width, height, numChannels;
 		const int targetChannels = GetTexelComponentCount(_description.FormatHint);
 
-		// Use STBI to load the image
-		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(_description.Filename.c_str(), &width, &height, &numChannels, targetChannels);
-
-		// If we could not load any data, warn and return null
-		if (data == nullptr) {
-			LOG_WARN("STBI Failed to load image from \"{}\"", _description.Filename);
-			return ;
-		}
-
-		if (width % _description.XDivisions != 0) {
-			stbi_image_free(data);
-			LOG_ERROR("Could not load image, X dimension not equal divisor");
-			return;
-		}
-		if (height % _description.YDivisions != 0) {
-			stbi_image_free(data);
-			LOG_ERROR("Could not load image, Y dimension not equal divisor");
-			return;
-		}
-
-		if (width * height == 0) {
-			stbi_image_free(data);
-			LOG_ERROR("Image empty, skipping");
-			return;
-		}
-
-		// We should estimate a good format for our data
-
-		// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
-		if (targetChannels != 0)
-			numChannels = targetChannels;
-
-		// We'll determine a recommended format for the image based on number of channels
-		// We hinted that we wanted a certain number of channels, but we're not guaranteed
-		// that all those channels exist (ex: loading an RGB image but requesting RGBA)
-		InternalFormat internal_format = GetInternalFormatForChannels8(numChannels);
-		PixelFormat    image_format = GetPixelFormatForChannels(numChannels);
-
-		// This is one of those poorly documented things in OpenGL
-		if ((numChannels * width) % 4 != 0) {
-			LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
-		}
+		// Splitting the image into layers is done on the worker too, so it only needs the divisions
+		const uint64_t xDivisions = _description.XDivisions;
+		const uint64_t yDivisions = _description.YDivisions;
+		TextureLoader::Queue(this, { _description.Filename }, targetChannels, [xDivisions, yDivisions](std::vector<ImageData>& images) {
+			ImageData& image = images[0];
+			uint64_t width = image.Width, height = image.Height;
+			const uint8_t* data = image.Pixels.data();
+
+			if (width % xDivisions != 0) {
+				LOG_ERROR("Could not load image, X dimension not equal divisor");
+				return false;
+			}
+			if (height % yDivisions != 0) {
+				LOG_ERROR("Could not load image, Y dimension not equal divisor");
+				return false;
+			}
 
-		// Update our description to match what we loaded
-		_description.Format = internal_format;
-		_description.Width = width;
-		_description.Height = height;
+			if (width * height == 0) {
+				LOG_ERROR("Image empty, skipping");
+				return false;
+			}
 
-		// Allocates our memory
-		_SetTextureParams();
+			uint64_t layers = xDivisions * yDivisions;
+			uint64_t xSize = width / xDivisions;
+			uint64_t ySize = height / yDivisions;
+
+			size_t texelSize = image.Channels;
+
+			uint64_t size = xSize * ySize;
+
+			std::vector<uint8_t> repack(width * height * texelSize);
+
+			// We need to remap our 2D image to 3D space
+			uint64_t xLoc{ 0 }, yLoc{ 0 };
+			for (uint64_t iz = 0; iz < layers; iz++) {
+				for (uint64_t iy = 0; iy < ySize; iy++) {
+					for (uint64_t ix = 0; ix < xSize; ix++) {
+						xLoc = (iz % xDivisions) * xSize + ix;
+						yLoc = (iz / yDivisions) * ySize + iy;
+						memcpy(
+							repack.data() + (iz * size + iy * xSize + ix) * texelSize,
+							data + (yLoc * width + xLoc) * texelSize,
+							texelSize
+						);
+					}
+				}
+			}
 
+			image.Pixels.swap(repack);
+			return true;
+		});
+	}
+	
+	SetDebugName(_description.Filename);
+}
 
-		uint64_t layers = _description.XDivisions * _description.YDivisions;
-		uint64_t xSize = width / _description.XDivisions;
-		uint64_t ySize = height / _description.YDivisions;
+bool Texture2DArray::_OnImagesDecoded(std::vector<ImageData>& images) {
+	// The pixels have already been split into layers by the job in _LoadDataFromFile
+	const ImageData& image = images[0];
+	int width = image.Width, height = image.Height, numChannels = image.Channels;
 
-		size_t texelSize = GetTexelSize(_description.FormatHint, PixelType::UByte);
+	// We should estimate a good format for our data
 
-		uint64_t size = xSize * ySize;
+	// We'll determine a recommended format for the image based on number of channels
+	// We hinted that we wanted a certain number of channels, but we're not guaranteed
+	// that all those channels exist (ex: loading an RGB image but requesting RGBA)
+	InternalFormat internal_format = GetInternalFormatForChannels8(numChannels);
+	PixelFormat    image_format = GetPixelFormatForChannels(numChannels);
 
-		uint8_t* repack = (uint8_t*)malloc(width * height * texelSize);
+	// This is one of those poorly documented things in OpenGL
+	if ((numChannels * width) % 4 != 0) {
+		LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
+	}
 
-		// We need to remap our 2D image to 3D space
-		uint64_t sourceLoc{ 0 }, xLoc{ 0 }, yLoc{ 0 };
-		for (uint64_t iz = 0; iz < layers; iz++) {
-			for (uint64_t iy = 0; iy < ySize; iy++) {
-				for (uint64_t ix = 0; ix < xSize; ix++) {
-					xLoc = (iz % _description.XDivisions) * xSize + ix;
-					yLoc = (iz / _description.YDivisions) * ySize + iy;
-					memcpy(
-						repack + (iz * size + iy * xSize + ix) * texelSize,
-						data + (yLoc * width + xLoc) * texelSize,
-						texelSize
-					);
-				}
-			}
-		}
+	// Update our description to match what we loaded
+	_description.Format = internal_format;
+	_description.Width = width;
+	_description.Height = height;
 
-		_CrtCheckMemory();
+	// Allocates our memory
+	_SetTextureParams();
 
-		// Upload data to our texture
-		LoadData(xSize, ySize, layers, image_format, PixelType::UByte, repack);
+	uint64_t layers = _description.XDivisions * _description.YDivisions;
+	uint64_t xSize = width / _description.XDivisions;
+	uint64_t ySize = height / _description.YDivisions;
 
-		free(repack);
+	// Upload data to our texture through the loader's staging buffer
+	memcpy(TextureLoader::BeginUpload(image.Pixels.size()), image.Pixels.data(), image.Pixels.size());
+	LoadData(xSize, ySize, layers, image_format, PixelType::UByte, TextureLoader::SubmitUpload());
+	TextureLoader::EndUpload();
 
-		// We now have data in the image, we can clear the STBI data
-		stbi_image_free(data);
-	}
-	
-	SetDebugName(_description.Filename);
+	return true;
 }
 
 void Texture2DArray::_SetTextureParams() {
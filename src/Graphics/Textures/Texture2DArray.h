@@ -155,8 +155,8 @@ protected:
 	PixelType _pixelType;
 
 	/// <summary>
-	/// Loads this texture from the file specified in the description
-	/// Will overwrite description size
+	/// Queues the file specified in the description to be loaded by the TextureLoader
+	/// Will overwrite description size once the image arrives
 	/// </summary>
 	void _LoadDataFromFile();
 	/// <summary>
@@ -164,6 +164,8 @@ protected:
 	/// </summary>
 	void _SetTextureParams();
 
+	virtual bool _OnImagesDecoded(std::vector<ImageData>& images) override;
+
 public:
 	static Texture2DArray::Sptr LoadFromFile(const std::string& path, const Texture2DArrayDescription& description = Texture2DArrayDescription(), bool forceRgba = true);
 };
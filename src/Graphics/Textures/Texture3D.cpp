@@ -2,12 +2,55 @@
 #include "Utils/Base64.h"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/StringUtils.h"
+#include "Utils/ResourceManager/DerivedDataCache.h"
 #include <Logging.h>
-#include <stb_image.h>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
 
+namespace {
+	// Bump this whenever the way we parse .cube files changes, so that old cache entries are ignored
+	const uint32_t CUBE_IMPORTER_VERSION = 1;
+
+	// Stored after the texels and title in a cached LUT
+	struct CachedLutTrailer {
+		uint32_t LutSize;
+		uint32_t TitleLength;
+	};
+
+	std::vector<uint8_t> EncodeCachedLut(const std::vector<glm::u8vec3>& texels, uint32_t lutSize, const std::string& title) {
+		size_t texelBytes = texels.size() * sizeof(glm::u8vec3);
+		CachedLutTrailer trailer = { lutSize, static_cast<uint32_t>(title.size()) };
+
+		std::vector<uint8_t> result(texelBytes + title.size() + sizeof(CachedLutTrailer));
+		memcpy(result.data(), texels.data(), texelBytes);
+		memcpy(result.data() + texelBytes, title.data(), title.size());
+		memcpy(result.data() + texelBytes + title.size(), &trailer, sizeof(CachedLutTrailer));
+		return result;
+	}
+
+	bool DecodeCachedLut(const std::vector<uint8_t>& payload, std::vector<glm::u8vec3>& texels, uint32_t& lutSize, std::string& title) {
+		if (payload.size() < sizeof(CachedLutTrailer)) {
+			return false;
+		}
+		CachedLutTrailer trailer;
+		memcpy(&trailer, payload.data() + payload.size() - sizeof(CachedLutTrailer), sizeof(CachedLutTrailer));
+
+		size_t texelCount = (size_t)trailer.LutSize * trailer.LutSize * trailer.LutSize;
+		size_t texelBytes = texelCount * sizeof(glm::u8vec3);
+		if (texelCount == 0 || payload.size() != texelBytes + trailer.TitleLength + sizeof(CachedLutTrailer)) {
+			return false;
+		}
+
+		lutSize = trailer.LutSize;
+		texels.resize(texelCount);
+		memcpy(texels.data(), payload.data(), texelBytes);
+		title.assign(reinterpret_cast<const char*>(payload.data()) + texelBytes, trailer.TitleLength);
+		return true;
+	}
+}
+
 inline int CalcRequiredMipLevels(int width, int height, int depth) {
 	return (1 + floor(log2(std::max(width, std::max(height, depth)))));
 }
@@ -148,16 +191,65 @@ void Texture3D::_LoadDataFromFile()
 }
 
 void Texture3D::_LoadCubeFile()
+{
+	std::vector<glm::u8vec3> textureData;
+	uint32_t lutSize{ 0 };
+	std::string title;
+
+	// Parsing the text is much slower than uploading the LUT, so parsed LUTs are kept in the derived data cache
+	DerivedDataCache::Key key;
+	DerivedDataCache::MakeKey(_description.Filename, "cube_lut", CUBE_IMPORTER_VERSION, "", key);
+
+	std::vector<uint8_t> payload;
+	bool loaded = false;
+	if (key.IsValid() && DerivedDataCache::Load(key, payload)) {
+		loaded = DecodeCachedLut(payload, textureData, lutSize, title);
+		if (!loaded) {
+			LOG_WARN("Cached LUT data for \"{}\" was invalid, parsing it again", _description.Filename);
+		}
+	}
+	if (!loaded && _ParseCubeFile(textureData, lutSize, title)) {
+		loaded = true;
+		if (key.IsValid()) {
+			payload = EncodeCachedLut(textureData, lutSize, title);
+			DerivedDataCache::Store(key, payload.data(), payload.size());
+		}
+	}
+
+	if (loaded) {
+		// We'll grab the title for our debug name, nice lil use of it
+		if (!title.empty()) {
+			SetDebugName(title);
+		}
+
+		// Update the description's size
+		_description.Width = _description.Height = _description.Depth = lutSize;
+		// Set the pixel format
+		_description.Format = InternalFormat::RGB8;
+		// We need to clamp to edge for LUTS
+		_description.WrapS = _description.WrapT = _description.WrapR = WrapMode::ClampToEdge;
+
+		// Allocate data and configure params
+		_SetTextureParams();
+		// Load data
+		LoadData(lutSize, lutSize, lutSize, PixelFormat::RGB, PixelType::UByte, textureData.data());
+	}
+	else {
+		LOG_WARN("Failed to load cube file: \"{}\"", _description.Filename);
+	}
+}
+
+bool Texture3D::_ParseCubeFile(std::vector<glm::u8vec3>& textureData, uint32_t& lutSize, std::string& title)
 {
 	std::ifstream inFile(_description.Filename);
 
 	if (!inFile.is_open()) {
 		LOG_WARN("Failed to open file .cube file: {}", _description.Filename);
-		return;
+		return false;
 	}
 
-	glm::u8vec3* textureData = nullptr;
-	uint32_t lutSize{ 0 };
+	textureData.clear();
+	lutSize = 0;
 	uint32_t ix{ 0 };
 	glm::vec3 rgb { 0, 0, 0 };
 
@@ -185,33 +277,22 @@ void Texture3D::_LoadCubeFile()
 			std::stringstream lReader(line.substr(12));
 			lReader >> lutSize;
 
-			// Update the description's size
-			_description.Width = _description.Height = _description.Depth = lutSize;
-
 			// If the size we read is non-zero, allocate our data!
 			if (lutSize > 0) {
-				// If we had data already, delete it
-				if (textureData != nullptr) {
-					delete[] textureData;
-				} 
-
-				// Allocate data to store texels in
-				textureData = new glm::u8vec3[(size_t)lutSize * lutSize * lutSize];
+				// Allocate data to store texels in, replacing anything we had already
+				textureData.assign((size_t)lutSize * lutSize * lutSize, glm::u8vec3(0));
 				ix = 0;
 			}
 		}
 
-		// We'll grab the title for our debug name, nice lil use of it
+		// Grab the title, it makes a nice debug name
 		else if (line.find("TITLE") != std::string::npos) {
 
 			// Skip over the TITLE token and the space after it
-			std::string name = line.substr(6);
+			title = line.substr(6);
 
 			// Trim any excess whitespace
-			StringTools::Trim(name);
-
-			// We'll store this in the debug name
-			SetDebugName(name);
+			StringTools::Trim(title);
 		}
 
 		else if (line.find("DOMAIN_MIN") != std::string::npos)
@@ -224,11 +305,12 @@ void Texture3D::_LoadCubeFile()
 		{ /* ignore for now */ }
 
 		// Reading data lines
-		else if (!line.empty() && textureData != nullptr) {
+		else if (!line.empty() && !textureData.empty()) {
 
 			// Make sure we don't case a write access violation
-			if (ix >= (lutSize * lutSize * lutSize) && lutSize > 0) {
+			if (ix >= textureData.size()) {
 				LOG_ASSERT(false, "Attempting to write outside the bounds of the LUT");
+				continue;
 			}
 
 			// Read RGB from the line
@@ -247,23 +329,7 @@ void Texture3D::_LoadCubeFile()
 		}
 	} 
 
-	if (textureData != nullptr) {
-		// Set the pixel format
-		_description.Format = InternalFormat::RGB8;
-		// We need to clamp to edge for LUTS
-		_description.WrapS = _description.WrapT = _description.WrapR = WrapMode::ClampToEdge;
-
-		// Allocate data and configure params
-		_SetTextureParams();
-		// Load data
-		LoadData(lutSize, lutSize, lutSize, PixelFormat::RGB, PixelType::UByte, textureData);
-
-		// Clean up after ourselves
-		delete[] textureData;
-	}
-	else {
-		LOG_WARN("Failed to load cube file: \"{}\"", _description.Filename);
-	}
+	return !textureData.empty();
 }
 
 void Texture3D::_SetTextureParams()
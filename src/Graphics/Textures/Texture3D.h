@@ -156,10 +156,18 @@ protected:
 	/// </summary>
 	void _LoadDataFromFile();
 	/// <summary>
-	/// Loads a 3D LUT from a .cube file
+	/// Loads a 3D LUT from a .cube file, or from the derived data cache if the file has been parsed before
 	/// </summary>
 	void _LoadCubeFile();
 	/// <summary>
+	/// Parses the texels out of a .cube file
+	/// </summary>
+	/// <param name="texels">Will store the texels of the LUT</param>
+	/// <param name="lutSize">Will store the size of the LUT along each axis</param>
+	/// <param name="title">Will store the title from the file, if it has one</param>
+	/// <returns>True if the file was opened and contained a LUT</returns>
+	bool _ParseCubeFile(std::vector<glm::u8vec3>& texels, uint32_t& lutSize, std::string& title);
+	/// <summary>
 	/// Allocates our texture's memory and sets sampling / filtering parameters
 	/// </summary>
 	void _SetTextureParams();
@@ -1,7 +1,8 @@
 #include "TextureCube.h"
+#include <cstring>
 #include <filesystem>
-#include "stb_image.h"
 #include "Utils/JsonGlmHelpers.h"
+#include "Graphics/Textures/TextureLoader.h"
 
 TextureCube::TextureCube(const std::string& baseFilename) :
 	ITexture(TextureType::Cubemap),
@@ -100,43 +101,38 @@ void TextureCube::_LoadFromDescription()
 
 void TextureCube::_LoadImages(const std::unordered_map<CubeMapFace, std::string>& faceFilenames)
 {
-	// Will store all of our texture data, back to back in memory
-	uint8_t* datastore = nullptr;
+	// Queue all 6 faces, they'll be decoded in parallel and handed back to _OnImagesDecoded in face order
+	std::vector<std::string> filenames;
+	filenames.reserve(6);
+	for (int ix = 0; ix < 6; ix++) {
+		filenames.push_back(faceFilenames.at((CubeMapFace)ix));
+	}
+	TextureLoader::Queue(this, filenames, 0);
+}
+
+bool TextureCube::_OnImagesDecoded(std::vector<ImageData>& images)
+{
 	// The size of a single face's texture, in bytes
 	size_t textureDataSize = 0;
 
 	// The number of channels that we're expecting
 	int numChannels = 0;
 
-	// Load all 6 faces
+	// Make sure all 6 faces agree with each other before we allocate anything
 	for (int ix = 0; ix < 6; ix++) {
-		CubeMapFace face = (CubeMapFace)ix;
-		
-		const std::string& filename = _description.FaceFileNames[face];
-		int fileWidth, fileHeight, fileNumChannels;
-
-		// Use STBI to load the image
-		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(filename.c_str(), &fileWidth, &fileHeight, &fileNumChannels, 0);
-
-		// If we could not load any data, warn and return null
-		if (data == nullptr) {
-			if (data != nullptr) { delete[] datastore; }
-			LOG_ERROR("STBI Failed to load image from \"{}\"", filename);
-			return;
-		}
+		const ImageData& image = images[ix];
+		const std::string& filename = _description.FaceFileNames[(CubeMapFace)ix];
+
 		// If the texture is not square, warn and abort
-		if (fileWidth != fileHeight) {
-			if (data != nullptr) { delete[] datastore; }
+		if (image.Width != image.Height) {
 			LOG_ERROR("Image loaded from \"{}\" was not square", filename);
-			stbi_image_free(data);
-			return;
+			return false;
 		}
-		// If the dataStore is empty, this is the first texture we loaded
-		if (datastore == nullptr) {
+		// If this is the first face, it determines the size and format for the rest
+		if (ix == 0) {
 			// Store the size and number of channels
-			_description.Size = fileWidth;
-			numChannels = fileNumChannels;
+			_description.Size = image.Width;
+			numChannels = image.Channels;
 
 			// Get the format and pixel format for the number of channels
 			_description.Format = GetInternalFormatForChannels8(numChannels);
@@ -149,32 +145,32 @@ void TextureCube::_LoadImages(const std::unordered_map<CubeMapFace, std::string>
 			if ((GetTexelSize(_description.FormatHint, PixelType::Byte) * _description.Size) % 4 != 0) {
 				LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
 			}
-
-			// Allocate the data store for our image data
-			datastore = new uint8_t[textureDataSize * 6];
 		}
 		// If this is NOT the first image, and it does not match previous images, abort
-		else if (fileWidth != _description.Size || fileNumChannels != numChannels) {
-			delete[] datastore;
+		else if (image.Width != _description.Size || image.Channels != numChannels) {
 			LOG_WARN("Image \"{}\" did not match size or format of texture cube", filename);
-			stbi_image_free(data);
-			return;
+			return false;
 		}
-
-		// Copy the data we loaded into the corresponding location in the data store
-		memcpy(datastore + textureDataSize * ix, data, textureDataSize);
-		stbi_image_free(data);
 	}
 
 	// Allocate memory and set up initial parameters
 	_SetTextureParams();
 
+	// Copy the faces back to back into the staging buffer
+	uint8_t* staging = static_cast<uint8_t*>(TextureLoader::BeginUpload(textureDataSize * 6));
+	for (int ix = 0; ix < 6; ix++) {
+		memcpy(staging + textureDataSize * ix, images[ix].Pixels.data(), textureDataSize);
+	}
+	void* datastore = TextureLoader::SubmitUpload();
+
 	// Set our pixel alignment to a single byte so we don't get banding
 	glPixelStorei(GL_PACK_ALIGNMENT, 1);
 
 	// Upload our data to our image (note that the custom enum tools let us convert to base type [GLenum] with the * operator)
 	glTextureSubImage3D(_rendererId, 0, 0, 0, 0, _description.Size, _description.Size, 6, *_description.FormatHint, *PixelType::UByte, datastore);
-	delete[] datastore;
+	TextureLoader::EndUpload();
+
+	return true;
 }
 
 void TextureCube::_SetTextureParams(){
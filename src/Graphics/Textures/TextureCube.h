@@ -116,6 +116,7 @@ protected:
 
 	virtual void _LoadFromDescription();
 	virtual void _LoadImages(const std::unordered_map<CubeMapFace, std::string>& faceFilenames);
+	virtual bool _OnImagesDecoded(std::vector<ImageData>& images) override;
 
 	/// <summary>
 	/// Allocates our texture's memory and sets sampling / filtering parameters
@@ -0,0 +1,236 @@
+#include "Graphics/Textures/TextureLoader.h"
+#include <cstring>
+#include <limits>
+#include <Logging.h>
+#include "Graphics/GlStateCache.h"
+#include "Utils/Profiler.h"
+
+std::vector<std::shared_ptr<TextureLoader::Request>> TextureLoader::__requests;
+PixelUnpackBuffer::Sptr TextureLoader::__staging = nullptr;
+std::vector<uint8_t>    TextureLoader::__fallbackStaging;
+bool                    TextureLoader::__usingFallback = false;
+uint32_t                TextureLoader::__loadGeneration = 0;
+GLuint                  TextureLoader::__placeholder2D = 0;
+GLuint                  TextureLoader::__placeholderCube = 0;
+GLuint                  TextureLoader::__placeholder2DArray = 0;
+int64_t                 TextureLoader::__batchStart = 0;
+uint32_t                TextureLoader::__batchCount = 0;
+
+namespace {
+	// Mid grey, so streaming textures don't stand out too much against whatever they end up being
+	const uint8_t PLACEHOLDER_COLOR[4] = { 128, 128, 128, 255 };
+
+	// Creates a 1x1 RGBA8 texture of the given type, with layers faces or slices
+	GLuint CreatePlaceholder(TextureType type, int layers) {
+		uint8_t texels[6 * 4];
+		for (int ix = 0; ix < layers; ix++) {
+			memcpy(texels + ix * 4, PLACEHOLDER_COLOR, 4);
+		}
+
+		GLuint result = 0;
+		glCreateTextures(*type, 1, &result);
+		if (type == TextureType::_2DArray) {
+			glTextureStorage3D(result, 1, GL_RGBA8, 1, 1, layers);
+		} else {
+			glTextureStorage2D(result, 1, GL_RGBA8, 1, 1);
+		}
+		// Cubemap faces are uploaded as layers when using DSA
+		glTextureSubImage3D(result, 0, 0, 0, 0, 1, 1, layers, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+		glTextureParameteri(result, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTextureParameteri(result, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		const std::string name = "Placeholder " + ~type;
+		glObjectLabel(GL_TEXTURE, result, (GLsizei)name.size(), name.c_str());
+		return result;
+	}
+}
+
+void TextureLoader::Queue(ITexture* texture, const std::vector<std::string>& filenames, int targetChannels, ProcessFunc process) {
+	LOG_ASSERT(texture != nullptr && !filenames.empty(), "Texture load requests need a texture and at least one file!");
+
+	// Time batches from when the queue was last empty, so we can report how long cold loads take
+	if (__requests.empty()) {
+		__batchStart = Profiler::Now();
+	}
+	__batchCount++;
+
+	std::shared_ptr<Request> request = std::make_shared<Request>();
+	request->Texture        = texture;
+	request->Filenames      = filenames;
+	request->TargetChannels = targetChannels;
+	request->Process        = process;
+	request->Images.resize(filenames.size());
+	request->Remaining      = static_cast<int>(filenames.size());
+	__requests.push_back(request);
+
+	texture->_usePlaceholder = true;
+
+	// One job per image, so multi-image textures like cubemaps decode in parallel too
+	for (size_t ix = 0; ix < filenames.size(); ix++) {
+		JobSystem::Schedule([request, ix]() { __Decode(request, ix); }, &request->Jobs);
+	}
+}
+
+void TextureLoader::Cancel(ITexture* texture) {
+	for (const auto& request : __requests) {
+		if (request->Texture == texture) {
+			request->Texture = nullptr;
+		}
+	}
+}
+
+void TextureLoader::__Decode(const std::shared_ptr<Request>& request, size_t index) {
+	PROFILE_SCOPE("TextureLoader::Decode");
+
+	// No point decoding the rest of the images once one of them has failed
+	const std::string& filename = request->Filenames[index];
+	if (!request->Failed.load(std::memory_order_relaxed) && !ITexture::_LoadImage(filename, request->TargetChannels, request->Images[index])) {
+		LOG_WARN("STBI Failed to load image from \"{}\"", filename);
+		request->Failed = true;
+	}
+
+	// Whichever job finishes last has all the images, so it gets to run the processing step
+	if (request->Remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		if (!request->Failed && request->Process != nullptr && !request->Process(request->Images)) {
+			request->Failed = true;
+		}
+
+		size_t bytes = 0;
+		for (const ImageData& image : request->Images) {
+			bytes += image.Pixels.size();
+		}
+		request->Bytes = bytes;
+	}
+}
+
+void TextureLoader::Update(size_t maxBytes) {
+	if (__requests.empty()) {
+		return;
+	}
+	PROFILE_SCOPE("TextureLoader::Update");
+
+	size_t uploaded = 0;
+	for (auto it = __requests.begin(); it != __requests.end();) {
+		Request& request = **it;
+
+		// Don't hold up the rest of the queue for a texture that is still decoding
+		if (!request.Jobs.IsDone()) {
+			it++;
+			continue;
+		}
+
+		// Cancelled requests are dropped without counting against the budget
+		if (request.Texture != nullptr) {
+			// Always let at least one texture through, so that a texture larger than the budget still gets loaded
+			if (uploaded > 0 && uploaded + request.Bytes > maxBytes) {
+				break;
+			}
+			uploaded += request.Bytes;
+
+			if (!request.Failed && request.Texture->_OnImagesDecoded(request.Images)) {
+				request.Texture->_usePlaceholder = false;
+				__loadGeneration++;
+			}
+		}
+		it = __requests.erase(it);
+	}
+
+	if (__requests.empty()) {
+		LOG_INFO("Loaded {} textures in {:.1f}ms on {} threads", __batchCount, (Profiler::Now() - __batchStart) / 1000000.0, JobSystem::NumThreads());
+		__batchCount = 0;
+	}
+}
+
+void TextureLoader::WaitAll() {
+	PROFILE_SCOPE("TextureLoader::WaitAll");
+
+	// Jobs never modify the request list, so we're safe to iterate it while they run
+	for (const auto& request : __requests) {
+		JobSystem::Wait(request->Jobs);
+	}
+	Update(std::numeric_limits<size_t>::max());
+}
+
+size_t TextureLoader::GetPendingCount() {
+	return __requests.size();
+}
+
+uint32_t TextureLoader::GetLoadGeneration() {
+	return __loadGeneration;
+}
+
+GLuint TextureLoader::GetPlaceholder(TextureType type) {
+	switch (type) {
+		case TextureType::_2D:
+			if (__placeholder2D == 0) {
+				__placeholder2D = CreatePlaceholder(type, 1);
+			}
+			return __placeholder2D;
+		case TextureType::Cubemap:
+			if (__placeholderCube == 0) {
+				__placeholderCube = CreatePlaceholder(type, 6);
+			}
+			return __placeholderCube;
+		case TextureType::_2DArray:
+			if (__placeholder2DArray == 0) {
+				__placeholder2DArray = CreatePlaceholder(type, 1);
+			}
+			return __placeholder2DArray;
+		default:
+			return 0;
+	}
+}
+
+void* TextureLoader::BeginUpload(size_t size) {
+	if (__staging == nullptr) {
+		__staging = PixelUnpackBuffer::Create(BufferUsage::StreamDraw);
+		__staging->SetDebugName("Texture Staging");
+	}
+
+	// Re-specifying the store orphans the memory from the last upload, so we never wait for the GPU to finish reading it
+	__staging->LoadData(nullptr, 1, static_cast<uint32_t>(size));
+	void* result = __staging->Map(BufferMapMode::Write | BufferMapMode::InvalidateBuffer);
+
+	// If we can't map the buffer, we can still upload straight from client memory
+	__usingFallback = result == nullptr;
+	if (__usingFallback) {
+		LOG_WARN("Failed to map the texture staging buffer, uploading {} bytes from client memory", size);
+		__fallbackStaging.resize(size);
+		result = __fallbackStaging.data();
+	}
+	return result;
+}
+
+void* TextureLoader::SubmitUpload() {
+	if (__usingFallback) {
+		return __fallbackStaging.data();
+	}
+
+	__staging->Unmap();
+	__staging->Bind();
+	// While a pixel unpack buffer is bound, the data pointer for uploads is an offset into the buffer
+	return nullptr;
+}
+
+void TextureLoader::EndUpload() {
+	if (__usingFallback) {
+		std::vector<uint8_t>().swap(__fallbackStaging);
+		__usingFallback = false;
+	} else {
+		PixelUnpackBuffer::UnBind();
+	}
+}
+
+void TextureLoader::Cleanup() {
+	__requests.clear();
+	__staging = nullptr;
+
+	GLuint placeholders[] = { __placeholder2D, __placeholderCube, __placeholder2DArray };
+	for (GLuint placeholder : placeholders) {
+		if (placeholder != 0) {
+			GlStateCache::OnTextureDeleted(placeholder);
+			glDeleteTextures(1, &placeholder);
+		}
+	}
+	__placeholder2D = __placeholderCube = __placeholder2DArray = 0;
+}
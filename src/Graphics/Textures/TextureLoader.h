@@ -0,0 +1,140 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+#include "Graphics/Textures/ITexture.h"
+#include "Graphics/Buffers/PixelUnpackBuffer.h"
+#include "Utils/JobSystem.h"
+
+/// <summary>
+/// Streams textures in from image files. Decoding is done on the job system's worker threads,
+/// one job per image, so a batch of textures created together decodes across all cores. Once a
+/// texture's images are ready, it is handed back to the texture on the main thread during Update,
+/// which allocates it's storage and uploads the pixels through a pixel unpack buffer
+///
+/// Until then, the texture's handle refers to a small grey placeholder of the same type, so
+/// textures can be used in materials as soon as they are created
+/// </summary>
+class TextureLoader {
+public:
+	typedef ITexture::ImageData ImageData;
+	/// <summary>
+	/// Runs on a worker thread once all the images for a request are decoded, for textures that
+	/// need to rearrange their pixels before uploading. Returns false if the images can't be used
+	/// </summary>
+	typedef std::function<bool(std::vector<ImageData>& images)> ProcessFunc;
+
+	/// <summary>
+	/// The default number of bytes of pixels we will upload in a single frame. A texture that is
+	/// larger than this is still uploaded, but it will be the only one uploaded that frame
+	/// </summary>
+	static const size_t DEFAULT_UPLOAD_BUDGET = 32 * 1024 * 1024;
+
+	TextureLoader() = delete;
+
+	/// <summary>
+	/// Queues the images for a texture to be decoded. The texture will use a placeholder until
+	/// they are ready, and will be sent the decoded images through ITexture::_OnImagesDecoded
+	/// </summary>
+	/// <param name="texture">The texture to load the images into</param>
+	/// <param name="filenames">The paths of the images to decode</param>
+	/// <param name="targetChannels">The number of channels to convert the images to, or 0 to keep the channels from the files</param>
+	/// <param name="process">An optional function to run on the decoded images, on a worker thread</param>
+	static void Queue(ITexture* texture, const std::vector<std::string>& filenames, int targetChannels, ProcessFunc process = nullptr);
+	/// <summary>
+	/// Cancels any pending load for a texture, called when a texture is destroyed before it's
+	/// images have arrived. Jobs that are already running will finish, but their results are dropped
+	/// </summary>
+	static void Cancel(ITexture* texture);
+
+	/// <summary>
+	/// Uploads textures that have finished decoding, until we've uploaded maxBytes worth of pixels.
+	/// Must be called on the main thread, once per frame
+	/// </summary>
+	/// <param name="maxBytes">The upload budget for this call, see DEFAULT_UPLOAD_BUDGET</param>
+	static void Update(size_t maxBytes = DEFAULT_UPLOAD_BUDGET);
+	/// <summary>
+	/// Blocks until all queued textures are decoded and uploaded, the calling thread will help
+	/// with decoding while it waits. Must be called on the main thread
+	/// </summary>
+	static void WaitAll();
+
+	/// <summary>
+	/// Returns the number of textures that are waiting to be decoded or uploaded
+	/// </summary>
+	static size_t GetPendingCount();
+	/// <summary>
+	/// Gets a counter that goes up every time a queued texture finishes loading, code that caches
+	/// texture handles can use this to tell when it needs to fetch them again
+	/// </summary>
+	static uint32_t GetLoadGeneration();
+
+	/// <summary>
+	/// Gets the OpenGL handle of the placeholder for the given texture type, creating it on the
+	/// first call. Returns 0 for types that never stream in
+	/// </summary>
+	static GLuint GetPlaceholder(TextureType type);
+
+	/// <summary>
+	/// Allocates space in the staging buffer for an upload, and returns a pointer that the pixels
+	/// should be written to. Must be followed by SubmitUpload and EndUpload
+	/// </summary>
+	/// <param name="size">The number of bytes to upload</param>
+	static void* BeginUpload(size_t size);
+	/// <summary>
+	/// Finishes writing to the staging buffer and binds it, returns the pointer that should be
+	/// passed as the data to glTextureSubImage* calls until EndUpload is called
+	/// </summary>
+	static void* SubmitUpload();
+	/// <summary>
+	/// Unbinds the staging buffer, so texture uploads read from client memory again
+	/// </summary>
+	static void EndUpload();
+
+	/// <summary>
+	/// Drops any outstanding requests and releases the staging buffer and placeholders, must be
+	/// called while the context is still alive
+	/// </summary>
+	static void Cleanup();
+
+private:
+	// Shared between the main thread and the decode jobs for a single texture
+	struct Request {
+		// Cleared by Cancel, so the main thread knows to drop the results. Never touched by jobs
+		ITexture*                Texture;
+		std::vector<std::string> Filenames;
+		int                      TargetChannels;
+		ProcessFunc              Process;
+
+		// One per filename, each job only writes to it's own image
+		std::vector<ImageData>   Images;
+		// The number of images still being decoded, the job that finishes last runs Process
+		std::atomic<int>         Remaining;
+		std::atomic<bool>        Failed;
+		// The total size of the decoded pixels, set by the last job
+		size_t                   Bytes;
+		JobSystem::Counter       Jobs;
+
+		Request() : Texture(nullptr), TargetChannels(0), Process(nullptr), Remaining(0), Failed(false), Bytes(0) {}
+	};
+
+	static void __Decode(const std::shared_ptr<Request>& request, size_t index);
+
+	static std::vector<std::shared_ptr<Request>> __requests;
+	static PixelUnpackBuffer::Sptr __staging;
+	static std::vector<uint8_t>    __fallbackStaging;
+	static bool                    __usingFallback;
+	static uint32_t                __loadGeneration;
+	static GLuint                  __placeholder2D;
+	static GLuint                  __placeholderCube;
+	static GLuint                  __placeholder2DArray;
+
+	// Used to report how long it took to load a batch of textures
+	static int64_t                 __batchStart;
+	static uint32_t                __batchCount;
+};
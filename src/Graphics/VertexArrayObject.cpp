@@ -37,14 +37,17 @@ void VertexArrayObject::SetIndexBuffer(const IndexBuffer::Sptr& ibo) {
 }
 
 VertexArrayObject::VertexBufferBinding* VertexArrayObject::AddVertexBuffer(const VertexBuffer::Sptr& buffer, const std::vector<BufferAttribute>& attributes, bool instanced) {
-	if (_vertexBuffers.size() == 0) {
-		_vertexCount = buffer->GetElementCount();
-		if (_indexBuffer == nullptr) {
-			_elementCount = _vertexCount;
+	// Instanced buffers hold one element per instance, so they have nothing to do with the vertex count
+	if (!instanced) {
+		if (_vertexCount == 0) {
+			_vertexCount = buffer->GetElementCount();
+			if (_indexBuffer == nullptr) {
+				_elementCount = _vertexCount;
+			}
+		}
+		else if (buffer->GetElementCount() != _vertexCount) {
+			LOG_WARN("Buffer element count does not match vertex count of this VAO!!!");
 		}
-	} 
-	else if (buffer->GetElementCount() != _vertexCount) {
-		LOG_WARN("Buffer element count does not match vertex count of this VAO!!!");
 	}
 
 	VertexBufferBinding* binding = new VertexBufferBinding();
@@ -77,7 +80,7 @@ void VertexArrayObject::ReplaceVertexBuffer(VertexBufferBinding* binding, const
 	});
 
 	if (it != _vertexBuffers.end()) {
-		if (buffer->GetElementCount() != _vertexCount) {
+		if (!binding->Instanced && buffer->GetElementCount() != _vertexCount) {
 			LOG_WARN("Buffer element count does not match vertex count of this VAO!!!");
 		}
 
@@ -103,6 +106,11 @@ void VertexArrayObject::ReplaceVertexBuffer(VertexBufferBinding* binding, const
 
 void VertexArrayObject::Draw(DrawMode mode) {
 	Bind();
+	DrawBound(mode);
+	Unbind();
+}
+
+void VertexArrayObject::DrawBound(DrawMode mode) {
 	if (_indexBuffer == nullptr) {
 		uint32_t elements = _elementCount == 0 ? _vertexBuffers[0]->Buffer->GetElementCount() : _elementCount;
 		glDrawArrays((GLenum)mode, 0, elements);
@@ -110,22 +118,25 @@ void VertexArrayObject::Draw(DrawMode mode) {
 		uint32_t elements = _elementCount == 0 ? _indexBuffer->GetElementCount() : _elementCount;
 		glDrawElements((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(), nullptr);
 	}
-	Unbind();
 }
 
 void VertexArrayObject::DrawInstanced(uint32_t instanceCount, DrawMode mode /*= DrawMode::TriangleList*/)
 {
 	Bind();
+	DrawInstancedBound(instanceCount, mode);
+	Unbind();
+}
+
+void VertexArrayObject::DrawInstancedBound(uint32_t instanceCount, DrawMode mode /*= DrawMode::TriangleList*/, uint32_t baseInstance /*= 0*/)
+{
 	if (_indexBuffer == nullptr) {
 		uint32_t elements = _elementCount == 0 ? _vertexBuffers[0]->Buffer->GetElementCount() : _elementCount;
-		glDrawArraysInstanced((GLenum)mode, 0, elements, instanceCount);
+		glDrawArraysInstancedBaseInstance((GLenum)mode, 0, elements, instanceCount, baseInstance);
 	}
 	else {
 		uint32_t elements = _elementCount == 0 ? _indexBuffer->GetElementCount() : _elementCount;
-		glDrawElementsInstanced((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(), nullptr, instanceCount);
+		glDrawElementsInstancedBaseInstance((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(), nullptr, instanceCount, baseInstance);
 	}
-	Unbind();
-	
 }
 
 void VertexArrayObject::Bind() {
@@ -134,6 +134,20 @@ public:
 	/// <param name="mode">The primitive mode for rendering the mesh</param>
 	void DrawInstanced(uint32_t instanceCount, DrawMode mode = DrawMode::TriangleList);
 
+	/// <summary>
+	/// Same as Draw, but assumes that this VAO is already bound and leaves it bound afterwards.
+	/// Lets the render queue skip redundant VAO binds between consecutive draws of the same mesh
+	/// </summary>
+	/// <param name="mode">The draw mode for primitives in this VAO</param>
+	void DrawBound(DrawMode mode = DrawMode::TriangleList);
+	/// <summary>
+	/// Same as DrawInstanced, but assumes that this VAO is already bound
+	/// </summary>
+	/// <param name="instanceCount">The number of instances to render</param>
+	/// <param name="mode">The primitive mode for rendering the mesh</param>
+	/// <param name="baseInstance">The index of the first element to read from instanced buffers</param>
+	void DrawInstancedBound(uint32_t instanceCount, DrawMode mode = DrawMode::TriangleList, uint32_t baseInstance = 0);
+
 	/// <summary>
 	/// Binds this VAO as the source of data for draw operations
 	/// </summary>
@@ -0,0 +1,154 @@
+#include "Utils/BlockCompression.h"
+#include <cstring>
+
+namespace {
+	// The shortest match worth encoding
+	const size_t MIN_MATCH = 4;
+	// The format requires the last 5 bytes to be literals, and the last match to start at least
+	// 12 bytes from the end of the block, so decoders can copy in wide chunks
+	const size_t LAST_LITERALS = 5;
+	const size_t MATCH_SAFE_DISTANCE = 12;
+	// Matches are encoded with a 16 bit offset
+	const size_t MAX_OFFSET = 65535;
+
+	const uint32_t HASH_BITS = 16;
+
+	inline uint32_t Read32(const uint8_t* p) {
+		uint32_t result;
+		memcpy(&result, p, sizeof(uint32_t));
+		return result;
+	}
+
+	inline uint32_t Hash(uint32_t sequence) {
+		return (sequence * 2654435761u) >> (32 - HASH_BITS);
+	}
+
+	// Writes the extra bytes for a length that didn't fit in it's 4 bit token field
+	inline void WriteLength(std::vector<uint8_t>& out, size_t length) {
+		while (length >= 255) {
+			out.push_back(255);
+			length -= 255;
+		}
+		out.push_back(static_cast<uint8_t>(length));
+	}
+
+	// Reads the extra bytes for a length, returns false if we run off the end of the input
+	inline bool ReadLength(const uint8_t*& p, const uint8_t* end, size_t& length) {
+		uint8_t value;
+		do {
+			if (p >= end) { return false; }
+			value = *p++;
+			length += value;
+		} while (value == 255);
+		return true;
+	}
+
+	void WriteSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength) {
+		size_t matchCode = matchLength > 0 ? matchLength - MIN_MATCH : 0;
+		uint8_t token = static_cast<uint8_t>(((literalCount < 15 ? literalCount : 15) << 4) | (matchCode < 15 ? matchCode : 15));
+		out.push_back(token);
+		if (literalCount >= 15) {
+			WriteLength(out, literalCount - 15);
+		}
+		out.insert(out.end(), literals, literals + literalCount);
+
+		// The final sequence is literals only
+		if (matchLength > 0) {
+			out.push_back(static_cast<uint8_t>(offset & 0xFF));
+			out.push_back(static_cast<uint8_t>(offset >> 8));
+			if (matchCode >= 15) {
+				WriteLength(out, matchCode - 15);
+			}
+		}
+	}
+}
+
+size_t BlockCompression::Compress(const uint8_t* data, size_t size, std::vector<uint8_t>& result) {
+	result.clear();
+	result.reserve(GetMaxCompressedSize(size));
+
+	// Positions of the last time we saw each hashed 4 byte sequence
+	std::vector<uint32_t> table(1 << HASH_BITS, 0);
+
+	size_t anchor = 0;
+	size_t pos = 0;
+	if (size > MATCH_SAFE_DISTANCE) {
+		size_t matchLimit = size - LAST_LITERALS;
+		size_t searchLimit = size - MATCH_SAFE_DISTANCE;
+		while (pos < searchLimit) {
+			uint32_t sequence = Read32(data + pos);
+			uint32_t hash = Hash(sequence);
+			size_t candidate = table[hash];
+			table[hash] = static_cast<uint32_t>(pos);
+
+			if (candidate >= pos || pos - candidate > MAX_OFFSET || Read32(data + candidate) != sequence) {
+				pos++;
+				continue;
+			}
+
+			// Extend the match backwards over any literals we haven't written yet
+			while (pos > anchor && candidate > 0 && data[pos - 1] == data[candidate - 1]) {
+				pos--;
+				candidate--;
+			}
+
+			// And forwards as far as the format lets us
+			size_t length = MIN_MATCH;
+			while (pos + length < matchLimit && data[pos + length] == data[candidate + length]) {
+				length++;
+			}
+
+			WriteSequence(result, data + anchor, pos - anchor, pos - candidate, length);
+			pos += length;
+			anchor = pos;
+		}
+	}
+
+	// Whatever is left goes out as literals
+	WriteSequence(result, data + anchor, size - anchor, 0, 0);
+	return result.size();
+}
+
+bool BlockCompression::Decompress(const uint8_t* data, size_t size, uint8_t* output, size_t outputSize) {
+	const uint8_t* p = data;
+	const uint8_t* end = data + size;
+	uint8_t* out = output;
+	uint8_t* outEnd = output + outputSize;
+
+	while (p < end) {
+		uint8_t token = *p++;
+
+		size_t literalCount = token >> 4;
+		if (literalCount == 15 && !ReadLength(p, end, literalCount)) { return false; }
+		if (literalCount > static_cast<size_t>(end - p) || literalCount > static_cast<size_t>(outEnd - out)) { return false; }
+		memcpy(out, p, literalCount);
+		p += literalCount;
+		out += literalCount;
+
+		// The last sequence has no match
+		if (p >= end) { break; }
+
+		if (end - p < 2) { return false; }
+		size_t offset = p[0] | (p[1] << 8);
+		p += 2;
+		if (offset == 0 || offset > static_cast<size_t>(out - output)) { return false; }
+
+		size_t matchLength = token & 0x0F;
+		if (matchLength == 15 && !ReadLength(p, end, matchLength)) { return false; }
+		matchLength += MIN_MATCH;
+		if (matchLength > static_cast<size_t>(outEnd - out)) { return false; }
+
+		// Matches can overlap their own output (ex: runs), so we can only memcpy when they don't
+		const uint8_t* match = out - offset;
+		if (offset >= matchLength) {
+			memcpy(out, match, matchLength);
+			out += matchLength;
+		} else {
+			for (size_t ix = 0; ix < matchLength; ix++) {
+				*out++ = *match++;
+			}
+		}
+	}
+
+	return out == outEnd;
+}
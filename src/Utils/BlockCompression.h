@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// A small, fast LZ77 block compressor that reads and writes the LZ4 block format. It trades
+/// compression ratio for speed, decompression runs at close to memcpy speeds, which makes it
+/// a good fit for asset data that we want to load straight into GPU buffers
+/// </summary>
+class BlockCompression {
+public:
+	BlockCompression() = delete;
+
+	/// <summary>
+	/// Compresses a block of data
+	/// </summary>
+	/// <param name="data">The data to compress</param>
+	/// <param name="size">The number of bytes in data</param>
+	/// <param name="result">The vector to store the compressed data in, any existing contents are replaced</param>
+	/// <returns>The size of the compressed data in bytes</returns>
+	static size_t Compress(const uint8_t* data, size_t size, std::vector<uint8_t>& result);
+
+	/// <summary>
+	/// Decompresses a block that was compressed with Compress. The size of the decompressed data
+	/// must be known up front
+	/// </summary>
+	/// <param name="data">The compressed data</param>
+	/// <param name="size">The number of bytes in data</param>
+	/// <param name="output">The buffer to write the decompressed data into</param>
+	/// <param name="outputSize">The exact size of the decompressed data, in bytes</param>
+	/// <returns>True if the block was valid and exactly filled the output, false if it was corrupt</returns>
+	static bool Decompress(const uint8_t* data, size_t size, uint8_t* output, size_t outputSize);
+
+	/// <summary>
+	/// Gets the largest size that compressing a block of the given size could produce
+	/// </summary>
+	static size_t GetMaxCompressedSize(size_t size) { return size + size / 255 + 16; }
+};
@@ -0,0 +1,455 @@
+#include "Utils/FastObjLoader.h"
+
+#include <atomic>
+#include <cstring>
+#include <Logging.h>
+#include <GLFW/glfw3.h>
+
+#include "Utils/JobSystem.h"
+#include "Utils/MappedFile.h"
+#include "Utils/Profiler.h"
+
+namespace {
+	// Chunks smaller than this aren't worth the overhead of a job
+	const size_t MIN_CHUNK_BYTES = 256 * 1024;
+	// How many chunks we aim to give each thread, so that uneven chunks balance out
+	const uint32_t CHUNKS_PER_THREAD = 4;
+
+	// Vertex keys pack the 1-based position, UV and normal indices into 21 bits each, with 0
+	// meaning that the attribute is missing
+	const uint32_t KEY_BITS = 21;
+	const uint64_t KEY_MASK = (1ull << KEY_BITS) - 1;
+
+	// Flags for which parts of a face corner are relative to the end of the chunk's attributes
+	// rather than absolute indices into the file's attributes
+	const uint8_t RELATIVE_POSITION = 1 << 0;
+	const uint8_t RELATIVE_UV       = 1 << 1;
+	const uint8_t RELATIVE_NORMAL   = 1 << 2;
+
+	// A single v/vt/vn corner of a face, as it was written in the file
+	struct Corner {
+		glm::ivec3 Index;
+		uint8_t    RelativeMask;
+	};
+
+	/// <summary>
+	/// An open-addressing hash table mapping vertex keys to vertex indices. It's sized up front
+	/// for the worst case, so it never needs to rehash
+	/// </summary>
+	class VertexTable {
+	public:
+		static constexpr uint64_t EMPTY = ~0ull;
+
+		void Reset(size_t maxEntries) {
+			size_t capacity = 16;
+			while (capacity < maxEntries * 2) {
+				capacity <<= 1;
+			}
+			_keys.assign(capacity, EMPTY);
+			_values.resize(capacity);
+			_mask = capacity - 1;
+		}
+
+		// Returns the value stored for the key, or stores and returns value if the key is new
+		uint32_t FindOrAdd(uint64_t key, uint32_t value, bool& added) {
+			size_t slot = _Hash(key) & _mask;
+			while (true) {
+				if (_keys[slot] == key) {
+					added = false;
+					return _values[slot];
+				}
+				if (_keys[slot] == EMPTY) {
+					_keys[slot] = key;
+					_values[slot] = value;
+					added = true;
+					return value;
+				}
+				slot = (slot + 1) & _mask;
+			}
+		}
+
+	private:
+		std::vector<uint64_t> _keys;
+		std::vector<uint32_t> _values;
+		size_t                _mask = 0;
+
+		// splitmix64 finalizer, our keys are very regular so they need a good mix
+		static uint64_t _Hash(uint64_t key) {
+			key ^= key >> 30; key *= 0xbf58476d1ce4e5b9ull;
+			key ^= key >> 27; key *= 0x94d049bb133111ebull;
+			key ^= key >> 31;
+			return key;
+		}
+	};
+
+	// Everything a single job extracts from it's slice of the file
+	struct Chunk {
+		const char* Begin;
+		const char* End;
+
+		std::vector<glm::vec3> Positions;
+		std::vector<glm::vec3> Normals;
+		std::vector<glm::vec2> UVs;
+		std::vector<Corner>    Corners;
+		// Triangles as indices into Corners
+		std::vector<uint32_t>  Triangles;
+
+		// The number of each attribute in all the chunks before this one
+		uint32_t PositionOffset;
+		uint32_t NormalOffset;
+		uint32_t UVOffset;
+		// Where this chunk's triangles start in the final index list
+		size_t   IndexOffset;
+
+		// The keys for the unique vertices in this chunk, in the order they were first seen
+		std::vector<uint64_t> LocalVertices;
+		// Maps each corner to an entry in LocalVertices
+		std::vector<uint32_t> CornerToLocal;
+		// Maps each entry in LocalVertices to a vertex in the final mesh
+		std::vector<uint32_t> LocalToGlobal;
+		VertexTable           Table;
+	};
+
+	inline bool IsSpace(char c) {
+		return c == ' ' || c == '\t';
+	}
+
+	inline bool IsLineEnd(const char* p, const char* end) {
+		return p >= end || *p == '\n' || *p == '\r' || *p == '#';
+	}
+
+	inline const char* SkipSpaces(const char* p, const char* end) {
+		while (p < end && IsSpace(*p)) { p++; }
+		return p;
+	}
+
+	inline const char* SkipLine(const char* p, const char* end) {
+		const char* next = static_cast<const char*>(memchr(p, '\n', end - p));
+		return next != nullptr ? next + 1 : end;
+	}
+
+	// Scans a signed integer, returns the position after the last character consumed
+	inline const char* ScanInt(const char* p, const char* end, int& result) {
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			p++;
+		}
+		int value = 0;
+		while (p < end && *p >= '0' && *p <= '9') {
+			value = value * 10 + (*p - '0');
+			p++;
+		}
+		result = negative ? -value : value;
+		return p;
+	}
+
+	// Scans a float in plain or scientific notation, returns the position after the last
+	// character consumed. Accurate to within a couple ULP, which is plenty for mesh data
+	inline const char* ScanFloat(const char* p, const char* end, float& result) {
+		static const double POWERS_OF_TEN[] = {
+			1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+		p = SkipSpaces(p, end);
+
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			p++;
+		}
+
+		// Accumulate up to 19 significant digits, anything past that can't change a float
+		uint64_t mantissa = 0;
+		int digits = 0;
+		int exponent = 0;
+		while (p < end && *p >= '0' && *p <= '9') {
+			if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); digits += mantissa > 0; }
+			else { exponent++; }
+			p++;
+		}
+		if (p < end && *p == '.') {
+			p++;
+			while (p < end && *p >= '0' && *p <= '9') {
+				if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); digits += mantissa > 0; exponent--; }
+				p++;
+			}
+		}
+		if (p < end && (*p == 'e' || *p == 'E')) {
+			int explicitExponent = 0;
+			p = ScanInt(p + 1, end, explicitExponent);
+			exponent += explicitExponent;
+		}
+
+		double value = static_cast<double>(mantissa);
+		while (exponent > 22)  { value *= 1e22; exponent -= 22; }
+		while (exponent < -22) { value /= 1e22; exponent += 22; }
+		value = exponent >= 0 ? value * POWERS_OF_TEN[exponent] : value / POWERS_OF_TEN[-exponent];
+
+		result = static_cast<float>(negative ? -value : value);
+		return p;
+	}
+
+	// Resolves an index from a face into a chunk-local 1-based index if it's relative, returns
+	// true if the index was relative
+	inline bool ResolveRelative(int& index, size_t localCount) {
+		if (index < 0) {
+			index = static_cast<int>(localCount) + 1 + index;
+			return true;
+		}
+		return false;
+	}
+
+	// Parses every line in the chunk, extracting attributes and faces
+	void ParseChunk(Chunk& chunk) {
+		PROFILE_SCOPE("FastObjLoader::ParseChunk");
+
+		// OBJ lines average around 30 bytes, so this saves us most of our vector growth
+		size_t estimatedLines = (chunk.End - chunk.Begin) / 30 + 1;
+		chunk.Positions.reserve(estimatedLines / 3);
+		chunk.Corners.reserve(estimatedLines);
+		chunk.Triangles.reserve(estimatedLines);
+
+		const char* p = chunk.Begin;
+		const char* end = chunk.End;
+		while (p < end) {
+			p = SkipSpaces(p, end);
+			if (p + 1 >= end) { break; }
+
+			if (p[0] == 'v') {
+				// Vertex position
+				if (IsSpace(p[1])) {
+					glm::vec3 value;
+					p = ScanFloat(p + 2, end, value.x);
+					p = ScanFloat(p, end, value.y);
+					p = ScanFloat(p, end, value.z);
+					chunk.Positions.push_back(value);
+				}
+				// Vertex normal
+				else if (p[1] == 'n') {
+					glm::vec3 value;
+					p = ScanFloat(p + 2, end, value.x);
+					p = ScanFloat(p, end, value.y);
+					p = ScanFloat(p, end, value.z);
+					chunk.Normals.push_back(value);
+				}
+				// Texture coordinate, we ignore the optional w component
+				else if (p[1] == 't') {
+					glm::vec2 value;
+					p = ScanFloat(p + 2, end, value.x);
+					p = ScanFloat(p, end, value.y);
+					chunk.UVs.push_back(value);
+				}
+			}
+			// Face, in any of the v, v/vt, v//vn or v/vt/vn forms
+			else if (p[0] == 'f' && IsSpace(p[1])) {
+				p += 2;
+				uint32_t firstCorner = static_cast<uint32_t>(chunk.Corners.size());
+				uint32_t cornerCount = 0;
+				while (true) {
+					p = SkipSpaces(p, end);
+					if (IsLineEnd(p, end)) { break; }
+
+					Corner corner = { glm::ivec3(0), 0 };
+					p = ScanInt(p, end, corner.Index.x);
+					if (p < end && *p == '/') {
+						p++;
+						if (p < end && *p != '/') {
+							p = ScanInt(p, end, corner.Index.y);
+						}
+						if (p < end && *p == '/') {
+							p = ScanInt(p + 1, end, corner.Index.z);
+						}
+					}
+					// Skip anything we didn't understand, so that one bad corner doesn't stall us
+					while (p < end && !IsSpace(*p) && !IsLineEnd(p, end)) { p++; }
+
+					corner.RelativeMask |= ResolveRelative(corner.Index.x, chunk.Positions.size()) ? RELATIVE_POSITION : 0;
+					corner.RelativeMask |= ResolveRelative(corner.Index.y, chunk.UVs.size())       ? RELATIVE_UV       : 0;
+					corner.RelativeMask |= ResolveRelative(corner.Index.z, chunk.Normals.size())   ? RELATIVE_NORMAL   : 0;
+					chunk.Corners.push_back(corner);
+
+					// Fan triangulation, this matches what we've always done for quads
+					cornerCount++;
+					if (cornerCount >= 3) {
+						uint32_t current = firstCorner + cornerCount - 1;
+						chunk.Triangles.push_back(firstCorner);
+						chunk.Triangles.push_back(current - 1);
+						chunk.Triangles.push_back(current);
+					}
+				}
+			}
+
+			// Everything else (comments, groups, materials, etc...) is ignored
+			p = SkipLine(p, end);
+		}
+	}
+
+	// Converts an index from a corner to a 1-based index into the file's attributes, or 0 if it
+	// is missing or out of range
+	inline uint32_t ToGlobal(int index, bool relative, uint32_t offset, uint32_t total, std::atomic<bool>& invalid) {
+		if (index == 0 && !relative) { return 0; }
+		int64_t result = relative ? static_cast<int64_t>(offset) + index : index;
+		if (result < 1 || result > total) {
+			invalid.store(true, std::memory_order_relaxed);
+			return 0;
+		}
+		return static_cast<uint32_t>(result);
+	}
+
+	// Resolves this chunk's corners to file-wide vertex keys, and de-duplicates them
+	void DedupChunk(Chunk& chunk, const glm::uvec3& totals, std::atomic<bool>& invalid) {
+		PROFILE_SCOPE("FastObjLoader::DedupChunk");
+
+		chunk.Table.Reset(chunk.Corners.size());
+		chunk.LocalVertices.reserve(chunk.Corners.size() / 2);
+		chunk.CornerToLocal.resize(chunk.Corners.size());
+
+		for (size_t ix = 0; ix < chunk.Corners.size(); ix++) {
+			const Corner& corner = chunk.Corners[ix];
+			uint64_t position = ToGlobal(corner.Index.x, (corner.RelativeMask & RELATIVE_POSITION) != 0, chunk.PositionOffset, totals.x, invalid);
+			uint64_t uv       = ToGlobal(corner.Index.y, (corner.RelativeMask & RELATIVE_UV) != 0,       chunk.UVOffset,       totals.y, invalid);
+			uint64_t normal   = ToGlobal(corner.Index.z, (corner.RelativeMask & RELATIVE_NORMAL) != 0,   chunk.NormalOffset,   totals.z, invalid);
+			uint64_t key = ((position & KEY_MASK) << (KEY_BITS * 2)) | ((uv & KEY_MASK) << KEY_BITS) | (normal & KEY_MASK);
+
+			bool added = false;
+			chunk.CornerToLocal[ix] = chunk.Table.FindOrAdd(key, static_cast<uint32_t>(chunk.LocalVertices.size()), added);
+			if (added) {
+				chunk.LocalVertices.push_back(key);
+			}
+		}
+	}
+
+	// Splits the file into chunks that start and end on line boundaries
+	void SplitChunks(const char* data, size_t size, std::vector<Chunk>& chunks) {
+		size_t maxChunks = JobSystem::NumThreads() * CHUNKS_PER_THREAD;
+		size_t count = size / MIN_CHUNK_BYTES + 1;
+		count = count < maxChunks ? count : maxChunks;
+
+		chunks.resize(count);
+		const char* begin = data;
+		const char* end = data + size;
+		for (size_t ix = 0; ix < count; ix++) {
+			const char* target = data + (size * (ix + 1)) / count;
+			const char* chunkEnd = ix == count - 1 || target >= end ? end : SkipLine(target, end);
+			// A single very long line can swallow the next chunk's target entirely, leaving it empty
+			chunkEnd = chunkEnd > begin ? chunkEnd : begin;
+			chunks[ix].Begin = begin;
+			chunks[ix].End = chunkEnd;
+			begin = chunkEnd;
+		}
+	}
+}
+
+bool FastObjLoader::Parse(const std::string& filename, ParsedObj& result) {
+	PROFILE_SCOPE("FastObjLoader::Parse");
+
+	MappedFile file;
+	if (!file.Open(filename)) {
+		return false;
+	}
+
+	float startTime = static_cast<float>(glfwGetTime());
+
+	result.Positions.clear();
+	result.Normals.clear();
+	result.UVs.clear();
+	result.Vertices.clear();
+	result.Indices.clear();
+
+	std::vector<Chunk> chunks;
+	SplitChunks(file.GetData(), file.GetSize(), chunks);
+	uint32_t chunkCount = static_cast<uint32_t>(chunks.size());
+
+	// Pass 1: parse every chunk independently
+	JobSystem::ParallelFor(chunkCount, 1, [&](uint32_t start, uint32_t end) {
+		for (uint32_t ix = start; ix < end; ix++) {
+			ParseChunk(chunks[ix]);
+		}
+	});
+
+	// Now that we know how many attributes each chunk has, we can work out where they sit in the file
+	glm::uvec3 totals = glm::uvec3(0);
+	size_t indexCount = 0;
+	for (Chunk& chunk : chunks) {
+		chunk.PositionOffset = totals.x;
+		chunk.UVOffset       = totals.y;
+		chunk.NormalOffset   = totals.z;
+		chunk.IndexOffset    = indexCount;
+		totals += glm::uvec3(chunk.Positions.size(), chunk.UVs.size(), chunk.Normals.size());
+		indexCount += chunk.Triangles.size();
+	}
+	if (totals.x > KEY_MASK || totals.y > KEY_MASK || totals.z > KEY_MASK) {
+		LOG_WARN("\"{}\" has more than {} of an attribute, some vertices will be merged incorrectly", filename, KEY_MASK);
+	}
+
+	// Pass 2: resolve indices and de-duplicate vertices within each chunk, while we gather up the attributes
+	std::atomic<bool> invalid(false);
+	JobSystem::Counter counter;
+	JobSystem::Schedule([&]() {
+		result.Positions.reserve(totals.x);
+		result.UVs.reserve(totals.y);
+		result.Normals.reserve(totals.z);
+		for (const Chunk& chunk : chunks) {
+			result.Positions.insert(result.Positions.end(), chunk.Positions.begin(), chunk.Positions.end());
+			result.UVs.insert(result.UVs.end(), chunk.UVs.begin(), chunk.UVs.end());
+			result.Normals.insert(result.Normals.end(), chunk.Normals.begin(), chunk.Normals.end());
+		}
+	}, &counter);
+	JobSystem::ParallelFor(chunkCount, 1, [&](uint32_t start, uint32_t end) {
+		for (uint32_t ix = start; ix < end; ix++) {
+			DedupChunk(chunks[ix], totals, invalid);
+		}
+	});
+	JobSystem::Wait(counter);
+	if (invalid) {
+		LOG_WARN("\"{}\" contains faces with missing or out of range indices", filename);
+	}
+
+	// Pass 3: merge the chunk tables in file order, so vertices end up in the order they first appear
+	{
+		PROFILE_SCOPE("FastObjLoader::MergeVertices");
+
+		size_t maxVertices = 0;
+		for (const Chunk& chunk : chunks) {
+			maxVertices += chunk.LocalVertices.size();
+		}
+
+		VertexTable table;
+		table.Reset(maxVertices);
+		result.Vertices.reserve(maxVertices);
+		for (Chunk& chunk : chunks) {
+			chunk.LocalToGlobal.resize(chunk.LocalVertices.size());
+			for (size_t ix = 0; ix < chunk.LocalVertices.size(); ix++) {
+				uint64_t key = chunk.LocalVertices[ix];
+				bool added = false;
+				chunk.LocalToGlobal[ix] = table.FindOrAdd(key, static_cast<uint32_t>(result.Vertices.size()), added);
+				if (added) {
+					result.Vertices.push_back(glm::ivec3(
+						static_cast<int>((key >> (KEY_BITS * 2)) & KEY_MASK),
+						static_cast<int>((key >> KEY_BITS) & KEY_MASK),
+						static_cast<int>(key & KEY_MASK)
+					) - glm::ivec3(1));
+				}
+			}
+		}
+	}
+
+	// Pass 4: write out the final indices, each chunk has it's own slice of the list
+	result.Indices.resize(indexCount);
+	JobSystem::ParallelFor(chunkCount, 1, [&](uint32_t start, uint32_t end) {
+		for (uint32_t ix = start; ix < end; ix++) {
+			const Chunk& chunk = chunks[ix];
+			uint32_t* out = result.Indices.data() + chunk.IndexOffset;
+			for (size_t iy = 0; iy < chunk.Triangles.size(); iy++) {
+				out[iy] = chunk.LocalToGlobal[chunk.CornerToLocal[chunk.Triangles[iy]]];
+			}
+		}
+	});
+
+	float endTime = static_cast<float>(glfwGetTime());
+	LOG_TRACE("Parsed OBJ file \"{}\" in {} seconds ({} chunks, {} vertices, {} indices)", filename, endTime - startTime, chunkCount, result.Vertices.size(), result.Indices.size());
+
+	return true;
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Utils/MeshBuilder.h"
+#include "Utils/MeshFactory.h"
+#include "Graphics/VertexTypes.h"
+#include "Graphics/VertexParamMap.h"
+
+/// <summary>
+/// An OBJ loader built for large files. The file is memory mapped and split into line-aligned
+/// chunks that are parsed in parallel on the job system, using a hand-rolled number scanner
+/// instead of streams so that no allocations are made per line. Each chunk de-duplicates its
+/// own vertices, and the chunk tables are then merged in file order, so the resulting mesh is
+/// identical no matter how many threads took part
+///
+/// Faces with more than 3 vertices are triangulated as a fan
+/// </summary>
+class FastObjLoader {
+public:
+	/// <summary>
+	/// The raw results of parsing an OBJ file, before it is turned into a mesh
+	/// </summary>
+	struct ParsedObj {
+		std::vector<glm::vec3>  Positions;
+		std::vector<glm::vec3>  Normals;
+		std::vector<glm::vec2>  UVs;
+		// The unique combinations of attributes in the mesh, as 0-based indices into
+		// Positions, UVs and Normals. UVs and normals are -1 if the vertex does not have one
+		std::vector<glm::ivec3> Vertices;
+		// Triangle list indexing into Vertices
+		std::vector<uint32_t>   Indices;
+	};
+
+	/// <summary>
+	/// Parses an OBJ file into it's attribute streams and de-duplicated vertices
+	/// </summary>
+	/// <param name="filename">The path to the OBJ file to parse</param>
+	/// <param name="result">The structure to store the parsed data in, any existing data is replaced</param>
+	/// <returns>True if the file was parsed, false if it could not be opened</returns>
+	static bool Parse(const std::string& filename, ParsedObj& result);
+
+	/// <summary>
+	/// Appends the vertices and indices from a parsed OBJ file to a mesh builder
+	/// </summary>
+	/// <typeparam name="VertexType">The type of vertex the mesh is using</typeparam>
+	/// <param name="data">The parsed OBJ data</param>
+	/// <param name="mesh">The mesh to append to</param>
+	template <typename VertexType>
+	static void BuildMesh(const ParsedObj& data, MeshBuilder<VertexType>& mesh);
+
+	/// <summary>
+	/// Loads a VAO from an OBJ file, see ObjLoader::LoadFromFile
+	/// </summary>
+	/// <typeparam name="VertexType">The type of vertex to generate</typeparam>
+	/// <param name="filename">The path to the OBJ file to load</param>
+	/// <param name="calcTangents">True if tangents and bitangents should be calculated</param>
+	template <typename VertexType = VertexPosNormTexColTangents>
+	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename, bool calcTangents = true);
+
+protected:
+	FastObjLoader() = default;
+	~FastObjLoader() = default;
+};
+
+template <typename VertexType>
+void FastObjLoader::BuildMesh(const ParsedObj& data, MeshBuilder<VertexType>& mesh) {
+	// Could also take this in as a parameter
+	const glm::vec4 color = glm::vec4(1.0f);
+
+	VertexParamMap vMap = VertexParamMap(VertexType::V_DECL);
+
+	uint32_t baseVertex = static_cast<uint32_t>(mesh.GetVertexCount());
+	mesh.ReserveVertexSpace(data.Vertices.size());
+	for (const glm::ivec3& indices : data.Vertices) {
+		VertexType vertex;
+		vMap.SetPosition(vertex, indices.x >= 0 ? data.Positions[indices.x] : glm::vec3(0.0f));
+		vMap.SetTexture(vertex, indices.y >= 0 ? data.UVs[indices.y] : glm::vec2(0.0f));
+		vMap.SetNormal(vertex, indices.z >= 0 ? data.Normals[indices.z] : glm::vec3(0.0f, 0.0f, 1.0f));
+		vMap.SetColor(vertex, color);
+		mesh.AddVertex(vertex);
+	}
+
+	mesh.ReserveIndexSpace(data.Indices.size());
+	for (uint32_t ix : data.Indices) {
+		mesh.AddIndex(baseVertex + ix);
+	}
+}
+
+template <typename VertexType>
+VertexArrayObject::Sptr FastObjLoader::LoadFromFile(const std::string& filename, bool calcTangents) {
+	ParsedObj data;
+	if (!Parse(filename, data)) {
+		throw std::runtime_error("Failed to open file");
+	}
+
+	MeshBuilder<VertexType> mesh = MeshBuilder<VertexType>();
+	BuildMesh(data, mesh);
+
+	if (calcTangents) {
+		MeshFactory::CalculateTBN(mesh);
+	}
+
+	return mesh.Bake();
+}
@@ -0,0 +1,191 @@
+#include "Utils/JobSystem.h"
+#include <Logging.h>
+#include "Utils/Profiler.h"
+
+std::vector<std::unique_ptr<JobSystem::WorkQueue>> JobSystem::_queues;
+std::vector<std::thread>                           JobSystem::_workers;
+std::atomic<bool>                                  JobSystem::_isRunning(false);
+std::atomic<int>                                   JobSystem::_queuedJobs(0);
+std::mutex                                         JobSystem::_sleepMutex;
+std::condition_variable                            JobSystem::_wakeCondition;
+
+thread_local uint32_t JobSystem::_threadIndex = 0;
+
+void JobSystem::Init(uint32_t numWorkers) {
+	LOG_ASSERT(!_isRunning, "Job system has already been initialized!");
+
+	// Default to one worker per core, leaving a core for the main thread
+	if (numWorkers == 0) {
+		uint32_t cores = std::thread::hardware_concurrency();
+		numWorkers = cores > 1 ? cores - 1 : 1;
+	}
+
+	// Queue 0 belongs to the main thread, the rest belong to the workers
+	_queues.clear();
+	for (uint32_t ix = 0; ix <= numWorkers; ix++) {
+		_queues.push_back(std::make_unique<WorkQueue>());
+	}
+
+	_threadIndex = 0;
+	_isRunning = true;
+	for (uint32_t ix = 1; ix <= numWorkers; ix++) {
+		_workers.emplace_back(&JobSystem::_WorkerMain, ix);
+	}
+
+	LOG_INFO("Started job system with {} worker threads", numWorkers);
+}
+
+void JobSystem::Shutdown() {
+	if (!_isRunning) return;
+
+	// Drain anything that is still queued so no one is left waiting on a counter
+	while (_TryRunJob(_threadIndex)) {}
+
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_isRunning = false;
+	}
+	_wakeCondition.notify_all();
+
+	for (auto& worker : _workers) {
+		worker.join();
+	}
+	_workers.clear();
+	_queues.clear();
+}
+
+bool JobSystem::IsInitialized() {
+	return _isRunning;
+}
+
+uint32_t JobSystem::NumThreads() {
+	return _isRunning ? static_cast<uint32_t>(_queues.size()) : 1;
+}
+
+uint32_t JobSystem::ThreadIndex() {
+	return _threadIndex;
+}
+
+void JobSystem::Schedule(JobFunc job, Counter* counter) {
+	Job entry;
+	entry.Func = std::move(job);
+	entry.Tracker = counter;
+
+	if (counter != nullptr) {
+		counter->_pending.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Without workers we just run the job in place
+	if (!_isRunning) {
+		_Run(entry);
+		return;
+	}
+
+	{
+		WorkQueue& queue = *_queues[_threadIndex];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Jobs.push_back(std::move(entry));
+	}
+	_queuedJobs.fetch_add(1, std::memory_order_release);
+
+	// Take the sleep lock before notifying, otherwise a worker that has just checked the queue
+	// count could miss the wakeup and sleep with work available
+	{ std::lock_guard<std::mutex> lock(_sleepMutex); }
+	_wakeCondition.notify_one();
+}
+
+void JobSystem::Wait(Counter& counter) {
+	while (!counter.IsDone()) {
+		if (!_TryRunJob(_threadIndex)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t grainSize, const RangeFunc& func) {
+	if (count == 0) return;
+	if (grainSize == 0) grainSize = 1;
+
+	// Not worth splitting up, or we have nowhere to send it
+	if (!_isRunning || count <= grainSize) {
+		func(0, count);
+		return;
+	}
+
+	Counter counter;
+	for (uint32_t start = 0; start < count; start += grainSize) {
+		uint32_t end = start + grainSize < count ? start + grainSize : count;
+		Schedule([&func, start, end]() { func(start, end); }, &counter);
+	}
+	Wait(counter);
+}
+
+void JobSystem::_WorkerMain(uint32_t threadIndex) {
+	_threadIndex = threadIndex;
+	Profiler::SetThreadName("Job Worker " + std::to_string(threadIndex));
+
+	while (true) {
+		if (_TryRunJob(threadIndex)) {
+			continue;
+		}
+
+		// Nothing to do, sleep until someone queues a job
+		std::unique_lock<std::mutex> lock(_sleepMutex);
+		_wakeCondition.wait(lock, []() {
+			return !_isRunning || _queuedJobs.load(std::memory_order_acquire) > 0;
+		});
+		if (!_isRunning) {
+			break;
+		}
+	}
+}
+
+bool JobSystem::_TryRunJob(uint32_t threadIndex) {
+	if (_queues.empty()) return false;
+
+	Job job;
+	if (_PopLocal(threadIndex, job) || _Steal(threadIndex, job)) {
+		_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+		_Run(job);
+		return true;
+	}
+	return false;
+}
+
+bool JobSystem::_PopLocal(uint32_t threadIndex, Job& result) {
+	// We take from the back of our own queue, since those jobs are the most likely to still be in cache
+	WorkQueue& queue = *_queues[threadIndex];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+	if (queue.Jobs.empty()) {
+		return false;
+	}
+	result = std::move(queue.Jobs.back());
+	queue.Jobs.pop_back();
+	return true;
+}
+
+bool JobSystem::_Steal(uint32_t threadIndex, Job& result) {
+	// Thieves take from the front of the other queues, starting with our neighbour so that
+	// all the threads don't hammer the same queue
+	uint32_t numQueues = static_cast<uint32_t>(_queues.size());
+	for (uint32_t offset = 1; offset < numQueues; offset++) {
+		WorkQueue& queue = *_queues[(threadIndex + offset) % numQueues];
+		std::unique_lock<std::mutex> lock(queue.Mutex, std::try_to_lock);
+		if (lock.owns_lock() && !queue.Jobs.empty()) {
+			result = std::move(queue.Jobs.front());
+			queue.Jobs.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::_Run(Job& job) {
+	{
+		PROFILE_SCOPE("Job");
+		job.Func();
+	}
+	if (job.Tracker != nullptr) {
+		job.Tracker->_pending.fetch_sub(1, std::memory_order_release);
+	}
+}
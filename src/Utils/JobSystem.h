@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// A small work-stealing job scheduler. Each thread (including the main thread)
+/// owns a queue of jobs, threads pop work from the back of their own queue and
+/// steal from the front of other queues when they run dry. Threads that are
+/// waiting on a counter help out by running jobs instead of blocking
+///
+/// Jobs must not touch OpenGL, and must not make structural changes to a scene
+/// (see Scene::Defer)
+/// </summary>
+class JobSystem {
+public:
+	typedef std::function<void()> JobFunc;
+	typedef std::function<void(uint32_t start, uint32_t end)> RangeFunc;
+
+	/// <summary>
+	/// Tracks the number of outstanding jobs in a batch, pass to Schedule and
+	/// then Wait on it
+	/// </summary>
+	class Counter {
+	public:
+		Counter() : _pending(0) {}
+		NO_COPY(Counter)
+		NO_MOVE(Counter)
+
+		/// <summary>
+		/// Returns true when all jobs associated with this counter have completed
+		/// </summary>
+		bool IsDone() const { return _pending.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+		std::atomic<int> _pending;
+	};
+
+	JobSystem() = delete;
+
+	/// <summary>
+	/// Starts the worker threads
+	/// </summary>
+	/// <param name="numWorkers">The number of worker threads to spawn, or 0 to use one per core (minus the main thread)</param>
+	static void Init(uint32_t numWorkers = 0);
+	/// <summary>
+	/// Finishes all outstanding jobs and joins the worker threads
+	/// </summary>
+	static void Shutdown();
+
+	/// <summary>
+	/// Returns true if the worker threads have been started
+	/// </summary>
+	static bool IsInitialized();
+	/// <summary>
+	/// Gets the number of threads that can execute jobs, including the main thread
+	/// </summary>
+	static uint32_t NumThreads();
+	/// <summary>
+	/// Gets the index of the calling thread, 0 is the main thread
+	/// </summary>
+	static uint32_t ThreadIndex();
+
+	/// <summary>
+	/// Queues a job on the calling thread's queue. If the job system has not been
+	/// initialized, the job is run immediately
+	/// </summary>
+	/// <param name="job">The job to run</param>
+	/// <param name="counter">An optional counter to track completion of the job</param>
+	static void Schedule(JobFunc job, Counter* counter = nullptr);
+	/// <summary>
+	/// Blocks until all jobs associated with the counter have finished. The calling
+	/// thread will run queued jobs while it waits
+	/// </summary>
+	static void Wait(Counter& counter);
+
+	/// <summary>
+	/// Splits the range [0, count) into batches of at most grainSize elements and
+	/// processes them across all threads, returning once all batches are done
+	/// </summary>
+	/// <param name="count">The number of elements to process</param>
+	/// <param name="grainSize">The maximum number of elements to give to a single job</param>
+	/// <param name="func">The function to invoke for each batch</param>
+	static void ParallelFor(uint32_t count, uint32_t grainSize, const RangeFunc& func);
+
+protected:
+	struct Job {
+		JobFunc  Func;
+		Counter* Tracker;
+	};
+
+	struct WorkQueue {
+		std::mutex      Mutex;
+		std::deque<Job> Jobs;
+	};
+
+	static std::vector<std::unique_ptr<WorkQueue>> _queues;
+	static std::vector<std::thread>                _workers;
+	static std::atomic<bool>                       _isRunning;
+	static std::atomic<int>                        _queuedJobs;
+	static std::mutex                              _sleepMutex;
+	static std::condition_variable                 _wakeCondition;
+
+	static thread_local uint32_t _threadIndex;
+
+	static void _WorkerMain(uint32_t threadIndex);
+	static bool _TryRunJob(uint32_t threadIndex);
+	static bool _PopLocal(uint32_t threadIndex, Job& result);
+	static bool _Steal(uint32_t threadIndex, Job& result);
+	static void _Run(Job& job);
+};
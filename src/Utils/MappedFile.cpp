@@ -0,0 +1,110 @@
+#include "Utils/MappedFile.h"
+#include <Logging.h>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+	_data(nullptr),
+	_size(0),
+	_isOpen(false),
+	_fileHandle(nullptr),
+	_mappingHandle(nullptr)
+{ }
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+bool MappedFile::Open(const std::string& filename) {
+	Close();
+
+	#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		LOG_ERROR("Could not open file '{}'", filename);
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		LOG_ERROR("Could not get the size of '{}'", filename);
+		CloseHandle(file);
+		return false;
+	}
+	_fileHandle = file;
+	_size = static_cast<size_t>(size.QuadPart);
+
+	// Windows won't map empty files, but they're still valid files
+	if (_size > 0) {
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		const void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (view == nullptr) {
+			LOG_ERROR("Could not map file '{}'", filename);
+			if (mapping != nullptr) { CloseHandle(mapping); }
+			CloseHandle(file);
+			_fileHandle = nullptr;
+			_size = 0;
+			return false;
+		}
+		_mappingHandle = mapping;
+		_data = static_cast<const char*>(view);
+	}
+	#else
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0) {
+		LOG_ERROR("Could not open file '{}'", filename);
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0) {
+		LOG_ERROR("Could not get the size of '{}'", filename);
+		close(file);
+		return false;
+	}
+	_size = static_cast<size_t>(info.st_size);
+
+	if (_size > 0) {
+		void* view = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (view == MAP_FAILED) {
+			LOG_ERROR("Could not map file '{}'", filename);
+			close(file);
+			_size = 0;
+			return false;
+		}
+		madvise(view, _size, MADV_SEQUENTIAL);
+		_data = static_cast<const char*>(view);
+	}
+
+	// The mapping keeps the file alive, we don't need the descriptor anymore
+	close(file);
+	#endif
+
+	_isOpen = true;
+	return true;
+}
+
+void MappedFile::Close() {
+	#ifdef _WIN32
+	if (_data != nullptr) { UnmapViewOfFile(_data); }
+	if (_mappingHandle != nullptr) { CloseHandle(_mappingHandle); }
+	if (_fileHandle != nullptr) { CloseHandle(_fileHandle); }
+	#else
+	if (_data != nullptr) { munmap(const_cast<char*>(_data), _size); }
+	#endif
+
+	_data = nullptr;
+	_size = 0;
+	_isOpen = false;
+	_fileHandle = nullptr;
+	_mappingHandle = nullptr;
+}
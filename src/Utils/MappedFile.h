@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// A read-only view of a file that is memory mapped rather than read into a buffer, so
+/// large files can be scanned without copying them. The view is released when the
+/// object is destroyed
+/// </summary>
+class MappedFile {
+public:
+	MAKE_PTRS(MappedFile);
+	NO_COPY(MappedFile);
+	NO_MOVE(MappedFile);
+
+	MappedFile();
+	~MappedFile();
+
+	/// <summary>
+	/// Maps the given file into memory, closing any file that was already open
+	/// </summary>
+	/// <param name="filename">The path of the file to map</param>
+	/// <returns>True if the file was mapped, false if it could not be opened</returns>
+	bool Open(const std::string& filename);
+	/// <summary>
+	/// Releases the mapping, any pointers from GetData are invalid after this
+	/// </summary>
+	void Close();
+
+	/// <summary>
+	/// Returns true if a file is currently mapped
+	/// </summary>
+	bool IsOpen() const { return _isOpen; }
+	/// <summary>
+	/// Gets a pointer to the start of the file's contents, or nullptr for empty files
+	/// </summary>
+	const char* GetData() const { return _data; }
+	/// <summary>
+	/// Gets the size of the file in bytes
+	/// </summary>
+	size_t GetSize() const { return _size; }
+
+private:
+	const char* _data;
+	size_t      _size;
+	bool        _isOpen;
+
+	// Platform handles, stored as pointers so we don't need to pull in the OS headers here
+	void*       _fileHandle;
+	void*       _mappingHandle;
+};
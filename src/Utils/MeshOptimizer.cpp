@@ -0,0 +1,321 @@
+#include "Utils/MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace {
+	const uint32_t CACHE_SIZE = MeshOptimizer::VERTEX_CACHE_SIZE;
+
+	// Tunings from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+	const float CACHE_DECAY_POWER   = 1.5f;
+	const float LAST_TRI_SCORE      = 0.75f;
+	const float VALENCE_BOOST_SCALE = 2.0f;
+	const float VALENCE_BOOST_POWER = 0.5f;
+	// Vertices used by more triangles than this all get the same boost
+	const uint32_t MAX_VALENCE = 32;
+
+	// Vertex scores get recalculated constantly, so we look them up from tables
+	struct ScoreTables {
+		float Cache[CACHE_SIZE];
+		float Valence[MAX_VALENCE + 1];
+
+		ScoreTables() {
+			for (uint32_t ix = 0; ix < CACHE_SIZE; ix++) {
+				// The last triangle's vertices get a fixed score, otherwise we'd favour long thin strips
+				Cache[ix] = ix < 3 ? LAST_TRI_SCORE : powf(1.0f - static_cast<float>(ix - 3) / (CACHE_SIZE - 3), CACHE_DECAY_POWER);
+			}
+			// Vertices with few triangles left get a boost, so we finish them off instead of leaving lone triangles behind
+			Valence[0] = 0.0f;
+			for (uint32_t ix = 1; ix <= MAX_VALENCE; ix++) {
+				Valence[ix] = VALENCE_BOOST_SCALE * powf(static_cast<float>(ix), -VALENCE_BOOST_POWER);
+			}
+		}
+
+		float VertexScore(int32_t cachePosition, uint32_t remaining) const {
+			// No triangles need this vertex anymore
+			if (remaining == 0) {
+				return -1.0f;
+			}
+			float score = cachePosition >= 0 ? Cache[cachePosition] : 0.0f;
+			return score + Valence[std::min(remaining, MAX_VALENCE)];
+		}
+	};
+
+	// Simulates a FIFO cache using the time each vertex was inserted. Time only advances on a
+	// miss, so a vertex is still in the cache if less than cacheSize vertices have been added since
+	bool CacheMiss(uint32_t vertex, std::vector<uint32_t>& insertedAt, uint32_t& time, uint32_t cacheSize) {
+		if (time - insertedAt[vertex] >= cacheSize) {
+			insertedAt[vertex] = time++;
+			return true;
+		}
+		return false;
+	}
+
+	uint32_t TriangleMisses(const uint32_t* triangle, std::vector<uint32_t>& insertedAt, uint32_t& time, uint32_t cacheSize) {
+		return
+			CacheMiss(triangle[0], insertedAt, time, cacheSize) +
+			CacheMiss(triangle[1], insertedAt, time, cacheSize) +
+			CacheMiss(triangle[2], insertedAt, time, cacheSize);
+	}
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+	VertexCacheStats result;
+	if (indexCount < 3 || cacheSize == 0) {
+		return result;
+	}
+
+	// Start time at the cache size, so every vertex begins out of the cache
+	std::vector<uint32_t> insertedAt(vertexCount, 0);
+	uint32_t time = cacheSize;
+	std::vector<bool> used(vertexCount, false);
+	size_t uniqueVertices = 0;
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		CacheMiss(indices[ix], insertedAt, time, cacheSize);
+		if (!used[indices[ix]]) {
+			used[indices[ix]] = true;
+			uniqueVertices++;
+		}
+	}
+
+	float transforms = static_cast<float>(time - cacheSize);
+	result.ACMR = transforms / (indexCount / 3);
+	result.ATVR = transforms / uniqueVertices;
+	return result;
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount) {
+	static const ScoreTables scores;
+
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// Build the list of triangles that use each vertex. The first remaining[v] entries of a vertex's
+	// list are the triangles that haven't been emitted yet
+	std::vector<uint32_t> remaining(vertexCount, 0);
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		remaining[indices[ix]]++;
+	}
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		adjacencyOffsets[ix + 1] = adjacencyOffsets[ix] + remaining[ix];
+	}
+	std::vector<uint32_t> adjacency(indexCount);
+	{
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t ix = 0; ix < indexCount; ix++) {
+			adjacency[fill[indices[ix]]++] = static_cast<uint32_t>(ix / 3);
+		}
+	}
+
+	std::vector<int32_t> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		vertexScore[ix] = scores.VertexScore(-1, remaining[ix]);
+	}
+	std::vector<float> triangleScore(triangleCount);
+	for (size_t ix = 0; ix < triangleCount; ix++) {
+		triangleScore[ix] = vertexScore[indices[ix * 3]] + vertexScore[indices[ix * 3 + 1]] + vertexScore[indices[ix * 3 + 2]];
+	}
+	std::vector<bool> emitted(triangleCount, false);
+
+	// Moves a vertex in the cache and pushes the change in it's score out to the triangles that still need it
+	auto updateVertex = [&](uint32_t vertex, int32_t position) {
+		cachePosition[vertex] = position;
+		float score = scores.VertexScore(position, remaining[vertex]);
+		float delta = score - vertexScore[vertex];
+		vertexScore[vertex] = score;
+		const uint32_t* triangles = adjacency.data() + adjacencyOffsets[vertex];
+		for (uint32_t ix = 0; ix < remaining[vertex]; ix++) {
+			triangleScore[triangles[ix]] += delta;
+		}
+	};
+
+	std::vector<uint32_t> output;
+	output.reserve(indexCount);
+
+	// The cache has room for an extra triangle, so we can push one in before evicting anything
+	uint32_t cache[CACHE_SIZE + 3];
+	uint32_t newCache[CACHE_SIZE + 3];
+	uint32_t cacheCount = 0;
+
+	size_t cursor = 0;
+	int64_t best = -1;
+	for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+		// If nothing in the cache has triangles left, carry on with the next triangle in the original order
+		if (best < 0) {
+			while (emitted[cursor]) {
+				cursor++;
+			}
+			best = static_cast<int64_t>(cursor);
+		}
+
+		const uint32_t* triangle = indices + best * 3;
+		output.insert(output.end(), triangle, triangle + 3);
+		emitted[best] = true;
+
+		// Remove the triangle from it's vertices' lists of remaining triangles
+		for (int corner = 0; corner < 3; corner++) {
+			uint32_t vertex = triangle[corner];
+			uint32_t* triangles = adjacency.data() + adjacencyOffsets[vertex];
+			for (uint32_t ix = 0; ix < remaining[vertex]; ix++) {
+				if (triangles[ix] == best) {
+					triangles[ix] = triangles[remaining[vertex] - 1];
+					remaining[vertex]--;
+					break;
+				}
+			}
+		}
+
+		// Push the triangle's vertices to the front of the cache, followed by everything else that was in it
+		uint32_t newCount = 0;
+		for (int corner = 0; corner < 3; corner++) {
+			if (std::find(newCache, newCache + newCount, triangle[corner]) == newCache + newCount) {
+				newCache[newCount++] = triangle[corner];
+			}
+		}
+		for (uint32_t ix = 0; ix < cacheCount; ix++) {
+			if (cache[ix] != triangle[0] && cache[ix] != triangle[1] && cache[ix] != triangle[2]) {
+				newCache[newCount++] = cache[ix];
+			}
+		}
+
+		// Anything pushed past the end falls out of the cache
+		for (uint32_t ix = CACHE_SIZE; ix < newCount; ix++) {
+			updateVertex(newCache[ix], -1);
+		}
+		cacheCount = std::min(newCount, CACHE_SIZE);
+		memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+
+		// Rescore the cached vertices, then find the best triangle that uses one of them
+		for (uint32_t ix = 0; ix < cacheCount; ix++) {
+			updateVertex(cache[ix], static_cast<int32_t>(ix));
+		}
+		best = -1;
+		float bestScore = -FLT_MAX;
+		for (uint32_t ix = 0; ix < cacheCount; ix++) {
+			uint32_t vertex = cache[ix];
+			const uint32_t* triangles = adjacency.data() + adjacencyOffsets[vertex];
+			for (uint32_t jx = 0; jx < remaining[vertex]; jx++) {
+				if (triangleScore[triangles[jx]] > bestScore) {
+					bestScore = triangleScore[triangles[jx]];
+					best = triangles[jx];
+				}
+			}
+		}
+	}
+
+	memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+void MeshOptimizer::OptimizeOverdraw(uint32_t* indices, size_t indexCount, const glm::vec3* positions, size_t vertexCount, float threshold) {
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	std::vector<uint32_t> insertedAt(vertexCount, 0);
+	uint32_t time = CACHE_SIZE;
+
+	// Hard boundaries are where a triangle misses on all 3 vertices, which usually means the cache
+	// optimizer has moved on to a new patch of the mesh, so we can split there for free
+	std::vector<size_t> hardClusters;
+	for (size_t ix = 0; ix < triangleCount; ix++) {
+		if (TriangleMisses(indices + ix * 3, insertedAt, time, CACHE_SIZE) == 3 || ix == 0) {
+			hardClusters.push_back(ix);
+		}
+	}
+	hardClusters.push_back(triangleCount);
+
+	// Split the hard clusters up further, as long as each piece stays within threshold of the whole
+	// cluster's ACMR. Smaller clusters sort better, but each split flushes the cache
+	std::vector<size_t> clusters;
+	for (size_t cx = 0; cx + 1 < hardClusters.size(); cx++) {
+		size_t start = hardClusters[cx];
+		size_t end = hardClusters[cx + 1];
+
+		time += CACHE_SIZE;
+		uint32_t clusterMisses = 0;
+		for (size_t ix = start; ix < end; ix++) {
+			clusterMisses += TriangleMisses(indices + ix * 3, insertedAt, time, CACHE_SIZE);
+		}
+		float clusterThreshold = threshold * clusterMisses / (end - start);
+
+		time += CACHE_SIZE;
+		clusters.push_back(start);
+		uint32_t runningMisses = 0;
+		uint32_t runningTriangles = 0;
+		for (size_t ix = start; ix < end; ix++) {
+			runningMisses += TriangleMisses(indices + ix * 3, insertedAt, time, CACHE_SIZE);
+			runningTriangles++;
+			if (static_cast<float>(runningMisses) / runningTriangles <= clusterThreshold && ix + 1 < end) {
+				clusters.push_back(ix + 1);
+				time += CACHE_SIZE;
+				runningMisses = 0;
+				runningTriangles = 0;
+			}
+		}
+	}
+	clusters.push_back(triangleCount);
+
+	glm::vec3 meshCentroid = glm::vec3(0.0f);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		meshCentroid += positions[ix];
+	}
+	meshCentroid /= static_cast<float>(std::max<size_t>(vertexCount, 1));
+
+	// Clusters that face away from the middle of the mesh are likely to be in front of the rest,
+	// so we sort by how far out along it's normal each cluster sits and draw the furthest out first
+	size_t clusterCount = clusters.size() - 1;
+	std::vector<float> sortKeys(clusterCount);
+	for (size_t cx = 0; cx < clusterCount; cx++) {
+		glm::vec3 centroid = glm::vec3(0.0f);
+		glm::vec3 normal = glm::vec3(0.0f);
+		float area = 0.0f;
+		for (size_t ix = clusters[cx]; ix < clusters[cx + 1]; ix++) {
+			const glm::vec3& a = positions[indices[ix * 3]];
+			const glm::vec3& b = positions[indices[ix * 3 + 1]];
+			const glm::vec3& c = positions[indices[ix * 3 + 2]];
+			// The cross product's length is twice the area, so summing them area weights the normal for us
+			glm::vec3 cross = glm::cross(b - a, c - a);
+			float triangleArea = glm::length(cross) * 0.5f;
+			centroid += (a + b + c) * (triangleArea / 3.0f);
+			normal += cross;
+			area += triangleArea;
+		}
+		float normalLength = glm::length(normal);
+		sortKeys[cx] = area > 0.0f && normalLength > 0.0f ? glm::dot(centroid / area - meshCentroid, normal / normalLength) : -FLT_MAX;
+	}
+
+	std::vector<uint32_t> order(clusterCount);
+	for (size_t cx = 0; cx < clusterCount; cx++) {
+		order[cx] = static_cast<uint32_t>(cx);
+	}
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t left, uint32_t right) {
+		return sortKeys[left] > sortKeys[right];
+	});
+
+	std::vector<uint32_t> output;
+	output.reserve(indexCount);
+	for (uint32_t cx : order) {
+		output.insert(output.end(), indices + clusters[cx] * 3, indices + clusters[cx + 1] * 3);
+	}
+	memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+size_t MeshOptimizer::OptimizeVertexFetch(std::vector<uint32_t>& remap, uint32_t* indices, size_t indexCount, size_t vertexCount) {
+	remap.assign(vertexCount, INVALID_INDEX);
+	uint32_t nextVertex = 0;
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		uint32_t& index = indices[ix];
+		if (remap[index] == INVALID_INDEX) {
+			remap[index] = nextVertex++;
+		}
+		index = remap[index];
+	}
+	return nextVertex;
+}
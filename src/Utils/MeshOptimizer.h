@@ -0,0 +1,142 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Utils/MeshBuilder.h"
+#include "Graphics/VertexParamMap.h"
+
+/// <summary>
+/// Import time optimisations for indexed triangle meshes. Triangles are reordered so the GPU's
+/// post-transform vertex cache gets more hits, then grouped into clusters that are sorted so
+/// outward facing parts of the mesh draw first to reduce overdraw, and finally vertices are
+/// reordered by first use so vertex fetch walks the buffer linearly
+///
+/// These are too slow to run every time a mesh is loaded, they're meant to be baked into
+/// assets when they are converted (see OptimizedObjLoader::ConvertToBinary)
+/// </summary>
+class MeshOptimizer {
+public:
+	/// <summary>
+	/// The size of the vertex cache we optimize for and simulate, most GPUs behave close to a
+	/// FIFO cache of around this size
+	/// </summary>
+	static const uint32_t VERTEX_CACHE_SIZE = 32;
+	/// <summary>
+	/// Marks vertices that are dropped by OptimizeVertexFetch
+	/// </summary>
+	static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+	/// <summary>
+	/// The results of simulating a vertex cache over an index buffer
+	/// </summary>
+	struct VertexCacheStats {
+		// Average cache miss ratio, the number of vertex shader invocations per triangle. 3 is the
+		// worst case, around 0.5 is the best a typical mesh can do
+		float ACMR = 0.0f;
+		// Average transform to vertex ratio, the number of vertex shader invocations per unique
+		// vertex. 1 is ideal
+		float ATVR = 0.0f;
+	};
+
+	/// <summary>
+	/// The vertex cache stats for a mesh before and after optimizing it
+	/// </summary>
+	struct OptimizeResult {
+		VertexCacheStats Before;
+		VertexCacheStats After;
+	};
+
+	MeshOptimizer() = delete;
+
+	/// <summary>
+	/// Simulates a FIFO vertex cache over a triangle list to measure how well it will use the cache
+	/// </summary>
+	/// <param name="indices">The triangle list to analyze</param>
+	/// <param name="indexCount">The number of indices in the list</param>
+	/// <param name="vertexCount">The number of vertices the indices refer to</param>
+	/// <param name="cacheSize">The number of entries in the simulated cache</param>
+	static VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+	/// <summary>
+	/// Reorders the triangles in a triangle list to improve vertex cache hits, using Tom Forsyth's
+	/// linear-speed vertex cache optimisation
+	/// </summary>
+	/// <param name="indices">The triangle list to reorder in place</param>
+	/// <param name="indexCount">The number of indices in the list, must be a multiple of 3</param>
+	/// <param name="vertexCount">The number of vertices the indices refer to</param>
+	static void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	/// <summary>
+	/// Reorders clusters of triangles to reduce overdraw, using the approach from Sander et al's
+	/// "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw". Should be run after
+	/// OptimizeVertexCache, since clusters are found by looking at where the cache gets flushed
+	/// </summary>
+	/// <param name="indices">The triangle list to reorder in place</param>
+	/// <param name="indexCount">The number of indices in the list, must be a multiple of 3</param>
+	/// <param name="positions">The positions of the vertices</param>
+	/// <param name="vertexCount">The number of vertices in positions</param>
+	/// <param name="threshold">How much we're allowed to make the ACMR worse to get smaller clusters, 1.05 allows 5%</param>
+	static void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const glm::vec3* positions, size_t vertexCount, float threshold = 1.05f);
+
+	/// <summary>
+	/// Generates a remapping that orders vertices by when they are first used by a triangle list,
+	/// and applies it to the indices. Vertices that are never used are dropped
+	/// </summary>
+	/// <param name="remap">Will be filled with the new index for each vertex, or INVALID_INDEX if it is unused</param>
+	/// <param name="indices">The triangle list to remap in place</param>
+	/// <param name="indexCount">The number of indices in the list</param>
+	/// <param name="vertexCount">The number of vertices the indices refer to</param>
+	/// <returns>The number of vertices remaining after the remap</returns>
+	static size_t OptimizeVertexFetch(std::vector<uint32_t>& remap, uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	/// <summary>
+	/// Runs all of the optimisations on a mesh, the mesh must have indices
+	/// </summary>
+	/// <typeparam name="VertexType">The type of vertex the mesh is using</typeparam>
+	/// <param name="mesh">The mesh to optimize in place</param>
+	/// <param name="overdrawThreshold">See OptimizeOverdraw</param>
+	/// <returns>The vertex cache stats from before and after the optimisation</returns>
+	template <typename VertexType>
+	static OptimizeResult Optimize(MeshBuilder<VertexType>& mesh, float overdrawThreshold = 1.05f);
+};
+
+template <typename VertexType>
+MeshOptimizer::OptimizeResult MeshOptimizer::Optimize(MeshBuilder<VertexType>& mesh, float overdrawThreshold) {
+	OptimizeResult result;
+
+	std::vector<uint32_t>& indices = mesh._indices;
+	std::vector<VertexType>& vertices = mesh._vertices;
+	// Nothing to do for meshes that aren't indexed triangle lists
+	if (indices.size() < 3 || indices.size() % 3 != 0) {
+		return result;
+	}
+
+	result.Before = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+
+	OptimizeVertexCache(indices.data(), indices.size(), vertices.size());
+
+	// Overdraw sorting only needs the positions
+	VertexParamMap vMap = VertexParamMap(VertexType::V_DECL);
+	std::vector<glm::vec3> positions;
+	positions.resize(vertices.size());
+	for (size_t ix = 0; ix < vertices.size(); ix++) {
+		positions[ix] = vMap.GetPosition(vertices[ix]);
+	}
+	OptimizeOverdraw(indices.data(), indices.size(), positions.data(), positions.size(), overdrawThreshold);
+
+	// Move the vertices into the order they're fetched in
+	std::vector<uint32_t> remap;
+	size_t newVertexCount = OptimizeVertexFetch(remap, indices.data(), indices.size(), vertices.size());
+	std::vector<VertexType> reordered;
+	reordered.resize(newVertexCount);
+	for (size_t ix = 0; ix < vertices.size(); ix++) {
+		if (remap[ix] != INVALID_INDEX) {
+			reordered[remap[ix]] = vertices[ix];
+		}
+	}
+	vertices.swap(reordered);
+
+	result.After = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+	return result;
+}
@@ -0,0 +1,96 @@
+#include "Utils/ObjLoaderBenchmark.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <vector>
+#include <GLFW/glfw3.h>
+#include <Logging.h>
+
+#include "Utils/ObjLoader.h"
+#include "Utils/OptimizedObjLoader.h"
+#include "Utils/FastObjLoader.h"
+#include "Utils/StringUtils.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+	struct Timing {
+		double Best = 0.0;
+		double Average = 0.0;
+	};
+
+	// Runs func the given number of times, returning the best and average times in milliseconds
+	Timing Measure(uint32_t iterations, const std::function<void()>& func) {
+		Timing result;
+		result.Best = std::numeric_limits<double>::max();
+		for (uint32_t ix = 0; ix < iterations; ix++) {
+			double start = glfwGetTime();
+			func();
+			double elapsed = (glfwGetTime() - start) * 1000.0;
+			result.Best = std::min(result.Best, elapsed);
+			result.Average += elapsed;
+		}
+		result.Average /= iterations;
+		return result;
+	}
+}
+
+void ObjLoaderBenchmark::Run(const std::string& directory, uint32_t iterations) {
+	std::vector<fs::path> files;
+	for (const auto& entry : fs::directory_iterator(directory)) {
+		std::string extension = entry.path().extension().string();
+		StringTools::ToLower(extension);
+		if (entry.is_regular_file() && extension == ".obj") {
+			files.push_back(entry.path());
+		}
+	}
+	std::sort(files.begin(), files.end());
+
+	if (files.empty()) {
+		LOG_WARN("No OBJ files found in \"{}\" to benchmark", directory);
+		return;
+	}
+
+	LOG_INFO("Benchmarking OBJ loaders on {} files, {} iterations each (best / average ms)", files.size(), iterations);
+	LOG_INFO("{:<16} {:>10} {:>21} {:>21} {:>21} {:>21} {:>8}", "File", "Size (KB)", "ObjLoader", "OptimizedObjLoader", "FastObjLoader", "FastObjLoader Parse", "Speedup");
+
+	double totalLegacy = 0.0, totalFast = 0.0;
+	for (const fs::path& path : files) {
+		std::string filename = path.string();
+
+		// Every loader reads the same file, warm it up so the first one doesn't pay for the disk
+		FastObjLoader::ParsedObj warmup;
+		FastObjLoader::Parse(filename, warmup);
+
+		Timing legacy = Measure(iterations, [&]() {
+			ObjLoader::LoadFromFile(filename);
+		});
+		Timing optimized = Measure(iterations, [&]() {
+			MeshBuilder<VertexPosNormTexColTangents>* mesh = OptimizedObjLoader::_LoadFromObjFile(filename);
+			mesh->Bake();
+			delete mesh;
+		});
+		Timing fast = Measure(iterations, [&]() {
+			FastObjLoader::LoadFromFile(filename);
+		});
+		Timing parse = Measure(iterations, [&]() {
+			FastObjLoader::ParsedObj data;
+			FastObjLoader::Parse(filename, data);
+		});
+
+		totalLegacy += legacy.Best;
+		totalFast += fast.Best;
+
+		LOG_INFO("{:<16} {:>10} {:>9.2f} / {:>9.2f} {:>9.2f} / {:>9.2f} {:>9.2f} / {:>9.2f} {:>9.2f} / {:>9.2f} {:>7.2f}x",
+			path.filename().string(), fs::file_size(path) / 1024,
+			legacy.Best, legacy.Average,
+			optimized.Best, optimized.Average,
+			fast.Best, fast.Average,
+			parse.Best, parse.Average,
+			legacy.Best / std::max(fast.Best, 0.001));
+	}
+
+	LOG_INFO("Total best times: ObjLoader {:.2f}ms, FastObjLoader {:.2f}ms ({:.2f}x)", totalLegacy, totalFast, totalLegacy / std::max(totalFast, 0.001));
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Times ObjLoader, OptimizedObjLoader and FastObjLoader against each other on every OBJ file in
+/// a directory, and logs the results. Each loader goes from the file on disk to a VAO with
+/// tangents, so the numbers include everything a scene load would pay for. Requires an active
+/// GL context, run it with --benchmark-obj
+/// </summary>
+class ObjLoaderBenchmark {
+public:
+	ObjLoaderBenchmark() = delete;
+
+	/// <summary>
+	/// Runs the benchmark on all the OBJ files in a directory
+	/// </summary>
+	/// <param name="directory">The directory to search for .obj files, not recursive</param>
+	/// <param name="iterations">The number of times to load each file with each loader</param>
+	static void Run(const std::string& directory, uint32_t iterations);
+};
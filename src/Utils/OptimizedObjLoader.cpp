@@ -7,8 +7,18 @@
 #include <fstream>
 #include <iostream>
 #include <filesystem>
+#include <cfloat>
+#include <cstring>
+#include <GLM/packing.hpp>
+#include <GLM/gtc/packing.hpp>
 
+#include "Graphics/BoundingVolume.h"
 #include "Utils/StringUtils.h"
+#include "Utils/FastObjLoader.h"
+#include "Utils/MeshOptimizer.h"
+#include "Utils/MappedFile.h"
+#include "Utils/BlockCompression.h"
+#include "Utils/ResourceManager/DerivedDataCache.h"
 #include "GLFW/glfw3.h"
 #include "Logging.h"
 
@@ -17,7 +27,63 @@ const std::string binaryExtension = ".bin";
 
 namespace fs = std::filesystem;
 
-VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& filename) {
+namespace {
+	// Half floats keep 10 bits of mantissa, so the step between values doubles with each power of two. In
+	// [0.5, 1] the step is 2^-11, under half a texel on a 1024 texture, but in [1, 2] it is already 2^-10,
+	// a whole texel, so we only use halves for UVs that stay within [-1, 1]
+	const float MAX_HALF_UV = 1.0f;
+
+	// Gets the value of an attribute from a vertex, padded out to a vec4
+	glm::vec4 GetAttributeValue(const VertexPosNormTexColTangents& vertex, AttribUsage usage) {
+		switch (usage) {
+			case AttribUsage::Position:  return glm::vec4(vertex.Position, 1.0f);
+			case AttribUsage::Normal:    return glm::vec4(vertex.Normal, 0.0f);
+			case AttribUsage::Texture:   return glm::vec4(vertex.UV, 0.0f, 0.0f);
+			case AttribUsage::Color:     return vertex.Color;
+			case AttribUsage::Tangent:   return glm::vec4(vertex.Tangent, 0.0f);
+			case AttribUsage::BiTangent: return glm::vec4(vertex.BiTangent, 0.0f);
+			default:                     return glm::vec4(0.0f);
+		}
+	}
+
+	// Writes a value into the output in the format given by the attribute
+	void EncodeAttribute(const BufferAttribute& attrib, const glm::vec4& value, uint8_t* output) {
+		switch (attrib.Type) {
+			case AttributeType::Half:
+				for (int ix = 0; ix < attrib.Size; ix++) {
+					uint16_t half = glm::packHalf1x16(value[ix]);
+					memcpy(output + ix * sizeof(uint16_t), &half, sizeof(uint16_t));
+				}
+				break;
+			case AttributeType::Int2_10_10_10_Rev:
+			{
+				// Only directions get packed, so we normalize to make the most of our 10 bits
+				glm::vec3 direction = glm::vec3(value);
+				float length = glm::length(direction);
+				direction = length > 0.0f ? direction / length : direction;
+				uint32_t packed = glm::packSnorm3x10_1x2(glm::vec4(direction, 0.0f));
+				memcpy(output, &packed, sizeof(uint32_t));
+				break;
+			}
+			case AttributeType::UByte:
+			{
+				uint32_t packed = glm::packUnorm4x8(value);
+				memcpy(output, &packed, attrib.Size);
+				break;
+			}
+			case AttributeType::Float:
+			default:
+				memcpy(output, &value[0], attrib.Size * sizeof(float));
+				break;
+		}
+	}
+
+	uint64_t AlignSection(uint64_t offset, uint64_t alignment) {
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& filename, MeshTables* tables) {
 	// Get the file extension and lowercase it
 	fs::path filePath = std::filesystem::path(filename);
 	std::string extension = filePath.extension().string();
@@ -25,18 +91,31 @@ VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& file
 
 	// Load regular 'ol OBJ files
 	if (extension == ".obj") {
-		// Get the binary path
-		fs::path binPath = filePath.replace_extension(binaryExtension);
-		// If the file does not exist, convert the OBJ file to a binary file
-		if (!fs::exists(binPath)) {
+		// Converted meshes live in the derived data cache, keyed on the OBJ's contents so edits are always picked up
+		DerivedDataCache::Key key;
+		if (DerivedDataCache::MakeKey(filename, "mesh", IMPORTER_VERSION, "", key)) {
+			bool cached = DerivedDataCache::Contains(key);
+			if (!cached) {
+				std::string tempPath = DerivedDataCache::GetTempPath(key);
+				ConvertToBinary(filename, tempPath);
+				cached = DerivedDataCache::StoreFile(key, tempPath);
+			}
+			if (cached) {
+				return _LoadFromBinFile(DerivedDataCache::GetEntryPath(key), tables);
+			}
+		}
+
+		// Without the cache we fall back to a binary file next to the OBJ, rebuilding it if the OBJ has changed since
+		fs::path binPath = fs::path(filename).replace_extension(binaryExtension);
+		if (!fs::exists(binPath) || fs::last_write_time(binPath) < fs::last_write_time(filePath)) {
 			ConvertToBinary(filename, binPath.string());
 		}
 		// Load the corresponding binary file
-		return _LoadFromBinFile(binPath.string());
+		return _LoadFromBinFile(binPath.string(), tables);
 	} 
 	// Load our fancy binary files
 	else if (extension == ".bin") {
-		return _LoadFromBinFile(filename);
+		return _LoadFromBinFile(filename, tables);
 	}
 	// We've never met this extension in our life
 	else {
@@ -45,9 +124,22 @@ VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& file
 	}
 }
 
-void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::string& outFile) {
-	// Load in the input file
-	MeshBuilder<VertexPosNormTexColTangents>* mesh = _LoadFromObjFile(inFile);
+void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::string& outFile, const BinaryOptions& options) {
+	// Load in the input file, conversion is a one time cost so we use the fast parser rather than _LoadFromObjFile
+	FastObjLoader::ParsedObj data;
+	if (!FastObjLoader::Parse(inFile, data)) {
+		throw std::runtime_error("Failed to open file");
+	}
+	MeshBuilder<VertexPosNormTexColTangents> mesh;
+	FastObjLoader::BuildMesh(data, mesh);
+	MeshFactory::CalculateTBN(mesh);
+
+	// Bake the vertex cache and overdraw optimisations into the file, and report the gain so it can be tracked per asset
+	if (options.OptimizeMesh) {
+		MeshOptimizer::OptimizeResult stats = MeshOptimizer::Optimize(mesh, options.OverdrawThreshold);
+		LOG_INFO("Optimized \"{}\": ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", inFile, 
+			stats.Before.ACMR, stats.After.ACMR, stats.Before.ATVR, stats.After.ATVR);
+	}
 
 	float startTime = static_cast<float>(glfwGetTime());
 
@@ -63,13 +155,206 @@ void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::s
 	}
 
 	// Save the mesh to the file
-	SaveBinaryFile(*mesh, outFileName);
+	SaveBinaryFileV2(mesh, outFileName, options);
 
 	float endTime = static_cast<float>(glfwGetTime());
-	LOG_TRACE("Converted OBJ file to binary \"{}\" in {} seconds ({} vertices, {} indices)", inFile, endTime - startTime, mesh->GetVertexCount(), mesh->GetIndexCount());
+	LOG_TRACE("Converted OBJ file to binary \"{}\" in {} seconds ({} vertices, {} indices)", inFile, endTime - startTime, mesh.GetVertexCount(), mesh.GetIndexCount());
+}
+
+void OptimizedObjLoader::SaveBinaryFileV2(const MeshBuilder<VertexPosNormTexColTangents>& mesh, const std::string& outFilename, const BinaryOptions& options) {
+	// Open the output file
+	std::ofstream file(outFilename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open output file");
+	}
+
+	const VertexPosNormTexColTangents* vertices = mesh.GetVertexDataPtr();
+	uint32_t vertexCount = static_cast<uint32_t>(mesh.GetVertexCount());
+	uint32_t indexCount  = static_cast<uint32_t>(mesh.GetIndexCount());
+
+	// Work out which streams we can quantize without a visible loss, and grab our bounds while we're here
+	bool halfUVs = options.QuantizeUVs;
+	bool byteColors = options.QuantizeColors;
+	glm::vec3 boundsMin = glm::vec3(vertexCount > 0 ? FLT_MAX : 0.0f);
+	glm::vec3 boundsMax = glm::vec3(vertexCount > 0 ? -FLT_MAX : 0.0f);
+	for (uint32_t ix = 0; ix < vertexCount; ix++) {
+		const VertexPosNormTexColTangents& vertex = vertices[ix];
+		halfUVs = halfUVs && glm::abs(vertex.UV.x) <= MAX_HALF_UV && glm::abs(vertex.UV.y) <= MAX_HALF_UV;
+		byteColors = byteColors && glm::all(glm::greaterThanEqual(vertex.Color, glm::vec4(0.0f))) && glm::all(glm::lessThanEqual(vertex.Color, glm::vec4(1.0f)));
+		boundsMin = glm::min(boundsMin, vertex.Position);
+		boundsMax = glm::max(boundsMax, vertex.Position);
+	}
+
+	// Build our vertex declaration, we keep the slots from VertexPosNormTexColTangents so shaders work with either
+	std::vector<BufferAttribute> attributes;
+	uint32_t stride = 0;
+	auto addAttribute = [&](uint32_t slot, uint32_t size, AttributeType type, uint32_t bytes, AttribUsage usage, bool normalized) {
+		attributes.push_back(BufferAttribute(slot, size, type, 0, static_cast<GLsizei>(stride), usage, normalized));
+		stride += bytes;
+	};
+	addAttribute(0, 3, AttributeType::Float, sizeof(glm::vec3), AttribUsage::Position, false);
+	if (options.QuantizeNormals) {
+		addAttribute(2, 4, AttributeType::Int2_10_10_10_Rev, sizeof(uint32_t), AttribUsage::Normal,    true);
+		addAttribute(4, 4, AttributeType::Int2_10_10_10_Rev, sizeof(uint32_t), AttribUsage::Tangent,   true);
+		addAttribute(5, 4, AttributeType::Int2_10_10_10_Rev, sizeof(uint32_t), AttribUsage::BiTangent, true);
+	} else {
+		addAttribute(2, 3, AttributeType::Float, sizeof(glm::vec3), AttribUsage::Normal,    false);
+		addAttribute(4, 3, AttributeType::Float, sizeof(glm::vec3), AttribUsage::Tangent,   false);
+		addAttribute(5, 3, AttributeType::Float, sizeof(glm::vec3), AttribUsage::BiTangent, false);
+	}
+	if (halfUVs) {
+		addAttribute(3, 2, AttributeType::Half, sizeof(uint16_t) * 2, AttribUsage::Texture, false);
+	} else {
+		addAttribute(3, 2, AttributeType::Float, sizeof(glm::vec2), AttribUsage::Texture, false);
+	}
+	if (byteColors) {
+		addAttribute(1, 4, AttributeType::UByte, sizeof(uint8_t) * 4, AttribUsage::Color, true);
+	} else {
+		addAttribute(1, 4, AttributeType::Float, sizeof(glm::vec4), AttribUsage::Color, false);
+	}
+	for (BufferAttribute& attrib : attributes) {
+		attrib.Stride = static_cast<GLsizei>(stride);
+	}
+
+	// Encode our vertices into the new layout
+	std::vector<uint8_t> vertexData(static_cast<size_t>(vertexCount) * stride);
+	for (uint32_t ix = 0; ix < vertexCount; ix++) {
+		uint8_t* output = vertexData.data() + static_cast<size_t>(ix) * stride;
+		for (const BufferAttribute& attrib : attributes) {
+			EncodeAttribute(attrib, GetAttributeValue(vertices[ix], attrib.Usage), output + attrib.Offset);
+		}
+	}
+
+	// Use 16 bit indices if every vertex can be reached by one
+	IndexType indexType = options.AllowShortIndices && vertexCount <= 65536 ? IndexType::UShort : IndexType::UInt;
+	std::vector<uint16_t> shortIndices;
+	if (indexType == IndexType::UShort) {
+		shortIndices.assign(mesh.GetIndexDataPtr(), mesh.GetIndexDataPtr() + indexCount);
+	}
+
+	// For now OBJ files only give us a single submesh covering the whole mesh
+	MeshTables tables;
+	tables.Submeshes.push_back({ 0, indexCount, boundsMin, boundsMax });
+	if (options.BuildMeshlets && indexCount > 0) {
+		_BuildMeshlets(mesh, tables);
+	}
+
+	// Gather up the raw contents of each section
+	struct SectionData {
+		const uint8_t*       Data;
+		size_t               Size;
+		std::vector<uint8_t> Compressed;
+	};
+	SectionData sections[SectionCount];
+	sections[SectionAttributes]       = { reinterpret_cast<const uint8_t*>(attributes.data()), attributes.size() * sizeof(BufferAttribute) };
+	sections[SectionVertices]         = { vertexData.data(), vertexData.size() };
+	sections[SectionIndices]          = indexType == IndexType::UShort ?
+		SectionData{ reinterpret_cast<const uint8_t*>(shortIndices.data()), shortIndices.size() * sizeof(uint16_t) } :
+		SectionData{ reinterpret_cast<const uint8_t*>(mesh.GetIndexDataPtr()), indexCount * sizeof(uint32_t) };
+	sections[SectionSubmeshes]        = { reinterpret_cast<const uint8_t*>(tables.Submeshes.data()), tables.Submeshes.size() * sizeof(Submesh) };
+	sections[SectionMeshlets]         = { reinterpret_cast<const uint8_t*>(tables.Meshlets.data()), tables.Meshlets.size() * sizeof(Meshlet) };
+	sections[SectionMeshletVertices]  = { reinterpret_cast<const uint8_t*>(tables.MeshletVertices.data()), tables.MeshletVertices.size() * sizeof(uint32_t) };
+	sections[SectionMeshletTriangles] = { tables.MeshletTriangles.data(), tables.MeshletTriangles.size() };
+
+	// Fill out the header, laying out each section on an aligned offset
+	BinaryHeaderV2 header = BinaryHeaderV2();
+	header.NumVertices   = vertexCount;
+	header.NumIndices    = indexCount;
+	header.IndicesType   = indexType;
+	header.VertexStride  = static_cast<uint16_t>(stride);
+	header.NumAttributes = static_cast<uint16_t>(attributes.size());
+	header.NumSubmeshes  = static_cast<uint32_t>(tables.Submeshes.size());
+	header.NumMeshlets   = static_cast<uint32_t>(tables.Meshlets.size());
+
+	uint64_t offset = AlignSection(sizeof(BinaryHeaderV2), SECTION_ALIGNMENT);
+	for (int ix = 0; ix < SectionCount; ix++) {
+		SectionData& section = sections[ix];
+		BinarySection& entry = header.Sections[ix];
+		entry.Offset  = offset;
+		entry.RawSize = section.Size;
+		entry.Size    = section.Size;
+
+		// Only keep the compressed data if it actually saved us something
+		if (options.Compress && section.Size > 0) {
+			BlockCompression::Compress(section.Data, section.Size, section.Compressed);
+			if (section.Compressed.size() < section.Size) {
+				entry.Size = section.Compressed.size();
+				entry.Compression = 1;
+				section.Data = section.Compressed.data();
+			}
+		}
+
+		offset = AlignSection(offset + entry.Size, SECTION_ALIGNMENT);
+	}
 
-	// We no longer need the mesh data, free it
-	delete mesh;
+	// Write the header, then each section with padding between them
+	file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeaderV2));
+	uint64_t written = sizeof(BinaryHeaderV2);
+	const char padding[SECTION_ALIGNMENT] = { 0 };
+	for (int ix = 0; ix < SectionCount; ix++) {
+		file.write(padding, header.Sections[ix].Offset - written);
+		file.write(reinterpret_cast<const char*>(sections[ix].Data), header.Sections[ix].Size);
+		written = header.Sections[ix].Offset + header.Sections[ix].Size;
+	}
+}
+
+void OptimizedObjLoader::_BuildMeshlets(const MeshBuilder<VertexPosNormTexColTangents>& mesh, MeshTables& tables) {
+	const VertexPosNormTexColTangents* vertices = mesh.GetVertexDataPtr();
+	const uint32_t* indices = mesh.GetIndexDataPtr();
+	size_t indexCount = mesh.GetIndexCount();
+
+	// Where each vertex sits in the meshlet we're building, or 0xFF if it's not in it
+	const uint8_t NOT_IN_MESHLET = 0xFF;
+	std::vector<uint8_t> localIndex(mesh.GetVertexCount(), NOT_IN_MESHLET);
+
+	Meshlet current = Meshlet();
+	auto finishMeshlet = [&]() {
+		if (current.TriangleCount == 0) {
+			return;
+		}
+
+		// A sphere around the meshlet's bounding box, it's not the tightest fit but it's cheap and close
+		glm::vec3 min = glm::vec3(FLT_MAX), max = glm::vec3(-FLT_MAX);
+		for (uint32_t ix = 0; ix < current.VertexCount; ix++) {
+			uint32_t vertex = tables.MeshletVertices[current.VertexOffset + ix];
+			min = glm::min(min, vertices[vertex].Position);
+			max = glm::max(max, vertices[vertex].Position);
+			localIndex[vertex] = NOT_IN_MESHLET;
+		}
+		current.Center = (min + max) * 0.5f;
+		current.Radius = 0.0f;
+		for (uint32_t ix = 0; ix < current.VertexCount; ix++) {
+			uint32_t vertex = tables.MeshletVertices[current.VertexOffset + ix];
+			current.Radius = glm::max(current.Radius, glm::length(vertices[vertex].Position - current.Center));
+		}
+		tables.Meshlets.push_back(current);
+
+		current = Meshlet();
+		current.VertexOffset = static_cast<uint32_t>(tables.MeshletVertices.size());
+		current.TriangleOffset = static_cast<uint32_t>(tables.MeshletTriangles.size() / 3);
+	};
+
+	// Greedily fill meshlets in index order, so they benefit from whatever locality the index buffer already has
+	for (size_t ix = 0; ix + 2 < indexCount; ix += 3) {
+		uint32_t a = indices[ix], b = indices[ix + 1], c = indices[ix + 2];
+		uint32_t newVertices =
+			(localIndex[a] == NOT_IN_MESHLET) +
+			(localIndex[b] == NOT_IN_MESHLET && b != a) +
+			(localIndex[c] == NOT_IN_MESHLET && c != a && c != b);
+		if (current.VertexCount + newVertices > MESHLET_MAX_VERTICES || current.TriangleCount + 1 > MESHLET_MAX_TRIANGLES) {
+			finishMeshlet();
+		}
+
+		for (uint32_t vertex : { a, b, c }) {
+			if (localIndex[vertex] == NOT_IN_MESHLET) {
+				localIndex[vertex] = static_cast<uint8_t>(current.VertexCount++);
+				tables.MeshletVertices.push_back(vertex);
+			}
+			tables.MeshletTriangles.push_back(localIndex[vertex]);
+		}
+		current.TriangleCount++;
+	}
+	finishMeshlet();
 }
 
 MeshBuilder<VertexPosNormTexColTangents>* OptimizedObjLoader::_LoadFromObjFile(const std::string& filename) {
@@ -233,96 +518,235 @@ MeshBuilder<VertexPosNormTexColTangents>* OptimizedObjLoader::_LoadFromObjFile(c
 	return mesh;
 }
 
-VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFile(const std::string& filename) {
 
-	// Open the output file
-	std::ifstream file(filename, std::ios::binary);
+VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFile(const std::string& filename, MeshTables* tables) {
+	// Map the file into memory, so that sections can be uploaded straight from it
+	MappedFile file;
 	// If our file fails to open, we will throw an error
-	if (!file) { throw std::runtime_error("Failed to open file"); }
+	if (!file.Open(filename)) { throw std::runtime_error("Failed to open file"); }
 
 	float startTime = static_cast<float>(glfwGetTime());
 
-	// Get the file size so we can avoid reading past the end
-	file.seekg(0, std::ios::end);
-	size_t size = file.tellg();
-	file.seekg(0, std::ios::beg);
+	const uint8_t* data = static_cast<const uint8_t*>(file.GetData());
+	size_t size = file.GetSize();
+
+	// Every version starts with the magic bytes followed by the version number
+	if (size < sizeof(HEADER_BYTES) + sizeof(uint16_t)) {
+		LOG_ERROR("Not enough data in the file!");
+		return nullptr;
+	}
+	if (memcmp(data, HEADER_BYTES, sizeof(HEADER_BYTES)) != 0) {
+		LOG_ERROR("\"{}\" is not a binary mesh file", filename);
+		return nullptr;
+	}
+	uint16_t version = 0;
+	memcpy(&version, data + sizeof(HEADER_BYTES), sizeof(uint16_t));
+
+	if (tables != nullptr) {
+		*tables = MeshTables();
+	}
+
+	// Handle our version
+	VertexArrayObject::Sptr result = nullptr;
+	switch (version) {
+		case 0x01:
+			result = _LoadFromBinV1(data, size, tables);
+			break;
+		case 0x02:
+			result = _LoadFromBinV2(data, size, tables);
+			break;
+		default:
+			LOG_ERROR("Unsupported binary mesh version {} in \"{}\"", version, filename);
+			return nullptr;
+	}
+
+	// Calculate and trace out how long it took us to load
+	if (result != nullptr) {
+		float endTime = static_cast<float>(glfwGetTime());
+		LOG_TRACE("Loaded OBJ file \"{}\" (version {}) in {} seconds ({} vertices, {} indices)", filename, version, endTime - startTime, 
+			result->GetVertexCount(), result->GetIndexCount());
+	}
 
+	return result;
+}
+
+VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinV1(const uint8_t* data, size_t size, MeshTables* tables) {
 	// Read the header from the file
 	BinaryHeader header = BinaryHeader();
 	if (size >= sizeof(BinaryHeader)) {
-		file.read(reinterpret_cast<char*>(&header), sizeof(BinaryHeader));
+		memcpy(&header, data, sizeof(BinaryHeader));
 	} else {
 		LOG_ERROR("Not enough data in the file!");
 		return nullptr;
 	}
 
-	// TODO: validate header
+	// Determine how many bytes we need in the file
+	size_t attributeBytes = header.NumAttributes * sizeof(BufferAttribute);
+	size_t vertexBytes = header.VertexStride * (size_t)header.NumVertices;
+	size_t indexBytes = header.NumIndices * GetIndexTypeSize(header.IndicesType);
+	size_t requiredBytes = sizeof(BinaryHeader) + attributeBytes + vertexBytes + indexBytes;
 
-	// Handle our version
-	if (header.Version == 0x01) {
-		// Determine how many bytes we need in the file
-		size_t requiredBytes =
-			sizeof(BinaryHeader) +
-			(header.NumAttributes * sizeof(BufferAttribute)) +
-			(header.VertexStride * (size_t)header.NumVertices) +
-			(header.NumIndices * GetIndexTypeSize(header.IndicesType));
-
-		// Make sure there's enough data in the file
-		if (size < requiredBytes) {
-			LOG_ERROR("Not enough data in the file!");
-			return nullptr;
-		}
-
-		// Read all attributes from the file, this is basically our VDECL
-		std::vector<BufferAttribute> vertexDeclaration;
-		vertexDeclaration.resize(header.NumAttributes);
-		for (int ix = 0; ix < header.NumAttributes; ix++) {
-			file.read(reinterpret_cast<char*>(&vertexDeclaration[ix]), sizeof(BufferAttribute));
-		}
+	// Make sure there's enough data in the file
+	if (size < requiredBytes) {
+		LOG_ERROR("Not enough data in the file!");
+		return nullptr;
+	}
+	const uint8_t* attributeData = data + sizeof(BinaryHeader);
+	const uint8_t* indexData = attributeData + attributeBytes;
+	const uint8_t* vertexData = indexData + indexBytes;
+
+	// Read all attributes from the file, this is basically our VDECL
+	std::vector<BufferAttribute> vertexDeclaration;
+	vertexDeclaration.resize(header.NumAttributes);
+	memcpy(vertexDeclaration.data(), attributeData, attributeBytes);
+
+	// These will have the buffer pointers
+	IndexBuffer::Sptr indices = nullptr;
+	VertexBuffer::Sptr vertices = nullptr;
+
+	// If we have index data, load it straight from the mapped file
+	if (header.NumIndices > 0) {
+		indices = IndexBuffer::Create(BufferUsage::StaticDraw);
+		indices->LoadData(indexData, GetIndexTypeSize(header.IndicesType), header.NumIndices, header.IndicesType);
+	}
 
-		// These will have the buffer pointers
-		IndexBuffer::Sptr indices = nullptr;
-		VertexBuffer::Sptr vertices = nullptr;
-
-		// If we have index data, load it
-		if (header.NumIndices > 0) {
-			// Create index buffer
-			indices = IndexBuffer::Create(BufferUsage::StaticDraw);
-
-			// Create memory to store indices, then read from the file
-			void* dataStore = malloc(header.NumIndices * GetIndexTypeSize(header.IndicesType));
-			file.read(reinterpret_cast<char*>(dataStore), header.NumIndices * GetIndexTypeSize(header.IndicesType));
-			
-			// Load data into OpenGL and free the CPU memory we allocated
-			indices->LoadData(dataStore, GetIndexTypeSize(header.IndicesType), header.NumIndices, header.IndicesType);
-			free(dataStore);
+	// Create a new VBO and load it from the mapped file
+	vertices = VertexBuffer::Create(BufferUsage::StaticDraw);
+	vertices->LoadData(vertexData, header.VertexStride, header.NumVertices);
+
+	// Create the VAO and attach our index and vertex buffers
+	VertexArrayObject::Sptr result = VertexArrayObject::Create();
+	result->SetIndexBuffer(indices);
+	result->AddVertexBuffer(vertices, vertexDeclaration);
+
+	// Copy in the vertex declaration we loaded
+	result->SetVDecl(vertexDeclaration);
+
+	// Version 1 files have no submesh table, so describe the whole mesh as one submesh while the
+	// vertices are still mapped, rather than making callers read them back from the GPU
+	if (tables != nullptr) {
+		Submesh submesh = { 0, header.NumIndices, glm::vec3(0.0f), glm::vec3(0.0f) };
+		for (const BufferAttribute& attrib : vertexDeclaration) {
+			if (attrib.Usage == AttribUsage::Position && attrib.Type == AttributeType::Float && attrib.Size >= 3 && header.NumVertices > 0) {
+				BoundingVolume bounds = BoundingVolume::FromPoints(vertexData + attrib.Offset, header.NumVertices, header.VertexStride);
+				submesh.BoundsMin = bounds.Min;
+				submesh.BoundsMax = bounds.Max;
+				break;
+			}
 		}
+		tables->Submeshes.push_back(submesh);
+	}
 
-		// Create a new VBO
-		vertices = VertexBuffer::Create(BufferUsage::StaticDraw);
+	return result;
+}
 
-		// Create memory to store vertices and load from file
-		void* vertexStore = malloc(header.NumVertices * (size_t)header.VertexStride);
-		file.read(reinterpret_cast<char*>(vertexStore), header.NumVertices * (size_t)header.VertexStride);
+VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinV2(const uint8_t* data, size_t size, MeshTables* tables) {
+	// Read the header from the file
+	BinaryHeaderV2 header = BinaryHeaderV2();
+	if (size >= sizeof(BinaryHeaderV2)) {
+		memcpy(&header, data, sizeof(BinaryHeaderV2));
+	} else {
+		LOG_ERROR("Not enough data in the file!");
+		return nullptr;
+	}
 
-		// Load data into OpenGL and free the CPU copy
-		vertices->LoadData(vertexStore, header.VertexStride, header.NumVertices);
-		free(vertexStore);
+	// The size each section should have once decompressed
+	uint64_t expectedSizes[SectionCount];
+	expectedSizes[SectionAttributes]       = header.NumAttributes * sizeof(BufferAttribute);
+	expectedSizes[SectionVertices]         = header.VertexStride * (uint64_t)header.NumVertices;
+	expectedSizes[SectionIndices]          = header.NumIndices * (uint64_t)GetIndexTypeSize(header.IndicesType);
+	expectedSizes[SectionSubmeshes]        = header.NumSubmeshes * sizeof(Submesh);
+	expectedSizes[SectionMeshlets]         = header.NumMeshlets * sizeof(Meshlet);
+	expectedSizes[SectionMeshletVertices]  = header.Sections[SectionMeshletVertices].RawSize;
+	expectedSizes[SectionMeshletTriangles] = header.Sections[SectionMeshletTriangles].RawSize;
+
+	// Make sure every section is actually in the file before we touch any of them
+	for (int ix = 0; ix < SectionCount; ix++) {
+		const BinarySection& section = header.Sections[ix];
+		bool valid =
+			section.Offset >= sizeof(BinaryHeaderV2) &&
+			section.Offset <= size && section.Size <= size - section.Offset &&
+			section.RawSize == expectedSizes[ix] &&
+			(section.Compression == 1 || (section.Compression == 0 && section.Size == section.RawSize));
+		if (!valid) {
+			LOG_ERROR("Binary mesh section {} is corrupt or truncated!", ix);
+			return nullptr;
+		}
+	}
 
-		// Create the VAO and attach our index and vertex buffers
-		VertexArrayObject::Sptr result = VertexArrayObject::Create();
-		result->SetIndexBuffer(indices);
-		result->AddVertexBuffer(vertices, vertexDeclaration);
+	// Uncompressed sections upload straight from the mapped file, compressed ones are decompressed
+	// directly into the mapped GL buffer, so either way we never make a CPU side copy
+	auto decompressInto = [&](IBuffer& buffer, const BinarySection& section) {
+		uint8_t* target = static_cast<uint8_t*>(buffer.Map(BufferMapMode::Write | BufferMapMode::InvalidateBuffer));
+		bool success = target != nullptr && BlockCompression::Decompress(data + section.Offset, section.Size, target, section.RawSize);
+		buffer.Unmap();
+		return success;
+	};
+	// Small tables are copied out into CPU memory
+	auto readSection = [&](const BinarySection& section, void* output) {
+		if (section.Compression == 0) {
+			memcpy(output, data + section.Offset, section.RawSize);
+			return true;
+		}
+		return BlockCompression::Decompress(data + section.Offset, section.Size, static_cast<uint8_t*>(output), section.RawSize);
+	};
+
+	// Read all attributes from the file, this is basically our VDECL
+	std::vector<BufferAttribute> vertexDeclaration;
+	vertexDeclaration.resize(header.NumAttributes);
+	if (!readSection(header.Sections[SectionAttributes], vertexDeclaration.data())) {
+		LOG_ERROR("Failed to decompress the vertex declaration!");
+		return nullptr;
+	}
 
-		// Copy in the vertex declaration we loaded
-		result->SetVDecl(vertexDeclaration);
+	// These will have the buffer pointers
+	IndexBuffer::Sptr indices = nullptr;
+	VertexBuffer::Sptr vertices = nullptr;
+
+	// If we have index data, load it
+	if (header.NumIndices > 0) {
+		const BinarySection& section = header.Sections[SectionIndices];
+		indices = IndexBuffer::Create(BufferUsage::StaticDraw);
+		indices->LoadData(section.Compression == 0 ? data + section.Offset : nullptr, GetIndexTypeSize(header.IndicesType), header.NumIndices, header.IndicesType);
+		if (section.Compression != 0 && !decompressInto(*indices, section)) {
+			LOG_ERROR("Failed to decompress the index data!");
+			return nullptr;
+		}
+	}
 
-		// Calculate and trace out how long it took us to load
-		float endTime = static_cast<float>(glfwGetTime());
-		LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, header.NumVertices, header.NumIndices);
+	// Create a new VBO and load our vertices
+	const BinarySection& vertexSection = header.Sections[SectionVertices];
+	vertices = VertexBuffer::Create(BufferUsage::StaticDraw);
+	vertices->LoadData(vertexSection.Compression == 0 ? data + vertexSection.Offset : nullptr, header.VertexStride, header.NumVertices);
+	if (vertexSection.Compression != 0 && !decompressInto(*vertices, vertexSection)) {
+		LOG_ERROR("Failed to decompress the vertex data!");
+		return nullptr;
+	}
 
-		return result;
+	// Read out the submesh and meshlet tables if the caller wants them
+	if (tables != nullptr) {
+		tables->Submeshes.resize(header.NumSubmeshes);
+		tables->Meshlets.resize(header.NumMeshlets);
+		tables->MeshletVertices.resize(header.Sections[SectionMeshletVertices].RawSize / sizeof(uint32_t));
+		tables->MeshletTriangles.resize(header.Sections[SectionMeshletTriangles].RawSize);
+		bool success =
+			readSection(header.Sections[SectionSubmeshes], tables->Submeshes.data()) &&
+			readSection(header.Sections[SectionMeshlets], tables->Meshlets.data()) &&
+			readSection(header.Sections[SectionMeshletVertices], tables->MeshletVertices.data()) &&
+			readSection(header.Sections[SectionMeshletTriangles], tables->MeshletTriangles.data());
+		if (!success) {
+			LOG_WARN("Failed to decompress the mesh tables, they will be left empty");
+			*tables = MeshTables();
+		}
 	}
 
-	return nullptr;
+	// Create the VAO and attach our index and vertex buffers
+	VertexArrayObject::Sptr result = VertexArrayObject::Create();
+	result->SetIndexBuffer(indices);
+	result->AddVertexBuffer(vertices, vertexDeclaration);
+
+	// Copy in the vertex declaration we loaded
+	result->SetVDecl(vertexDeclaration);
+
+	return result;
 }
@@ -7,6 +7,8 @@
  */
 #pragma once
 #include <fstream>
+#include <vector>
+#include <GLM/glm.hpp>
 
 #include "Graphics/VertexArrayObject.h"
 #include "Graphics/VertexTypes.h"
@@ -20,29 +22,115 @@
 class OptimizedObjLoader {
 public:
 	/// <summary>
-	/// Loads a VAO from an OBJ file. On the first time this is called for an OBJ file, will convert the OBJ file 
-	/// to a binary file and load that instead. On subsequent runs, the binary file will be loaded instead
+	/// The most vertices and triangles we will put in a single meshlet, these match the limits
+	/// most hardware prefers for mesh shading and cluster culling
+	/// </summary>
+	static const uint32_t MESHLET_MAX_VERTICES = 64;
+	static const uint32_t MESHLET_MAX_TRIANGLES = 124;
+	/// <summary>
+	/// The version of the meshes that ConvertToBinary produces, bump this whenever that changes so that
+	/// meshes in the derived data cache get converted again
+	/// </summary>
+	static const uint32_t IMPORTER_VERSION = 2;
+
+	/// <summary>
+	/// Controls how meshes are stored when writing version 2 binary files
+	/// </summary>
+	struct BinaryOptions {
+		// Packs normals, tangents and bitangents into signed 10:10:10:2 integers
+		bool QuantizeNormals = true;
+		// Stores UVs as half floats, when they are in a range where that doesn't cost precision
+		bool QuantizeUVs = true;
+		// Stores colors as 8 bit normalized values, when they are in the [0, 1] range
+		bool QuantizeColors = true;
+		// Uses 16 bit indices when the mesh has few enough vertices
+		bool AllowShortIndices = true;
+		// Compresses each section of the file with BlockCompression, trades a bit of load time for file size
+		bool Compress = false;
+		// Generates meshlets for the mesh, see MESHLET_MAX_VERTICES
+		bool BuildMeshlets = true;
+		// Reorders triangles and vertices for the vertex cache, overdraw and vertex fetch, see MeshOptimizer
+		bool OptimizeMesh = true;
+		// How much worse the vertex cache can get to reduce overdraw, see MeshOptimizer::OptimizeOverdraw
+		float OverdrawThreshold = 1.05f;
+	};
+
+	/// <summary>
+	/// A range of indices in the mesh that can be drawn on it's own
+	/// </summary>
+	struct Submesh {
+		uint32_t  IndexOffset;
+		uint32_t  IndexCount;
+		glm::vec3 BoundsMin;
+		glm::vec3 BoundsMax;
+	};
+
+	/// <summary>
+	/// A small cluster of triangles, with it's own local vertex list, for culling or mesh shading
+	/// </summary>
+	struct Meshlet {
+		// Where this meshlet's vertex list starts in MeshTables::MeshletVertices
+		uint32_t  VertexOffset;
+		// Where this meshlet's triangles start in MeshTables::MeshletTriangles, in triangles
+		uint32_t  TriangleOffset;
+		uint32_t  VertexCount;
+		uint32_t  TriangleCount;
+		// Bounding sphere of the meshlet, in mesh space
+		glm::vec3 Center;
+		float     Radius;
+	};
+
+	/// <summary>
+	/// The submesh and meshlet tables stored in a version 2 binary file
+	/// </summary>
+	struct MeshTables {
+		std::vector<Submesh>  Submeshes;
+		std::vector<Meshlet>  Meshlets;
+		// Indices into the mesh's vertex buffer, referenced by Meshlet::VertexOffset
+		std::vector<uint32_t> MeshletVertices;
+		// Triangles as 3 indices into the meshlet's vertex list, referenced by Meshlet::TriangleOffset
+		std::vector<uint8_t>  MeshletTriangles;
+	};
+
+	/// <summary>
+	/// Loads a VAO from an OBJ file. The first time this is called for an OBJ file, it will convert the OBJ file
+	/// to a binary file in the DerivedDataCache and load that instead. On subsequent runs, the binary file will
+	/// be loaded, as long as the OBJ file has not changed since
 	/// </summary>
 	/// <param name="filename">The path to the .obj or .bin file to load</param>
+	/// <param name="tables">If not null, receives the submesh and meshlet tables from the file (version 1 files get a single submesh and no meshlets)</param>
 	/// <returns>A VAO loaded from disk</returns>
-	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename);
+	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename, MeshTables* tables = nullptr);
 	/// <summary>
 	/// Manually converts an OBJ file into a binary mesh file
 	/// </summary>
 	/// <param name="inFile">The path to OBJ file to convert</param>
 	/// <param name="outFile">The output path for the bin file, or empty to use the inFile path and replace the extension with .bin</param>
-	static void ConvertToBinary(const std::string& inFile, const std::string& outFile = "");
+	/// <param name="options">Controls how the mesh is stored in the file</param>
+	static void ConvertToBinary(const std::string& inFile, const std::string& outFile = "", const BinaryOptions& options = BinaryOptions());
 
 	/// <summary>
-	/// Saves a mesh builder of the given type to a binary file
+	/// Saves a mesh builder of the given type to a version 1 binary file
 	/// </summary>
 	/// <typeparam name="VertexType"></typeparam>
 	/// <param name="mesh"></param>
 	/// <param name="outFilename"></param>
 	template <typename VertexType>
 	static void SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename);
+	/// <summary>
+	/// Saves a mesh to a version 2 binary file. Version 2 files store each attribute in the smallest
+	/// format that holds it without visible loss, lay out every section so the file can be memory mapped
+	/// and uploaded straight to the GPU, and carry submesh and meshlet tables
+	/// </summary>
+	/// <param name="mesh">The mesh to save</param>
+	/// <param name="outFilename">The path of the file to write</param>
+	/// <param name="options">Controls how the mesh is stored in the file</param>
+	static void SaveBinaryFileV2(const MeshBuilder<VertexPosNormTexColTangents>& mesh, const std::string& outFilename, const BinaryOptions& options = BinaryOptions());
 
 protected:
+	// The benchmark times our OBJ parsing on it's own, without the binary conversion
+	friend class ObjLoaderBenchmark;
+
 	// Will be put at the start of the binary file, contains info about the contents of the file
 	struct BinaryHeader {
 		// A check value so we can ensure that we're loading in the right file type
@@ -61,11 +149,57 @@ protected:
 		uint8_t   NumAttributes = 0;
 	};
 
+	// The sections of a version 2 file, in the order they are stored
+	enum BinarySectionType {
+		SectionAttributes       = 0,
+		SectionVertices         = 1,
+		SectionIndices          = 2,
+		SectionSubmeshes        = 3,
+		SectionMeshlets         = 4,
+		SectionMeshletVertices  = 5,
+		SectionMeshletTriangles = 6,
+		SectionCount
+	};
+
+	// Where a section lives in a version 2 file. Offsets are aligned to SECTION_ALIGNMENT, so sections
+	// can be used in place when the file is memory mapped
+	struct BinarySection {
+		uint64_t Offset = 0;
+		// The size of the section in the file
+		uint64_t Size = 0;
+		// The size of the section once decompressed, same as Size if it's not compressed
+		uint64_t RawSize = 0;
+		// 0 for uncompressed, 1 for BlockCompression
+		uint32_t Compression = 0;
+		uint32_t Padding = 0;
+	};
+
+	// The header for version 2 files, the first 6 bytes line up with BinaryHeader so we can tell them apart
+	struct BinaryHeaderV2 {
+		char          HeaderBytes[4] = { 'B', 'O', 'B', 'J' };
+		uint16_t      Version = 2;
+		uint16_t      Flags = 0;
+		uint32_t      NumVertices = 0;
+		uint32_t      NumIndices = 0;
+		IndexType     IndicesType = IndexType::Unknown;
+		uint16_t      VertexStride = 0;
+		uint16_t      NumAttributes = 0;
+		uint32_t      NumSubmeshes = 0;
+		uint32_t      NumMeshlets = 0;
+		uint32_t      Padding = 0;
+		BinarySection Sections[SectionCount];
+	};
+
+	static const uint32_t SECTION_ALIGNMENT = 16;
+
 	OptimizedObjLoader() = default;
 	~OptimizedObjLoader() = default;
 
 	static MeshBuilder<VertexPosNormTexColTangents>* _LoadFromObjFile(const std::string& filename);
-	static VertexArrayObject::Sptr _LoadFromBinFile(const std::string& filename);
+	static VertexArrayObject::Sptr _LoadFromBinFile(const std::string& filename, MeshTables* tables);
+	static VertexArrayObject::Sptr _LoadFromBinV1(const uint8_t* data, size_t size, MeshTables* tables);
+	static VertexArrayObject::Sptr _LoadFromBinV2(const uint8_t* data, size_t size, MeshTables* tables);
+	static void _BuildMeshlets(const MeshBuilder<VertexPosNormTexColTangents>& mesh, MeshTables& tables);
 };
 
 template <typename VertexType>
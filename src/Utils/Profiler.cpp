@@ -0,0 +1,160 @@
+#include "Utils/Profiler.h"
+
+#include <fstream>
+#include <Logging.h>
+
+std::atomic<bool>     Profiler::_isCapturing(false);
+std::atomic<uint32_t> Profiler::_generation(0);
+std::atomic<uint32_t> Profiler::_droppedEvents(0);
+int64_t               Profiler::_captureStart = 0;
+uint32_t              Profiler::_framesRemaining = 0;
+std::string           Profiler::_capturePath;
+
+std::mutex                                           Profiler::_buffersMutex;
+std::vector<std::unique_ptr<Profiler::ThreadBuffer>> Profiler::_buffers;
+
+thread_local Profiler::ThreadBuffer* Profiler::_threadBuffer = nullptr;
+
+// Writes a string to a JSON stream with the characters that JSON cares about escaped
+static void WriteJsonString(std::ostream& stream, const std::string& value) {
+	stream << '"';
+	for (char c : value) {
+		switch (c) {
+			case '"':  stream << "\\\""; break;
+			case '\\': stream << "\\\\"; break;
+			case '\n': stream << "\\n"; break;
+			case '\t': stream << "\\t"; break;
+			default:   stream << c; break;
+		}
+	}
+	stream << '"';
+}
+
+void Profiler::BeginCapture() {
+	// Threads will throw out their old events the next time they record, since the
+	// generation no longer matches
+	_generation.fetch_add(1, std::memory_order_relaxed);
+	_droppedEvents = 0;
+	_captureStart = Now();
+	_isCapturing.store(true, std::memory_order_release);
+}
+
+void Profiler::EndCapture() {
+	_isCapturing.store(false, std::memory_order_release);
+}
+
+void Profiler::CaptureFrames(uint32_t frameCount, const std::string& path) {
+	LOG_INFO("Capturing {} frames to \"{}\"", frameCount, path);
+	_framesRemaining = frameCount;
+	_capturePath = path;
+	BeginCapture();
+}
+
+bool Profiler::EndFrame() {
+	if (_framesRemaining == 0) {
+		return false;
+	}
+
+	_framesRemaining--;
+	if (_framesRemaining == 0) {
+		EndCapture();
+		ExportChromeTrace(_capturePath);
+		return true;
+	}
+	return false;
+}
+
+bool Profiler::ExportChromeTrace(const std::string& path) {
+	if (IsCapturing()) {
+		LOG_WARN("Cannot export a trace while a capture is running");
+		return false;
+	}
+
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file.is_open()) {
+		LOG_ERROR("Failed to open \"{}\" for writing", path);
+		return false;
+	}
+
+	uint32_t generation = _generation.load(std::memory_order_relaxed);
+	size_t eventCount = 0;
+
+	std::lock_guard<std::mutex> lock(_buffersMutex);
+
+	// Chrome expects times in microseconds, we keep 3 decimals so we don't lose our nanoseconds
+	file.setf(std::ios::fixed);
+	file.precision(3);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	for (const auto& buffer : _buffers) {
+		// Name the thread, so the trace viewer can label it's track
+		file << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << buffer->ThreadId << ",\"args\":{\"name\":";
+		WriteJsonString(file, buffer->Name);
+		file << "}}";
+		first = false;
+
+		// Buffers that haven't recorded since the capture started are holding old data
+		if (buffer->Generation.load(std::memory_order_acquire) != generation) {
+			continue;
+		}
+
+		uint32_t count = buffer->Count.load(std::memory_order_acquire);
+		for (uint32_t ix = 0; ix < count; ix++) {
+			const Event& event = buffer->Chunks[ix / EVENTS_PER_CHUNK][ix % EVENTS_PER_CHUNK];
+			file << ",\n{\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->ThreadId << ",\"name\":";
+			WriteJsonString(file, event.Name);
+			file << ",\"ts\":" << (event.Start - _captureStart) / 1000.0 << ",\"dur\":" << (event.End - event.Start) / 1000.0 << "}";
+		}
+		eventCount += count;
+	}
+	file << "\n]}\n";
+
+	uint32_t dropped = _droppedEvents.load(std::memory_order_relaxed);
+	if (dropped > 0) {
+		LOG_WARN("Profiler buffers were full, {} events were dropped", dropped);
+	}
+	LOG_INFO("Wrote {} profiler events from {} threads to \"{}\"", eventCount, _buffers.size(), path);
+	return true;
+}
+
+void Profiler::SetThreadName(const std::string& name) {
+	ThreadBuffer* buffer = _GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(_buffersMutex);
+	buffer->Name = name;
+}
+
+void Profiler::RecordZone(const char* name, int64_t start, int64_t end) {
+	ThreadBuffer* buffer = _GetThreadBuffer();
+
+	// First event since a new capture started, we can re-use our chunks from the last one
+	uint32_t generation = _generation.load(std::memory_order_relaxed);
+	if (buffer->Generation.load(std::memory_order_relaxed) != generation) {
+		buffer->Count.store(0, std::memory_order_relaxed);
+		buffer->Generation.store(generation, std::memory_order_release);
+	}
+
+	uint32_t index = buffer->Count.load(std::memory_order_relaxed);
+	uint32_t chunk = index / EVENTS_PER_CHUNK;
+	if (chunk >= MAX_CHUNKS) {
+		_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	if (buffer->Chunks[chunk] == nullptr) {
+		buffer->Chunks[chunk] = std::make_unique<Event[]>(EVENTS_PER_CHUNK);
+	}
+
+	buffer->Chunks[chunk][index % EVENTS_PER_CHUNK] = { name, start, end };
+	buffer->Count.store(index + 1, std::memory_order_release);
+}
+
+Profiler::ThreadBuffer* Profiler::_GetThreadBuffer() {
+	if (_threadBuffer == nullptr) {
+		std::lock_guard<std::mutex> lock(_buffersMutex);
+		_buffers.push_back(std::make_unique<ThreadBuffer>());
+		_threadBuffer = _buffers.back().get();
+		_threadBuffer->ThreadId = static_cast<uint32_t>(_buffers.size());
+		_threadBuffer->Name = "Thread " + std::to_string(_threadBuffer->ThreadId);
+		_threadBuffer->Generation.store(_generation.load(std::memory_order_relaxed));
+	}
+	return _threadBuffer;
+}
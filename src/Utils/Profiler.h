@@ -0,0 +1,157 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Utils/Macros.h"
+
+// Set to 0 to compile all profiler zones out of the build
+#ifndef ENABLE_PROFILING
+#define ENABLE_PROFILING 1
+#endif
+
+/// <summary>
+/// A lightweight CPU profiler for capturing timed zones from any thread. Each thread records
+/// into it's own buffer without taking any locks, and captures can be exported in the Chrome
+/// trace event format (load them in chrome://tracing or https://ui.perfetto.dev)
+///
+/// When no capture is running, a zone costs a single relaxed atomic load
+/// </summary>
+class Profiler {
+public:
+	Profiler() = delete;
+
+	/// <summary>
+	/// Starts a new capture, discarding anything from the previous capture
+	/// </summary>
+	static void BeginCapture();
+	/// <summary>
+	/// Stops the current capture, zones that are still open will not be recorded
+	/// </summary>
+	static void EndCapture();
+	/// <summary>
+	/// Returns true if a capture is running
+	/// </summary>
+	static bool IsCapturing() { return _isCapturing.load(std::memory_order_relaxed); }
+
+	/// <summary>
+	/// Starts a capture that will end after the given number of frames, and write the result
+	/// to a file. Frames are counted by EndFrame
+	/// </summary>
+	/// <param name="frameCount">The number of frames to capture</param>
+	/// <param name="path">The path to write the Chrome trace to when the capture ends</param>
+	static void CaptureFrames(uint32_t frameCount, const std::string& path);
+	/// <summary>
+	/// Should be invoked by the main thread at the end of every frame, handles ending captures
+	/// started with CaptureFrames
+	/// </summary>
+	/// <returns>True if a frame capture finished this frame</returns>
+	static bool EndFrame();
+
+	/// <summary>
+	/// Writes the events from the last capture to a JSON file in the Chrome trace format. The
+	/// capture must have ended, and all threads must be done recording
+	/// </summary>
+	/// <param name="path">The path of the file to write</param>
+	/// <returns>True if the file was written</returns>
+	static bool ExportChromeTrace(const std::string& path);
+
+	/// <summary>
+	/// Sets the name that the calling thread will have in exported traces
+	/// </summary>
+	static void SetThreadName(const std::string& name);
+
+	/// <summary>
+	/// Records a completed zone on the calling thread, prefer PROFILE_SCOPE over calling this directly
+	/// </summary>
+	/// <param name="name">The name of the zone, must outlive the capture (ex: a string literal)</param>
+	/// <param name="start">The time the zone started, from Now</param>
+	/// <param name="end">The time the zone ended, from Now</param>
+	static void RecordZone(const char* name, int64_t start, int64_t end);
+
+	/// <summary>
+	/// Gets the current time in nanoseconds, for use with RecordZone
+	/// </summary>
+	static int64_t Now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+protected:
+	struct Event {
+		const char* Name;
+		int64_t     Start;
+		int64_t     End;
+	};
+
+	static const uint32_t EVENTS_PER_CHUNK = 16384;
+	static const uint32_t MAX_CHUNKS = 256;
+
+	// Events recorded by a single thread. Only the owning thread writes to this, and it
+	// publishes new events by bumping the count, so readers never see a half-written event
+	struct ThreadBuffer {
+		uint32_t              ThreadId = 0;
+		std::string           Name;
+		std::atomic<uint32_t> Generation{ 0 };
+		std::atomic<uint32_t> Count{ 0 };
+		std::unique_ptr<Event[]> Chunks[MAX_CHUNKS];
+	};
+
+	static std::atomic<bool>     _isCapturing;
+	static std::atomic<uint32_t> _generation;
+	static std::atomic<uint32_t> _droppedEvents;
+	static int64_t               _captureStart;
+	static uint32_t              _framesRemaining;
+	static std::string           _capturePath;
+
+	// Only locked when a thread first records, or when exporting
+	static std::mutex                                 _buffersMutex;
+	static std::vector<std::unique_ptr<ThreadBuffer>> _buffers;
+
+	static thread_local ThreadBuffer* _threadBuffer;
+
+	static ThreadBuffer* _GetThreadBuffer();
+};
+
+/// <summary>
+/// Records the time between it's construction and destruction as a zone on the calling thread
+/// </summary>
+class ProfileZone {
+public:
+	NO_COPY(ProfileZone)
+	NO_MOVE(ProfileZone)
+
+	ProfileZone(const char* name) :
+		_name(name),
+		_start(Profiler::IsCapturing() ? Profiler::Now() : 0)
+	{ }
+
+	~ProfileZone() {
+		if (_start != 0 && Profiler::IsCapturing()) {
+			Profiler::RecordZone(_name, _start, Profiler::Now());
+		}
+	}
+
+private:
+	const char* _name;
+	int64_t     _start;
+};
+
+#if ENABLE_PROFILING
+	#define __PROFILE_CONCAT_INNER(a, b) a##b
+	#define __PROFILE_CONCAT(a, b) __PROFILE_CONCAT_INNER(a, b)
+	// Profiles the rest of the enclosing block, name must be a string literal
+	#define PROFILE_SCOPE(name) ProfileZone __PROFILE_CONCAT(__profileZone, __LINE__)("" name "")
+	// Profiles the rest of the enclosing block, name can be any string that outlives the capture (ex: a layer's name)
+	#define PROFILE_SCOPE_DYNAMIC(name) ProfileZone __PROFILE_CONCAT(__profileZone, __LINE__)(name)
+	// Profiles the rest of the enclosing function, using the function's name
+	#define PROFILE_FUNCTION() ProfileZone __PROFILE_CONCAT(__profileZone, __LINE__)(__FUNCTION__)
+#else
+	#define PROFILE_SCOPE(name)
+	#define PROFILE_SCOPE_DYNAMIC(name)
+	#define PROFILE_FUNCTION()
+#endif
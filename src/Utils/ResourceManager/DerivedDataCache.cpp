@@ -0,0 +1,182 @@
+#include "Utils/ResourceManager/DerivedDataCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <Logging.h>
+
+#include "Utils/MappedFile.h"
+
+namespace fs = std::filesystem;
+
+std::string DerivedDataCache::_directory = "cache";
+bool DerivedDataCache::_enabled = true;
+std::atomic<uint32_t> DerivedDataCache::_hits{ 0 };
+std::atomic<uint32_t> DerivedDataCache::_misses{ 0 };
+std::atomic<uint32_t> DerivedDataCache::_tempCounter{ 0 };
+
+namespace {
+	const uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+	const uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+
+	inline uint64_t RotateLeft(uint64_t value, int bits) {
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	inline uint64_t Mix(uint64_t hash, uint64_t value) {
+		hash ^= RotateLeft(value * PRIME_2, 31) * PRIME_1;
+		return RotateLeft(hash, 27) * PRIME_1 + PRIME_2;
+	}
+
+	// A fast non-cryptographic 64 bit hash, we only need to detect changes, not resist tampering.
+	// Reading 8 bytes at a time keeps hashing well ahead of how fast we can decode the source
+	uint64_t HashBytes(const void* data, size_t size, uint64_t seed) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		uint64_t hash = seed ^ (size * PRIME_1);
+
+		size_t ix = 0;
+		for (; ix + 8 <= size; ix += 8) {
+			uint64_t word;
+			memcpy(&word, bytes + ix, sizeof(uint64_t));
+			hash = Mix(hash, word);
+		}
+		uint64_t tail = 0;
+		if (ix < size) {
+			memcpy(&tail, bytes + ix, size - ix);
+		}
+		hash = Mix(hash, tail);
+
+		// Final avalanche so that small changes affect every bit of the key
+		hash ^= hash >> 33;
+		hash *= PRIME_2;
+		hash ^= hash >> 29;
+		hash *= PRIME_1;
+		hash ^= hash >> 32;
+		return hash;
+	}
+}
+
+void DerivedDataCache::Init(const std::string& directory) {
+	_directory = directory;
+	std::error_code error;
+	fs::create_directories(_directory, error);
+	if (error) {
+		LOG_WARN("Could not create derived data cache directory \"{}\" ({}), caching is disabled", _directory, error.message());
+		_enabled = false;
+	}
+}
+
+void DerivedDataCache::SetEnabled(bool enabled) {
+	_enabled = enabled;
+}
+
+bool DerivedDataCache::IsEnabled() {
+	return _enabled;
+}
+
+bool DerivedDataCache::MakeKey(const std::string& sourceFile, const std::string& importer, uint32_t importerVersion, const std::string& settings, Key& result) {
+	result = Key();
+	if (!_enabled) {
+		return false;
+	}
+
+	// The source is memory mapped so we can hash it without copying
+	MappedFile file;
+	if (!file.Open(sourceFile)) {
+		return false;
+	}
+
+	uint64_t hash = HashBytes(file.GetData(), file.GetSize(), importerVersion);
+	hash = HashBytes(importer.data(), importer.size(), hash);
+	hash = HashBytes(settings.data(), settings.size(), hash);
+
+	result.Hash = hash;
+	result.Importer = importer;
+	return true;
+}
+
+std::string DerivedDataCache::GetEntryPath(const Key& key) {
+	char name[17];
+	snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key.Hash));
+	return (fs::path(_directory) / (key.Importer + "-" + name + ".ddc")).string();
+}
+
+std::string DerivedDataCache::GetTempPath(const Key& key) {
+	// Several threads may be importing at once, so each temporary file needs a unique name
+	return GetEntryPath(key) + "." + std::to_string(_tempCounter++) + ".tmp";
+}
+
+bool DerivedDataCache::Contains(const Key& key) {
+	bool result = _enabled && key.IsValid() && fs::exists(GetEntryPath(key));
+	(result ? _hits : _misses)++;
+	return result;
+}
+
+bool DerivedDataCache::Load(const Key& key, std::vector<uint8_t>& result) {
+	if (!_enabled || !key.IsValid()) {
+		return false;
+	}
+
+	std::ifstream file(GetEntryPath(key), std::ios::binary | std::ios::ate);
+	if (!file) {
+		_misses++;
+		return false;
+	}
+
+	size_t size = static_cast<size_t>(file.tellg());
+	file.seekg(0, std::ios::beg);
+	result.resize(size);
+	if (!file.read(reinterpret_cast<char*>(result.data()), size)) {
+		LOG_WARN("Failed to read derived data cache entry \"{}\"", GetEntryPath(key));
+		_misses++;
+		return false;
+	}
+
+	_hits++;
+	return true;
+}
+
+bool DerivedDataCache::Store(const Key& key, const void* data, size_t size) {
+	if (!_enabled || !key.IsValid()) {
+		return false;
+	}
+
+	std::string tempPath = GetTempPath(key);
+	{
+		std::ofstream file(tempPath, std::ios::binary);
+		if (!file) {
+			LOG_WARN("Could not write derived data cache entry \"{}\"", tempPath);
+			return false;
+		}
+		file.write(static_cast<const char*>(data), size);
+		if (!file) {
+			file.close();
+			fs::remove(tempPath);
+			LOG_WARN("Could not write derived data cache entry \"{}\"", tempPath);
+			return false;
+		}
+	}
+	return StoreFile(key, tempPath);
+}
+
+bool DerivedDataCache::StoreFile(const Key& key, const std::string& path) {
+	if (!_enabled || !key.IsValid()) {
+		return false;
+	}
+
+	// Renaming is atomic, so readers only ever see a missing entry or a complete one
+	std::error_code error;
+	fs::create_directories(_directory, error);
+	fs::rename(path, GetEntryPath(key), error);
+	if (error) {
+		LOG_WARN("Could not move \"{}\" into the derived data cache ({})", path, error.message());
+		fs::remove(path, error);
+		return false;
+	}
+	return true;
+}
+
+void DerivedDataCache::LogStats() {
+	LOG_INFO("Derived data cache: {} hits, {} misses", _hits.load(), _misses.load());
+}
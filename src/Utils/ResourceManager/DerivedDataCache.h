@@ -0,0 +1,111 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// A cache on disk for data that importers derive from source assets (ex: decoded images,
+/// optimized meshes, parsed LUTs), so that we don't need to re-process the source files every
+/// time we start up.
+///
+/// Entries are keyed by a hash of the source file's contents, along with the importer's name,
+/// version and settings. Editing a source file, bumping an importer version, or changing the
+/// settings an asset is imported with will all give a new key, so a stale entry can never be
+/// served. Old entries are simply left behind, and the cache directory can be deleted at any
+/// time
+/// </summary>
+class DerivedDataCache {
+public:
+	/// <summary>
+	/// Identifies a single entry in the cache
+	/// </summary>
+	struct Key {
+		uint64_t    Hash = 0;
+		std::string Importer;
+
+		/// <summary>
+		/// Returns true if this key was successfully generated by MakeKey
+		/// </summary>
+		bool IsValid() const { return !Importer.empty(); }
+	};
+
+	DerivedDataCache() = delete;
+
+	/// <summary>
+	/// Sets the directory that cache entries are stored in, creating it if needed. The cache
+	/// will use "cache" in the working directory if this is never called
+	/// </summary>
+	/// <param name="directory">The path of the cache directory</param>
+	static void Init(const std::string& directory = "cache");
+
+	/// <summary>
+	/// Enables or disables the cache, when disabled all lookups miss and nothing is stored
+	/// </summary>
+	static void SetEnabled(bool enabled);
+	static bool IsEnabled();
+
+	/// <summary>
+	/// Generates a key for data derived from a source file. The entire source file is hashed, so
+	/// this should only be called once per asset load
+	/// </summary>
+	/// <param name="sourceFile">The path to the source asset</param>
+	/// <param name="importer">A short name for the importer, used in the entry's filename</param>
+	/// <param name="importerVersion">The version of the importer, bump this whenever the importer's output changes</param>
+	/// <param name="settings">Any import settings that affect the output</param>
+	/// <param name="result">The key to store the result in</param>
+	/// <returns>True if the key was generated, false if the source file could not be read or the cache is disabled</returns>
+	static bool MakeKey(const std::string& sourceFile, const std::string& importer, uint32_t importerVersion, const std::string& settings, Key& result);
+
+	/// <summary>
+	/// Gets the path that the entry for a key is stored at, this lets importers with their own
+	/// file formats map entries directly rather than copying them through Load
+	/// </summary>
+	static std::string GetEntryPath(const Key& key);
+	/// <summary>
+	/// Checks if there is an entry for the given key, and counts it as a hit or miss
+	/// </summary>
+	static bool Contains(const Key& key);
+
+	/// <summary>
+	/// Loads the contents of the entry for a key
+	/// </summary>
+	/// <param name="key">The key to look up</param>
+	/// <param name="result">The vector to store the entry's contents in</param>
+	/// <returns>True on a cache hit, false if there is no entry for the key</returns>
+	static bool Load(const Key& key, std::vector<uint8_t>& result);
+	/// <summary>
+	/// Stores an entry in the cache, replacing any existing entry for the key. Entries are
+	/// written to a temporary file first, so a crash mid-write never leaves a partial entry
+	/// </summary>
+	/// <param name="key">The key to store the entry under</param>
+	/// <param name="data">The contents of the entry</param>
+	/// <param name="size">The number of bytes in data</param>
+	/// <returns>True if the entry was stored</returns>
+	static bool Store(const Key& key, const void* data, size_t size);
+	/// <summary>
+	/// Moves a file into the cache as the entry for a key, for importers that write their output
+	/// to disk themselves
+	/// </summary>
+	/// <param name="key">The key to store the entry under</param>
+	/// <param name="path">The path of the file to move, should be on the same drive as the cache</param>
+	/// <returns>True if the file was moved into the cache</returns>
+	static bool StoreFile(const Key& key, const std::string& path);
+	/// <summary>
+	/// Gets a temporary path in the cache directory that an importer can write to before
+	/// passing it to StoreFile
+	/// </summary>
+	static std::string GetTempPath(const Key& key);
+
+	/// <summary>
+	/// Logs the number of cache hits and misses since startup
+	/// </summary>
+	static void LogStats();
+
+protected:
+	static std::string _directory;
+	static bool _enabled;
+	static std::atomic<uint32_t> _hits;
+	static std::atomic<uint32_t> _misses;
+	static std::atomic<uint32_t> _tempCounter;
+};
@@ -3,6 +3,7 @@
 #include "Utils/ObjLoader.h"
 #include "Utils/FileHelpers.h"
 #include "Utils/StringUtils.h"
+#include "Utils/ResourceManager/DerivedDataCache.h"
 
 std::map<std::type_index, std::map<Guid, IResource::Sptr>> ResourceManager::_resources;
 std::map<std::string, std::function<Guid(const nlohmann::json&)>> ResourceManager::_typeLoaders;
@@ -10,6 +11,9 @@ std::map<std::string, std::function<Guid(const nlohmann::json&)>> ResourceManage
 nlohmann::ordered_json ResourceManager::_manifest;
 
 void ResourceManager::Init() {
+	// Loaders store the data they derive from source assets here, so we don't need to re-process them each run
+	DerivedDataCache::Init("cache");
+
 	// TODO: initialize the resource manager once it's a bit more complex
 	//_manifest["textures"]  = std::vector<nlohmann::json>();
 	//_manifest["meshes"]    = std::vector<nlohmann::json>();
@@ -22,6 +26,7 @@ const nlohmann::ordered_json& ResourceManager::GetManifest() {
 }
 
 void ResourceManager::LoadManifest(const std::string& path, bool preloadAssets) {
+	PROFILE_SCOPE("ResourceManager::LoadManifest");
 	std::string contents = FileHelpers::ReadFile(path);
 	nlohmann::ordered_json blob = nlohmann::ordered_json::parse(contents);
 	_manifest = blob;
@@ -35,6 +40,7 @@ void ResourceManager::LoadManifest(const std::string& path, bool preloadAssets)
 				}
 			}
 		}
+		DerivedDataCache::LogStats();
 	}
 }
 